@@ -158,6 +158,10 @@ class Settings(CiBuildSettingsManager, UpdateSettingsManager, SetupSettingsManag
             "MdeModulePkg/Library/BrotliCustomDecompressLib/brotli", False))
         rs.append(RequiredSubmodule(
             "BaseTools/Source/C/BrotliCompress/brotli", False))
+        rs.append(RequiredSubmodule(
+            "MdeModulePkg/Library/ZstdCustomDecompressLib/zstd", False))
+        rs.append(RequiredSubmodule(
+            "BaseTools/Source/C/ZstdCompress/zstd", False))
         return rs
 
     def GetName(self):
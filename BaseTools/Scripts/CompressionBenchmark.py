@@ -0,0 +1,144 @@
+## @file
+# Compare the GUIDed section compression tools on one or more inputs.
+#
+# The input is normally the payload of the compressed section of the
+# FVMAIN_COMPACT firmware volume, which GenFds leaves in the build output as
+# Build/<Platform>/<Target>_<ToolChain>/FV/Ffs/<FileGuid>/<FileGuid>SEC1.guided.dummy,
+# or the PEIFV.Fv and DXEFV.Fv files next to it. Every tool compresses and
+# decompresses each input several times, and the fastest run is reported.
+# The times are those of the host tools on the build machine, including the
+# start of each tool process, so they only compare the codecs with each
+# other on this host. They do not predict how long SEC or DxeIpl takes to
+# decompress the section at boot, where the decoders run with other compiler
+# options, without caches warmed up and often from slower memory; measure the
+# boot itself for that.
+#
+# A tool may be given with options, for example -t "LzmaCompress --threads 1".
+# The digest column shows whether the compressed output of two tools is the
+# same; a tool whose output changes from one run to the next fails.
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+'''
+CompressionBenchmark
+'''
+from __future__ import print_function
+
+import sys
+import os
+import argparse
+import filecmp
+import hashlib
+import shutil
+import subprocess
+import tempfile
+import time
+
+#
+# Globals for help information
+#
+__prog__        = 'CompressionBenchmark'
+__description__ = 'Compare the compression ratio and host speed of the GUIDed section compression tools.\n'
+
+#
+# The tools of the GUIDed sections in tools_def.txt, with the GUID GenFds
+# tags the section with.
+#
+DefaultTools = [
+    ('TianoCompress',  'A31280AD-481E-41B6-95E8-127F4C984779'),
+    ('LzmaCompress',   'EE4E5898-3914-4259-9D6E-DC7BD79403CF'),
+    ('BrotliCompress', '3D532050-5CDA-4FD0-879E-0F7F630D5AFB'),
+    ('ZstdCompress',   '54C50FE7-BAF4-4137-AAC5-944000B68AA7'),
+]
+
+def RunTool (Tool, Option, InputFile, OutputFile):
+    Command = Tool.split () + [Option, '-o', OutputFile, InputFile]
+    Start = time.time ()
+    Process = subprocess.Popen (Command, stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+    Output = Process.communicate ()[0]
+    Elapsed = time.time () - Start
+    if Process.returncode != 0 or not os.path.exists (OutputFile):
+        raise RuntimeError ('{Command} failed: {Output}'.format (Command = ' '.join (Command), Output = Output.decode ('ascii', 'replace').strip ()))
+    return Elapsed
+
+def FileDigest (FileName):
+    with open (FileName, 'rb') as File:
+        return hashlib.sha1 (File.read ()).hexdigest ()
+
+def Benchmark (Tool, InputFile, Iterations, WorkDir):
+    Compressed   = os.path.join (WorkDir, 'compressed')
+    Decompressed = os.path.join (WorkDir, 'decompressed')
+    CompressTimes   = []
+    DecompressTimes = []
+    Digest = None
+    for Index in range (Iterations):
+        CompressTimes.append (RunTool (Tool, '-e', InputFile, Compressed))
+        if Digest is None:
+            Digest = FileDigest (Compressed)
+        elif Digest != FileDigest (Compressed):
+            raise RuntimeError ('{Tool} does not give the same output on every run'.format (Tool = Tool))
+        DecompressTimes.append (RunTool (Tool, '-d', Compressed, Decompressed))
+    if not filecmp.cmp (InputFile, Decompressed, shallow = False):
+        raise RuntimeError ('{Tool} does not give back the input'.format (Tool = Tool))
+    return os.path.getsize (Compressed), min (CompressTimes), min (DecompressTimes), Digest
+
+if __name__ == '__main__':
+    #
+    # Create command line argument parser object
+    #
+    parser = argparse.ArgumentParser (prog = __prog__,
+                                      description = __description__,
+                                      conflict_handler = 'resolve')
+    parser.add_argument ("-i", "--input", dest = 'InputFiles', action = 'append', required = True,
+                         help = "Uncompressed section payload or FV file. May be given several times.")
+    parser.add_argument ("-n", "--iterations", dest = 'Iterations', type = int, default = 5,
+                         help = "Number of runs per tool and input; the fastest one is reported. Default is 5.")
+    parser.add_argument ("-t", "--tool", dest = 'Tools', action = 'append',
+                         help = "Compression tool to compare, with its options. May be given several times. Default is all GUIDed section tools.")
+    parser.add_argument ("-v", "--verbose", dest = 'Verbose', action = "store_true",
+                         help = "Increase output messages")
+
+    #
+    # Parse command line arguments
+    #
+    args = parser.parse_args ()
+
+    for InputFile in args.InputFiles:
+        if not os.path.isfile (InputFile):
+            print ('{Prog}: error: {File} is not a file'.format (Prog = __prog__, File = InputFile), file = sys.stderr)
+            sys.exit (1)
+    if args.Iterations < 1:
+        print ('{Prog}: error: at least one iteration is needed'.format (Prog = __prog__), file = sys.stderr)
+        sys.exit (1)
+
+    if args.Tools is None:
+        Tools = DefaultTools
+    else:
+        Guids = dict (DefaultTools)
+        Tools = [(Tool, Guids.get (Tool.split ()[0], '')) for Tool in args.Tools]
+
+    Failed  = False
+    WorkDir = tempfile.mkdtemp (prefix = __prog__)
+    try:
+        for InputFile in args.InputFiles:
+            InputSize = os.path.getsize (InputFile)
+            print ('{File}: {Size} bytes, best of {Count} runs'.format (File = InputFile, Size = InputSize, Count = args.Iterations))
+            print ('  {0:<28} {1:>10} {2:>7} {3:>14} {4:>16} {5:>13}'.format ('Tool', 'Size', 'Ratio', 'Compress (ms)', 'Decompress (ms)', 'Digest'))
+            for (Tool, Guid) in Tools:
+                try:
+                    Size, CompressTime, DecompressTime, Digest = Benchmark (Tool, InputFile, args.Iterations, WorkDir)
+                except (OSError, RuntimeError) as Error:
+                    print ('  {0:<28} {1}'.format (Tool, 'skipped' if isinstance (Error, OSError) else 'failed'))
+                    if args.Verbose or not isinstance (Error, OSError):
+                        print ('    {Error}'.format (Error = Error), file = sys.stderr)
+                    Failed = Failed or not isinstance (Error, OSError)
+                    continue
+                print ('  {0:<28} {1:>10} {2:>6.1f}% {3:>14.1f} {4:>16.1f} {5:>13}'.format (
+                       Tool, Size, Size * 100.0 / max (InputSize, 1), CompressTime * 1000, DecompressTime * 1000, Digest[:12]))
+                if args.Verbose and Guid:
+                    print ('    SECTION GUIDED {Guid}'.format (Guid = Guid))
+    finally:
+        shutil.rmtree (WorkDir)
+
+    sys.exit (1 if Failed else 0)
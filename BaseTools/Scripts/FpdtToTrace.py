@@ -0,0 +1,242 @@
+## @file
+# Convert a raw firmware boot performance table dump to a Chrome trace event file.
+#
+# The input is either the Firmware Basic Boot Performance Table (FBPT) the
+# performance libraries fill in, or the ACPI FPDT together with a memory image
+# (for example /dev/mem) the FBPT pointer of the FPDT can be followed in. The
+# output can be opened in chrome://tracing or in the Perfetto UI, the same as
+# the file the shell command "dp -o" writes.
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+'''
+FpdtToTrace
+'''
+from __future__ import print_function
+
+import sys
+import argparse
+import json
+import struct
+import uuid
+
+#
+# Globals for help information
+#
+__prog__        = 'FpdtToTrace'
+__description__ = 'Convert a raw FBPT or FPDT dump to a Chrome trace event file.\n'
+
+#
+# Record types of MdeModulePkg/Include/Guid/ExtendedFirmwarePerformance.h
+#
+FPDT_FBPT_POINTER_TYPE             = 0x0000
+FPDT_BASIC_BOOT_TYPE               = 0x0002
+FPDT_GUID_EVENT_TYPE               = 0x1010
+FPDT_DYNAMIC_STRING_EVENT_TYPE     = 0x1011
+FPDT_DUAL_GUID_STRING_EVENT_TYPE   = 0x1012
+FPDT_GUID_QWORD_EVENT_TYPE         = 0x1013
+FPDT_GUID_QWORD_STRING_EVENT_TYPE  = 0x1014
+
+#
+# Progress IDs of MdePkg/Include/Library/PerformanceLib.h
+#
+PERF_EVENTSIGNAL_START_ID          = 0x10
+PERF_CROSSMODULE_START_ID          = 0x50
+PERF_CROSSMODULE_END_ID            = 0x51
+
+ModuleTokens = {
+    0x01: 'StartImage:',
+    0x03: 'LoadImage:',
+    0x05: 'DB:Start:',
+    0x07: 'DB:Support:',
+    0x09: 'DB:Stop:',
+}
+
+PhaseTokens = ('SEC', 'PEI', 'DXE', 'BDS')
+ThreadNames = ('Phases', 'PEIMs', 'Drivers and events')
+
+class Record:
+    def __init__ (self, Type, ProgressId, Timestamp, Guid, Qword, String):
+        self.Type       = Type
+        self.ProgressId = ProgressId
+        self.Timestamp  = Timestamp
+        self.Guid       = Guid
+        self.Qword      = Qword
+        self.String     = String
+
+def ParseString (Buffer):
+    return Buffer.split (b'\0', 1)[0].decode ('ascii', 'replace')
+
+def ParseRecords (Table):
+    if Table[0:4] != b'FBPT':
+        raise ValueError ('The table does not start with the FBPT signature')
+    Length = struct.unpack_from ('<I', Table, 4)[0]
+    if Length > len (Table):
+        raise ValueError ('The table is truncated, {Length} bytes expected'.format (Length = Length))
+
+    BasicBoot = None
+    Records   = []
+    Offset    = 8
+    while Offset + 4 <= Length:
+        Type, RecordLength = struct.unpack_from ('<HB', Table, Offset)
+        if RecordLength < 4 or Offset + RecordLength > Length:
+            break
+        Data = Table[Offset:Offset + RecordLength]
+        if Type == FPDT_BASIC_BOOT_TYPE:
+            BasicBoot = struct.unpack_from ('<5Q', Data, 8)
+        elif Type in (FPDT_GUID_EVENT_TYPE, FPDT_DYNAMIC_STRING_EVENT_TYPE, FPDT_DUAL_GUID_STRING_EVENT_TYPE,
+                      FPDT_GUID_QWORD_EVENT_TYPE, FPDT_GUID_QWORD_STRING_EVENT_TYPE):
+            ProgressId, ApicId, Timestamp = struct.unpack_from ('<HIQ', Data, 4)
+            Guid   = str (uuid.UUID (bytes_le = bytes (Data[18:34])))
+            Qword  = None
+            String = ''
+            if Type == FPDT_DYNAMIC_STRING_EVENT_TYPE:
+                String = ParseString (Data[34:])
+            elif Type == FPDT_DUAL_GUID_STRING_EVENT_TYPE:
+                String = ParseString (Data[50:])
+            elif Type == FPDT_GUID_QWORD_EVENT_TYPE:
+                Qword = struct.unpack_from ('<Q', Data, 34)[0]
+            elif Type == FPDT_GUID_QWORD_STRING_EVENT_TYPE:
+                Qword  = struct.unpack_from ('<Q', Data, 34)[0]
+                String = ParseString (Data[42:])
+            Records.append (Record (Type, ProgressId, Timestamp, Guid, Qword, String))
+        Offset += RecordLength
+    return BasicBoot, Records
+
+def ReadFbptFromFpdt (Fpdt, Memory):
+    if Fpdt[0:4] != b'FPDT':
+        raise ValueError ('The table does not start with the FPDT signature')
+    Length = struct.unpack_from ('<I', Fpdt, 4)[0]
+    Offset = 36
+    while Offset + 4 <= Length:
+        Type, RecordLength = struct.unpack_from ('<HB', Fpdt, Offset)
+        if RecordLength < 4:
+            break
+        if Type == FPDT_FBPT_POINTER_TYPE:
+            Address = struct.unpack_from ('<Q', Fpdt, Offset + 8)[0]
+            Memory.seek (Address)
+            Header = Memory.read (8)
+            Memory.seek (Address)
+            return Memory.read (struct.unpack_from ('<I', Header, 4)[0])
+        Offset += RecordLength
+    raise ValueError ('The FPDT has no FBPT pointer record')
+
+def IsStartRecord (ProgressId):
+    if ProgressId >= PERF_EVENTSIGNAL_START_ID:
+        return (ProgressId & 0x000F) == 0
+    return (ProgressId & 0x0001) != 0
+
+def BuildEvents (BasicBoot, Records):
+    #
+    # Pair the start and end records the way the dp command does.
+    #
+    Measurements = []
+    PeiPhase     = False
+    for Item in Records:
+        if Item.ProgressId < PERF_EVENTSIGNAL_START_ID and Item.ProgressId != 0:
+            Token = ModuleTokens.get ((Item.ProgressId - 1) | 1, Item.String)
+            if (Item.ProgressId - 1) | 1 == 0x01 and PeiPhase:
+                Token = 'PEIM'
+        else:
+            Token = Item.String
+        if Item.ProgressId == PERF_CROSSMODULE_START_ID and Item.String in ('PEI', 'DXE'):
+            PeiPhase = Item.String == 'PEI'
+
+        if Item.ProgressId == 0:
+            Measurements.append ({'Token': Token, 'Record': Item, 'Start': 0, 'End': Item.Timestamp})
+        elif IsStartRecord (Item.ProgressId):
+            Measurements.append ({'Token': Token, 'Record': Item, 'Start': Item.Timestamp, 'End': 0})
+        else:
+            for Measurement in reversed (Measurements):
+                Start = Measurement['Record']
+                if Measurement['End'] != 0 or Measurement['Token'] != Token:
+                    continue
+                if Item.ProgressId == PERF_CROSSMODULE_END_ID:
+                    if Start.ProgressId != PERF_CROSSMODULE_START_ID:
+                        continue
+                elif Start.Guid != Item.Guid:
+                    continue
+                elif Start.Qword is not None and Item.Qword is not None and Start.Qword != Item.Qword:
+                    continue
+                Measurement['End'] = Item.Timestamp
+                break
+
+    Events = []
+    for Thread, Name in enumerate (ThreadNames):
+        Events.append ({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': Thread, 'args': {'name': Name}})
+    Events.append ({'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'Boot'}})
+
+    for Measurement in Measurements:
+        Item  = Measurement['Record']
+        Token = Measurement['Token']
+        if Token in PhaseTokens and Item.ProgressId in (PERF_CROSSMODULE_START_ID, PERF_CROSSMODULE_END_ID):
+            Thread = 0
+        elif Token == 'PEIM':
+            Thread = 1
+        else:
+            Thread = 2
+        Name = Item.String if Item.String and Item.String != Token else Item.Guid
+        if Thread == 0:
+            Name = Token
+        Event = {
+            'name': Name,
+            'cat':  Token,
+            'pid':  1,
+            'tid':  Thread,
+            'args': {'guid': Item.Guid, 'id': Item.ProgressId},
+        }
+        if Item.Qword is not None:
+            Event['args']['qword'] = '0x{Qword:x}'.format (Qword = Item.Qword)
+        if Measurement['Start'] != 0 and Measurement['End'] != 0:
+            Event['ph']  = 'X'
+            Event['ts']  = Measurement['Start'] / 1000.0
+            Event['dur'] = (Measurement['End'] - Measurement['Start']) / 1000.0
+        else:
+            Event['ph']  = 'i'
+            Event['s']   = 't'
+            Event['ts']  = (Measurement['End'] or Measurement['Start']) / 1000.0
+        Events.append (Event)
+
+    if BasicBoot is not None:
+        for Name, Timestamp in zip (('ResetEnd', 'OsLoaderLoadImageStart', 'OsLoaderStartImageStart',
+                                     'ExitBootServicesEntry', 'ExitBootServicesExit'), BasicBoot):
+            if Timestamp != 0:
+                Events.append ({'name': Name, 'cat': 'FBPT', 'ph': 'i', 's': 'p', 'pid': 1, 'tid': 0,
+                                'ts': Timestamp / 1000.0})
+    return Events
+
+if __name__ == '__main__':
+    #
+    # Create command line argument parser object
+    #
+    parser = argparse.ArgumentParser (prog = __prog__,
+                                      description = __description__,
+                                      conflict_handler = 'resolve')
+    parser.add_argument ("-i", "--input", dest = 'InputFile', type = argparse.FileType ('rb'), required = True,
+                         help = "Raw FBPT dump, or raw ACPI FPDT dump when --memory is given.")
+    parser.add_argument ("-m", "--memory", dest = 'MemoryFile', type = argparse.FileType ('rb'),
+                         help = "Memory image the FBPT address of the FPDT is read from, for example /dev/mem.")
+    parser.add_argument ("-o", "--output", dest = 'OutputFile', type = argparse.FileType ('w'), required = True,
+                         help = "Chrome trace event JSON file to write.")
+    parser.add_argument ("-v", "--verbose", dest = 'Verbose', action = "store_true",
+                         help = "Increase output messages")
+
+    #
+    # Parse command line arguments
+    #
+    args = parser.parse_args ()
+
+    try:
+        Table = args.InputFile.read ()
+        if args.MemoryFile is not None:
+            Table = ReadFbptFromFpdt (Table, args.MemoryFile)
+        BasicBoot, Records = ParseRecords (Table)
+    except (ValueError, IOError, struct.error) as Error:
+        print ('{Prog}: error: {Error}'.format (Prog = __prog__, Error = Error), file = sys.stderr)
+        sys.exit (1)
+
+    Events = BuildEvents (BasicBoot, Records)
+    json.dump ({'displayTimeUnit': 'ns', 'traceEvents': Events}, args.OutputFile, indent = 1)
+    if args.Verbose:
+        print ('{Count} records converted to {Events} trace events'.format (Count = len (Records), Events = len (Events)))
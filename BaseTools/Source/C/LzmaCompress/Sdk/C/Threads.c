@@ -3,6 +3,8 @@
 
 #include "Precomp.h"
 
+#ifdef _WIN32
+
 #ifndef UNDER_CE
 #include <process.h>
 #endif
@@ -93,3 +95,162 @@ WRes CriticalSection_Init(CCriticalSection *p)
   #endif
   return 0;
 }
+
+#else
+
+#include <errno.h>
+
+#include "Threads.h"
+
+WRes Thread_Create(CThread *p, THREAD_FUNC_TYPE func, void *param)
+{
+  WRes res = pthread_create(&p->_tid, NULL, func, param);
+  if (res == 0)
+    p->_created = 1;
+  return res;
+}
+
+WRes Thread_Wait(CThread *p)
+{
+  WRes res;
+  if (!p->_created)
+    return EINVAL;
+  res = pthread_join(p->_tid, NULL);
+  p->_created = 0;
+  return res;
+}
+
+WRes Thread_Close(CThread *p)
+{
+  /* Thread_Wait() has joined the thread already */
+  if (p->_created)
+  {
+    pthread_detach(p->_tid);
+    p->_created = 0;
+  }
+  return 0;
+}
+
+static WRes Event_Create(CEvent *p, int manualReset, int signaled)
+{
+  WRes res = pthread_mutex_init(&p->_mutex, NULL);
+  if (res != 0)
+    return res;
+  res = pthread_cond_init(&p->_cond, NULL);
+  if (res != 0)
+  {
+    pthread_mutex_destroy(&p->_mutex);
+    return res;
+  }
+  p->_manual_reset = manualReset;
+  p->_state = (signaled ? 1 : 0);
+  p->_created = 1;
+  return 0;
+}
+
+WRes Event_Set(CEvent *p)
+{
+  pthread_mutex_lock(&p->_mutex);
+  p->_state = 1;
+  pthread_cond_broadcast(&p->_cond);
+  pthread_mutex_unlock(&p->_mutex);
+  return 0;
+}
+
+WRes Event_Reset(CEvent *p)
+{
+  pthread_mutex_lock(&p->_mutex);
+  p->_state = 0;
+  pthread_mutex_unlock(&p->_mutex);
+  return 0;
+}
+
+WRes Event_Wait(CEvent *p)
+{
+  pthread_mutex_lock(&p->_mutex);
+  while (p->_state == 0)
+    pthread_cond_wait(&p->_cond, &p->_mutex);
+  if (!p->_manual_reset)
+    p->_state = 0;
+  pthread_mutex_unlock(&p->_mutex);
+  return 0;
+}
+
+WRes Event_Close(CEvent *p)
+{
+  if (p->_created)
+  {
+    p->_created = 0;
+    pthread_cond_destroy(&p->_cond);
+    pthread_mutex_destroy(&p->_mutex);
+  }
+  return 0;
+}
+
+WRes ManualResetEvent_Create(CManualResetEvent *p, int signaled) { return Event_Create(p, 1, signaled); }
+WRes AutoResetEvent_Create(CAutoResetEvent *p, int signaled) { return Event_Create(p, 0, signaled); }
+WRes ManualResetEvent_CreateNotSignaled(CManualResetEvent *p) { return ManualResetEvent_Create(p, 0); }
+WRes AutoResetEvent_CreateNotSignaled(CAutoResetEvent *p) { return AutoResetEvent_Create(p, 0); }
+
+
+WRes Semaphore_Create(CSemaphore *p, UInt32 initCount, UInt32 maxCount)
+{
+  WRes res = pthread_mutex_init(&p->_mutex, NULL);
+  if (res != 0)
+    return res;
+  res = pthread_cond_init(&p->_cond, NULL);
+  if (res != 0)
+  {
+    pthread_mutex_destroy(&p->_mutex);
+    return res;
+  }
+  p->_count = initCount;
+  p->_maxCount = maxCount;
+  p->_created = 1;
+  return 0;
+}
+
+WRes Semaphore_ReleaseN(CSemaphore *p, UInt32 num)
+{
+  WRes res = 0;
+  pthread_mutex_lock(&p->_mutex);
+  if (num > p->_maxCount - p->_count)
+    res = EINVAL;
+  else
+  {
+    p->_count += num;
+    pthread_cond_broadcast(&p->_cond);
+  }
+  pthread_mutex_unlock(&p->_mutex);
+  return res;
+}
+
+WRes Semaphore_Release1(CSemaphore *p) { return Semaphore_ReleaseN(p, 1); }
+
+WRes Semaphore_Wait(CSemaphore *p)
+{
+  pthread_mutex_lock(&p->_mutex);
+  while (p->_count == 0)
+    pthread_cond_wait(&p->_cond, &p->_mutex);
+  p->_count--;
+  pthread_mutex_unlock(&p->_mutex);
+  return 0;
+}
+
+WRes Semaphore_Close(CSemaphore *p)
+{
+  if (p->_created)
+  {
+    p->_created = 0;
+    pthread_cond_destroy(&p->_cond);
+    pthread_mutex_destroy(&p->_mutex);
+  }
+  return 0;
+}
+
+WRes CriticalSection_Init(CCriticalSection *p)
+{
+  return pthread_mutex_init(p, NULL);
+}
+
+#endif
@@ -0,0 +1,261 @@
+/** @file
+  Zstandard Compress/Decompress tool (ZstdCompress)
+
+  The compressed file is one Zstandard frame that records the size of the
+  original data, which is what ZstdCustomDecompressLib expects.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd.h"
+
+#define UTILITY_NAME          "ZstdCompress"
+#define UTILITY_MAJOR_VERSION 0
+#define UTILITY_MINOR_VERSION 1
+
+//
+// Default compression level. The decompression speed hardly depends on it,
+// so the build uses the strongest level that keeps a bounded window.
+//
+#define DEFAULT_LEVEL         19
+
+static int mQuietMode = 0;
+
+static void Version (void)
+{
+  printf ("%s Version %d.%d based on Zstandard %s\n",
+    UTILITY_NAME, UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION, ZSTD_versionString ());
+}
+
+static void Usage (void)
+{
+  printf ("\n" UTILITY_NAME "\n");
+  printf ("Based on Zstandard %s\n", ZSTD_versionString ());
+  printf ("\nUsage:  ZstdCompress -e|-d [options] <inputFile>\n"
+          "  -e: encode file\n"
+          "  -d: decode file\n"
+          "  -o FileName, --output FileName: specify the output filename\n"
+          "  -q Level, --level Level: compression level, 1 - %d (default %d)\n"
+          "  --quiet: do not print messages\n"
+          "  -v, --version: print the tool version\n"
+          "  -h, --help: print this help\n",
+          ZSTD_maxCLevel (), DEFAULT_LEVEL);
+}
+
+static void PrintError (const char *Message, const char *Detail)
+{
+  if (!mQuietMode) {
+    fprintf (stderr, "\n%s: %s", UTILITY_NAME, Message);
+    if (Detail != NULL) {
+      fprintf (stderr, " [%s]", Detail);
+    }
+    fprintf (stderr, "\n");
+  }
+}
+
+static unsigned char *ReadFile (const char *FileName, size_t *Size)
+{
+  FILE          *File;
+  long          Length;
+  unsigned char *Buffer;
+
+  File = fopen (FileName, "rb");
+  if (File == NULL) {
+    return NULL;
+  }
+  Buffer = NULL;
+  if (fseek (File, 0, SEEK_END) == 0 && (Length = ftell (File)) >= 0 && fseek (File, 0, SEEK_SET) == 0) {
+    //
+    // Allocate one byte more so that an empty file is not a NULL buffer.
+    //
+    Buffer = malloc ((size_t) Length + 1);
+    if (Buffer != NULL && fread (Buffer, 1, (size_t) Length, File) != (size_t) Length) {
+      free (Buffer);
+      Buffer = NULL;
+    }
+    *Size = (size_t) Length;
+  }
+  fclose (File);
+  return Buffer;
+}
+
+static int WriteFile (const char *FileName, const void *Buffer, size_t Size)
+{
+  FILE  *File;
+  int   Ok;
+
+  File = fopen (FileName, "wb");
+  if (File == NULL) {
+    return 0;
+  }
+  Ok = (fwrite (Buffer, 1, Size, File) == Size);
+  if (fclose (File) != 0) {
+    Ok = 0;
+  }
+  return Ok;
+}
+
+static int Encode (const unsigned char *Input, size_t InputSize, int Level, void **Output, size_t *OutputSize)
+{
+  ZSTD_CCtx  *CCtx;
+  size_t     Bound;
+  size_t     Result;
+
+  CCtx = ZSTD_createCCtx ();
+  Bound = ZSTD_compressBound (InputSize);
+  *Output = malloc (Bound);
+  if (CCtx == NULL || *Output == NULL) {
+    ZSTD_freeCCtx (CCtx);
+    PrintError ("Can not allocate memory", NULL);
+    return 0;
+  }
+
+  //
+  // The decompressor sizes its output buffer from the frame header, so the
+  // content size must be recorded. A checksum is not needed, the FFS file
+  // has its own.
+  //
+  ZSTD_CCtx_setParameter (CCtx, ZSTD_c_compressionLevel, Level);
+  ZSTD_CCtx_setParameter (CCtx, ZSTD_c_contentSizeFlag, 1);
+  ZSTD_CCtx_setParameter (CCtx, ZSTD_c_checksumFlag, 0);
+  Result = ZSTD_compress2 (CCtx, *Output, Bound, Input, InputSize);
+  ZSTD_freeCCtx (CCtx);
+  if (ZSTD_isError (Result)) {
+    PrintError ("Compression failed", ZSTD_getErrorName (Result));
+    return 0;
+  }
+
+  *OutputSize = Result;
+  return 1;
+}
+
+static int Decode (const unsigned char *Input, size_t InputSize, void **Output, size_t *OutputSize)
+{
+  unsigned long long  ContentSize;
+  size_t              Result;
+
+  ContentSize = ZSTD_getFrameContentSize (Input, InputSize);
+  if (ContentSize == ZSTD_CONTENTSIZE_ERROR || ContentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+      ContentSize != (size_t) ContentSize) {
+    PrintError ("Data error", "The frame does not record its content size");
+    return 0;
+  }
+
+  *Output = malloc ((size_t) ContentSize + 1);
+  if (*Output == NULL) {
+    PrintError ("Can not allocate memory", NULL);
+    return 0;
+  }
+  Result = ZSTD_decompress (*Output, (size_t) ContentSize, Input, InputSize);
+  if (ZSTD_isError (Result) || Result != ContentSize) {
+    PrintError ("Data error", ZSTD_isError (Result) ? ZSTD_getErrorName (Result) : NULL);
+    return 0;
+  }
+
+  *OutputSize = Result;
+  return 1;
+}
+
+int main (int argc, char **argv)
+{
+  int             Encoding;
+  int             Decoding;
+  int             Level;
+  const char      *InputFile;
+  const char      *OutputFile;
+  unsigned char   *Input;
+  size_t          InputSize;
+  void            *Output;
+  size_t          OutputSize;
+  int             Ok;
+  int             Index;
+
+  Encoding   = 0;
+  Decoding   = 0;
+  Level      = DEFAULT_LEVEL;
+  InputFile  = NULL;
+  OutputFile = NULL;
+  Output     = NULL;
+
+  if (argc < 2) {
+    Usage ();
+    return 1;
+  }
+
+  for (Index = 1; Index < argc; Index++) {
+    if (strcmp (argv[Index], "-h") == 0 || strcmp (argv[Index], "--help") == 0) {
+      Usage ();
+      return 0;
+    } else if (strcmp (argv[Index], "-v") == 0 || strcmp (argv[Index], "--version") == 0) {
+      Version ();
+      return 0;
+    } else if (strcmp (argv[Index], "-e") == 0) {
+      Encoding = 1;
+    } else if (strcmp (argv[Index], "-d") == 0) {
+      Decoding = 1;
+    } else if (strcmp (argv[Index], "--quiet") == 0) {
+      mQuietMode = 1;
+    } else if (strcmp (argv[Index], "-o") == 0 || strcmp (argv[Index], "--output") == 0) {
+      if (++Index == argc) {
+        PrintError ("Invalid parameter value", "-o needs a file name");
+        return 1;
+      }
+      OutputFile = argv[Index];
+    } else if (strcmp (argv[Index], "-q") == 0 || strcmp (argv[Index], "--level") == 0) {
+      if (++Index == argc) {
+        PrintError ("Invalid parameter value", "-q needs a level");
+        return 1;
+      }
+      Level = atoi (argv[Index]);
+      if (Level < 1 || Level > ZSTD_maxCLevel ()) {
+        PrintError ("Invalid parameter value", argv[Index]);
+        return 1;
+      }
+    } else if (InputFile == NULL) {
+      InputFile = argv[Index];
+    } else {
+      PrintError ("Invalid parameter value", argv[Index]);
+      return 1;
+    }
+  }
+
+  if (Encoding == Decoding) {
+    PrintError ("Invalid parameter value", "Exactly one of -e and -d must be given");
+    return 1;
+  }
+  if (InputFile == NULL || OutputFile == NULL) {
+    PrintError ("Invalid parameter value", "An input and an output file must be given");
+    return 1;
+  }
+
+  Input = ReadFile (InputFile, &InputSize);
+  if (Input == NULL) {
+    PrintError ("Can not read input file", InputFile);
+    return 1;
+  }
+
+  if (Encoding) {
+    Ok = Encode (Input, InputSize, Level, &Output, &OutputSize);
+  } else {
+    Ok = Decode (Input, InputSize, &Output, &OutputSize);
+  }
+  if (Ok && !WriteFile (OutputFile, Output, OutputSize)) {
+    PrintError ("Can not write output file", OutputFile);
+    Ok = 0;
+  }
+  if (Ok && Encoding && !mQuietMode) {
+    printf ("%s: %lu bytes compressed to %lu bytes\n", UTILITY_NAME, (unsigned long) InputSize, (unsigned long) OutputSize);
+  }
+
+  free (Input);
+  free (Output);
+  return !Ok;
+}
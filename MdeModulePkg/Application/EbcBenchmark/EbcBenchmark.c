@@ -0,0 +1,359 @@
+/** @file
+  UEFI Application with micro-benchmarks for the EBC interpreter.
+
+  The application runs a few small kernels - arithmetic, a byte copy loop,
+  branches, function calls, and array of structure accesses - for one second
+  each, and prints how many work units per second it completed. Build it for
+  EBC and for the native architecture of a platform that includes EbcDxe, and
+  compare the two results, or the EBC results with different settings of
+  PcdEbcTranslationCacheSize and PcdEbcJitEnable.
+
+  Each kernel is also run a fixed number of times before it is timed, and the
+  checksum of these runs is printed. It must be the same for all settings, and
+  for native code of the same word size.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+///
+/// Time each kernel runs for, in 100ns units.
+///
+#define EBC_BENCHMARK_PERIOD      10000000
+
+///
+/// Size of the buffers of the copy kernel.
+///
+#define EBC_BENCHMARK_COPY_SIZE   4096
+
+///
+/// Number of entries of the array of the structure kernel.
+///
+#define EBC_BENCHMARK_ITEMS       64
+
+///
+/// Number of calls to Fibonacci() of the call kernel, for a depth of 12.
+///
+#define EBC_BENCHMARK_FIB_CALLS   465
+
+///
+/// Number of runs of each kernel the printed checksum is computed from.
+///
+#define EBC_BENCHMARK_CHECK_RUNS  16
+
+typedef struct {
+  UINT32    Key;
+  UINT16    Flags;
+  UINT16    Count;
+  UINT64    Sum;
+} EBC_BENCHMARK_ITEM;
+
+/**
+  Run the kernel once.
+
+  @param[in] Seed   A value the work depends on, so that it cannot be folded
+                    by the compiler.
+
+  @return A checksum of the work.
+**/
+typedef
+UINTN
+(*EBC_BENCHMARK_KERNEL) (
+  IN UINTN  Seed
+  );
+
+typedef struct {
+  CHAR16                  *Name;
+  CHAR16                  *Unit;
+  EBC_BENCHMARK_KERNEL    Kernel;
+  UINTN                   UnitsPerRun;
+} EBC_BENCHMARK;
+
+UINT8               mSource[EBC_BENCHMARK_COPY_SIZE];
+UINT8               mDestination[EBC_BENCHMARK_COPY_SIZE];
+EBC_BENCHMARK_ITEM  mItems[EBC_BENCHMARK_ITEMS];
+UINTN               mFibonacciDepth = 12;
+UINTN               mChecksum;
+
+/**
+  Integer arithmetic on local variables.
+
+  @param[in] Seed   A value the work depends on.
+
+  @return A checksum of the work.
+**/
+UINTN
+ArithmeticKernel (
+  IN UINTN  Seed
+  )
+{
+  UINT32  Value32;
+  UINT64  Value64;
+  UINTN   Index;
+
+  Value32 = (UINT32) Seed;
+  Value64 = Seed;
+  for (Index = 0; Index < 256; Index++) {
+    Value32 = Value32 * 1664525 + 1013904223;
+    Value64 = (Value64 ^ Value32) + LShiftU64 (Value64, 3) - RShiftU64 (Value64, 7);
+    Value32 = (Value32 ^ (Value32 >> 11)) | (UINT32) Index;
+  }
+
+  return (UINTN) (Value64 + Value32);
+}
+
+/**
+  Copy a buffer one byte at a time.
+
+  @param[in] Seed   A value the work depends on.
+
+  @return A checksum of the work.
+**/
+UINTN
+CopyKernel (
+  IN UINTN  Seed
+  )
+{
+  UINTN  Index;
+
+  mSource[Seed % EBC_BENCHMARK_COPY_SIZE] = (UINT8) Seed;
+  for (Index = 0; Index < EBC_BENCHMARK_COPY_SIZE; Index++) {
+    mDestination[Index] = mSource[Index];
+  }
+
+  return mDestination[Seed % EBC_BENCHMARK_COPY_SIZE];
+}
+
+/**
+  Data dependent branches.
+
+  @param[in] Seed   A value the work depends on.
+
+  @return A checksum of the work.
+**/
+UINTN
+BranchKernel (
+  IN UINTN  Seed
+  )
+{
+  UINTN  Value;
+  UINTN  Index;
+  UINTN  Count;
+
+  Value = Seed | 1;
+  Count = 0;
+  for (Index = 0; Index < 256; Index++) {
+    if ((Value & 1) != 0) {
+      Value = Value * 3 + 1;
+      Count++;
+    } else if ((Value & 2) != 0) {
+      Value = Value >> 1;
+    } else if (Value > 1000) {
+      Value = Value / 4;
+      Count += 2;
+    } else {
+      Value = Value + Index;
+    }
+  }
+
+  return Value + Count;
+}
+
+/**
+  Compute a Fibonacci number recursively.
+
+  @param[in] Number   The index of the Fibonacci number.
+
+  @return The Fibonacci number.
+**/
+UINTN
+Fibonacci (
+  IN UINTN  Number
+  )
+{
+  if (Number < 2) {
+    return Number;
+  }
+
+  return Fibonacci (Number - 1) + Fibonacci (Number - 2);
+}
+
+/**
+  Function calls.
+
+  @param[in] Seed   A value the work depends on.
+
+  @return A checksum of the work.
+**/
+UINTN
+CallKernel (
+  IN UINTN  Seed
+  )
+{
+  return Fibonacci (mFibonacciDepth) + Seed;
+}
+
+/**
+  Indexed accesses to an array of structures.
+
+  @param[in] Seed   A value the work depends on.
+
+  @return A checksum of the work.
+**/
+UINTN
+StructureKernel (
+  IN UINTN  Seed
+  )
+{
+  UINTN               Index;
+  UINTN               Round;
+  EBC_BENCHMARK_ITEM  *Item;
+  UINT64              Total;
+
+  Total = 0;
+  for (Round = 0; Round < 4; Round++) {
+    for (Index = 0; Index < EBC_BENCHMARK_ITEMS; Index++) {
+      Item = &mItems[(Index * 7 + Seed) % EBC_BENCHMARK_ITEMS];
+      Item->Key   += (UINT32) Index;
+      Item->Flags ^= (UINT16) Round;
+      Item->Count++;
+      Item->Sum   += Item->Key + Item->Flags;
+      Total       += Item->Sum;
+    }
+  }
+
+  return (UINTN) Total;
+}
+
+EBC_BENCHMARK  mBenchmarks[] = {
+  { L"Arithmetic", L"loops",  ArithmeticKernel, 256                       },
+  { L"Byte copy",  L"bytes",  CopyKernel,       EBC_BENCHMARK_COPY_SIZE   },
+  { L"Branches",   L"loops",  BranchKernel,     256                       },
+  { L"Calls",      L"calls",  CallKernel,       EBC_BENCHMARK_FIB_CALLS   },
+  { L"Structures", L"items",  StructureKernel,  4 * EBC_BENCHMARK_ITEMS   }
+};
+
+/**
+  Run a kernel a fixed number of times. The kernels only change data of their
+  own, so the result does not depend on the kernels run before.
+
+  @param[in] Benchmark    The benchmark to run.
+
+  @return The checksum of the runs.
+**/
+UINTN
+CheckBenchmark (
+  IN EBC_BENCHMARK  *Benchmark
+  )
+{
+  UINTN  Checksum;
+  UINTN  Index;
+
+  Checksum = 0;
+  for (Index = 0; Index < EBC_BENCHMARK_CHECK_RUNS; Index++) {
+    Checksum += Benchmark->Kernel (Checksum + Index);
+  }
+
+  return Checksum;
+}
+
+/**
+  Run a kernel repeatedly until the timer event is signaled.
+
+  @param[in]  Benchmark   The benchmark to run.
+  @param[in]  TimerEvent  The timer event.
+  @param[out] Runs        The number of times the kernel ran.
+
+  @retval EFI_SUCCESS     The benchmark ran for EBC_BENCHMARK_PERIOD.
+  @retval Others          The timer could not be set.
+**/
+EFI_STATUS
+RunBenchmark (
+  IN  EBC_BENCHMARK  *Benchmark,
+  IN  EFI_EVENT      TimerEvent,
+  OUT UINTN          *Runs
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Checksum;
+
+  *Runs    = 0;
+  Checksum = 0;
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, EBC_BENCHMARK_PERIOD);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  while (gBS->CheckEvent (TimerEvent) == EFI_NOT_READY) {
+    Checksum += Benchmark->Kernel (Checksum + *Runs);
+    *Runs    += 1;
+  }
+
+  //
+  // Keep the checksum alive so that the kernels are not optimized away.
+  //
+  mChecksum = Checksum;
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the application.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   TimerEvent;
+  UINTN       Index;
+  UINTN       Runs;
+  UINTN       Checksum;
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_APPLICATION, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+#if defined (MDE_CPU_EBC)
+  Print (L"EBC micro-benchmarks, interpreted\n");
+#else
+  Print (L"EBC micro-benchmarks, native\n");
+#endif
+  Print (L"%-12s %18s %12s %14s\n", L"Kernel", L"Checksum", L"Runs/s", L"Units/s");
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchmarks); Index++) {
+    Checksum = CheckBenchmark (&mBenchmarks[Index]);
+    Status   = RunBenchmark (&mBenchmarks[Index], TimerEvent, &Runs);
+    if (EFI_ERROR (Status)) {
+      Print (L"%-12s failed - %r\n", mBenchmarks[Index].Name, Status);
+      break;
+    }
+    Print (
+      L"%-12s %18lx %12ld %14ld %s\n",
+      mBenchmarks[Index].Name,
+      (UINT64) Checksum,
+      (UINT64) Runs,
+      MultU64x32 (Runs, (UINT32) mBenchmarks[Index].UnitsPerRun),
+      mBenchmarks[Index].Unit
+      );
+  }
+
+  gBS->CloseEvent (TimerEvent);
+  return Status;
+}
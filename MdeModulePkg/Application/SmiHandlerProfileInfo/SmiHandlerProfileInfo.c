@@ -612,6 +612,9 @@ DumpSmiHandler(
           Print(L"         <RVA>0x%x</RVA>\n", (UINTN) (SmiHandlerStruct->CallerAddr - ImageStruct->ImageBase));
         }
         Print(L"      </Caller>\n", SmiHandlerStruct->Handler);
+        if ((SmiStruct->Header.Revision >= 0x0002) && (SmiHandlerStruct->InvocationCount != 0)) {
+          Print(L"      <Profile InvocationCount=\"%ld\" TotalTicks=\"%ld\"/>\n", SmiHandlerStruct->InvocationCount, SmiHandlerStruct->TotalTicks);
+        }
         SmiHandlerStruct = (VOID *)((UINTN)SmiHandlerStruct + SmiHandlerStruct->Length);
         Print(L"    </SmiHandler>\n");
       }
@@ -360,6 +360,72 @@ ContainEfiImage (
   return FALSE;
 }
 
+/**
+  Read a range of the Option Rom of a PCI device.
+
+  Byte reads cost one MMIO transaction per byte, so the dword aligned part of
+  the range is read a dword at a time.
+
+  @param PciDevice Pci device instance.
+  @param Address   Address of the range in the Option Rom BAR.
+  @param Length    Size of the range in bytes.
+  @param Buffer    Buffer to receive the data.
+
+  @retval EFI_SUCCESS  The range was read.
+  @retval Others       The PCI root bridge memory read failed.
+
+**/
+EFI_STATUS
+ReadOpRom (
+  IN  PCI_IO_DEVICE  *PciDevice,
+  IN  UINT64         Address,
+  IN  UINTN          Length,
+  OUT VOID           *Buffer
+  )
+{
+  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *RootBridgeIo;
+  UINT8                            *Data;
+  UINTN                            Count;
+  EFI_STATUS                       Status;
+
+  RootBridgeIo = PciDevice->PciRootBridgeIo;
+  Data         = (UINT8 *) Buffer;
+
+  //
+  // Leading bytes up to the first dword boundary
+  //
+  Count = MIN ((UINTN) (ALIGN_VALUE (Address, sizeof (UINT32)) - Address), Length);
+  if (Count > 0) {
+    Status = RootBridgeIo->Mem.Read (RootBridgeIo, EfiPciWidthUint8, Address, Count, Data);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Address += Count;
+    Data    += Count;
+    Length  -= Count;
+  }
+
+  Count = Length / sizeof (UINT32);
+  if (Count > 0) {
+    Status = RootBridgeIo->Mem.Read (RootBridgeIo, EfiPciWidthUint32, Address, Count, Data);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Address += Count * sizeof (UINT32);
+    Data    += Count * sizeof (UINT32);
+    Length  -= Count * sizeof (UINT32);
+  }
+
+  //
+  // Trailing bytes
+  //
+  if (Length > 0) {
+    return RootBridgeIo->Mem.Read (RootBridgeIo, EfiPciWidthUint8, Address, Length, Data);
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Load Option Rom image for specified PCI device.
 
@@ -444,13 +510,7 @@ LoadOpRomImage (
   LegacyImageLength = 0;
 
   do {
-    PciDevice->PciRootBridgeIo->Mem.Read (
-                                      PciDevice->PciRootBridgeIo,
-                                      EfiPciWidthUint8,
-                                      RomBarOffset,
-                                      sizeof (PCI_EXPANSION_ROM_HEADER),
-                                      (UINT8 *) RomHeader
-                                      );
+    ReadOpRom (PciDevice, RomBarOffset, sizeof (PCI_EXPANSION_ROM_HEADER), RomHeader);
 
     if (RomHeader->Signature != PCI_EXPANSION_ROM_HEADER_SIGNATURE) {
       RomBarOffset = RomBarOffset + 512;
@@ -473,13 +533,7 @@ LoadOpRomImage (
         RomImageSize + OffsetPcir + sizeof (PCI_DATA_STRUCTURE) > RomSize) {
       break;
     }
-    PciDevice->PciRootBridgeIo->Mem.Read (
-                                      PciDevice->PciRootBridgeIo,
-                                      EfiPciWidthUint8,
-                                      RomBarOffset + OffsetPcir,
-                                      sizeof (PCI_DATA_STRUCTURE),
-                                      (UINT8 *) RomPcir
-                                      );
+    ReadOpRom (PciDevice, RomBarOffset + OffsetPcir, sizeof (PCI_DATA_STRUCTURE), RomPcir);
     //
     // If a valid signature is not present in the PCI Data Structure, no further images can be located.
     //
@@ -519,13 +573,7 @@ LoadOpRomImage (
     //
     // Copy Rom image into memory
     //
-    PciDevice->PciRootBridgeIo->Mem.Read (
-                                      PciDevice->PciRootBridgeIo,
-                                      EfiPciWidthUint8,
-                                      RomBar,
-                                      (UINT32) RomImageSize,
-                                      Image
-                                      );
+    ReadOpRom (PciDevice, RomBar, (UINTN) RomImageSize, Image);
     RomInMemory = Image;
   }
 
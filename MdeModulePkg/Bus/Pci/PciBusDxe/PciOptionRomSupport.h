@@ -85,6 +85,29 @@ GetOpRomInfo (
   IN OUT PCI_IO_DEVICE    *PciIoDevice
   );
 
+/**
+  Read a range of the Option Rom of a PCI device.
+
+  Byte reads cost one MMIO transaction per byte, so the dword aligned part of
+  the range is read a dword at a time.
+
+  @param PciDevice Pci device instance.
+  @param Address   Address of the range in the Option Rom BAR.
+  @param Length    Size of the range in bytes.
+  @param Buffer    Buffer to receive the data.
+
+  @retval EFI_SUCCESS  The range was read.
+  @retval Others       The PCI root bridge memory read failed.
+
+**/
+EFI_STATUS
+ReadOpRom (
+  IN  PCI_IO_DEVICE  *PciDevice,
+  IN  UINT64         Address,
+  IN  UINTN          Length,
+  OUT VOID           *Buffer
+  );
+
 /**
   Load Option Rom image for specified PCI device.
 
@@ -1289,6 +1289,174 @@ ON_EXIT:
   return Status;
 }
 
+/**
+  Submits several bulk transfers to the bulk endpoints of a USB device, and
+  waits until all of them have completed, one of them has failed, or the
+  timeout has expired.
+
+  The TDs of all the transfers are put on the transfer rings before any
+  doorbell is rung, so the xHC can move on to the next transfer of an endpoint
+  without waiting for software.
+
+  @param  This                  This EDKII_USB2_HC_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  Count                 Number of entries in Entries.
+  @param  Entries               The transfers to execute, in order.
+  @param  Timeout               Indicates the maximum time, in millisecond, which
+                                the transfers are allowed to complete.
+  @param  Translator            A pointr to the transaction translator data.
+
+  @retval EFI_SUCCESS           The transfers were completed successfully.
+  @retval EFI_OUT_OF_RESOURCES  The transfers don't fit in the transfer rings.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_TIMEOUT           The transfers failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed due to host controller or
+                                device error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueTransfer (
+  IN     EDKII_USB2_HC_BULK_QUEUE_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY          *Entries,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  )
+{
+  USB_XHCI_INSTANCE       *Xhc;
+  URB                     *Urbs[XHC_BULK_QUEUE_MAX_ENTRIES];
+  UINTN                   UrbCount;
+  UINTN                   TrbNum;
+  UINTN                   Index;
+  UINT8                   SlotId;
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+
+  //
+  // Validate the parameters
+  //
+  if ((Entries == NULL) || (Count == 0) || (Count > XHC_BULK_QUEUE_MAX_ENTRIES) ||
+      (DeviceSpeed == EFI_USB_SPEED_LOW)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  TrbNum = 0;
+  for (Index = 0; Index < Count; Index++) {
+    if ((Entries[Index].Data == NULL) || (Entries[Index].DataLength == 0)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if (((DeviceSpeed == EFI_USB_SPEED_FULL) && (Entries[Index].MaximumPacketLength > 64)) ||
+        ((EFI_USB_SPEED_HIGH == DeviceSpeed) && (Entries[Index].MaximumPacketLength > 512)) ||
+        ((EFI_USB_SPEED_SUPER == DeviceSpeed) && (Entries[Index].MaximumPacketLength > 1024))) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    //
+    // A bulk TD takes one TRB per 64KB. All the TDs must fit in a transfer
+    // ring together with its link TRB.
+    //
+    TrbNum += Entries[Index].DataLength / 0x10000 + 1;
+    if (TrbNum >= TR_RING_TRB_NUMBER - 1) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc      = XHC_FROM_BULK_QUEUE (This);
+  UrbCount = 0;
+  Status   = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkQueueTransfer: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  //
+  // Check if the device is still enabled before every transaction.
+  //
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  //
+  // Put the TDs of all the transfers on the transfer rings, then ring the
+  // doorbells and poll the execution status of all of them together.
+  //
+  Status = EFI_SUCCESS;
+  for (UrbCount = 0; UrbCount < Count; UrbCount++) {
+    Urbs[UrbCount] = XhcCreateUrb (
+                       Xhc,
+                       DeviceAddress,
+                       Entries[UrbCount].EndPointAddress,
+                       DeviceSpeed,
+                       Entries[UrbCount].MaximumPacketLength,
+                       XHC_BULK_TRANSFER,
+                       NULL,
+                       Entries[UrbCount].Data,
+                       Entries[UrbCount].DataLength,
+                       NULL,
+                       NULL
+                       );
+    if (Urbs[UrbCount] == NULL) {
+      DEBUG ((DEBUG_ERROR, "XhcBulkQueueTransfer: failed to create URB!\n"));
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+    InsertTailList (&Xhc->BulkQueueUrbs, &Urbs[UrbCount]->UrbList);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = XhcExecTransferQueue (Xhc, Urbs, UrbCount, Timeout);
+  }
+
+  if (EFI_ERROR (Status)) {
+    XhcAbortTransferQueue (Xhc, Urbs, UrbCount);
+    if (Status == EFI_TIMEOUT) {
+      //
+      // The URBs may have finished just before their endpoints stopped.
+      //
+      for (Index = 0; Index < UrbCount; Index++) {
+        if (Urbs[Index]->Result != EFI_USB_NOERROR) {
+          break;
+        }
+      }
+      if (Index == UrbCount) {
+        Status = EFI_SUCCESS;
+      }
+    }
+  }
+
+  Xhc->PciIo->Flush (Xhc->PciIo);
+
+ON_EXIT:
+  for (Index = 0; Index < Count; Index++) {
+    if (Index < UrbCount) {
+      Entries[Index].DataLength     = Urbs[Index]->Completed;
+      Entries[Index].TransferResult = Urbs[Index]->Result;
+      RemoveEntryList (&Urbs[Index]->UrbList);
+      XhcFreeUrb (Xhc, Urbs[Index]);
+    } else {
+      Entries[Index].DataLength     = 0;
+      Entries[Index].TransferResult = (Status == EFI_OUT_OF_RESOURCES) ? EFI_USB_ERR_NOTEXECUTE : EFI_USB_ERR_SYSTEM;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkQueueTransfer: error - %r\n", Status));
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
@@ -1766,6 +1934,8 @@ XhcCreateUsbHc (
   Xhc->DevicePath            = DevicePath;
   Xhc->OriginalPciAttributes = OriginalPciAttributes;
   CopyMem (&Xhc->Usb2Hc, &gXhciUsb2HcTemplate, sizeof (EFI_USB2_HC_PROTOCOL));
+  Xhc->BulkQueue.QueueTransfer = XhcBulkQueueTransfer;
+  Xhc->BulkQueue.MaxEntries    = XHC_BULK_QUEUE_MAX_ENTRIES;
 
   Status = PciIo->Pci.Read (
                         PciIo,
@@ -1781,6 +1951,8 @@ XhcCreateUsbHc (
   }
 
   InitializeListHead (&Xhc->AsyncIntTransfers);
+  InitializeListHead (&Xhc->BulkQueueUrbs);
+  InitializeListHead (&Xhc->UrbPool);
 
   //
   // Be caution that the Offset passed to XhcReadCapReg() should be Dword align
@@ -2071,11 +2243,13 @@ XhcDriverBindingStart (
     FALSE
     );
 
-  Status = gBS->InstallProtocolInterface (
+  Status = gBS->InstallMultipleProtocolInterfaces (
                   &Controller,
                   &gEfiUsb2HcProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  &Xhc->Usb2Hc
+                  &Xhc->Usb2Hc,
+                  &gEdkiiUsb2HcBulkQueueProtocolGuid,
+                  &Xhc->BulkQueue,
+                  NULL
                   );
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "XhcDriverBindingStart: failed to install USB2_HC Protocol\n"));
@@ -2160,17 +2334,21 @@ XhcDriverBindingStop (
     return Status;
   }
 
-  Status = gBS->UninstallProtocolInterface (
+  Xhc   = XHC_FROM_THIS (Usb2Hc);
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (
                   Controller,
                   &gEfiUsb2HcProtocolGuid,
-                  Usb2Hc
+                  Usb2Hc,
+                  &gEdkiiUsb2HcBulkQueueProtocolGuid,
+                  &Xhc->BulkQueue,
+                  NULL
                   );
 
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  Xhc   = XHC_FROM_THIS (Usb2Hc);
   PciIo = Xhc->PciIo;
 
   //
@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Uefi.h>
 
 #include <Protocol/Usb2HostController.h>
+#include <Protocol/UsbBulkQueue.h>
 #include <Protocol/PciIo.h>
 
 #include <Guid/EventGroup.h>
@@ -72,6 +73,16 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 //
 #define XHC_TPL                      TPL_NOTIFY
 
+//
+// Number of free URBs each XHC instance keeps for reuse.
+//
+#define XHC_URB_POOL_SIZE            16
+
+//
+// The most bulk transfers XhcBulkQueueTransfer() takes in one call.
+//
+#define XHC_BULK_QUEUE_MAX_ENTRIES   16
+
 #define CMD_RING_TRB_NUMBER          0x100
 #define TR_RING_TRB_NUMBER           0x100
 #define ERST_NUMBER                  0x01
@@ -96,6 +107,7 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 
 #define XHCI_INSTANCE_SIG              SIGNATURE_32 ('x', 'h', 'c', 'i')
 #define XHC_FROM_THIS(a)               CR(a, USB_XHCI_INSTANCE, Usb2Hc, XHCI_INSTANCE_SIG)
+#define XHC_FROM_BULK_QUEUE(a)         CR(a, USB_XHCI_INSTANCE, BulkQueue, XHCI_INSTANCE_SIG)
 
 #define USB_DESC_TYPE_HUB              0x29
 #define USB_DESC_TYPE_HUB_SUPER_SPEED  0x2a
@@ -200,6 +212,7 @@ struct _USB_XHCI_INSTANCE {
   USBHC_MEM_POOL            *MemPool;
 
   EFI_USB2_HC_PROTOCOL      Usb2Hc;
+  EDKII_USB2_HC_BULK_QUEUE_PROTOCOL  BulkQueue;
 
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
 
@@ -210,6 +223,15 @@ struct _USB_XHCI_INSTANCE {
   EFI_EVENT                 ExitBootServiceEvent;
   EFI_EVENT                 PollTimer;
   LIST_ENTRY                AsyncIntTransfers;
+  //
+  // Bulk URBs queued by XhcBulkQueueTransfer() that have not been reaped.
+  //
+  LIST_ENTRY                BulkQueueUrbs;
+  //
+  // Free URBs kept for reuse.
+  //
+  LIST_ENTRY                UrbPool;
+  UINTN                     UrbPoolCount;
 
   UINT8                     CapLength;    ///< Capability Register Length
   XHC_HCSPARAMS1            HcSParams1;   ///< Structural Parameters 1
@@ -555,6 +577,45 @@ XhcBulkTransfer (
   OUT    UINT32                              *TransferResult
   );
 
+/**
+  Submits several bulk transfers to the bulk endpoints of a USB device, and
+  waits until all of them have completed, one of them has failed, or the
+  timeout has expired.
+
+  The TDs of all the transfers are put on the transfer rings before any
+  doorbell is rung, so the xHC can move on to the next transfer of an endpoint
+  without waiting for software.
+
+  @param  This                  This EDKII_USB2_HC_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  Count                 Number of entries in Entries.
+  @param  Entries               The transfers to execute, in order.
+  @param  Timeout               Indicates the maximum time, in millisecond, which
+                                the transfers are allowed to complete.
+  @param  Translator            A pointr to the transaction translator data.
+
+  @retval EFI_SUCCESS           The transfers were completed successfully.
+  @retval EFI_OUT_OF_RESOURCES  The transfers don't fit in the transfer rings.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_TIMEOUT           The transfers failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed due to host controller or
+                                device error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueTransfer (
+  IN     EDKII_USB2_HC_BULK_QUEUE_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY          *Entries,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  );
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
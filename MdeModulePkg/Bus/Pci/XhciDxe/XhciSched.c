@@ -10,6 +10,70 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Xhci.h"
 
+/**
+  Take an URB from the URB pool of the XHCI instance, or allocate a new one
+  if the pool is empty. The pool is accessed at XHC_TPL, the TPL of the
+  asynchronous transfer monitor, whichever TPL the caller runs at.
+
+  @param  Xhc       The XHCI Instance.
+
+  @return A zeroed URB, or NULL if there is not enough memory.
+
+**/
+URB*
+XhcAllocateUrb (
+  IN USB_XHCI_INSTANCE  *Xhc
+  )
+{
+  URB             *Urb;
+  EFI_TPL         OldTpl;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+  if (IsListEmpty (&Xhc->UrbPool)) {
+    gBS->RestoreTPL (OldTpl);
+    return AllocateZeroPool (sizeof (URB));
+  }
+
+  Urb = EFI_LIST_CONTAINER (GetFirstNode (&Xhc->UrbPool), URB, UrbList);
+  RemoveEntryList (&Urb->UrbList);
+  Xhc->UrbPoolCount--;
+  gBS->RestoreTPL (OldTpl);
+
+  ZeroMem (Urb, sizeof (URB));
+  return Urb;
+}
+
+/**
+  Return an URB to the URB pool of the XHCI instance, or free it if the pool
+  is full.
+
+  @param  Xhc       The XHCI Instance.
+  @param  Urb       The URB to release. It must not be on any list.
+
+**/
+VOID
+XhcReleaseUrb (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN URB                *Urb
+  )
+{
+  EFI_TPL         OldTpl;
+
+  Urb->Signature = 0;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+  if (Xhc->UrbPoolCount < XHC_URB_POOL_SIZE) {
+    InsertHeadList (&Xhc->UrbPool, &Urb->UrbList);
+    Xhc->UrbPoolCount++;
+    Urb = NULL;
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  if (Urb != NULL) {
+    FreePool (Urb);
+  }
+}
+
 /**
   Create a command transfer TRB to support XHCI command interfaces.
 
@@ -27,7 +91,7 @@ XhcCreateCmdTrb (
 {
   URB    *Urb;
 
-  Urb = AllocateZeroPool (sizeof (URB));
+  Urb = XhcAllocateUrb (Xhc);
   if (Urb == NULL) {
     return NULL;
   }
@@ -147,7 +211,7 @@ XhcCreateUrb (
   EFI_STATUS                    Status;
   URB                           *Urb;
 
-  Urb = AllocateZeroPool (sizeof (URB));
+  Urb = XhcAllocateUrb (Xhc);
   if (Urb == NULL) {
     return NULL;
   }
@@ -173,7 +237,7 @@ XhcCreateUrb (
   ASSERT_EFI_ERROR (Status);
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "XhcCreateUrb: XhcCreateTransferTrb Failed, Status = %r\n", Status));
-    FreePool (Urb);
+    XhcReleaseUrb (Xhc, Urb);
     Urb = NULL;
   }
 
@@ -201,7 +265,7 @@ XhcFreeUrb (
     Xhc->PciIo->Unmap (Xhc->PciIo, Urb->DataMap);
   }
 
-  FreePool (Urb);
+  XhcReleaseUrb (Xhc, Urb);
 }
 
 /**
@@ -473,6 +537,7 @@ XhcInitSched (
   EFI_PHYSICAL_ADDRESS  ScratchEntryPhy;
   UINT32                Index;
   UINTN                 *ScratchEntryMap;
+  URB                   *Urb;
   EFI_STATUS            Status;
 
   //
@@ -620,6 +685,17 @@ XhcInitSched (
     Xhc->CmdRing.RingSeg0,        (UINTN)Xhc->CmdRing.RingSeg0 + sizeof (TRB_TEMPLATE) * CMD_RING_TRB_NUMBER,
     Xhc->EventRing.EventRingSeg0, (UINTN)Xhc->EventRing.EventRingSeg0 + sizeof (TRB_TEMPLATE) * EVENT_RING_TRB_NUMBER
     ));
+
+  //
+  // Fill the URB pool, so that commands and transfers don't allocate memory.
+  //
+  while (Xhc->UrbPoolCount < XHC_URB_POOL_SIZE) {
+    Urb = AllocateZeroPool (sizeof (URB));
+    if (Urb == NULL) {
+      break;
+    }
+    XhcReleaseUrb (Xhc, Urb);
+  }
 }
 
 /**
@@ -948,6 +1024,14 @@ XhcFreeSched (
 {
   UINT32                  Index;
   UINT64                  *ScratchEntry;
+  URB                     *Urb;
+
+  while (!IsListEmpty (&Xhc->UrbPool)) {
+    Urb = EFI_LIST_CONTAINER (GetFirstNode (&Xhc->UrbPool), URB, UrbList);
+    RemoveEntryList (&Urb->UrbList);
+    FreePool (Urb);
+  }
+  Xhc->UrbPoolCount = 0;
 
   if (Xhc->ScratchBuf != NULL) {
     ScratchEntry = Xhc->ScratchEntry;
@@ -1063,6 +1147,38 @@ IsAsyncIntTrb (
   return FALSE;
 }
 
+/**
+  Check if the Trb is a transaction of the URBs queued by XhcBulkQueueTransfer().
+
+  @param Xhc    The XHCI Instance.
+  @param Trb    The TRB to be checked.
+  @param Urb    The pointer to the matched Urb.
+
+  @retval TRUE  The Trb is matched with a transaction of the queued URBs.
+  @retval FALSE The Trb is not matched with any queued URBs.
+
+**/
+BOOLEAN
+IsBulkQueueTrb (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  TRB_TEMPLATE        *Trb,
+  OUT URB                 **Urb
+  )
+{
+  LIST_ENTRY              *Entry;
+  URB                     *CheckedUrb;
+
+  BASE_LIST_FOR_EACH (Entry, &Xhc->BulkQueueUrbs) {
+    CheckedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (IsTransferRingTrb (Xhc, Trb, CheckedUrb)) {
+      *Urb = CheckedUrb;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 
 /**
   Check the URB's execution result and update the URB's
@@ -1086,6 +1202,7 @@ XhcCheckUrbResult (
   UINT8                   TRBType;
   EFI_STATUS              Status;
   URB                     *AsyncUrb;
+  URB                     *QueuedUrb;
   URB                     *CheckedUrb;
   UINT64                  XhcDequeue;
   UINT32                  High;
@@ -1136,14 +1253,16 @@ XhcCheckUrbResult (
 
     //
     // Update the status of URB including the pending URB, the URB that is currently checked,
-    // and URBs in the XHCI's async interrupt transfer list.
-    // This way is used to avoid that those completed async transfer events don't get
+    // the queued bulk URBs and URBs in the XHCI's async interrupt transfer list.
+    // This way is used to avoid that those completed transfer events don't get
     // handled in time and are flushed by newer coming events.
     //
     if (Xhc->PendingUrb != NULL && IsTransferRingTrb (Xhc, TRBPtr, Xhc->PendingUrb)) {
       CheckedUrb = Xhc->PendingUrb;
     } else if (IsTransferRingTrb (Xhc, TRBPtr, Urb)) {
       CheckedUrb = Urb;
+    } else if (IsBulkQueueTrb (Xhc, TRBPtr, &QueuedUrb)) {
+      CheckedUrb = QueuedUrb;
     } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {
       CheckedUrb = AsyncUrb;
     } else {
@@ -1350,6 +1469,192 @@ DONE:
   return Status;
 }
 
+/**
+  Ring the doorbells of queued bulk URBs, then poll the event ring until all
+  of them have finished, one of them has failed, or the timeout expires.
+
+  The events of all the URBs are handled in each pass over the event ring, so
+  that URBs that finish while an earlier one is still running are completed
+  at once.
+
+  @param  Xhc             The XHCI Instance.
+  @param  Urbs            The URBs, in the order they were queued.
+  @param  Count           The number of URBs.
+  @param  Timeout         The time to wait before abort, in millisecond.
+
+  @retval EFI_SUCCESS       All the URBs finished successfully.
+  @retval EFI_DEVICE_ERROR  An URB failed.
+  @retval EFI_TIMEOUT       The URBs did not finish in time.
+  @retval Others            The timer could not be set up.
+
+**/
+EFI_STATUS
+XhcExecTransferQueue (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 **Urbs,
+  IN  UINTN               Count,
+  IN  UINTN               Timeout
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   Index;
+  UINTN                   Prev;
+  UINT8                   SlotId;
+  UINT8                   Dci;
+  EFI_EVENT               TimeoutEvent;
+  BOOLEAN                 IndefiniteTimeout;
+
+  Status            = EFI_SUCCESS;
+  TimeoutEvent      = NULL;
+  IndefiniteTimeout = FALSE;
+  Index             = 0;
+
+  if (Timeout == 0) {
+    IndefiniteTimeout = TRUE;
+  } else {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER,
+                    TPL_CALLBACK,
+                    NULL,
+                    NULL,
+                    &TimeoutEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      goto DONE;
+    }
+
+    Status = gBS->SetTimer (TimeoutEvent,
+                            TimerRelative,
+                            EFI_TIMER_PERIOD_MILLISECONDS(Timeout));
+    if (EFI_ERROR (Status)) {
+      goto DONE;
+    }
+  }
+
+  //
+  // Ring the doorbell of each endpoint once.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    for (Prev = 0; Prev < Index; Prev++) {
+      if (Urbs[Prev]->Ring == Urbs[Index]->Ring) {
+        break;
+      }
+    }
+    if (Prev == Index) {
+      SlotId = XhcBusDevAddrToSlotId (Xhc, Urbs[Index]->Ep.BusAddr);
+      Dci    = XhcEndpointToDci (Urbs[Index]->Ep.EpAddr, (UINT8)(Urbs[Index]->Ep.Direction));
+      XhcRingDoorBell (Xhc, SlotId, Dci);
+    }
+  }
+
+  //
+  // Wait for the URBs in order. The URBs after the one that is waited for are
+  // completed by the same passes over the event ring.
+  //
+  Index = 0;
+  do {
+    XhcCheckUrbResult (Xhc, Urbs[Index]);
+    while ((Index < Count) && Urbs[Index]->Finished && (Urbs[Index]->Result == EFI_USB_NOERROR)) {
+      Index++;
+    }
+    if ((Index == Count) || Urbs[Index]->Finished) {
+      break;
+    }
+    gBS->Stall (XHC_1_MICROSECOND);
+  } while (IndefiniteTimeout || EFI_ERROR(gBS->CheckEvent (TimeoutEvent)));
+
+  if (Index < Count) {
+    Status = Urbs[Index]->Finished ? EFI_DEVICE_ERROR : EFI_TIMEOUT;
+  }
+
+DONE:
+  if (TimeoutEvent != NULL) {
+    gBS->CloseEvent (TimeoutEvent);
+  }
+
+  return Status;
+}
+
+/**
+  Remove the queued bulk URBs that have not finished from their transfer rings,
+  and recover the endpoints that halted.
+
+  The URBs that are still on a transfer ring when this function returns are
+  marked with EFI_USB_ERR_NOTEXECUTE.
+
+  @param  Xhc             The XHCI Instance.
+  @param  Urbs            The URBs, in the order they were queued.
+  @param  Count           The number of URBs.
+
+**/
+VOID
+XhcAbortTransferQueue (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 **Urbs,
+  IN  UINTN               Count
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   Index;
+  UINTN                   Other;
+  BOOLEAN                 Cleared[XHC_BULK_QUEUE_MAX_ENTRIES];
+
+  ASSERT (Count <= XHC_BULK_QUEUE_MAX_ENTRIES);
+  ZeroMem (Cleared, sizeof (Cleared));
+
+  //
+  // Recovering a halted endpoint moves its dequeue pointer past all the TDs
+  // queued on it.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    if (!Cleared[Index] &&
+        ((Urbs[Index]->Result == EFI_USB_ERR_STALL) || (Urbs[Index]->Result == EFI_USB_ERR_BABBLE))) {
+      Status = XhcRecoverHaltedEndpoint (Xhc, Urbs[Index]);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "XhcAbortTransferQueue: XhcRecoverHaltedEndpoint failed!\n"));
+      }
+      for (Other = Index; Other < Count; Other++) {
+        if (Urbs[Other]->Ring == Urbs[Index]->Ring) {
+          Cleared[Other] = TRUE;
+        }
+      }
+    }
+  }
+
+  //
+  // Stop the other endpoints that still have TDs queued.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    if (Cleared[Index] || Urbs[Index]->Finished) {
+      continue;
+    }
+
+    Status = XhcDequeueTrbFromEndpoint (Xhc, Urbs[Index]);
+    if (Status == EFI_ALREADY_STARTED) {
+      //
+      // The URB finished just before the endpoint stopped. The endpoint has
+      // been restarted and goes on with the next URB queued on it.
+      //
+      continue;
+    }
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "XhcAbortTransferQueue: XhcDequeueTrbFromEndpoint failed!\n"));
+    }
+    for (Other = Index; Other < Count; Other++) {
+      if (Urbs[Other]->Ring == Urbs[Index]->Ring) {
+        Cleared[Other] = TRUE;
+      }
+    }
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if (!Urbs[Index]->Finished) {
+      Urbs[Index]->Result  |= EFI_USB_ERR_NOTEXECUTE;
+      Urbs[Index]->Finished = TRUE;
+    }
+  }
+}
+
 /**
   Delete a single asynchronous interrupt transfer for
   the device and endpoint.
@@ -817,6 +817,44 @@ XhcExecTransfer (
   IN  UINTN               Timeout
   );
 
+/**
+  Ring the doorbells of queued bulk URBs, then poll the event ring until all
+  of them have finished, one of them has failed, or the timeout expires.
+
+  @param  Xhc               The XHCI Instance.
+  @param  Urbs              The URBs, in the order they were queued.
+  @param  Count             The number of URBs.
+  @param  Timeout           The time to wait before abort, in millisecond.
+
+  @return EFI_DEVICE_ERROR  An URB failed.
+  @return EFI_TIMEOUT       The URBs did not finish in time.
+  @return EFI_SUCCESS       All the URBs finished OK.
+
+**/
+EFI_STATUS
+XhcExecTransferQueue (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 **Urbs,
+  IN  UINTN               Count,
+  IN  UINTN               Timeout
+  );
+
+/**
+  Remove the queued bulk URBs that have not finished from their transfer rings,
+  and recover the endpoints that halted.
+
+  @param  Xhc               The XHCI Instance.
+  @param  Urbs              The URBs, in the order they were queued.
+  @param  Count             The number of URBs.
+
+**/
+VOID
+XhcAbortTransferQueue (
+  IN  USB_XHCI_INSTANCE   *Xhc,
+  IN  URB                 **Urbs,
+  IN  UINTN               Count
+  );
+
 /**
   Delete a single asynchronous interrupt transfer for
   the device and endpoint.
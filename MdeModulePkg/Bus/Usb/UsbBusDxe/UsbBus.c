@@ -304,6 +304,99 @@ ON_EXIT:
 }
 
 
+/**
+  Execute several bulk transfers to the endpoints of the interface, with all
+  of them queued on the host controller at once.
+
+  @param  This                   The USB IO bulk queue instance.
+  @param  Count                  The number of transfers.
+  @param  Entries                The transfers to execute, in order.
+  @param  Timeout                Time to wait before timeout.
+
+  @retval EFI_SUCCESS            The bulk transfers are OK.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to execute the transfers, reason returned
+                                 in the TransferResult of the entries.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoBulkQueueTransfer (
+  IN     EDKII_USB_IO_BULK_QUEUE_PROTOCOL  *This,
+  IN     UINTN                             Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY        *Entries,
+  IN     UINTN                             Timeout
+  )
+{
+  USB_DEVICE              *Dev;
+  USB_INTERFACE           *UsbIf;
+  USB_ENDPOINT_DESC       *EpDesc;
+  UINTN                   Index;
+  EFI_TPL                 OldTpl;
+  EFI_STATUS              Status;
+
+  if ((Entries == NULL) || (Count == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl  = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf   = USB_INTERFACE_FROM_BULK_QUEUE (This);
+  Dev     = UsbIf->Device;
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((USB_ENDPOINT_ADDR (Entries[Index].EndPointAddress) == 0) ||
+        (USB_ENDPOINT_ADDR (Entries[Index].EndPointAddress) > 15)) {
+      Status = EFI_INVALID_PARAMETER;
+      goto ON_EXIT;
+    }
+
+    EpDesc = UsbGetEndpointDesc (UsbIf, Entries[Index].EndPointAddress);
+
+    if ((EpDesc == NULL) || (USB_ENDPOINT_TYPE (&EpDesc->Desc) != USB_ENDPOINT_BULK)) {
+      Status = EFI_INVALID_PARAMETER;
+      goto ON_EXIT;
+    }
+
+    Entries[Index].MaximumPacketLength = EpDesc->Desc.MaxPacketSize;
+  }
+
+  //
+  // Only XHCI produces the bulk queue protocol, and XHCI keeps the data
+  // toggles itself. So the toggles in the endpoint descriptors are not used.
+  //
+  Status = Dev->Bus->BulkQueue->QueueTransfer (
+                                  Dev->Bus->BulkQueue,
+                                  Dev->Address,
+                                  Dev->Speed,
+                                  Count,
+                                  Entries,
+                                  Timeout,
+                                  &Dev->Translator
+                                  );
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Clear TT buffer when CTRL/BULK split transaction failes.
+    // Clear the TRANSLATOR TT buffer, not parent's buffer
+    //
+    ASSERT (Dev->Translator.TranslatorHubAddress < Dev->Bus->MaxDevices);
+    if (Dev->Translator.TranslatorHubAddress != 0) {
+      UsbHubCtrlClearTTBuffer (
+        Dev->Bus->Devices[Dev->Translator.TranslatorHubAddress],
+        Dev->Translator.TranslatorPortNumber,
+        Dev->Address,
+        0,
+        USB_ENDPOINT_BULK
+        );
+    }
+  }
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
 /**
   Execute a synchronous interrupt transfer.
 
@@ -982,6 +1075,22 @@ UsbBusBuildProtocol (
     if (UsbBus->Usb2Hc->MajorRevision == 0x3) {
       UsbBus->MaxDevices = 256;
     }
+
+    //
+    // The bulk queue protocol is optional, and is installed together with
+    // the EFI_USB2_HC_PROTOCOL that is opened above.
+    //
+    Status = gBS->OpenProtocol (
+                    Controller,
+                    &gEdkiiUsb2HcBulkQueueProtocolGuid,
+                    (VOID **) &(UsbBus->BulkQueue),
+                    This->DriverBindingHandle,
+                    Controller,
+                    EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                    );
+    if (EFI_ERROR (Status)) {
+      UsbBus->BulkQueue = NULL;
+    }
   }
 
   //
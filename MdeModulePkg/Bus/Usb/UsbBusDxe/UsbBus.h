@@ -16,6 +16,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/Usb2HostController.h>
 #include <Protocol/UsbHostController.h>
 #include <Protocol/UsbIo.h>
+#include <Protocol/UsbBulkQueue.h>
 #include <Protocol/DevicePath.h>
 
 #include <Library/BaseLib.h>
@@ -27,6 +28,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/PrintLib.h>
 
 
 #include <IndustryStandard/Usb.h>
@@ -144,6 +147,9 @@ typedef struct _USB_HUB_API    USB_HUB_API;
 #define USB_INTERFACE_FROM_USBIO(a) \
           CR(a, USB_INTERFACE, UsbIo, USB_INTERFACE_SIGNATURE)
 
+#define USB_INTERFACE_FROM_BULK_QUEUE(a) \
+          CR(a, USB_INTERFACE, BulkQueue, USB_INTERFACE_SIGNATURE)
+
 #define USB_BUS_FROM_THIS(a) \
           CR(a, USB_BUS, BusId, USB_BUS_SIGNATURE)
 
@@ -209,6 +215,7 @@ struct _USB_INTERFACE {
   //
   EFI_HANDLE                Handle;
   EFI_USB_IO_PROTOCOL       UsbIo;
+  EDKII_USB_IO_BULK_QUEUE_PROTOCOL  BulkQueue;
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
   BOOLEAN                   IsManaged;
 
@@ -248,6 +255,10 @@ struct _USB_BUS {
   EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
   EFI_USB2_HC_PROTOCOL      *Usb2Hc;
   EFI_USB_HC_PROTOCOL       *UsbHc;
+  //
+  // The bulk queue protocol of the host controller, NULL if it has none.
+  //
+  EDKII_USB2_HC_BULK_QUEUE_PROTOCOL  *BulkQueue;
 
   //
   // Recorded the max supported usb devices.
@@ -424,6 +435,30 @@ UsbIoBulkTransfer (
   OUT UINT32              *UsbStatus
   );
 
+/**
+  Execute several bulk transfers to the endpoints of the interface, with all
+  of them queued on the host controller at once.
+
+  @param  This                   The USB IO bulk queue instance.
+  @param  Count                  The number of transfers.
+  @param  Entries                The transfers to execute, in order.
+  @param  Timeout                Time to wait before timeout.
+
+  @retval EFI_SUCCESS            The bulk transfers are OK.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to execute the transfers, reason returned
+                                 in the TransferResult of the entries.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoBulkQueueTransfer (
+  IN     EDKII_USB_IO_BULK_QUEUE_PROTOCOL  *This,
+  IN     UINTN                             Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY        *Entries,
+  IN     UINTN                             Timeout
+  );
+
 /**
   Execute a synchronous interrupt transfer.
 
@@ -66,6 +66,13 @@ UsbFreeInterface (
                   NULL
                   );
   if (!EFI_ERROR (Status)) {
+    if (UsbIf->Device->Bus->BulkQueue != NULL) {
+      gBS->UninstallProtocolInterface (
+             UsbIf->Handle,
+             &gEdkiiUsbIoBulkQueueProtocolGuid,
+             &UsbIf->BulkQueue
+             );
+    }
     if (UsbIf->DevicePath != NULL) {
       FreePool (UsbIf->DevicePath);
     }
@@ -116,6 +123,11 @@ UsbCreateInterface (
     sizeof (EFI_USB_IO_PROTOCOL)
     );
 
+  UsbIf->BulkQueue.QueueTransfer = UsbIoBulkQueueTransfer;
+  if (Device->Bus->BulkQueue != NULL) {
+    UsbIf->BulkQueue.MaxEntries  = Device->Bus->BulkQueue->MaxEntries;
+  }
+
   //
   // Install protocols for USBIO and device path
   //
@@ -171,6 +183,22 @@ UsbCreateInterface (
     goto ON_ERROR;
   }
 
+  //
+  // Let the drivers of the interface queue bulk transfers if the host
+  // controller supports it.
+  //
+  if (Device->Bus->BulkQueue != NULL) {
+    Status = gBS->InstallProtocolInterface (
+                    &UsbIf->Handle,
+                    &gEdkiiUsbIoBulkQueueProtocolGuid,
+                    EFI_NATIVE_INTERFACE,
+                    &UsbIf->BulkQueue
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "UsbCreateInterface: failed to install bulk queue - %r\n", Status));
+    }
+  }
+
   return UsbIf;
 
 ON_ERROR:
@@ -650,6 +678,8 @@ UsbFindChild (
 /**
   Enumerate and configure the new device on the port of this HUB interface.
 
+  The caller has waited for the connection on the port to become stable.
+
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
   @param  ResetIsNeeded         The boolean to control whether skip the reset of the port.
@@ -680,8 +710,6 @@ UsbEnumerateNewDev (
   HubApi  = HubIf->HubApi;
   Address = Bus->MaxDevices;
 
-  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
-
   //
   // Hub resets the device for at least 10 milliseconds.
   // Host learns device speed. If device is of low/full speed
@@ -872,20 +900,24 @@ ON_ERROR:
 
 
 /**
-  Process the events on the port.
+  Process the events on the port, up to the point where a new device
+  is waiting for its connection to become stable.
 
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
+  @param  PortEnum              The bring-up state of the port. On return, the
+                                state is UsbPortDebounce if a new device must be
+                                enumerated, and UsbPortDone otherwise.
 
-  @retval EFI_SUCCESS           The device is enumerated (added or removed).
-  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
-  @retval Others                Failed to enumerate the device.
+  @retval EFI_SUCCESS           The port events are processed.
+  @retval Others                Failed to get the port state, or over current.
 
 **/
 EFI_STATUS
-UsbEnumeratePort (
+UsbCheckPortChange (
   IN USB_INTERFACE        *HubIf,
-  IN UINT8                Port
+  IN UINT8                Port,
+  OUT USB_PORT_ENUM       *PortEnum
   )
 {
   USB_HUB_API             *HubApi;
@@ -896,6 +928,9 @@ UsbEnumeratePort (
   Child   = NULL;
   HubApi  = HubIf->HubApi;
 
+  ZeroMem (PortEnum, sizeof (USB_PORT_ENUM));
+  PortEnum->State = UsbPortDone;
+
   //
   // Host learns of the new device by polling the hub for port changes.
   //
@@ -975,24 +1010,199 @@ UsbEnumeratePort (
 
   if (USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_CONNECTION)) {
     //
-    // Now, new device connected, enumerate and configure the device
+    // Now, new device connected. It is enumerated and configured once the
+    // connection is stable.
     //
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: new device connected at port %d\n", Port));
-    if (USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)) {
-      Status = UsbEnumerateNewDev (HubIf, Port, FALSE);
-    } else {
-      Status = UsbEnumerateNewDev (HubIf, Port, TRUE);
-    }
-
-  } else {
-    DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
+    PortEnum->State         = UsbPortDebounce;
+    PortEnum->ResetIsNeeded = (BOOLEAN) !USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET);
+    return EFI_SUCCESS;
   }
 
+  DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
   HubApi->ClearPortChange (HubIf, Port);
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Enumerate and configure the new device on a port whose connection is
+  stable, and acknowledge the port changes.
+
+  @param  HubIf                 The HUB that has the device connected.
+  @param  Port                  The port index of the hub (started with zero).
+  @param  PortEnum              The bring-up state of the port.
+
+  @retval EFI_SUCCESS           The device is enumerated.
+  @retval Others                Failed to enumerate the device.
+
+**/
+EFI_STATUS
+UsbBringUpPort (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port,
+  IN OUT USB_PORT_ENUM    *PortEnum
+  )
+{
+  EFI_STATUS              Status;
+  CHAR8                   Token[USB_PORT_PERF_TOKEN_SIZE];
+
+  ASSERT (PortEnum->State == UsbPortDebounce);
+
+  AsciiSPrint (Token, sizeof (Token), "UsbBringUpPort %d.%d", HubIf->Device->Address, Port);
+  PERF_INMODULE_BEGIN (Token);
+  Status = UsbEnumerateNewDev (HubIf, Port, PortEnum->ResetIsNeeded);
+  HubIf->HubApi->ClearPortChange (HubIf, Port);
+  PortEnum->State = UsbPortDone;
+  PERF_INMODULE_END (Token);
+
+  if (!EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "UsbEnumeratePort: hub %p port %d is up\n", HubIf, Port));
+  }
   return Status;
 }
 
 
+/**
+  Wait until the connections seen on the ports have been stable for
+  USB_WAIT_PORT_STABLE_STALL.
+
+  The ports are all checked before the wait starts, so a single wait covers
+  every port with a new connection.
+
+  @param  HubIf                 The HUB whose ports are waited for.
+  @param  PortEnum              The bring-up state of the ports.
+  @param  Count                 The number of entries in PortEnum.
+
+**/
+VOID
+UsbWaitPortStable (
+  IN USB_INTERFACE        *HubIf,
+  IN USB_PORT_ENUM        *PortEnum,
+  IN UINTN                Count
+  )
+{
+  UINTN                   Index;
+  CHAR8                   Token[USB_PORT_PERF_TOKEN_SIZE];
+
+  for (Index = 0; Index < Count; Index++) {
+    if (PortEnum[Index].State == UsbPortDebounce) {
+      AsciiSPrint (Token, sizeof (Token), "UsbWaitPortStable %d", HubIf->Device->Address);
+      PERF_INMODULE_BEGIN (Token);
+      gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
+      PERF_INMODULE_END (Token);
+      return;
+    }
+  }
+}
+
+
+/**
+  Process the events on the port.
+
+  @param  HubIf                 The HUB that has the device connected.
+  @param  Port                  The port index of the hub (started with zero).
+
+  @retval EFI_SUCCESS           The device is enumerated (added or removed).
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
+  @retval Others                Failed to enumerate the device.
+
+**/
+EFI_STATUS
+UsbEnumeratePort (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port
+  )
+{
+  USB_PORT_ENUM           PortEnum;
+  EFI_STATUS              Status;
+
+  Status = UsbCheckPortChange (HubIf, Port, &PortEnum);
+  if (EFI_ERROR (Status) || (PortEnum.State != UsbPortDebounce)) {
+    return Status;
+  }
+
+  UsbWaitPortStable (HubIf, &PortEnum, 1);
+  return UsbBringUpPort (HubIf, Port, &PortEnum);
+}
+
+
+/**
+  Process the events on several ports of a hub.
+
+  The ports with a new device wait for their connections to become stable
+  together, so the wait is only spent once for the hub instead of once per
+  port. The new devices are then enumerated in port order.
+
+  @param  HubIf                 The HUB whose ports are processed.
+  @param  ChangeMap             The hub status change bitmap. Bit 0 is the hub,
+                                bit N is port N - 1. NULL processes all ports.
+
+**/
+VOID
+UsbEnumeratePorts (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                *ChangeMap  OPTIONAL
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  UINTN                   Count;
+  UINT8                   Byte;
+  UINT8                   Bit;
+  UINT8                   Index;
+
+  if (HubIf->NumOfPort == 0) {
+    return;
+  }
+
+  PortEnum = AllocateZeroPool (HubIf->NumOfPort * sizeof (USB_PORT_ENUM));
+  if (PortEnum == NULL) {
+    //
+    // Fall back to bringing up one port after another.
+    //
+    Byte = 0;
+    Bit  = 1;
+    for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+      if ((ChangeMap == NULL) || USB_BIT_IS_SET (ChangeMap[Byte], USB_BIT (Bit))) {
+        UsbEnumeratePort (HubIf, Index);
+      }
+      USB_NEXT_BIT (Byte, Bit);
+    }
+    return;
+  }
+
+  //
+  // HUB starts its port index with 1.
+  //
+  Byte      = 0;
+  Bit       = 1;
+  Count     = 0;
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    if ((ChangeMap == NULL) || USB_BIT_IS_SET (ChangeMap[Byte], USB_BIT (Bit))) {
+      UsbCheckPortChange (HubIf, Index, &PortEnum[Index]);
+      if (PortEnum[Index].State == UsbPortDebounce) {
+        Count++;
+      }
+    }
+    USB_NEXT_BIT (Byte, Bit);
+  }
+
+  if (Count != 0) {
+    UsbWaitPortStable (HubIf, PortEnum, HubIf->NumOfPort);
+
+    for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+      if (PortEnum[Index].State == UsbPortDebounce) {
+        UsbBringUpPort (HubIf, Index, &PortEnum[Index]);
+      }
+    }
+
+    DEBUG ((DEBUG_INFO, "UsbEnumeratePorts: %d new device(s) on hub %p\n", Count, HubIf));
+  }
+
+  FreePool (PortEnum);
+}
+
+
 /**
   Enumerate all the changed hub ports.
 
@@ -1008,8 +1218,6 @@ UsbHubEnumeration (
   )
 {
   USB_INTERFACE           *HubIf;
-  UINT8                   Byte;
-  UINT8                   Bit;
   UINT8                   Index;
   USB_DEVICE              *Child;
 
@@ -1029,19 +1237,7 @@ UsbHubEnumeration (
     return ;
   }
 
-  //
-  // HUB starts its port index with 1.
-  //
-  Byte  = 0;
-  Bit   = 1;
-
-  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
-    if (USB_BIT_IS_SET (HubIf->ChangeMap[Byte], USB_BIT (Bit))) {
-      UsbEnumeratePort (HubIf, Index);
-    }
-
-    USB_NEXT_BIT (Byte, Bit);
-  }
+  UsbEnumeratePorts (HubIf, HubIf->ChangeMap);
 
   UsbHubAckHubStatus (HubIf->Device);
 
@@ -1077,7 +1273,7 @@ UsbRootHubEnumeration (
       DEBUG (( EFI_D_INFO, "UsbEnumeratePort: The device disconnect fails at port %d from root hub %p, try again\n", Index, RootHub));
       UsbRemoveDevice (Child);
     }
-
-    UsbEnumeratePort (RootHub, Index);
   }
+
+  UsbEnumeratePorts (RootHub, NULL);
 }
@@ -22,6 +22,32 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
             }                 \
           } while (0)
 
+//
+// Bring-up state of a hub port. All the ports of a hub that see a new
+// connection in one enumeration pass wait for the connection to become
+// stable at the same time. They are then reset, addressed and configured
+// one after another, as only one device may answer at the default address.
+// A zeroed entry is UsbPortDone, so ports that are not checked are skipped.
+//
+typedef enum {
+  UsbPortDone,
+  UsbPortDebounce
+} USB_PORT_ENUM_STATE;
+
+//
+// Size of the performance tokens that name a hub port, such as
+// "UsbBringUpPort 127.255" for port 255 of the hub at address 127.
+//
+#define USB_PORT_PERF_TOKEN_SIZE  32
+
+//
+// Per-port bring-up state.
+//
+typedef struct {
+  USB_PORT_ENUM_STATE       State;
+  BOOLEAN                   ResetIsNeeded;
+} USB_PORT_ENUM;
+
 
 //
 // Common interface used by usb bus enumeration process.
@@ -370,6 +370,167 @@ UsbBotGetStatus (
 }
 
 
+/**
+  Issue the command/data/status circle of a command with all three stages
+  queued on the host controller at once.
+
+  The stages that fail are handled like UsbBotSendCommand(),
+  UsbBotDataTransfer() and UsbBotGetStatus() handle them.
+
+  @param  UsbBot                The USB BOT protocol.
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval EFI_UNSUPPORTED       The host controller could not queue the stages.
+                                Nothing was sent to the device.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbBotExecCommandQueued (
+  IN  USB_BOT_PROTOCOL        *UsbBot,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  )
+{
+  USB_BOT_CBW                 Cbw;
+  USB_BOT_CSW                 Csw;
+  EDKII_USB_BULK_QUEUE_ENTRY  Entries[USB_BOT_QUEUE_ENTRIES];
+  EDKII_USB_BULK_QUEUE_ENTRY  *CbwEntry;
+  EDKII_USB_BULK_QUEUE_ENTRY  *DataEntry;
+  EDKII_USB_BULK_QUEUE_ENTRY  *CswEntry;
+  UINTN                       Count;
+  EFI_USB_ENDPOINT_DESCRIPTOR *Endpoint;
+  EFI_STATUS                  Status;
+  UINT8                       Result;
+
+  ASSERT ((CmdLen > 0) && (CmdLen <= USB_BOT_MAX_CMDLEN));
+
+  //
+  // Fill in the Command Block Wrapper.
+  //
+  Cbw.Signature = USB_BOT_CBW_SIGNATURE;
+  Cbw.Tag       = UsbBot->CbwTag;
+  Cbw.DataLen   = DataLen;
+  Cbw.Flag      = (UINT8) ((DataDir == EfiUsbDataIn) ? BIT7 : 0);
+  Cbw.Lun       = Lun;
+  Cbw.CmdLen    = CmdLen;
+
+  ZeroMem (Cbw.CmdBlock, USB_BOT_MAX_CMDLEN);
+  CopyMem (Cbw.CmdBlock, Cmd, CmdLen);
+  ZeroMem (&Csw, sizeof (USB_BOT_CSW));
+  ZeroMem (Entries, sizeof (Entries));
+
+  Count     = 0;
+  CbwEntry  = &Entries[Count++];
+  CbwEntry->EndPointAddress = UsbBot->BulkOutEndpoint->EndpointAddress;
+  CbwEntry->Data            = &Cbw;
+  CbwEntry->DataLength      = sizeof (USB_BOT_CBW);
+
+  DataEntry = NULL;
+  if ((DataDir != EfiUsbNoData) && (DataLen != 0)) {
+    if (DataDir == EfiUsbDataIn) {
+      Endpoint = UsbBot->BulkInEndpoint;
+    } else {
+      Endpoint = UsbBot->BulkOutEndpoint;
+    }
+    DataEntry = &Entries[Count++];
+    DataEntry->EndPointAddress = Endpoint->EndpointAddress;
+    DataEntry->Data            = Data;
+    DataEntry->DataLength      = DataLen;
+  }
+
+  CswEntry  = &Entries[Count++];
+  CswEntry->EndPointAddress = UsbBot->BulkInEndpoint->EndpointAddress;
+  CswEntry->Data            = &Csw;
+  CswEntry->DataLength      = sizeof (USB_BOT_CSW);
+
+  Status = UsbBot->BulkQueue->QueueTransfer (
+                                UsbBot->BulkQueue,
+                                Count,
+                                Entries,
+                                (USB_BOT_SEND_CBW_TIMEOUT + Timeout + USB_BOT_RECV_CSW_TIMEOUT) / USB_MASS_1_MILLISECOND
+                                );
+  if ((Status == EFI_INVALID_PARAMETER) || (Status == EFI_OUT_OF_RESOURCES)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Return immediately if device rejects the command.
+  //
+  if (CbwEntry->TransferResult != EFI_USB_NOERROR) {
+    if (USB_IS_ERROR (CbwEntry->TransferResult, EFI_USB_ERR_STALL) && DataDir == EfiUsbDataOut) {
+      //
+      // Respond to Bulk-Out endpoint stall with a Reset Recovery,
+      // according to section 5.3.1 of USB Mass Storage Class Bulk-Only Transport Spec, v1.0.
+      //
+      UsbBotResetDevice (UsbBot, FALSE);
+    } else if (USB_IS_ERROR (CbwEntry->TransferResult, EFI_USB_ERR_NAK)) {
+      Status = EFI_NOT_READY;
+    }
+    DEBUG ((EFI_D_ERROR, "UsbBotExecCommandQueued: send command (%r)\n", Status));
+    return EFI_ERROR (Status) ? Status : EFI_DEVICE_ERROR;
+  }
+
+  if ((DataEntry != NULL) && (DataEntry->TransferResult != EFI_USB_NOERROR)) {
+    if (USB_IS_ERROR (DataEntry->TransferResult, EFI_USB_ERR_STALL)) {
+      DEBUG ((EFI_D_INFO, "UsbBotExecCommandQueued: data stage stall\n"));
+      UsbClearEndpointStall (UsbBot->UsbIo, DataEntry->EndPointAddress);
+    } else {
+      DEBUG ((EFI_D_ERROR, "UsbBotExecCommandQueued: data stage (%r)\n", Status));
+    }
+    if (Status == EFI_TIMEOUT) {
+      UsbBotResetDevice (UsbBot, FALSE);
+    }
+  }
+
+  //
+  // Interpret the CSW if it has been received. Otherwise get the status
+  // the way the stages are done one by one.
+  //
+  if (CswEntry->TransferResult != EFI_USB_NOERROR) {
+    if (USB_IS_ERROR (CswEntry->TransferResult, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbBot->UsbIo, CswEntry->EndPointAddress);
+    }
+    Status = UsbBotGetStatus (UsbBot, DataLen, &Result);
+  } else if ((Csw.Signature != USB_BOT_CSW_SIGNATURE) || (Csw.CmdStatus == USB_BOT_COMMAND_ERROR)) {
+    //
+    // Invalid CSW or phase error needs reset recovery
+    //
+    UsbBotResetDevice (UsbBot, FALSE);
+    Status = UsbBotGetStatus (UsbBot, DataLen, &Result);
+  } else {
+    Result = Csw.CmdStatus;
+    UsbBot->CbwTag++;
+    Status = EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "UsbBotExecCommandQueued: get status (%r)\n", Status));
+    return Status;
+  }
+
+  if (Result == 0) {
+    *CmdStatus = USB_MASS_CMD_SUCCESS;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Call the USB Mass Storage Class BOT protocol to issue
   the command/data/status circle to execute the commands.
@@ -410,6 +571,17 @@ UsbBotExecCommand (
   *CmdStatus  = USB_MASS_CMD_FAIL;
   UsbBot      = (USB_BOT_PROTOCOL *) Context;
 
+  //
+  // Queue all the stages at once when the host controller supports it, so
+  // that the device doesn't wait for software between them.
+  //
+  if ((UsbBot->BulkQueue != NULL) && (DataLen <= USB_BOT_QUEUE_MAX_DATA_LEN)) {
+    Status = UsbBotExecCommandQueued (UsbBot, Cmd, CmdLen, DataDir, Data, DataLen, Lun, Timeout, CmdStatus);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
   //
   // Send the command to the device. Return immediately if device
   // rejects the command.
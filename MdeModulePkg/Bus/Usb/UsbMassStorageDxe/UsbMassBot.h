@@ -35,6 +35,19 @@ extern USB_MASS_TRANSPORT mUsbBotTransport;
 //
 #define USB_BOT_RECV_CSW_RETRY   3
 
+//
+// Number of bulk transfers a command takes when its stages are queued at
+// once: CBW, data and CSW.
+//
+#define USB_BOT_QUEUE_ENTRIES    3
+
+//
+// The largest data stage that is queued together with CBW and CSW. A larger
+// data stage takes more than one TD, and a short packet would leave the TDs
+// after it to receive the CSW.
+//
+#define USB_BOT_QUEUE_MAX_DATA_LEN  SIZE_64KB
+
 //
 // Usb Bot wait device reset complete, set by experience
 //
@@ -81,6 +94,7 @@ typedef struct {
   EFI_USB_ENDPOINT_DESCRIPTOR   *BulkOutEndpoint;
   UINT32                        CbwTag;
   EFI_USB_IO_PROTOCOL           *UsbIo;
+  EDKII_USB_IO_BULK_QUEUE_PROTOCOL  *BulkQueue;
 } USB_BOT_PROTOCOL;
 
 /**
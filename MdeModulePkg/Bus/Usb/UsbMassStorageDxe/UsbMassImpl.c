@@ -394,6 +394,7 @@ UsbMassInitTransport (
 {
   EFI_USB_IO_PROTOCOL           *UsbIo;
   EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  USB_BOT_PROTOCOL              *UsbBot;
   UINT8                         Index;
   EFI_STATUS                    Status;
 
@@ -443,6 +444,23 @@ UsbMassInitTransport (
   //
   if ((*Transport)->Protocol == USB_MASS_STORE_BOT) {
     (*Transport)->GetMaxLun (*Context, MaxLun);
+
+    //
+    // Queue the stages of BOT commands at once if the USB bus supports it.
+    //
+    UsbBot = (USB_BOT_PROTOCOL *) *Context;
+    Status = gBS->OpenProtocol (
+                    Controller,
+                    &gEdkiiUsbIoBulkQueueProtocolGuid,
+                    (VOID **) &UsbBot->BulkQueue,
+                    This->DriverBindingHandle,
+                    Controller,
+                    EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                    );
+    if (EFI_ERROR (Status) || (UsbBot->BulkQueue->MaxEntries < USB_BOT_QUEUE_ENTRIES)) {
+      UsbBot->BulkQueue = NULL;
+    }
+    Status = EFI_SUCCESS;
   }
 
 ON_EXIT:
@@ -1734,11 +1734,14 @@ CoreStartImage (
   // unload it
   //
   if (EFI_ERROR (Image->Status) || Image->Type == EFI_IMAGE_SUBSYSTEM_EFI_APPLICATION) {
-    CoreUnloadAndCloseImage (Image, TRUE);
     //
-    // ImageHandle may be invalid after the image is unloaded, so use NULL handle to record perf log.
+    // ImageHandle is invalid after the image is unloaded, so use NULL handle to record perf log.
+    // It is recorded before the image is unloaded, so that a performance library which resolves
+    // the handles of its records later still finds the image.
     //
-    Handle = NULL;
+    PERF_START_IMAGE_END (NULL);
+    CoreUnloadAndCloseImage (Image, TRUE);
+    return Status;
   }
 
   //
@@ -74,13 +74,21 @@ typedef struct {
 
 #define SMI_ENTRY_SIGNATURE  SIGNATURE_32('s','m','i','e')
 
- typedef struct {
+typedef struct _SMI_ENTRY  SMI_ENTRY;
+
+struct _SMI_ENTRY {
   UINTN       Signature;
   LIST_ENTRY  AllEntries;  // All entries
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  SmiHandlers; // All handlers
-} SMI_ENTRY;
+  SMI_ENTRY   *HashNext;   // Next entry in the same hash bucket
+};
+
+//
+// Number of buckets of the SMI entry hash table. Must be a power of 2.
+//
+#define SMI_ENTRY_HASH_SIZE  64
 
 #define SMI_HANDLER_SIGNATURE  SIGNATURE_32('s','m','i','h')
 
@@ -92,6 +100,10 @@ typedef struct {
   SMI_ENTRY                     *SmiEntry;
   VOID                          *Context;    // for profile
   UINTN                         ContextSize; // for profile
+  UINT64                        InvocationCount; // for profile
+  UINT64                        TotalTicks;      // for profile, time stamp counter ticks
+  BOOLEAN                       ToRemove;    // To remove this SMI_HANDLER later
+  LIST_ENTRY                    RemoveLink;  // Link on the list of SMI_HANDLERs to remove
 } SMI_HANDLER;
 
 //
@@ -15,8 +15,46 @@ SMI_ENTRY   mRootSmiEntry = {
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.AllEntries),
   {0},
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.SmiHandlers),
+  NULL
 };
 
+//
+// Hash table of the entries in mSmiEntryList, indexed by SmiEntryHash().
+//
+SMI_ENTRY   *mSmiEntryHash[SMI_ENTRY_HASH_SIZE];
+
+//
+// The nesting depth of SmiManage(). The handlers unregistered while it is
+// non-zero are queued on mSmiHandlerRemoveList, and only freed when the
+// outermost SmiManage() returns.
+//
+STATIC UINTN       mSmiManageCallingDepth = 0;
+STATIC LIST_ENTRY  mSmiHandlerRemoveList  = INITIALIZE_LIST_HEAD_VARIABLE (mSmiHandlerRemoveList);
+
+/**
+  Compute the hash bucket of an SMI handler type.
+
+  @param  HandlerType            The type of the interrupt
+
+  @return The index in mSmiEntryHash.
+
+**/
+UINTN
+SmiEntryHash (
+  IN CONST EFI_GUID  *HandlerType
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *)HandlerType) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (SMI_ENTRY_HASH_SIZE - 1);
+}
+
 /**
   Finds the SMI entry for the requested handler type.
 
@@ -33,19 +71,17 @@ SmmCoreFindSmiEntry (
   IN BOOLEAN   Create
   )
 {
-  LIST_ENTRY  *Link;
   SMI_ENTRY   *Item;
   SMI_ENTRY   *SmiEntry;
+  UINTN       Hash;
 
   //
-  // Search the SMI entry list for the matching GUID
+  // Search the hash bucket of the GUID for the matching entry
   //
   SmiEntry = NULL;
-  for (Link = mSmiEntryList.ForwardLink;
-       Link != &mSmiEntryList;
-       Link = Link->ForwardLink) {
-
-    Item = CR (Link, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+  Hash     = SmiEntryHash (HandlerType);
+  for (Item = mSmiEntryHash[Hash]; Item != NULL; Item = Item->HashNext) {
+    ASSERT (Item->Signature == SMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the SMI entry
@@ -70,14 +106,86 @@ SmmCoreFindSmiEntry (
       InitializeListHead (&SmiEntry->SmiHandlers);
 
       //
-      // Add it to SMI entry list
+      // Add it to SMI entry list and to the hash table
       //
       InsertTailList (&mSmiEntryList, &SmiEntry->AllEntries);
+      SmiEntry->HashNext  = mSmiEntryHash[Hash];
+      mSmiEntryHash[Hash] = SmiEntry;
     }
   }
   return SmiEntry;
 }
 
+/**
+  Remove an SMI handler from its entry, and remove the entry when it has no
+  handler left.
+
+  @param  SmiHandler  The SMI handler to remove.
+
+**/
+VOID
+RemoveSmiHandler (
+  IN SMI_HANDLER  *SmiHandler
+  )
+{
+  SMI_ENTRY    *SmiEntry;
+  SMI_ENTRY    **HashLink;
+
+  ASSERT (SmiHandler->ToRemove);
+
+  SmiEntry = SmiHandler->SmiEntry;
+
+  RemoveEntryList (&SmiHandler->Link);
+  FreePool (SmiHandler);
+
+  if (SmiEntry == NULL) {
+    //
+    // This is root SMI handler
+    //
+    return;
+  }
+
+  if (IsListEmpty (&SmiEntry->SmiHandlers)) {
+    //
+    // No handler registered for this interrupt now, remove the SMI_ENTRY
+    //
+    RemoveEntryList (&SmiEntry->AllEntries);
+    for (HashLink = &mSmiEntryHash[SmiEntryHash (&SmiEntry->HandlerType)];
+         *HashLink != NULL;
+         HashLink = &(*HashLink)->HashNext) {
+      if (*HashLink == SmiEntry) {
+        *HashLink = SmiEntry->HashNext;
+        break;
+      }
+    }
+
+    FreePool (SmiEntry);
+  }
+}
+
+/**
+  Remove the SMI handlers unregistered while SmiManage() was dispatching.
+
+**/
+VOID
+RemoveDeferredSmiHandlers (
+  VOID
+  )
+{
+  SMI_HANDLER  *SmiHandler;
+
+  while (!IsListEmpty (&mSmiHandlerRemoveList)) {
+    SmiHandler = CR (
+                   GetFirstNode (&mSmiHandlerRemoveList),
+                   SMI_HANDLER,
+                   RemoveLink,
+                   SMI_HANDLER_SIGNATURE
+                   );
+    RemoveEntryList (&SmiHandler->RemoveLink);
+    RemoveSmiHandler (SmiHandler);
+  }
+}
+
 /**
   Manage SMI of a particular type.
 
@@ -106,7 +214,10 @@ SmiManage (
   SMI_ENTRY    *SmiEntry;
   SMI_HANDLER  *SmiHandler;
   BOOLEAN      SuccessReturn;
+  BOOLEAN      WillReturn;
   EFI_STATUS   Status;
+  EFI_STATUS   ReturnStatus;
+  UINT64       StartTicks;
 
   Status = EFI_NOT_FOUND;
   SuccessReturn = FALSE;
@@ -129,8 +240,27 @@ SmiManage (
   }
   Head = &SmiEntry->SmiHandlers;
 
+  //
+  // The handlers unregistered during the dispatch stay linked until the
+  // outermost SmiManage() returns, so Link and SmiHandler remain valid.
+  //
+  mSmiManageCallingDepth++;
+  WillReturn   = FALSE;
+  ReturnStatus = EFI_NOT_FOUND;
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+    if (SmiHandler->ToRemove) {
+      continue;
+    }
+
+    //
+    // Record the invocation count and the time spent in the handler for
+    // the SMI handler profile.
+    //
+    StartTicks = 0;
+    if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0) {
+      StartTicks = AsmReadTsc ();
+    }
 
     Status = SmiHandler->Handler (
                (EFI_HANDLE) SmiHandler,
@@ -139,6 +269,11 @@ SmiManage (
                CommBufferSize
                );
 
+    if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0) {
+      SmiHandler->InvocationCount++;
+      SmiHandler->TotalTicks += AsmReadTsc () - StartTicks;
+    }
+
     switch (Status) {
     case EFI_INTERRUPT_PENDING:
       //
@@ -146,7 +281,8 @@ SmiManage (
       // no additional handlers will be processed and EFI_INTERRUPT_PENDING will be returned.
       //
       if (HandlerType != NULL) {
-        return EFI_INTERRUPT_PENDING;
+        ReturnStatus = EFI_INTERRUPT_PENDING;
+        WillReturn   = TRUE;
       }
       break;
 
@@ -157,7 +293,8 @@ SmiManage (
       // additional handlers will be processed.
       //
       if (HandlerType != NULL) {
-        return EFI_SUCCESS;
+        ReturnStatus = EFI_SUCCESS;
+        WillReturn   = TRUE;
       }
       SuccessReturn = TRUE;
       break;
@@ -184,6 +321,20 @@ SmiManage (
       ASSERT (FALSE);
       break;
     }
+
+    if (WillReturn) {
+      break;
+    }
+  }
+
+  ASSERT (mSmiManageCallingDepth > 0);
+  mSmiManageCallingDepth--;
+  if ((mSmiManageCallingDepth == 0) && !IsListEmpty (&mSmiHandlerRemoveList)) {
+    RemoveDeferredSmiHandlers ();
+  }
+
+  if (WillReturn) {
+    return ReturnStatus;
   }
 
   if (SuccessReturn) {
@@ -304,29 +455,19 @@ SmiHandlerUnRegister (
     }
   }
 
-  if ((EFI_HANDLE) SmiHandler != DispatchHandle) {
+  if (((EFI_HANDLE) SmiHandler != DispatchHandle) || SmiHandler->ToRemove) {
     return EFI_INVALID_PARAMETER;
   }
 
-  SmiEntry = SmiHandler->SmiEntry;
-
-  RemoveEntryList (&SmiHandler->Link);
-  FreePool (SmiHandler);
-
-  if (SmiEntry == NULL) {
-    //
-    // This is root SMI handler
-    //
-    return EFI_SUCCESS;
-  }
-
-  if (IsListEmpty (&SmiEntry->SmiHandlers)) {
-    //
-    // No handler registered for this interrupt now, remove the SMI_ENTRY
-    //
-    RemoveEntryList (&SmiEntry->AllEntries);
-
-    FreePool (SmiEntry);
+  //
+  // A handler unregistered from within SmiManage(), usually by itself, is
+  // freed when the outermost SmiManage() returns.
+  //
+  SmiHandler->ToRemove = TRUE;
+  if (mSmiManageCallingDepth == 0) {
+    RemoveSmiHandler (SmiHandler);
+  } else {
+    InsertTailList (&mSmiHandlerRemoveList, &SmiHandler->RemoveLink);
   }
 
   return EFI_SUCCESS;
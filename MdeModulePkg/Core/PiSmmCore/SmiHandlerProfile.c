@@ -426,6 +426,9 @@ DumpSmiHandlerOnSmiEntry(
       DEBUG ((DEBUG_INFO, " <== RVA - 0x%x", SmiHandler->CallerAddr - (UINTN) ImageStruct->ImageBase));
     }
     DEBUG ((DEBUG_INFO, "\n"));
+    if (SmiHandler->InvocationCount != 0) {
+      DEBUG ((DEBUG_INFO, "  InvocationCount - %ld, TotalTicks - %ld\n", SmiHandler->InvocationCount, SmiHandler->TotalTicks));
+    }
   }
 
   return;
@@ -707,6 +710,8 @@ GetSmmSmiHandlerDataOnSmiEntry(
     SmiHandlerStruct->Handler = (UINTN)SmiHandler->Handler;
     SmiHandlerStruct->ImageRef = AddressToImageRef((UINTN)SmiHandler->Handler);
     SmiHandlerStruct->ContextBufferSize = (UINT32)SmiHandler->ContextSize;
+    SmiHandlerStruct->InvocationCount = SmiHandler->InvocationCount;
+    SmiHandlerStruct->TotalTicks = SmiHandler->TotalTicks;
     if (SmiHandler->ContextSize != 0) {
       SmiHandlerStruct->ContextBufferOffset = sizeof(SMM_CORE_SMI_HANDLER_STRUCTURE);
       CopyMem ((UINT8 *)SmiHandlerStruct + SmiHandlerStruct->ContextBufferOffset, SmiHandler->Context, SmiHandler->ContextSize);
@@ -842,6 +847,45 @@ BuildSmiHandlerProfileDatabase(
   }
 }
 
+/**
+  Rebuild the SMI handler profile database with the current invocation
+  counts and times.
+
+  The database keeps its buffer if the size did not change. If a larger
+  buffer cannot be allocated, the previous database is kept.
+**/
+VOID
+RefreshSmiHandlerProfileDatabase (
+  VOID
+  )
+{
+  VOID        *Database;
+  UINTN       DatabaseSize;
+  EFI_STATUS  Status;
+
+  DatabaseSize = GetSmiHandlerProfileDatabaseSize ();
+  if (DatabaseSize == mSmiHandlerProfileDatabaseSize) {
+    Database = mSmiHandlerProfileDatabase;
+  } else {
+    Database = AllocatePool (DatabaseSize);
+    if (Database == NULL) {
+      return;
+    }
+  }
+
+  Status = GetSmiHandlerProfileDatabaseData (Database);
+  if (Database == mSmiHandlerProfileDatabase) {
+    return;
+  }
+  if (EFI_ERROR (Status)) {
+    FreePool (Database);
+    return;
+  }
+  FreePool (mSmiHandlerProfileDatabase);
+  mSmiHandlerProfileDatabase     = Database;
+  mSmiHandlerProfileDatabaseSize = DatabaseSize;
+}
+
 /**
   Copy SMI handler profile data.
 
@@ -891,6 +935,12 @@ SmiHandlerProfileHandlerGetInfo(
   SmiHandlerProfileRecordingStatus = mSmiHandlerProfileRecordingStatus;
   mSmiHandlerProfileRecordingStatus = FALSE;
 
+  //
+  // Take a new snapshot so that the invocation counts and times are current.
+  // The following get data by offset requests copy from this snapshot.
+  //
+  RefreshSmiHandlerProfileDatabase ();
+
   SmiHandlerProfileParameterGetInfo->DataSize = mSmiHandlerProfileDatabaseSize;
   SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = 0;
 
@@ -1084,6 +1134,7 @@ SmmCoreFindHardwareSmiEntry (
       SmiEntry->Signature = SMI_ENTRY_SIGNATURE;
       CopyGuid ((VOID *)&SmiEntry->HandlerType, HandlerType);
       InitializeListHead (&SmiEntry->SmiHandlers);
+      SmiEntry->HashNext = NULL;
 
       //
       // Add it to SMI entry list
@@ -42,7 +42,7 @@ typedef struct {
 } SMM_CORE_IMAGE_DATABASE_STRUCTURE;
 
 #define SMM_CORE_SMI_DATABASE_SIGNATURE SIGNATURE_32 ('S','C','S','D')
-#define SMM_CORE_SMI_DATABASE_REVISION  0x0001
+#define SMM_CORE_SMI_DATABASE_REVISION  0x0002
 
 typedef enum {
   SmmCoreSmiHandlerCategoryRootHandler,
@@ -85,6 +85,14 @@ typedef struct {
   UINT16                ContextBufferOffset;
   UINT8                 Reserved[2];
   UINT32                ContextBufferSize;
+  //
+  // Added in revision 0x0002. The number of times SmiManage() called the
+  // handler and the time stamp counter ticks spent in the handler. Both are
+  // zero for hardware SMI handlers, which are dispatched by the SMM child
+  // dispatch drivers.
+  //
+  UINT64                InvocationCount;
+  UINT64                TotalTicks;
 //UINT8                 ContextBuffer[];
 } SMM_CORE_SMI_HANDLER_STRUCTURE;
 
@@ -77,6 +77,14 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO                14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH
+//
+#define SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME_BATCH          15
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE
+//
+#define SMM_VARIABLE_FUNCTION_INIT_UPDATE_SEQUENCE                  16
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -147,4 +155,49 @@ typedef struct {
   BOOLEAN                 AuthenticatedVariableUsage;
 } SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
 
+///
+/// This structure is used to communicate with SMI handler by GetNextVariableName
+/// when a run of variable names is returned by one SMI.
+///
+/// Name is the variable to start after. The entries follow Name at the offset
+/// SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (NameSize) from the start of the
+/// structure, and fill the rest of the payload.
+///
+typedef struct {
+  EFI_GUID    Guid;
+  UINTN       NameSize;     // Size of the start variable name
+  UINTN       EntriesSize;  // Return size of the packed entries
+  UINT32      Count;        // Return number of packed entries
+  UINT32      Sequence;     // Return update sequence the entries were read at
+  BOOLEAN     EndOfList;    // Return TRUE if the last entry is the last variable
+  CHAR16      Name[1];
+} SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH;
+
+///
+/// One packed entry returned by SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME_BATCH.
+/// Each entry starts on an 8-byte boundary.
+///
+typedef struct {
+  EFI_GUID    Guid;
+  UINT32      NameSize;
+  UINT32      Reserved;
+  CHAR16      Name[1];
+} SMM_VARIABLE_NAME_BATCH_ENTRY;
+
+#define SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET(NameSize) \
+  ALIGN_VALUE (OFFSET_OF (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH, Name) + (NameSize), 8)
+
+#define SMM_VARIABLE_NAME_BATCH_ENTRY_SIZE(NameSize) \
+  ALIGN_VALUE (OFFSET_OF (SMM_VARIABLE_NAME_BATCH_ENTRY, Name) + (NameSize), 8)
+
+///
+/// The update sequence is a counter outside SMRAM that the SMI handler makes odd
+/// before it changes a variable and even again afterwards. A copy of variable
+/// names taken at an even sequence is current as long as the counter keeps the
+/// same value.
+///
+typedef struct {
+  UINT32                  *UpdateSequence;
+} SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE;
+
 #endif // _SMM_VARIABLE_COMMON_H_
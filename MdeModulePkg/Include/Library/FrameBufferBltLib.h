@@ -42,6 +42,41 @@ FrameBufferBltConfigure (
   IN OUT  UINTN                                 *ConfigureSize
   );
 
+/**
+  Attach a shadow buffer in system memory to a frame buffer configuration.
+
+  When a shadow buffer is attached, all Blt operations are done on the shadow
+  buffer and only the changed rectangle is copied to the frame buffer, so the
+  frame buffer is never read back. The current frame buffer content is copied
+  to the shadow buffer once when it is attached.
+
+  Each Blt operation writes its rectangle to the frame buffer before it returns;
+  the changes of several operations are not coalesced. Anything that writes the
+  frame buffer directly, instead of through Blt operations, leaves the shadow
+  buffer stale, and the next VideoToBltBuffer or VideoToVideo operation returns
+  or copies the old content.
+
+  @param[in,out] Configure        Pointer to a configuration which was successfully
+                                  created by FrameBufferBltConfigure ().
+  @param[in]     ShadowBuffer     The shadow buffer, or NULL to detach the shadow
+                                  buffer.
+  @param[in,out] ShadowBufferSize Size of the shadow buffer in bytes. When
+                                  ShadowBuffer is NULL, the required size is
+                                  returned.
+
+  @retval RETURN_SUCCESS            The shadow buffer was attached or detached.
+  @retval RETURN_BUFFER_TOO_SMALL   The ShadowBuffer is too small. The required
+                                    size is returned in ShadowBufferSize.
+  @retval RETURN_INVALID_PARAMETER  Configure or ShadowBufferSize is NULL.
+**/
+RETURN_STATUS
+EFIAPI
+FrameBufferBltSetShadowBuffer (
+  IN OUT  FRAME_BUFFER_CONFIGURE                *Configure,
+  IN      VOID                                  *ShadowBuffer, OPTIONAL
+  IN OUT  UINTN                                 *ShadowBufferSize
+  );
+
 /**
   Performs a UEFI Graphics Output Protocol Blt operation.
 
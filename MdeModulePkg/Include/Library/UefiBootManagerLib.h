@@ -559,6 +559,31 @@ EfiBootManagerConnectAll (
   VOID
   );
 
+/**
+  Connect the controllers needed to boot the boot option that will be tried
+  first, using the full device path it was loaded from last time. All the
+  controllers are connected when no full device path is saved for the boot
+  option or when the device cannot be found on that path any more.
+
+  EfiBootManagerBoot() saves the full device path in L"BootPath####" each
+  time it loads a boot option. A platform that calls this function instead of
+  EfiBootManagerConnectAll() only connects one device chain on most boots.
+
+  The default consoles are connected in both cases. If only the saved full
+  device path was connected and a boot option then fails to load or start,
+  EfiBootManagerBoot() calls EfiBootManagerConnectAll() before it returns, so
+  that the boot options tried next find their devices.
+
+  @retval EFI_SUCCESS    The controllers on the saved full device path have
+                         been connected.
+  @retval EFI_NOT_FOUND  All the controllers have been connected instead.
+**/
+EFI_STATUS
+EFIAPI
+EfiBootManagerConnectBootPath (
+  VOID
+  );
+
 /**
   This function will create all handles associate with every device
   path node. If the handle associate with one device path node can not
@@ -0,0 +1,145 @@
+/** @file
+  Protocols to queue several bulk transfers at once.
+
+  EDKII_USB2_HC_BULK_QUEUE_PROTOCOL is installed by a host controller driver
+  next to EFI_USB2_HC_PROTOCOL when it can keep more than one bulk transfer
+  outstanding. EDKII_USB_IO_BULK_QUEUE_PROTOCOL is installed by the USB bus
+  driver next to EFI_USB_IO_PROTOCOL on the interfaces of such a controller.
+
+  All transfers of one call are handed to the host controller before the call
+  waits for any of them, and they are executed in the order of the entries on
+  each endpoint. When a transfer fails, the transfers of the later entries are
+  aborted and reported as EFI_USB_ERR_NOTEXECUTE.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __USB_BULK_QUEUE_H__
+#define __USB_BULK_QUEUE_H__
+
+#include <Protocol/Usb2HostController.h>
+#include <Protocol/UsbIo.h>
+
+#define EDKII_USB2_HC_BULK_QUEUE_PROTOCOL_GUID \
+  { 0x3f4e5a34, 0x8b60, 0x47bf, { 0xb6, 0x53, 0x6a, 0x45, 0x33, 0x21, 0x00, 0x49 } }
+
+#define EDKII_USB_IO_BULK_QUEUE_PROTOCOL_GUID \
+  { 0x2ac0e22f, 0x30fe, 0x4abd, { 0xab, 0x72, 0x6e, 0x12, 0x66, 0xc0, 0x9b, 0x53 } }
+
+typedef struct _EDKII_USB2_HC_BULK_QUEUE_PROTOCOL  EDKII_USB2_HC_BULK_QUEUE_PROTOCOL;
+typedef struct _EDKII_USB_IO_BULK_QUEUE_PROTOCOL   EDKII_USB_IO_BULK_QUEUE_PROTOCOL;
+
+///
+/// One bulk transfer of a queue.
+///
+typedef struct {
+  ///
+  /// The bulk endpoint address, including the direction bit.
+  ///
+  UINT8     EndPointAddress;
+  ///
+  /// The maximum packet size of the endpoint. Filled in by the USB bus driver
+  /// for EDKII_USB_IO_BULK_QUEUE_PROTOCOL callers.
+  ///
+  UINTN     MaximumPacketLength;
+  ///
+  /// The data buffer.
+  ///
+  VOID      *Data;
+  ///
+  /// On input, the size of Data in bytes. On output, the number of bytes
+  /// that were transferred.
+  ///
+  UINTN     DataLength;
+  ///
+  /// On output, the EFI_USB_ERR_* result of the transfer.
+  ///
+  UINT32    TransferResult;
+} EDKII_USB_BULK_QUEUE_ENTRY;
+
+/**
+  Submit several bulk transfers to a USB device, and wait until all of them
+  have completed, one of them has failed, or the timeout has expired.
+
+  @param  This                  This EDKII_USB2_HC_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  Count                 Number of entries in Entries.
+  @param  Entries               The transfers to execute, in order.
+  @param  Timeout               Time, in milliseconds, within which all transfers
+                                should complete. 0 waits without limit.
+  @param  Translator            A pointer to the transaction translator data.
+
+  @retval EFI_SUCCESS           All transfers completed successfully.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The transfers do not fit in the transfer rings
+                                of the host controller. Nothing was executed.
+  @retval EFI_TIMEOUT           The transfers failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed. The TransferResult of the
+                                entries tell which one.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_BULK_QUEUE_TRANSFER) (
+  IN     EDKII_USB2_HC_BULK_QUEUE_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY          *Entries,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  );
+
+/**
+  Submit several bulk transfers to the endpoints of a USB interface, and wait
+  until all of them have completed, one of them has failed, or the timeout has
+  expired.
+
+  @param  This                  This EDKII_USB_IO_BULK_QUEUE_PROTOCOL instance.
+  @param  Count                 Number of entries in Entries.
+  @param  Entries               The transfers to execute, in order.
+  @param  Timeout               Time, in milliseconds, within which all transfers
+                                should complete. 0 waits without limit.
+
+  @retval EFI_SUCCESS           All transfers completed successfully.
+  @retval EFI_INVALID_PARAMETER An entry does not name a bulk endpoint of the
+                                interface.
+  @retval EFI_OUT_OF_RESOURCES  The transfers do not fit in the transfer rings
+                                of the host controller. Nothing was executed.
+  @retval EFI_TIMEOUT           The transfers failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed. The TransferResult of the
+                                entries tell which one.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_BULK_QUEUE_TRANSFER) (
+  IN     EDKII_USB_IO_BULK_QUEUE_PROTOCOL    *This,
+  IN     UINTN                               Count,
+  IN OUT EDKII_USB_BULK_QUEUE_ENTRY          *Entries,
+  IN     UINTN                               Timeout
+  );
+
+struct _EDKII_USB2_HC_BULK_QUEUE_PROTOCOL {
+  EDKII_USB2_HC_BULK_QUEUE_TRANSFER    QueueTransfer;
+  ///
+  /// The largest number of entries QueueTransfer() accepts.
+  ///
+  UINTN                                MaxEntries;
+};
+
+struct _EDKII_USB_IO_BULK_QUEUE_PROTOCOL {
+  EDKII_USB_IO_BULK_QUEUE_TRANSFER     QueueTransfer;
+  ///
+  /// The largest number of entries QueueTransfer() accepts.
+  ///
+  UINTN                                MaxEntries;
+};
+
+extern EFI_GUID gEdkiiUsb2HcBulkQueueProtocolGuid;
+extern EFI_GUID gEdkiiUsbIoBulkQueueProtocolGuid;
+
+#endif
@@ -60,6 +60,36 @@ typedef struct {
 HANDLE_GUID_MAP mCacheHandleGuidTable[CACHE_HANDLE_GUID_COUNT];
 UINTN           mCachePairCount = 0;
 
+//
+// A measurement saved by CreatePerformanceMeasurement() when
+// PcdEdkiiFpdtDeferredRecordCount is not 0. It is turned into an FPDT record
+// at ReadyToBoot, or earlier when the buffer is full or an image that ran is
+// about to be unloaded.
+//
+typedef struct {
+  CONST VOID                  *CallerIdentifier;
+  EFI_GUID                    CallerGuid;
+  EFI_GUID                    Guid;
+  CHAR8                       String[STRING_SIZE];
+  UINT64                      Ticker;
+  UINT64                      Address;
+  UINT32                      Identifier;
+  PERF_MEASUREMENT_ATTRIBUTE  Attribute;
+  BOOLEAN                     HasCallerGuid;
+  BOOLEAN                     HasGuid;
+  BOOLEAN                     HasString;
+  volatile BOOLEAN            Valid;
+} DEFERRED_PERF_RECORD;
+
+//
+// Ring buffer of deferred records. Head and Tail only ever grow; the slot of
+// a record is its position modulo mDeferredRecordCount.
+//
+DEFERRED_PERF_RECORD  *mDeferredRecords    = NULL;
+UINT32                mDeferredRecordCount = 0;
+UINT32                mDeferredRecordHead  = 0;
+volatile UINT32       mDeferredRecordTail  = 0;
+
 UINT32  mLoadImageCount       = 0;
 UINT32  mPerformanceLength    = 0;
 UINT32  mMaxPerformanceLength = 0;
@@ -1244,6 +1274,120 @@ InsertFpdtRecord (
   return EFI_SUCCESS;
 }
 
+/**
+  Turn the measurements saved in the deferred record buffer into FPDT records,
+  oldest first. It stops at a record that is still being filled in by an
+  interrupted CreatePerformanceMeasurement().
+
+  The caller must have set mLockInsertRecord.
+
+**/
+VOID
+FlushDeferredRecords (
+  VOID
+  )
+{
+  DEFERRED_PERF_RECORD  *Record;
+  CONST VOID            *CallerIdentifier;
+
+  while (mDeferredRecordHead != mDeferredRecordTail) {
+    Record = &mDeferredRecords[mDeferredRecordHead % mDeferredRecordCount];
+    if (!Record->Valid) {
+      break;
+    }
+
+    CallerIdentifier = Record->HasCallerGuid ? &Record->CallerGuid : Record->CallerIdentifier;
+    InsertFpdtRecord (
+      CallerIdentifier,
+      Record->HasGuid ? &Record->Guid : NULL,
+      Record->HasString ? Record->String : NULL,
+      Record->Ticker,
+      Record->Address,
+      (UINT16) Record->Identifier,
+      Record->Attribute
+      );
+
+    Record->Valid = FALSE;
+    mDeferredRecordHead++;
+  }
+}
+
+/**
+  Save a measurement in the deferred record buffer.
+
+  The slot is reserved with a compare-exchange, so a measurement taken by an
+  event at a higher TPL can be saved while another one is being saved. No
+  memory is allocated and no protocol is looked up: module names, device paths
+  and the FPDT record layout are resolved when the buffer is flushed. The
+  buffer is flushed before DxeCore unloads an image that failed to start, or
+  an application, so the handles it holds are still valid then.
+
+  @param CallerIdentifier  - Image handle or pointer to caller ID GUID.
+  @param Guid              - Pointer to a GUID.
+  @param String            - Pointer to a string describing the measurement.
+  @param Ticker            - 64-bit time stamp, or 1 for the start of the reset.
+  @param Address           - Pointer to a location in memory relevant to the measurement.
+  @param Identifier        - Performance identifier describing the type of measurement.
+  @param Attribute         - The attribute of the measurement.
+
+  @retval EFI_SUCCESS           - The measurement is saved.
+  @retval EFI_OUT_OF_RESOURCES  - The deferred record buffer is full.
+**/
+EFI_STATUS
+SaveDeferredRecord (
+  IN CONST VOID                        *CallerIdentifier,  OPTIONAL
+  IN CONST VOID                        *Guid,    OPTIONAL
+  IN CONST CHAR8                       *String,  OPTIONAL
+  IN       UINT64                      Ticker,
+  IN       UINT64                      Address,  OPTIONAL
+  IN       UINT32                      Identifier,
+  IN       PERF_MEASUREMENT_ATTRIBUTE  Attribute
+  )
+{
+  UINT32                Tail;
+  DEFERRED_PERF_RECORD  *Record;
+
+  do {
+    Tail = mDeferredRecordTail;
+    if (Tail - mDeferredRecordHead >= mDeferredRecordCount) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  } while (InterlockedCompareExchange32 (&mDeferredRecordTail, Tail, Tail + 1) != Tail);
+
+  Record = &mDeferredRecords[Tail % mDeferredRecordCount];
+  Record->CallerIdentifier = CallerIdentifier;
+  Record->Ticker           = Ticker;
+  Record->Address          = Address;
+  Record->Identifier       = Identifier;
+  Record->Attribute        = Attribute;
+
+  //
+  // The caller ID GUID of the event and callback records is copied into the
+  // FPDT record, keep it in case the module is unloaded before the flush.
+  //
+  Record->HasCallerGuid = (BOOLEAN) ((CallerIdentifier != NULL) &&
+                                     ((Identifier == PERF_EVENTSIGNAL_START_ID) || (Identifier == PERF_EVENTSIGNAL_END_ID) ||
+                                      (Identifier == PERF_CALLBACK_START_ID) || (Identifier == PERF_CALLBACK_END_ID)));
+  if (Record->HasCallerGuid) {
+    CopyGuid (&Record->CallerGuid, CallerIdentifier);
+  }
+  Record->HasGuid = (BOOLEAN) (Guid != NULL);
+  if (Record->HasGuid) {
+    CopyGuid (&Record->Guid, Guid);
+  }
+  //
+  // FPDT records hold at most STRING_SIZE characters of the string.
+  //
+  Record->HasString = (BOOLEAN) (String != NULL);
+  if (Record->HasString) {
+    AsciiStrnCpyS (Record->String, sizeof (Record->String), String, sizeof (Record->String) - 1);
+  }
+
+  MemoryFence ();
+  Record->Valid = TRUE;
+  return EFI_SUCCESS;
+}
+
 /**
   Dumps all the PEI performance.
 
@@ -1316,6 +1460,16 @@ ReportFpdtRecordBuffer (
   UINT64          BPDTAddr;
 
   if (!mFpdtBufferIsReported) {
+    //
+    // Build the records of the deferred measurements before the boot
+    // performance table is allocated, so that it is large enough for them.
+    //
+    if (mDeferredRecords != NULL) {
+      mLockInsertRecord = TRUE;
+      FlushDeferredRecords ();
+      mLockInsertRecord = FALSE;
+    }
+
     Status = AllocateBootPerformanceTable ();
     if (!EFI_ERROR(Status)) {
       BPDTAddr = (UINT64)(UINTN)mAcpiBootPerformanceTable;
@@ -1333,6 +1487,16 @@ ReportFpdtRecordBuffer (
     // Set FPDT report state to TRUE.
     //
     mFpdtBufferIsReported = TRUE;
+
+    //
+    // Records created from now on go to the boot performance table directly.
+    // Measurements deferred while the table was allocated go there too.
+    //
+    if (mDeferredRecords != NULL) {
+      mLockInsertRecord = TRUE;
+      FlushDeferredRecords ();
+      mLockInsertRecord = FALSE;
+    }
   }
 }
 
@@ -1373,6 +1537,16 @@ DxeCorePerformanceLibConstructor (
   //
   InternalGetPeiPerformance (GetHobList());
 
+  //
+  // Preallocate the buffer of deferred records.
+  //
+  if (PcdGet32 (PcdEdkiiFpdtDeferredRecordCount) != 0) {
+    mDeferredRecords = AllocateZeroPool (PcdGet32 (PcdEdkiiFpdtDeferredRecordCount) * sizeof (DEFERRED_PERF_RECORD));
+    if (mDeferredRecords != NULL) {
+      mDeferredRecordCount = PcdGet32 (PcdEdkiiFpdtDeferredRecordCount);
+    }
+  }
+
   //
   // Install the protocol interfaces for DXE performance library instance.
   //
@@ -1451,6 +1625,44 @@ CreatePerformanceMeasurement (
 
   Status = EFI_SUCCESS;
 
+  //
+  // Before ReadyToBoot, only save the measurement when records are deferred.
+  //
+  if ((mDeferredRecords != NULL) && !mFpdtBufferIsReported) {
+    if (TimeStamp == 0) {
+      TimeStamp = GetPerformanceCounter ();
+    }
+    Status = SaveDeferredRecord (CallerIdentifier, Guid, String, TimeStamp, Address, Identifier, Attribute);
+    if (mLockInsertRecord) {
+      //
+      // The buffer is being flushed, the flush picks a saved measurement up.
+      //
+      return Status;
+    }
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      //
+      // The buffer is full, make room in it.
+      //
+      mLockInsertRecord = TRUE;
+      FlushDeferredRecords ();
+      mLockInsertRecord = FALSE;
+      Status = SaveDeferredRecord (CallerIdentifier, Guid, String, TimeStamp, Address, Identifier, Attribute);
+    }
+    if (mFpdtBufferIsReported ||
+        ((Identifier == MODULE_END_ID) && (CallerIdentifier == NULL))) {
+      //
+      // Either ReadyToBoot was handled by an event dispatched while the
+      // measurement was saved, and the buffer is no longer flushed after that,
+      // or StartImage() is about to unload the image that just ran. The
+      // handles of that image have to be resolved while they are valid.
+      //
+      mLockInsertRecord = TRUE;
+      FlushDeferredRecords ();
+      mLockInsertRecord = FALSE;
+    }
+    return Status;
+  }
+
   if (mLockInsertRecord) {
     return EFI_INVALID_PARAMETER;
   }
@@ -20,6 +20,7 @@ struct FRAME_BUFFER_CONFIGURE {
   UINT32                          Width;
   UINT32                          Height;
   UINT8                           *FrameBuffer;
+  UINT8                           *ShadowBuffer;
   EFI_GRAPHICS_PIXEL_FORMAT       PixelFormat;
   EFI_PIXEL_BITMASK               PixelMasks;
   INT8                            PixelShl[4]; // R-G-B-Rsvd
@@ -161,6 +162,7 @@ FrameBufferBltConfigure (
   Configure->BytesPerPixel     = BytesPerPixel;
   Configure->PixelFormat       = FrameBufferInfo->PixelFormat;
   Configure->FrameBuffer       = (UINT8*) FrameBuffer;
+  Configure->ShadowBuffer      = NULL;
   Configure->Width             = FrameBufferInfo->HorizontalResolution;
   Configure->Height            = FrameBufferInfo->VerticalResolution;
   Configure->PixelsPerScanLine = FrameBufferInfo->PixelsPerScanLine;
@@ -168,6 +170,127 @@ FrameBufferBltConfigure (
   return RETURN_SUCCESS;
 }
 
+/**
+  Attach a shadow buffer in system memory to a frame buffer configuration.
+
+  When a shadow buffer is attached, all Blt operations are done on the shadow
+  buffer and only the changed rectangle is copied to the frame buffer, so the
+  frame buffer is never read back. The current frame buffer content is copied
+  to the shadow buffer once when it is attached.
+
+  @param[in,out] Configure        Pointer to a configuration which was successfully
+                                  created by FrameBufferBltConfigure ().
+  @param[in]     ShadowBuffer     The shadow buffer, or NULL to detach the shadow
+                                  buffer.
+  @param[in,out] ShadowBufferSize Size of the shadow buffer in bytes. When
+                                  ShadowBuffer is NULL, the required size is
+                                  returned.
+
+  @retval RETURN_SUCCESS            The shadow buffer was attached or detached.
+  @retval RETURN_BUFFER_TOO_SMALL   The ShadowBuffer is too small. The required
+                                    size is returned in ShadowBufferSize.
+  @retval RETURN_INVALID_PARAMETER  Configure or ShadowBufferSize is NULL.
+**/
+RETURN_STATUS
+EFIAPI
+FrameBufferBltSetShadowBuffer (
+  IN OUT FRAME_BUFFER_CONFIGURE                *Configure,
+  IN     VOID                                  *ShadowBuffer, OPTIONAL
+  IN OUT UINTN                                 *ShadowBufferSize
+  )
+{
+  UINTN                                        FrameBufferSize;
+
+  if (Configure == NULL || ShadowBufferSize == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  FrameBufferSize = (UINTN) Configure->PixelsPerScanLine * Configure->Height *
+                    Configure->BytesPerPixel;
+  if (ShadowBuffer == NULL) {
+    Configure->ShadowBuffer = NULL;
+    *ShadowBufferSize       = FrameBufferSize;
+    return RETURN_SUCCESS;
+  }
+
+  if (*ShadowBufferSize < FrameBufferSize) {
+    *ShadowBufferSize = FrameBufferSize;
+    return RETURN_BUFFER_TOO_SMALL;
+  }
+
+  CopyMem (ShadowBuffer, Configure->FrameBuffer, FrameBufferSize);
+  Configure->ShadowBuffer = (UINT8 *) ShadowBuffer;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Return the buffer the Blt operations work on, which is the shadow buffer
+  when one is attached and the frame buffer otherwise.
+
+  @param[in]  Configure     Pointer to a configuration which was successfully
+                            created by FrameBufferBltConfigure ().
+
+  @return The buffer the Blt operations work on.
+**/
+UINT8 *
+FrameBufferBltLibSurface (
+  IN  FRAME_BUFFER_CONFIGURE        *Configure
+  )
+{
+  if (Configure->ShadowBuffer != NULL) {
+    return Configure->ShadowBuffer;
+  }
+  return Configure->FrameBuffer;
+}
+
+/**
+  Copy a rectangle of the shadow buffer to the frame buffer.
+
+  Nothing is done when no shadow buffer is attached.
+
+  @param[in]  Configure     Pointer to a configuration which was successfully
+                            created by FrameBufferBltConfigure ().
+  @param[in]  X             X location of the rectangle.
+  @param[in]  Y             Y location of the rectangle.
+  @param[in]  Width         Width (in pixels) of the rectangle.
+  @param[in]  Height        Height of the rectangle.
+**/
+VOID
+FrameBufferBltLibFlushShadow (
+  IN  FRAME_BUFFER_CONFIGURE        *Configure,
+  IN  UINTN                         X,
+  IN  UINTN                         Y,
+  IN  UINTN                         Width,
+  IN  UINTN                         Height
+  )
+{
+  UINTN                             Offset;
+  UINTN                             WidthInBytes;
+  UINTN                             LineStride;
+
+  if (Configure->ShadowBuffer == NULL) {
+    return;
+  }
+
+  Offset       = Configure->BytesPerPixel * ((Y * Configure->PixelsPerScanLine) + X);
+  WidthInBytes = Width * Configure->BytesPerPixel;
+  LineStride   = Configure->BytesPerPixel * Configure->PixelsPerScanLine;
+
+  if (Width == Configure->PixelsPerScanLine) {
+    //
+    // The rectangle covers full scan lines, copy it with one shot.
+    //
+    CopyMem (Configure->FrameBuffer + Offset, Configure->ShadowBuffer + Offset, WidthInBytes * Height);
+    return;
+  }
+
+  while (Height-- > 0) {
+    CopyMem (Configure->FrameBuffer + Offset, Configure->ShadowBuffer + Offset, WidthInBytes);
+    Offset += LineStride;
+  }
+}
+
 /**
   Performs a UEFI Graphics Output Protocol Blt Video Fill.
 
@@ -270,7 +393,7 @@ FrameBufferBltLibVideoFill (
     DEBUG ((EFI_D_VERBOSE, "VideoFill (wide, one-shot)\n"));
     Offset = DestinationY * Configure->PixelsPerScanLine;
     Offset = Configure->BytesPerPixel * Offset;
-    Destination = Configure->FrameBuffer + Offset;
+    Destination = FrameBufferBltLibSurface (Configure) + Offset;
     SizeInBytes = WidthInBytes * Height;
     if (SizeInBytes >= 8) {
       SetMem32 (Destination, SizeInBytes & ~3, (UINT32) WideFill);
@@ -285,7 +408,7 @@ FrameBufferBltLibVideoFill (
     for (IndexY = DestinationY; IndexY < (Height + DestinationY); IndexY++) {
       Offset = (IndexY * Configure->PixelsPerScanLine) + DestinationX;
       Offset = Configure->BytesPerPixel * Offset;
-      Destination = Configure->FrameBuffer + Offset;
+      Destination = FrameBufferBltLibSurface (Configure) + Offset;
 
       if (UseWideFill && (((UINTN) Destination & 7) == 0)) {
         DEBUG ((EFI_D_VERBOSE, "VideoFill (wide)\n"));
@@ -317,6 +440,8 @@ FrameBufferBltLibVideoFill (
     }
   }
 
+  FrameBufferBltLibFlushShadow (Configure, DestinationX, DestinationY, Width, Height);
+
   return RETURN_SUCCESS;
 }
 
@@ -396,7 +521,7 @@ FrameBufferBltLibVideoToBltBuffer (
 
     Offset = (SrcY * Configure->PixelsPerScanLine) + SourceX;
     Offset = Configure->BytesPerPixel * Offset;
-    Source = Configure->FrameBuffer + Offset;
+    Source = FrameBufferBltLibSurface (Configure) + Offset;
 
     if (Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
       Destination = (UINT8 *) BltBuffer + (DstY * Delta) + (DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
@@ -501,7 +626,7 @@ FrameBufferBltLibBufferToVideo (
 
     Offset = (DstY * Configure->PixelsPerScanLine) + DestinationX;
     Offset = Configure->BytesPerPixel * Offset;
-    Destination = Configure->FrameBuffer + Offset;
+    Destination = FrameBufferBltLibSurface (Configure) + Offset;
 
     if (Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
       Source = (UINT8 *) BltBuffer + (SrcY * Delta) + SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
@@ -530,6 +655,8 @@ FrameBufferBltLibBufferToVideo (
     CopyMem (Destination, Source, WidthInBytes);
   }
 
+  FrameBufferBltLibFlushShadow (Configure, DestinationX, DestinationY, Width, Height);
+
   return RETURN_SUCCESS;
 }
 
@@ -564,6 +691,7 @@ FrameBufferBltLibVideoToVideo (
   UINTN                                     Offset;
   UINTN                                     WidthInBytes;
   INTN                                      LineStride;
+  UINTN                                     Lines;
 
   //
   // Video to Video: Source is Video, destination is Video
@@ -592,29 +720,35 @@ FrameBufferBltLibVideoToVideo (
 
   Offset = (SourceY * Configure->PixelsPerScanLine) + SourceX;
   Offset = Configure->BytesPerPixel * Offset;
-  Source = Configure->FrameBuffer + Offset;
+  Source = FrameBufferBltLibSurface (Configure) + Offset;
 
   Offset = (DestinationY * Configure->PixelsPerScanLine) + DestinationX;
   Offset = Configure->BytesPerPixel * Offset;
-  Destination = Configure->FrameBuffer + Offset;
+  Destination = FrameBufferBltLibSurface (Configure) + Offset;
 
   LineStride = Configure->BytesPerPixel * Configure->PixelsPerScanLine;
   if (Destination > Source) {
     //
     // Copy from last line to avoid source is corrupted by copying
     //
-    Source += Height * LineStride;
-    Destination += Height * LineStride;
+    Source += (Height - 1) * LineStride;
+    Destination += (Height - 1) * LineStride;
     LineStride = -LineStride;
   }
 
-  while (Height-- > 0) {
+  for (Lines = Height; Lines > 0; Lines--) {
     CopyMem (Destination, Source, WidthInBytes);
 
     Source += LineStride;
     Destination += LineStride;
   }
 
+  //
+  // With a shadow buffer the move above only reads system memory, and the
+  // destination rectangle is then written to the frame buffer.
+  //
+  FrameBufferBltLibFlushShadow (Configure, DestinationX, DestinationY, Width, Height);
+
   return RETURN_SUCCESS;
 }
 
@@ -0,0 +1,419 @@
+/** @file
+  Unit tests of the FrameBufferBltLib shadow buffer support, plus a benchmark
+  that scrolls a full screen of boot log with and without the shadow buffer.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/FrameBufferBltLib.h>
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "FrameBufferBltLib Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Screen geometry of the tests, a 100x31 text console with the 8x19 EFI font.
+//
+#define TEST_HORIZONTAL_RESOLUTION  800
+#define TEST_VERTICAL_RESOLUTION    600
+#define TEST_PIXELS_PER_SCAN_LINE   832
+#define TEST_GLYPH_WIDTH            8
+#define TEST_GLYPH_HEIGHT           19
+#define TEST_SCROLL_ITERATIONS      (TEST_VERTICAL_RESOLUTION / TEST_GLYPH_HEIGHT)
+#define TEST_BENCHMARK_SCREENS      20
+
+typedef struct {
+  EFI_GRAPHICS_OUTPUT_MODE_INFORMATION  Info;
+  UINT8                                 *FrameBuffer;
+  UINTN                                 FrameBufferSize;
+  FRAME_BUFFER_CONFIGURE                *Configure;
+  VOID                                  *ShadowBuffer;
+} FRAME_BUFFER_TEST_CONTEXT;
+
+/**
+  Create a frame buffer and its FrameBufferBltLib configuration.
+
+  @param[out] Context     The test frame buffer.
+  @param[in]  Shadow      Whether to attach a shadow buffer.
+
+  @retval EFI_SUCCESS     The frame buffer is created.
+  @retval Others          Fail to create the frame buffer.
+**/
+STATIC
+EFI_STATUS
+CreateTestFrameBuffer (
+  OUT FRAME_BUFFER_TEST_CONTEXT  *Context,
+  IN  BOOLEAN                    Shadow
+  )
+{
+  RETURN_STATUS  Status;
+  UINTN          ConfigureSize;
+  UINTN          ShadowBufferSize;
+  UINTN          Index;
+
+  ZeroMem (Context, sizeof (*Context));
+  Context->Info.HorizontalResolution = TEST_HORIZONTAL_RESOLUTION;
+  Context->Info.VerticalResolution   = TEST_VERTICAL_RESOLUTION;
+  Context->Info.PixelFormat          = PixelBlueGreenRedReserved8BitPerColor;
+  Context->Info.PixelsPerScanLine    = TEST_PIXELS_PER_SCAN_LINE;
+
+  Context->FrameBufferSize = TEST_PIXELS_PER_SCAN_LINE * TEST_VERTICAL_RESOLUTION * sizeof (UINT32);
+  Context->FrameBuffer     = AllocatePool (Context->FrameBufferSize);
+  if (Context->FrameBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  //
+  // Start from a known, non trivial picture.
+  //
+  for (Index = 0; Index < Context->FrameBufferSize; Index++) {
+    Context->FrameBuffer[Index] = (UINT8) (Index * 7 + (Index >> 12));
+  }
+
+  ConfigureSize = 0;
+  Status = FrameBufferBltConfigure (Context->FrameBuffer, &Context->Info, NULL, &ConfigureSize);
+  if (Status != RETURN_BUFFER_TOO_SMALL) {
+    return EFI_DEVICE_ERROR;
+  }
+  Context->Configure = AllocatePool (ConfigureSize);
+  if (Context->Configure == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Status = FrameBufferBltConfigure (Context->FrameBuffer, &Context->Info, Context->Configure, &ConfigureSize);
+  if (RETURN_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Shadow) {
+    FrameBufferBltSetShadowBuffer (Context->Configure, NULL, &ShadowBufferSize);
+    Context->ShadowBuffer = AllocatePool (ShadowBufferSize);
+    if (Context->ShadowBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Status = FrameBufferBltSetShadowBuffer (Context->Configure, Context->ShadowBuffer, &ShadowBufferSize);
+    if (RETURN_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free a frame buffer created by CreateTestFrameBuffer ().
+
+  @param[in] Context     The test frame buffer.
+**/
+STATIC
+VOID
+FreeTestFrameBuffer (
+  IN FRAME_BUFFER_TEST_CONTEXT  *Context
+  )
+{
+  if (Context->ShadowBuffer != NULL) {
+    FreePool (Context->ShadowBuffer);
+  }
+  if (Context->Configure != NULL) {
+    FreePool (Context->Configure);
+  }
+  if (Context->FrameBuffer != NULL) {
+    FreePool (Context->FrameBuffer);
+  }
+}
+
+/**
+  Print one line of boot log the way GraphicsConsoleDxe does: scroll the
+  screen up by one text line when the cursor is at the bottom, clear the last
+  line and draw the glyphs of the new line.
+
+  @param[in] Configure     The FrameBufferBltLib configuration.
+  @param[in] Line          The index of the line which is printed.
+  @param[in] Glyph         A glyph sized BltBuffer.
+
+  @retval RETURN_SUCCESS   The line is printed.
+  @retval Others           A Blt operation failed.
+**/
+STATIC
+RETURN_STATUS
+PrintBootLogLine (
+  IN FRAME_BUFFER_CONFIGURE         *Configure,
+  IN UINTN                          Line,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Glyph
+  )
+{
+  RETURN_STATUS                  Status;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background;
+  UINTN                          Column;
+  UINTN                          Rows;
+
+  Rows = TEST_VERTICAL_RESOLUTION / TEST_GLYPH_HEIGHT;
+  ZeroMem (&Background, sizeof (Background));
+
+  Status = FrameBufferBlt (
+             Configure,
+             NULL,
+             EfiBltVideoToVideo,
+             0, TEST_GLYPH_HEIGHT,
+             0, 0,
+             TEST_HORIZONTAL_RESOLUTION, (Rows - 1) * TEST_GLYPH_HEIGHT,
+             0
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = FrameBufferBlt (
+             Configure,
+             &Background,
+             EfiBltVideoFill,
+             0, 0,
+             0, (Rows - 1) * TEST_GLYPH_HEIGHT,
+             TEST_HORIZONTAL_RESOLUTION, TEST_GLYPH_HEIGHT,
+             0
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Draw a line of varying length, like a real boot log.
+  //
+  for (Column = 0; Column < (Line * 13) % (TEST_HORIZONTAL_RESOLUTION / TEST_GLYPH_WIDTH); Column++) {
+    Status = FrameBufferBlt (
+               Configure,
+               Glyph,
+               EfiBltBufferToVideo,
+               0, 0,
+               Column * TEST_GLYPH_WIDTH, (Rows - 1) * TEST_GLYPH_HEIGHT,
+               TEST_GLYPH_WIDTH, TEST_GLYPH_HEIGHT,
+               0
+               );
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Fill a glyph sized BltBuffer with a pattern depending on Seed.
+
+  @param[out] Glyph     The glyph sized BltBuffer.
+  @param[in]  Seed      The pattern seed.
+**/
+STATIC
+VOID
+FillGlyph (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Glyph,
+  IN  UINTN                          Seed
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < TEST_GLYPH_WIDTH * TEST_GLYPH_HEIGHT; Index++) {
+    Glyph[Index].Blue     = (UINT8) (Seed + Index);
+    Glyph[Index].Green    = (UINT8) (Seed * 3 + Index);
+    Glyph[Index].Red      = (UINT8) (Seed * 5 + Index);
+    Glyph[Index].Reserved = 0;
+  }
+}
+
+/**
+  Unit test that a frame buffer with a shadow buffer attached ends up with the
+  same content as one without, after fills, buffer writes, scrolls in both
+  directions and reads back.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ShadowBufferShouldMatchFrameBuffer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FRAME_BUFFER_TEST_CONTEXT      Direct;
+  FRAME_BUFFER_TEST_CONTEXT      Shadowed;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Glyph[TEST_GLYPH_WIDTH * TEST_GLYPH_HEIGHT];
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  ReadDirect[TEST_GLYPH_WIDTH * TEST_GLYPH_HEIGHT];
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  ReadShadowed[TEST_GLYPH_WIDTH * TEST_GLYPH_HEIGHT];
+  UINTN                          Line;
+
+  UT_ASSERT_NOT_EFI_ERROR (CreateTestFrameBuffer (&Direct, FALSE));
+  UT_ASSERT_NOT_EFI_ERROR (CreateTestFrameBuffer (&Shadowed, TRUE));
+
+  for (Line = 0; Line < 2 * TEST_SCROLL_ITERATIONS; Line++) {
+    FillGlyph (Glyph, Line);
+    UT_ASSERT_NOT_EFI_ERROR (PrintBootLogLine (Direct.Configure, Line, Glyph));
+    UT_ASSERT_NOT_EFI_ERROR (PrintBootLogLine (Shadowed.Configure, Line, Glyph));
+  }
+
+  //
+  // Scroll down a partial rectangle, the copy must start from the last line.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FrameBufferBlt (Direct.Configure, NULL, EfiBltVideoToVideo, 16, 0, 24, 5, 200, TEST_VERTICAL_RESOLUTION - 5, 0));
+  UT_ASSERT_NOT_EFI_ERROR (FrameBufferBlt (Shadowed.Configure, NULL, EfiBltVideoToVideo, 16, 0, 24, 5, 200, TEST_VERTICAL_RESOLUTION - 5, 0));
+
+  UT_ASSERT_MEM_EQUAL (Direct.FrameBuffer, Shadowed.FrameBuffer, Direct.FrameBufferSize);
+
+  UT_ASSERT_NOT_EFI_ERROR (FrameBufferBlt (Direct.Configure, ReadDirect, EfiBltVideoToBltBuffer, 40, 60, 0, 0, TEST_GLYPH_WIDTH, TEST_GLYPH_HEIGHT, 0));
+  UT_ASSERT_NOT_EFI_ERROR (FrameBufferBlt (Shadowed.Configure, ReadShadowed, EfiBltVideoToBltBuffer, 40, 60, 0, 0, TEST_GLYPH_WIDTH, TEST_GLYPH_HEIGHT, 0));
+  UT_ASSERT_MEM_EQUAL (ReadDirect, ReadShadowed, sizeof (ReadDirect));
+
+  FreeTestFrameBuffer (&Direct);
+  FreeTestFrameBuffer (&Shadowed);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark scrolling a full screen of boot log with and without the shadow
+  buffer. On the host the frame buffer is plain memory, so the numbers only
+  show the cost of the extra copy; on real hardware reads of the frame buffer
+  are much slower than reads of system memory.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkBootLogScrolling (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FRAME_BUFFER_TEST_CONTEXT      FrameBuffer;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Glyph[TEST_GLYPH_WIDTH * TEST_GLYPH_HEIGHT];
+  UINTN                          Shadow;
+  UINTN                          Line;
+  clock_t                        Start;
+  clock_t                        End;
+
+  FillGlyph (Glyph, 0);
+  for (Shadow = 0; Shadow < 2; Shadow++) {
+    UT_ASSERT_NOT_EFI_ERROR (CreateTestFrameBuffer (&FrameBuffer, (BOOLEAN) (Shadow != 0)));
+
+    Start = clock ();
+    for (Line = 0; Line < TEST_BENCHMARK_SCREENS * TEST_SCROLL_ITERATIONS; Line++) {
+      UT_ASSERT_NOT_EFI_ERROR (PrintBootLogLine (FrameBuffer.Configure, Line, Glyph));
+    }
+    End = clock ();
+
+    DEBUG ((
+      DEBUG_INFO,
+      "%a shadow buffer: %d screens of boot log scrolled in %d ms\n",
+      (Shadow != 0) ? "With" : "Without",
+      TEST_BENCHMARK_SCREENS,
+      (UINT32) ((End - Start) * 1000 / CLOCKS_PER_SEC)
+      ));
+
+    FreeTestFrameBuffer (&FrameBuffer);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  FrameBufferBltLib and run the FrameBufferBltLib unit test.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ShadowTests;
+
+  Framework = NULL;
+
+  DEBUG(( DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION ));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+      goto EXIT;
+  }
+
+  //
+  // Populate the FrameBufferBltLib Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&ShadowTests, Framework, "FrameBufferBltLib Shadow Buffer Tests", "FrameBufferBltLib.Shadow", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ShadowTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite-----------Description--------------Name----------Function--------Pre---Post-------------------Context-----------
+  //
+  AddTestCase (ShadowTests, "Shadow buffer should keep the frame buffer content", "Match", ShadowBufferShouldMatchFrameBuffer, NULL, NULL, NULL);
+  AddTestCase (ShadowTests, "Benchmark scrolling a full screen of boot log", "Scroll", BenchmarkBootLogScrolling, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
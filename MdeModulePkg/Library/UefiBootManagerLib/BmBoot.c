@@ -20,6 +20,11 @@ EFI_BOOT_MANAGER_LEGACY_BOOT                 mBmLegacyBoot              = NULL;
 /// for a partial device path that starts with the HD node.
 ///
 EFI_GUID mBmHardDriveBootVariableGuid = { 0xfab7e9e1, 0x39dd, 0x4f2b, { 0x84, 0x08, 0xe2, 0x0e, 0x90, 0x6c, 0xb6, 0xde } };
+///
+/// This GUID is used for the EFI Variables that store the full device paths
+/// the boot options were loaded from last time.
+///
+EFI_GUID mBmBootPathVariableGuid      = { 0x19ed1526, 0xfe2d, 0x49cd, { 0xb6, 0x47, 0x0a, 0x03, 0x63, 0x45, 0xef, 0xb2 } };
 EFI_GUID mBmAutoCreateBootOptionGuid  = { 0x8108ac4e, 0x9f11, 0x4d59, { 0x85, 0x0e, 0xe2, 0x1a, 0x52, 0x2c, 0x59, 0xb2 } };
 
 /**
@@ -1159,6 +1164,36 @@ BmMatchHttpBootDevicePath (
   return (BOOLEAN) (IsDevicePathEnd (Left) && IsDevicePathEnd (Right));
 }
 
+/**
+  Return whether the device path node follows the LoadFile device path in a
+  block device produced by the LoadFile instance: the RAM disk holding a
+  downloaded image, or a block device reading a virtual CD or disk image on
+  demand.
+
+  @param Node  The device path node following the LoadFile device path.
+
+  @retval TRUE   Node is the node of a block device produced by LoadFile.
+  @retval FALSE  Node is not the node of a block device produced by LoadFile.
+**/
+BOOLEAN
+BmIsLoadFileBlockDeviceNode (
+  IN EFI_DEVICE_PATH_PROTOCOL *Node
+  )
+{
+  if (DevicePathType (Node) != MEDIA_DEVICE_PATH) {
+    return FALSE;
+  }
+
+  if (DevicePathSubType (Node) == MEDIA_RAM_DISK_DP) {
+    return TRUE;
+  }
+
+  return (BOOLEAN) ((DevicePathSubType (Node) == MEDIA_VENDOR_DP) &&
+                    (DevicePathNodeLength (Node) >= sizeof (VENDOR_DEVICE_PATH)) &&
+                    (CompareGuid (&((VENDOR_DEVICE_PATH *) Node)->Guid, &gEfiVirtualCdGuid) ||
+                     CompareGuid (&((VENDOR_DEVICE_PATH *) Node)->Guid, &gEfiVirtualDiskGuid)));
+}
+
 /**
   Get the file buffer from the file system produced by Load File instance.
 
@@ -1199,9 +1234,10 @@ BmExpandNetworkFileSystem (
     Status = gBS->LocateDevicePath (&gEfiLoadFileProtocolGuid, &Node, &Handle);
     if (!EFI_ERROR (Status) &&
         (Handle == LoadFileHandle) &&
-        (DevicePathType (Node) == MEDIA_DEVICE_PATH) && (DevicePathSubType (Node) == MEDIA_RAM_DISK_DP)) {
+        BmIsLoadFileBlockDeviceNode (Node)) {
       //
-      // Find the BlockIo instance populated from the LoadFile.
+      // Find the BlockIo instance populated from the LoadFile, a RAM disk or
+      // a block device reading the image on demand.
       //
       Handle = Handles[Index];
       break;
@@ -1229,6 +1265,30 @@ BmExpandNetworkFileSystem (
   }
 }
 
+/**
+  Return whether the device path points into a block device produced by a
+  LoadFile instance: the RAM disk holding a downloaded image, or a block
+  device reading a virtual CD or disk image on demand.
+
+  @param FilePath  The device path to check.
+
+  @retval TRUE   FilePath points into a block device produced by LoadFile.
+  @retval FALSE  FilePath does not point into a block device produced by LoadFile.
+**/
+BOOLEAN
+BmIsLoadFileBlockDevice (
+  IN EFI_DEVICE_PATH_PROTOCOL *FilePath
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_DEVICE_PATH_PROTOCOL    *Node;
+  EFI_HANDLE                  Handle;
+
+  Node = FilePath;
+  Status = gBS->LocateDevicePath (&gEfiLoadFileProtocolGuid, &Node, &Handle);
+  return (BOOLEAN) (!EFI_ERROR (Status) && BmIsLoadFileBlockDeviceNode (Node));
+}
+
 /**
   Return the RAM Disk device path created by LoadFile.
 
@@ -1337,6 +1397,79 @@ BmDestroyRamDisk (
   FreePages (RamDiskBuffer, RamDiskSizeInPages);
 }
 
+/**
+  Ask the Load File instance to produce a block device reading a virtual CD or
+  disk image on demand, instead of loading the image into a buffer.
+
+  The request is a vendor media node with the virtual CD or disk GUID appended
+  to FilePath. It is only sent for a file path with a URI node, as HTTP boot is
+  the LoadFile instance able to read an image on demand.
+
+  @param LoadFileHandle The specified Load File instance.
+  @param LoadFile       The Load File protocol of LoadFileHandle.
+  @param FilePath       The file path which will pass to LoadFile().
+
+  @return  The full device path pointing to the load option in the block device,
+           or NULL if no block device was produced.
+**/
+EFI_DEVICE_PATH_PROTOCOL *
+BmRequestLoadFileBlockDevice (
+  IN  EFI_HANDLE                      LoadFileHandle,
+  IN  EFI_LOAD_FILE_PROTOCOL          *LoadFile,
+  IN  EFI_DEVICE_PATH_PROTOCOL        *FilePath
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_DEVICE_PATH_PROTOCOL            *Node;
+  EFI_DEVICE_PATH_PROTOCOL            *RequestPath;
+  VENDOR_DEVICE_PATH                  VendorNode;
+  EFI_GUID                            *ImageTypeGuid[2];
+  EFI_HANDLE                          BlockDeviceHandle;
+  UINTN                               BufferSize;
+  UINTN                               Index;
+
+  for (Node = FilePath; !IsDevicePathEnd (Node); Node = NextDevicePathNode (Node)) {
+    if ((DevicePathType (Node) == MESSAGING_DEVICE_PATH) && (DevicePathSubType (Node) == MSG_URI_DP)) {
+      break;
+    }
+  }
+  if (IsDevicePathEnd (Node)) {
+    return NULL;
+  }
+
+  ImageTypeGuid[0] = &gEfiVirtualCdGuid;
+  ImageTypeGuid[1] = &gEfiVirtualDiskGuid;
+
+  VendorNode.Header.Type    = MEDIA_DEVICE_PATH;
+  VendorNode.Header.SubType = MEDIA_VENDOR_DP;
+  SetDevicePathNodeLength (&VendorNode.Header, sizeof (VENDOR_DEVICE_PATH));
+
+  for (Index = 0; Index < ARRAY_SIZE (ImageTypeGuid); Index++) {
+    CopyGuid (&VendorNode.Guid, ImageTypeGuid[Index]);
+    RequestPath = AppendDevicePathNode (FilePath, &VendorNode.Header);
+    if (RequestPath == NULL) {
+      return NULL;
+    }
+
+    BufferSize = 0;
+    Status = LoadFile->LoadFile (LoadFile, RequestPath, TRUE, &BufferSize, NULL);
+    FreePool (RequestPath);
+    if ((Status == EFI_WARN_FILE_SYSTEM) && (BufferSize == 0)) {
+      return BmExpandNetworkFileSystem (LoadFileHandle, &BlockDeviceHandle);
+    }
+
+    //
+    // EFI_UNSUPPORTED means the image is not of the requested type, or cannot
+    // be read on demand. Any other answer will not change for the other type.
+    //
+    if (Status != EFI_UNSUPPORTED) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
 /**
   Get the file buffer from the specified Load File instance.
 
@@ -1368,6 +1501,15 @@ BmExpandLoadFile (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Prefer a block device reading a CD or disk image on demand to downloading
+  // the whole image into a RAM disk.
+  //
+  FullPath = BmRequestLoadFileBlockDevice (LoadFileHandle, LoadFile, FilePath);
+  if (FullPath != NULL) {
+    return FullPath;
+  }
+
   FileBuffer = NULL;
   BufferSize = 0;
   Status = LoadFile->LoadFile (LoadFile, FilePath, TRUE, &BufferSize, FileBuffer);
@@ -1741,6 +1883,123 @@ BmReportLoadFailure (
     );
 }
 
+/**
+  Save the full device path a boot option was loaded from, so that only the
+  controllers on that device path need to be connected on the next boot.
+
+  The variable L"BootPath####" holds two device path instances: the device
+  path of the boot option when it was loaded, and the full device path.
+
+  @param OptionNumber  The number of the boot option.
+  @param FilePath      The device path of the boot option.
+  @param FullPath      The full device path the boot option was loaded from.
+**/
+VOID
+BmSetCachedBootPath (
+  IN UINTN                     OptionNumber,
+  IN EFI_DEVICE_PATH_PROTOCOL  *FilePath,
+  IN EFI_DEVICE_PATH_PROTOCOL  *FullPath
+  )
+{
+  CHAR16                       VariableName[sizeof ("BootPath####")];
+  EFI_DEVICE_PATH_PROTOCOL     *CachedPath;
+  EFI_DEVICE_PATH_PROTOCOL     *OldCachedPath;
+  UINTN                        OldSize;
+  UINTN                        Size;
+
+  CachedPath = AppendDevicePathInstance (FilePath, FullPath);
+  if (CachedPath == NULL) {
+    return;
+  }
+  Size = GetDevicePathSize (CachedPath);
+
+  UnicodeSPrint (VariableName, sizeof (VariableName), L"BootPath%04x", OptionNumber);
+  GetVariable2 (VariableName, &mBmBootPathVariableGuid, (VOID **) &OldCachedPath, &OldSize);
+
+  //
+  // Only write the variable when the device path changes.
+  // Failing to save it only makes the next boot connect all controllers.
+  //
+  if ((OldCachedPath == NULL) || (OldSize != Size) || (CompareMem (OldCachedPath, CachedPath, Size) != 0)) {
+    gRT->SetVariable (
+           VariableName,
+           &mBmBootPathVariableGuid,
+           EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_NON_VOLATILE,
+           Size,
+           CachedPath
+           );
+  }
+
+  if (OldCachedPath != NULL) {
+    FreePool (OldCachedPath);
+  }
+  FreePool (CachedPath);
+}
+
+/**
+  Return the full device path a boot option was loaded from last time.
+
+  @param BootOption  The boot option.
+
+  @return The full device path, or NULL when none is saved for the current
+          device path of the boot option. Caller is responsible to free it.
+**/
+EFI_DEVICE_PATH_PROTOCOL *
+BmGetCachedBootPath (
+  IN EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  )
+{
+  CHAR16                         VariableName[sizeof ("BootPath####")];
+  EFI_DEVICE_PATH_PROTOCOL       *CachedPath;
+  EFI_DEVICE_PATH_PROTOCOL       *Instance;
+  EFI_DEVICE_PATH_PROTOCOL       *OptionPath;
+  EFI_DEVICE_PATH_PROTOCOL       *FullPath;
+  UINTN                          Size;
+
+  UnicodeSPrint (VariableName, sizeof (VariableName), L"BootPath%04x", BootOption->OptionNumber);
+  GetVariable2 (VariableName, &mBmBootPathVariableGuid, (VOID **) &CachedPath, &Size);
+  if (CachedPath == NULL) {
+    return NULL;
+  }
+
+  FullPath = NULL;
+  if (IsDevicePathValid (CachedPath, Size)) {
+    Instance   = CachedPath;
+    OptionPath = GetNextDevicePathInstance (&Instance, &Size);
+    if (OptionPath != NULL) {
+      //
+      // The saved full device path is stale when the boot option was changed.
+      //
+      Size = GetDevicePathSize (OptionPath);
+      if ((Instance != NULL) &&
+          (Size == GetDevicePathSize (BootOption->FilePath)) &&
+          (CompareMem (OptionPath, BootOption->FilePath, Size) == 0)) {
+        FullPath = GetNextDevicePathInstance (&Instance, &Size);
+      }
+      FreePool (OptionPath);
+    }
+  }
+
+  FreePool (CachedPath);
+  return FullPath;
+}
+
+/**
+  Delete the full device path saved for a boot option.
+
+  @param OptionNumber  The number of the boot option.
+**/
+VOID
+BmDeleteCachedBootPath (
+  IN UINTN                     OptionNumber
+  )
+{
+  CHAR16                       VariableName[sizeof ("BootPath####")];
+
+  UnicodeSPrint (VariableName, sizeof (VariableName), L"BootPath%04x", OptionNumber);
+  gRT->SetVariable (VariableName, &mBmBootPathVariableGuid, 0, 0, NULL);
+}
+
 /**
   Attempt to boot the EFI boot option. This routine sets L"BootCurent" and
   also signals the EFI ready to boot event. If the device path for the option
@@ -1884,6 +2143,9 @@ EfiBootManagerBoot (
                       FileSize,
                       &ImageHandle
                       );
+      if (!EFI_ERROR (Status) && !BmIsLoadFileBlockDevice (FilePath)) {
+        BmSetCachedBootPath (OptionNumber, BootOption->FilePath, FilePath);
+      }
     }
     if (FileBuffer != NULL) {
       FreePool (FileBuffer);
@@ -1914,6 +2176,7 @@ EfiBootManagerBoot (
       //
       BmReportLoadFailure (EFI_SW_DXE_BS_EC_BOOT_OPTION_LOAD_ERROR, Status);
       BootOption->Status = Status;
+      BmConnectAllAfterBootPathFailure ();
       return;
     }
   }
@@ -1996,6 +2259,7 @@ EfiBootManagerBoot (
     // Report Status Code with the failure status to indicate that boot failure
     //
     BmReportLoadFailure (EFI_SW_DXE_BS_EC_BOOT_OPTION_FAILED, Status);
+    BmConnectAllAfterBootPathFailure ();
   }
   PERF_END_EX (gImageHandle, "BdsAttempt", NULL, 0, (UINT32) OptionNumber);
 
@@ -8,6 +8,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "InternalBm.h"
 
+//
+// TRUE when EfiBootManagerConnectBootPath() only connected the saved full
+// device path of a boot option, instead of all the controllers.
+//
+BOOLEAN  mBmBootPathOnlyConnected = FALSE;
+
 /**
   Connect all the drivers to all the controllers.
 
@@ -86,6 +92,190 @@ EfiBootManagerConnectAll (
   EfiBootManagerConnectAllDefaultConsoles ();
 }
 
+/**
+  Read the boot option that will be tried first: the one L"BootNext" points
+  to, or the first active boot option in L"BootOrder".
+
+  @param BootOption  Return the boot option.
+
+  @retval EFI_SUCCESS    The boot option is returned.
+  @retval EFI_NOT_FOUND  There is no boot option to try.
+**/
+EFI_STATUS
+BmGetFirstBootOption (
+  OUT EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  )
+{
+  EFI_STATUS                        Status;
+  CHAR16                            OptionName[BM_OPTION_NAME_LEN];
+  UINT16                            *BootNext;
+  UINT16                            *BootOrder;
+  UINTN                             Size;
+  UINTN                             Index;
+
+  GetEfiGlobalVariable2 (L"BootNext", (VOID **) &BootNext, &Size);
+  if (BootNext != NULL) {
+    Status = EFI_NOT_FOUND;
+    if (Size == sizeof (UINT16)) {
+      UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", *BootNext);
+      Status = EfiBootManagerVariableToLoadOption (OptionName, BootOption);
+    }
+    FreePool (BootNext);
+    return Status;
+  }
+
+  GetEfiGlobalVariable2 (L"BootOrder", (VOID **) &BootOrder, &Size);
+  if (BootOrder == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < Size / sizeof (UINT16); Index++) {
+    UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", BootOrder[Index]);
+    if (EFI_ERROR (EfiBootManagerVariableToLoadOption (OptionName, BootOption))) {
+      continue;
+    }
+    if (((BootOption->Attributes & LOAD_OPTION_ACTIVE) != 0) &&
+        ((BootOption->Attributes & LOAD_OPTION_CATEGORY) == LOAD_OPTION_CATEGORY_BOOT)) {
+      Status = EFI_SUCCESS;
+      break;
+    }
+    EfiBootManagerFreeLoadOption (BootOption);
+  }
+
+  FreePool (BootOrder);
+  return Status;
+}
+
+/**
+  Check whether the device the full device path of a boot option points to
+  has been connected.
+
+  @param FullPath  The full device path of the boot option.
+
+  @retval TRUE   The boot option can be loaded from the device.
+  @retval FALSE  The device has not been found.
+**/
+BOOLEAN
+BmIsBootPathConnected (
+  IN EFI_DEVICE_PATH_PROTOCOL       *FullPath
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_GUID                          *Protocols[3];
+  EFI_DEVICE_PATH_PROTOCOL          *Node;
+  EFI_HANDLE                        Handle;
+  UINTN                             Index;
+
+  Protocols[0] = &gEfiSimpleFileSystemProtocolGuid;
+  Protocols[1] = &gEfiLoadFileProtocolGuid;
+  Protocols[2] = &gEfiFirmwareVolume2ProtocolGuid;
+
+  for (Index = 0; Index < ARRAY_SIZE (Protocols); Index++) {
+    Node   = FullPath;
+    Status = gBS->LocateDevicePath (Protocols[Index], &Node, &Handle);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+    //
+    // The device path must resolve up to the file the boot option is loaded from.
+    //
+    if (IsDevicePathEnd (Node) ||
+        ((DevicePathType (Node) == MEDIA_DEVICE_PATH) &&
+         ((DevicePathSubType (Node) == MEDIA_FILEPATH_DP) || (DevicePathSubType (Node) == MEDIA_PIWG_FW_FILE_DP)))) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Connect the controllers needed to boot the boot option that will be tried
+  first, using the full device path it was loaded from last time. All the
+  controllers are connected when no full device path is saved for the boot
+  option or when the device cannot be found on that path any more.
+
+  The default consoles are connected in both cases. If only the saved full
+  device path was connected and the boot option then fails to load or start,
+  EfiBootManagerBoot() connects all the controllers before it returns.
+
+  @retval EFI_SUCCESS    The controllers on the saved full device path have
+                         been connected.
+  @retval EFI_NOT_FOUND  All the controllers have been connected instead.
+**/
+EFI_STATUS
+EFIAPI
+EfiBootManagerConnectBootPath (
+  VOID
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_BOOT_MANAGER_LOAD_OPTION      BootOption;
+  EFI_DEVICE_PATH_PROTOCOL          *FullPath;
+  BOOLEAN                           Connected;
+
+  FullPath = NULL;
+  Status   = BmGetFirstBootOption (&BootOption);
+  if (!EFI_ERROR (Status)) {
+    FullPath = BmGetCachedBootPath (&BootOption);
+    EfiBootManagerFreeLoadOption (&BootOption);
+  }
+
+  if (FullPath != NULL) {
+    PERF_INMODULE_BEGIN ("BdsConnectBootPath");
+    EfiBootManagerConnectDevicePath (FullPath, NULL);
+    Connected = BmIsBootPathConnected (FullPath);
+    PERF_INMODULE_END ("BdsConnectBootPath");
+
+    DEBUG_CODE_BEGIN ();
+    CHAR16 *FullPathStr;
+
+    FullPathStr = ConvertDevicePathToText (FullPath, TRUE, TRUE);
+    DEBUG ((
+      DEBUG_INFO, "[Bds] Connect boot path %s - %a\n",
+      (FullPathStr != NULL) ? FullPathStr : L"", Connected ? "Hit" : "Miss"
+      ));
+    if (FullPathStr != NULL) {
+      FreePool (FullPathStr);
+    }
+    DEBUG_CODE_END ();
+
+    FreePool (FullPath);
+    if (Connected) {
+      EfiBootManagerConnectAllDefaultConsoles ();
+      mBmBootPathOnlyConnected = TRUE;
+      return EFI_SUCCESS;
+    }
+  }
+
+  PERF_INMODULE_BEGIN ("BdsConnectAll");
+  EfiBootManagerConnectAll ();
+  PERF_INMODULE_END ("BdsConnectAll");
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Connect all the controllers and the default consoles after a boot option
+  failed, if EfiBootManagerConnectBootPath() only connected the saved full
+  device path of a boot option. The boot options tried next then find their
+  devices, as if all the controllers had been connected in the first place.
+**/
+VOID
+BmConnectAllAfterBootPathFailure (
+  VOID
+  )
+{
+  if (!mBmBootPathOnlyConnected) {
+    return;
+  }
+
+  mBmBootPathOnlyConnected = FALSE;
+  PERF_INMODULE_BEGIN ("BdsConnectAll");
+  EfiBootManagerConnectAll ();
+  PERF_INMODULE_END ("BdsConnectAll");
+}
+
 /**
   This function will create all handles associate with every device
   path node. If the handle associate with one device path node can not
@@ -599,6 +599,10 @@ EfiBootManagerDeleteLoadOptionVariable (
     }
   }
 
+  if (OptionType == LoadOptionTypeBoot) {
+    BmDeleteCachedBootPath (OptionNumber);
+  }
+
   //
   // Remove the Driver####, SysPrep####, Boot#### or PlatformRecovery#### itself.
   //
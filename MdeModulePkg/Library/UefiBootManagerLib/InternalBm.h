@@ -395,6 +395,21 @@ BmExpandLoadFile (
   IN  EFI_DEVICE_PATH_PROTOCOL        *FilePath
   );
 
+/**
+  Return whether the device path points into a block device produced by a
+  LoadFile instance: the RAM disk holding a downloaded image, or a block
+  device reading a virtual CD or disk image on demand.
+
+  @param FilePath  The device path to check.
+
+  @retval TRUE   FilePath points into a block device produced by LoadFile.
+  @retval FALSE  FilePath does not point into a block device produced by LoadFile.
+**/
+BOOLEAN
+BmIsLoadFileBlockDevice (
+  IN EFI_DEVICE_PATH_PROTOCOL *FilePath
+  );
+
 /**
   Return the RAM Disk device path created by LoadFile.
 
@@ -465,4 +480,52 @@ BmGetNextLoadOptionBuffer (
   OUT EFI_DEVICE_PATH_PROTOCOL          **FullPath,
   OUT UINTN                             *FileSize
   );
+
+/**
+  Save the full device path a boot option was loaded from, so that only the
+  controllers on that device path need to be connected on the next boot.
+
+  @param OptionNumber  The number of the boot option.
+  @param FilePath      The device path of the boot option.
+  @param FullPath      The full device path the boot option was loaded from.
+**/
+VOID
+BmSetCachedBootPath (
+  IN UINTN                     OptionNumber,
+  IN EFI_DEVICE_PATH_PROTOCOL  *FilePath,
+  IN EFI_DEVICE_PATH_PROTOCOL  *FullPath
+  );
+
+/**
+  Return the full device path a boot option was loaded from last time.
+
+  @param BootOption  The boot option.
+
+  @return The full device path, or NULL when none is saved for the current
+          device path of the boot option. Caller is responsible to free it.
+**/
+EFI_DEVICE_PATH_PROTOCOL *
+BmGetCachedBootPath (
+  IN EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  );
+
+/**
+  Delete the full device path saved for a boot option.
+
+  @param OptionNumber  The number of the boot option.
+**/
+VOID
+BmDeleteCachedBootPath (
+  IN UINTN                     OptionNumber
+  );
+
+/**
+  Connect all the controllers and the default consoles after a boot option
+  failed, if EfiBootManagerConnectBootPath() only connected the saved full
+  device path of a boot option.
+**/
+VOID
+BmConnectAllAfterBootPathFailure (
+  VOID
+  );
 #endif // _INTERNAL_BM_H_
@@ -0,0 +1,118 @@
+/** @file
+  Implements for functions declared in ZstdDecUefiSupport.h
+
+  The decompression context lives in the scratch buffer of the GUIDed section
+  extraction, so Zstandard never allocates memory on its own.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <ZstdDecUefiSupport.h>
+
+/**
+  Dummy malloc function for compiler.
+**/
+VOID *
+ZstdDummyMalloc (
+  IN size_t    Size
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Dummy calloc function for compiler.
+**/
+VOID *
+ZstdDummyCalloc (
+  IN size_t    Count,
+  IN size_t    Size
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Dummy free function for compiler.
+**/
+VOID
+ZstdDummyFree (
+  IN VOID *    Ptr
+  )
+{
+  ASSERT (FALSE);
+}
+
+#if defined (__GNUC__)
+//
+// Zstandard calls __builtin_memcpy(), __builtin_memmove() and __builtin_memset()
+// with GCC, which turns them into calls to the C library functions when the
+// size is not a constant, or when optimization is off. They are weak, so that
+// a module which also links an intrinsic library gets a single copy.
+//
+#undef memcpy
+#undef memmove
+#undef memset
+
+/**
+  Copy Count bytes from Src to Dest.
+
+  @param  Dest    The destination buffer.
+  @param  Src     The source buffer.
+  @param  Count   The number of bytes to copy.
+
+  @return Dest.
+**/
+__attribute__ ((weak))
+VOID *
+memcpy (
+  OUT VOID         *Dest,
+  IN  CONST VOID   *Src,
+  IN  size_t       Count
+  )
+{
+  return CopyMem (Dest, Src, (UINTN) Count);
+}
+
+/**
+  Copy Count bytes from Src to Dest. The buffers may overlap.
+
+  @param  Dest    The destination buffer.
+  @param  Src     The source buffer.
+  @param  Count   The number of bytes to copy.
+
+  @return Dest.
+**/
+__attribute__ ((weak))
+VOID *
+memmove (
+  OUT VOID         *Dest,
+  IN  CONST VOID   *Src,
+  IN  size_t       Count
+  )
+{
+  return CopyMem (Dest, Src, (UINTN) Count);
+}
+
+/**
+  Set Count bytes of Dest to Value.
+
+  @param  Dest    The buffer to set.
+  @param  Value   The value to set the bytes to.
+  @param  Count   The number of bytes to set.
+
+  @return Dest.
+**/
+__attribute__ ((weak))
+VOID *
+memset (
+  OUT VOID         *Dest,
+  IN  int          Value,
+  IN  size_t       Count
+  )
+{
+  return SetMem (Dest, (UINTN) Count, (UINT8) Value);
+}
+#endif
@@ -0,0 +1,115 @@
+/** @file
+  Zstandard Decompress interfaces
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <ZstdDecompressLibInternal.h>
+
+/**
+  Given a Zstandard compressed source buffer, this function retrieves the size
+  of the uncompressed buffer and the size of the scratch buffer required
+  to decompress the compressed source buffer.
+
+  Retrieves the size of the uncompressed buffer and the temporary scratch buffer
+  required to decompress the buffer specified by Source and SourceSize.
+  The size of the uncompressed buffer is read from the header of the frame and
+  returned in DestinationSize. The scratch buffer holds the decompression
+  context, its size is returned in ScratchSize.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer
+                          that will be generated when the compressed buffer specified
+                          by Source and SourceSize is decompressed.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer that
+                          is required to decompress the compressed buffer specified
+                          by Source and SourceSize.
+
+  @retval EFI_SUCCESS     The size of the uncompressed data was returned
+                          in DestinationSize and the size of the scratch
+                          buffer was returned in ScratchSize.
+  @retval EFI_INVALID_PARAMETER
+                          The source buffer is not a Zstandard frame that
+                          records the size of its content.
+**/
+EFI_STATUS
+EFIAPI
+ZstdUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  UINT64  ContentSize;
+
+  ContentSize = ZSTD_getFrameContentSize (Source, SourceSize);
+  if ((ContentSize == ZSTD_CONTENTSIZE_UNKNOWN) ||
+      (ContentSize == ZSTD_CONTENTSIZE_ERROR) ||
+      (ContentSize > MAX_UINT32)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *DestinationSize = (UINT32) ContentSize;
+  *ScratchSize     = (UINT32) ZSTD_estimateDCtxSize () + ZSTD_SCRATCH_ALIGNMENT;
+  return EFI_SUCCESS;
+}
+
+/**
+  Decompresses a Zstandard compressed source buffer.
+
+  Extracts decompressed data to its original form.
+  If the compressed source data specified by Source is successfully decompressed
+  into Destination, then RETURN_SUCCESS is returned.  If the compressed source data
+  specified by Source is not in a valid compressed data format,
+  then RETURN_INVALID_PARAMETER is returned.
+
+  The whole frame is decoded in one call straight into Destination, so the
+  decoder needs no window buffer besides the context in Scratch.
+
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size of source buffer.
+  @param  Destination The destination buffer to store the decompressed data
+  @param  Scratch     A temporary scratch buffer that is used to perform the decompression.
+                      It must be at least the ScratchSize returned by
+                      ZstdUefiDecompressGetInfo().
+
+  @retval EFI_SUCCESS Decompression completed successfully, and
+                      the uncompressed buffer is returned in Destination.
+  @retval EFI_INVALID_PARAMETER
+                      The source buffer specified by Source is corrupted
+                      (not in a valid compressed format).
+**/
+EFI_STATUS
+EFIAPI
+ZstdUefiDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  )
+{
+  UINT64      ContentSize;
+  ZSTD_DCtx   *DCtx;
+  size_t      Result;
+
+  ContentSize = ZSTD_getFrameContentSize (Source, SourceSize);
+  if ((ContentSize == ZSTD_CONTENTSIZE_UNKNOWN) ||
+      (ContentSize == ZSTD_CONTENTSIZE_ERROR) ||
+      (ContentSize > MAX_UINT32)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  DCtx = ZSTD_initStaticDCtx (ALIGN_POINTER (Scratch, ZSTD_SCRATCH_ALIGNMENT), ZSTD_estimateDCtxSize ());
+  if (DCtx == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Result = ZSTD_decompressDCtx (DCtx, Destination, (size_t) ContentSize, Source, SourceSize);
+  if (ZSTD_isError (Result) || (Result != ContentSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
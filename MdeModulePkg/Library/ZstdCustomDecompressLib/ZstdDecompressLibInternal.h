@@ -0,0 +1,41 @@
+/** @file
+  ZSTD UEFI header file
+
+  Allows ZSTD code to build under UEFI (edk2) build environment
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __ZSTD_DECOMPRESS_INTERNAL_H__
+#define __ZSTD_DECOMPRESS_INTERNAL_H__
+
+#include <PiPei.h>
+#include <Library/ExtractGuidedSectionLib.h>
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd/lib/zstd.h>
+
+//
+// ZSTD_initStaticDCtx() needs a workspace aligned on 8 bytes.
+//
+#define ZSTD_SCRATCH_ALIGNMENT  8
+
+EFI_STATUS
+EFIAPI
+ZstdUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+EFI_STATUS
+EFIAPI
+ZstdUefiDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  );
+
+#endif
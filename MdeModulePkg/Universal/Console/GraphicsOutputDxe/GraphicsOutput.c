@@ -189,7 +189,9 @@ CONST GRAPHICS_OUTPUT_PRIVATE_DATA mGraphicsOutputInstanceTemplate = {
   NULL,                                            // PciIo
   0,                                               // PciAttributes
   NULL,                                            // FrameBufferBltLibConfigure
-  0                                                // FrameBufferBltLibConfigureSize
+  0,                                               // FrameBufferBltLibConfigureSize
+  NULL,                                            // ShadowBuffer
+  0                                                // ShadowBufferSize
 };
 
 /**
@@ -484,6 +486,26 @@ GraphicsOutputDriverBindingStart (
     goto RestorePciAttributes;
   }
 
+  //
+  // Keep a shadow copy of the frame buffer in system memory so that Blt
+  // operations never read back from the frame buffer.
+  // The frame buffer is still usable without the shadow copy.
+  //
+  if (FeaturePcdGet (PcdFrameBufferShadowEnable)) {
+    FrameBufferBltSetShadowBuffer (Private->FrameBufferBltLibConfigure, NULL, &Private->ShadowBufferSize);
+    Private->ShadowBuffer = AllocatePool (Private->ShadowBufferSize);
+    if (Private->ShadowBuffer != NULL) {
+      ReturnStatus = FrameBufferBltSetShadowBuffer (
+                       Private->FrameBufferBltLibConfigure,
+                       Private->ShadowBuffer,
+                       &Private->ShadowBufferSize
+                       );
+      ASSERT_RETURN_ERROR (ReturnStatus);
+    } else {
+      DEBUG ((DEBUG_WARN, "GraphicsOutputDxe: No memory for the frame buffer shadow copy.\n"));
+    }
+  }
+
   Private->DevicePath = AppendDevicePathNode (PciDevicePath, (EFI_DEVICE_PATH_PROTOCOL *) &mGraphicsOutputAdrNode);
   if (Private->DevicePath == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
@@ -540,6 +562,9 @@ FreeMemory:
       if (Private->FrameBufferBltLibConfigure != NULL) {
         FreePool (Private->FrameBufferBltLibConfigure);
       }
+      if (Private->ShadowBuffer != NULL) {
+        FreePool (Private->ShadowBuffer);
+      }
       FreePool (Private);
     }
   }
@@ -662,6 +687,9 @@ GraphicsOutputDriverBindingStop (
 
     FreePool (Private->DevicePath);
     FreePool (Private->FrameBufferBltLibConfigure);
+    if (Private->ShadowBuffer != NULL) {
+      FreePool (Private->ShadowBuffer);
+    }
     mDriverStarted = FALSE;
   } else {
     Status = gBS->OpenProtocol (
@@ -29,6 +29,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiLib.h>
+#include <Library/PcdLib.h>
 
 #define MAX_PCI_BAR  6
 
@@ -42,6 +43,8 @@ typedef struct {
   UINT64                            PciAttributes;
   FRAME_BUFFER_CONFIGURE            *FrameBufferBltLibConfigure;
   UINTN                             FrameBufferBltLibConfigureSize;
+  VOID                              *ShadowBuffer;
+  UINTN                             ShadowBufferSize;
 } GRAPHICS_OUTPUT_PRIVATE_DATA;
 
 #define GRAPHICS_OUTPUT_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('g', 'g', 'o', 'p')
@@ -827,6 +827,10 @@ FreeResources:
     FreePool (TerminalDevice->TerminalConsoleModeData);
   }
 
+  if (TerminalDevice->Screen != NULL) {
+    FreePool (TerminalDevice->Screen);
+  }
+
   FreePool (TerminalDevice);
 
 CloseProtocols:
@@ -984,8 +988,18 @@ TerminalDriverBindingStop (
         gBS->CloseEvent (TerminalDevice->SimpleInputEx.WaitForKeyEx);
         gBS->CloseEvent (TerminalDevice->KeyNotifyProcessEvent);
         TerminalFreeNotifyList (&TerminalDevice->NotifyList);
+        DEBUG ((
+          DEBUG_INFO,
+          "Terminal: %ld bytes in %ld serial writes, %ld bytes avoided\n",
+          TerminalDevice->BytesWritten,
+          TerminalDevice->SerialWrites,
+          TerminalDevice->BytesAvoided
+          ));
         FreePool (TerminalDevice->DevicePath);
         FreePool (TerminalDevice->TerminalConsoleModeData);
+        if (TerminalDevice->Screen != NULL) {
+          FreePool (TerminalDevice->Screen);
+        }
         FreePool (TerminalDevice);
       }
     }
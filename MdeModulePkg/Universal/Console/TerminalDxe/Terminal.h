@@ -63,6 +63,23 @@ typedef struct {
   UINTN   Rows;
 } TERMINAL_CONSOLE_MODE_DATA;
 
+//
+// One character cell of the remote terminal screen model. A NULL Char marks
+// a cell whose content is unknown.
+//
+typedef struct {
+  CHAR16  Char;
+  UINT8   Attribute;
+} TERMINAL_SCREEN_CELL;
+
+#define TERMINAL_OUTPUT_BUFFER_SIZE     256
+
+//
+// Resending this many known characters is cheaper than a cursor motion
+// control sequence.
+//
+#define TERMINAL_MAX_GAP_FILL           4
+
 #define KEYBOARD_TIMER_INTERVAL         200000  // 0.02s
 
 #define TERMINAL_DEV_SIGNATURE  SIGNATURE_32 ('t', 'm', 'n', 'l')
@@ -122,6 +139,34 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL   SimpleInputEx;
   LIST_ENTRY                          NotifyList;
   EFI_EVENT                           KeyNotifyProcessEvent;
+
+  //
+  // Output is staged here and written to the serial device once per
+  // EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL call, or when the buffer is full.
+  //
+  UINT8                               OutputBuffer[TERMINAL_OUTPUT_BUFFER_SIZE];
+  UINTN                               OutputLength;
+
+  //
+  // Model of what the remote terminal displays, only allocated when
+  // PcdTerminalScreenDiffEnable is TRUE. Characters that the remote terminal
+  // already shows with the same attribute are not sent again, and attribute
+  // changes are only sent before a character that uses them.
+  // RemoteColumn, RemoteRow and RemoteAttribute are -1 when unknown.
+  //
+  TERMINAL_SCREEN_CELL                *Screen;
+  UINTN                               ScreenColumns;
+  UINTN                               ScreenRows;
+  INT32                               RemoteColumn;
+  INT32                               RemoteRow;
+  INT32                               RemoteAttribute;
+
+  //
+  // Output statistics.
+  //
+  UINT64                              SerialWrites;
+  UINT64                              BytesWritten;
+  UINT64                              BytesAvoided;
 } TERMINAL_DEV;
 
 #define INPUT_STATE_DEFAULT               0x00
@@ -448,6 +493,19 @@ TerminalConOutOutputString (
   IN  CHAR16                            *WString
   );
 
+/**
+  Allocate the remote screen model for the current text mode. Any previous
+  model is freed. The model stays disabled if PcdTerminalScreenDiffEnable is
+  FALSE or the allocation fails.
+
+  @param  TerminalDevice    The terminal device.
+
+**/
+VOID
+TerminalScreenReset (
+  IN TERMINAL_DEV  *TerminalDevice
+  );
+
 /**
   Implements EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL.TestString().
   If one of the characters in the *Wstring is
@@ -80,6 +80,515 @@ CHAR16 mSetCursorPositionString[]  = { ESC, '[', '0', '0', ';', '0', '0', 'H', 0
 CHAR16 mCursorForwardString[]      = { ESC, '[', '0', '0', 'C', 0 };
 CHAR16 mCursorBackwardString[]     = { ESC, '[', '0', '0', 'D', 0 };
 
+/**
+  Write the output staged in the terminal device to the serial device.
+
+  @param  TerminalDevice    The terminal device.
+
+  @retval EFI_SUCCESS       The staged output is written.
+  @retval Others            The serial device fails to write the data.
+
+**/
+EFI_STATUS
+TerminalFlushOutput (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  UINTN  Length;
+
+  if (TerminalDevice->OutputLength == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Length                       = TerminalDevice->OutputLength;
+  TerminalDevice->OutputLength = 0;
+  TerminalDevice->SerialWrites++;
+  TerminalDevice->BytesWritten += Length;
+
+  return TerminalDevice->SerialIo->Write (
+                                     TerminalDevice->SerialIo,
+                                     &Length,
+                                     TerminalDevice->OutputBuffer
+                                     );
+}
+
+/**
+  Drop the staged output after a failed write. The terminal may have received
+  part of it, so its cursor and attribute become unknown and the next write
+  does a full cursor and attribute sync.
+
+  @param  TerminalDevice    The terminal device.
+
+**/
+VOID
+TerminalDiscardOutput (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  TerminalDevice->OutputLength    = 0;
+  TerminalDevice->RemoteColumn    = -1;
+  TerminalDevice->RemoteRow       = -1;
+  TerminalDevice->RemoteAttribute = -1;
+}
+
+/**
+  Stage data to be sent to the serial device. The staged output is written
+  when the buffer is full.
+
+  @param  TerminalDevice    The terminal device.
+  @param  Data              The data to send.
+  @param  Length            Length of Data in bytes.
+
+  @retval EFI_SUCCESS       The data is staged.
+  @retval Others            The serial device fails to write the data.
+
+**/
+EFI_STATUS
+TerminalQueueOutput (
+  IN TERMINAL_DEV  *TerminalDevice,
+  IN CONST VOID    *Data,
+  IN UINTN         Length
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Chunk;
+
+  while (Length > 0) {
+    if (TerminalDevice->OutputLength == TERMINAL_OUTPUT_BUFFER_SIZE) {
+      Status = TerminalFlushOutput (TerminalDevice);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+    Chunk = MIN (Length, TERMINAL_OUTPUT_BUFFER_SIZE - TerminalDevice->OutputLength);
+    CopyMem (&TerminalDevice->OutputBuffer[TerminalDevice->OutputLength], Data, Chunk);
+    TerminalDevice->OutputLength += Chunk;
+    Data    = (CONST UINT8 *) Data + Chunk;
+    Length -= Chunk;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stage a control sequence to be sent to the serial device.
+
+  @param  TerminalDevice    The terminal device.
+  @param  String            The Null-terminated control sequence. It only
+                            contains ESC and ASCII characters.
+
+  @retval EFI_SUCCESS       The control sequence is staged.
+  @retval Others            The serial device fails to write the data.
+
+**/
+EFI_STATUS
+TerminalQueueControlString (
+  IN TERMINAL_DEV  *TerminalDevice,
+  IN CHAR16        *String
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       Char;
+
+  for (; *String != CHAR_NULL; String++) {
+    Char   = (CHAR8) *String;
+    Status = TerminalQueueOutput (TerminalDevice, &Char, sizeof (Char));
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Convert a Unicode character into the byte stream understood by the terminal.
+
+  @param  TerminalDevice    The terminal device.
+  @param  Char              The Unicode character.
+  @param  Buffer            Receives the bytes to send.
+  @param  Warning           Set to TRUE if the character can not be rendered
+                            and is replaced.
+
+  @return The number of bytes stored in Buffer.
+
+**/
+UINTN
+TerminalEncodeChar (
+  IN     TERMINAL_DEV  *TerminalDevice,
+  IN     CHAR16        Char,
+  OUT    UTF8_CHAR     *Buffer,
+  IN OUT BOOLEAN       *Warning
+  )
+{
+  CHAR8  GraphicChar;
+  CHAR8  AsciiChar;
+  UINT8  ValidBytes;
+
+  AsciiChar = 0;
+
+  switch (TerminalDevice->TerminalType) {
+
+  case TerminalTypePcAnsi:
+  case TerminalTypeVt100:
+  case TerminalTypeVt100Plus:
+  case TerminalTypeTtyTerm:
+  case TerminalTypeLinux:
+  case TerminalTypeXtermR6:
+  case TerminalTypeVt400:
+  case TerminalTypeSCO:
+
+    if (!TerminalIsValidTextGraphics (Char, &GraphicChar, &AsciiChar)) {
+      //
+      // If it's not a graphic character convert Unicode to ASCII.
+      //
+      GraphicChar = (CHAR8) Char;
+
+      if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
+        //
+        // when this driver use the OutputString to output control string,
+        // TerminalDevice->OutputEscChar is set to let the Esc char
+        // to be output to the terminal emulation software.
+        //
+        if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
+          GraphicChar = 27;
+        } else {
+          GraphicChar = '?';
+          *Warning    = TRUE;
+        }
+      }
+
+      AsciiChar = GraphicChar;
+
+    }
+
+    if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
+      GraphicChar = AsciiChar;
+    }
+
+    Buffer->Utf8_1 = (UINT8) GraphicChar;
+    return 1;
+
+  case TerminalTypeVtUtf8:
+    UnicodeToUtf8 (Char, Buffer, &ValidBytes);
+    return ValidBytes;
+  }
+
+  return 0;
+}
+
+/**
+  Build the control sequence that moves the cursor of the terminal.
+
+  Optimize cursor motion control sequences for TtyTerm.  Move within the
+  current line if possible, and don't output anyting if it isn't necessary.
+
+  @param  TerminalDevice    The terminal device.
+  @param  FromColumn        The current cursor column of the terminal.
+  @param  FromRow           The current cursor row of the terminal, or -1 if
+                            unknown.
+  @param  Column            The column to move the cursor to.
+  @param  Row               The row to move the cursor to.
+
+  @return The Null-terminated control sequence.
+
+**/
+CHAR16 *
+TerminalCursorPositionString (
+  IN TERMINAL_DEV  *TerminalDevice,
+  IN INT32         FromColumn,
+  IN INT32         FromRow,
+  IN UINTN         Column,
+  IN UINTN         Row
+  )
+{
+  if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
+      FromRow >= 0 && (UINTN) FromRow == Row) {
+    if ((UINTN) FromColumn > Column) {
+      mCursorBackwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((FromColumn - Column) / 10));
+      mCursorBackwardString[FW_BACK_OFFSET + 1] = (CHAR16) ('0' + ((FromColumn - Column) % 10));
+      return mCursorBackwardString;
+    } else if (Column > (UINTN) FromColumn) {
+      mCursorForwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((Column - FromColumn) / 10));
+      mCursorForwardString[FW_BACK_OFFSET + 1] = (CHAR16) ('0' + ((Column - FromColumn) % 10));
+      return mCursorForwardString;
+    }
+    return L"";  // No cursor motion necessary
+  }
+
+  mSetCursorPositionString[ROW_OFFSET + 0]    = (CHAR16) ('0' + ((Row + 1) / 10));
+  mSetCursorPositionString[ROW_OFFSET + 1]    = (CHAR16) ('0' + ((Row + 1) % 10));
+  mSetCursorPositionString[COLUMN_OFFSET + 0] = (CHAR16) ('0' + ((Column + 1) / 10));
+  mSetCursorPositionString[COLUMN_OFFSET + 1] = (CHAR16) ('0' + ((Column + 1) % 10));
+  return mSetCursorPositionString;
+}
+
+/**
+  Build the control sequence that sets the attribute of the terminal.
+
+  @param  Attribute         The EFI text attribute.
+
+  @return The Null-terminated control sequence.
+
+**/
+CHAR16 *
+TerminalAttributeString (
+  IN UINTN  Attribute
+  )
+{
+  UINT8  ForegroundControl;
+  UINT8  BackgroundControl;
+  UINT8  BrightControl;
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable foreground color
+  //
+  switch (Attribute & 0x07) {
+
+  case EFI_BLACK:
+    ForegroundControl = 30;
+    break;
+
+  case EFI_BLUE:
+    ForegroundControl = 34;
+    break;
+
+  case EFI_GREEN:
+    ForegroundControl = 32;
+    break;
+
+  case EFI_CYAN:
+    ForegroundControl = 36;
+    break;
+
+  case EFI_RED:
+    ForegroundControl = 31;
+    break;
+
+  case EFI_MAGENTA:
+    ForegroundControl = 35;
+    break;
+
+  case EFI_BROWN:
+    ForegroundControl = 33;
+    break;
+
+  default:
+
+  case EFI_LIGHTGRAY:
+    ForegroundControl = 37;
+    break;
+
+  }
+  //
+  //  bit4 of the Attribute indicates bright control
+  //  of terminal emulator.
+  //
+  BrightControl = (UINT8) ((Attribute >> 3) & 1);
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable background color.
+  //
+  switch ((Attribute >> 4) & 0x07) {
+
+  case EFI_BLACK:
+    BackgroundControl = 40;
+    break;
+
+  case EFI_BLUE:
+    BackgroundControl = 44;
+    break;
+
+  case EFI_GREEN:
+    BackgroundControl = 42;
+    break;
+
+  case EFI_CYAN:
+    BackgroundControl = 46;
+    break;
+
+  case EFI_RED:
+    BackgroundControl = 41;
+    break;
+
+  case EFI_MAGENTA:
+    BackgroundControl = 45;
+    break;
+
+  case EFI_BROWN:
+    BackgroundControl = 43;
+    break;
+
+  default:
+
+  case EFI_LIGHTGRAY:
+    BackgroundControl = 47;
+    break;
+  }
+  //
+  // terminal emulator's control sequence to set attributes
+  //
+  mSetAttributeString[BRIGHT_CONTROL_OFFSET]          = (CHAR16) ('0' + BrightControl);
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (ForegroundControl / 10));
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (ForegroundControl % 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (BackgroundControl / 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (BackgroundControl % 10));
+
+  return mSetAttributeString;
+}
+
+/**
+  Allocate the remote screen model for the current text mode. Any previous
+  model is freed. The model stays disabled if PcdTerminalScreenDiffEnable is
+  FALSE or the allocation fails.
+
+  @param  TerminalDevice    The terminal device.
+
+**/
+VOID
+TerminalScreenReset (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  TERMINAL_CONSOLE_MODE_DATA  *ModeData;
+
+  if (TerminalDevice->Screen != NULL) {
+    FreePool (TerminalDevice->Screen);
+    TerminalDevice->Screen = NULL;
+  }
+  TerminalDevice->RemoteColumn    = -1;
+  TerminalDevice->RemoteRow       = -1;
+  TerminalDevice->RemoteAttribute = -1;
+
+  if (!FeaturePcdGet (PcdTerminalScreenDiffEnable)) {
+    return;
+  }
+
+  ModeData = &TerminalDevice->TerminalConsoleModeData[TerminalDevice->SimpleTextOutputMode.Mode];
+  TerminalDevice->Screen = AllocateZeroPool (ModeData->Columns * ModeData->Rows * sizeof (TERMINAL_SCREEN_CELL));
+  if (TerminalDevice->Screen != NULL) {
+    TerminalDevice->ScreenColumns = ModeData->Columns;
+    TerminalDevice->ScreenRows    = ModeData->Rows;
+  }
+}
+
+/**
+  Send the current attribute to the terminal if it is not the attribute the
+  terminal is using already.
+
+  @param  TerminalDevice    The terminal device.
+
+  @retval EFI_SUCCESS       The terminal uses the current attribute.
+  @retval Others            The serial device fails to write the data.
+
+**/
+EFI_STATUS
+TerminalSyncAttribute (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *String;
+  UINTN       Length;
+
+  if (TerminalDevice->RemoteAttribute == TerminalDevice->SimpleTextOutputMode.Attribute) {
+    return EFI_SUCCESS;
+  }
+
+  String = TerminalAttributeString ((UINTN) TerminalDevice->SimpleTextOutputMode.Attribute);
+  Status = TerminalQueueControlString (TerminalDevice, String);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  TerminalDevice->RemoteAttribute = TerminalDevice->SimpleTextOutputMode.Attribute;
+
+  //
+  // TerminalConOutSetAttribute() accounted this sequence as avoided.
+  //
+  Length = StrLen (String);
+  if (TerminalDevice->BytesAvoided >= Length) {
+    TerminalDevice->BytesAvoided -= Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Move the cursor of the terminal to the cursor position of the driver if they
+  differ. Short gaps on the current line are filled by resending the known
+  characters instead of a cursor motion control sequence.
+
+  @param  TerminalDevice    The terminal device.
+
+  @retval EFI_SUCCESS       The cursor of the terminal is in sync.
+  @retval Others            The serial device fails to write the data.
+
+**/
+EFI_STATUS
+TerminalSyncCursor (
+  IN TERMINAL_DEV  *TerminalDevice
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_SIMPLE_TEXT_OUTPUT_MODE *Mode;
+  TERMINAL_SCREEN_CELL        *Cell;
+  UTF8_CHAR                   Utf8Char;
+  UINTN                       Length;
+  INT32                       Column;
+  BOOLEAN                     Warning;
+
+  Mode = &TerminalDevice->SimpleTextOutputMode;
+  if (TerminalDevice->RemoteColumn == Mode->CursorColumn &&
+      TerminalDevice->RemoteRow == Mode->CursorRow) {
+    return EFI_SUCCESS;
+  }
+
+  if (TerminalDevice->RemoteRow == Mode->CursorRow &&
+      TerminalDevice->RemoteColumn >= 0 &&
+      TerminalDevice->RemoteColumn < Mode->CursorColumn &&
+      Mode->CursorColumn - TerminalDevice->RemoteColumn <= TERMINAL_MAX_GAP_FILL) {
+    Cell = &TerminalDevice->Screen[Mode->CursorRow * TerminalDevice->ScreenColumns];
+    for (Column = TerminalDevice->RemoteColumn; Column < Mode->CursorColumn; Column++) {
+      if (Cell[Column].Char == CHAR_NULL || Cell[Column].Attribute != TerminalDevice->RemoteAttribute) {
+        break;
+      }
+    }
+    if (Column == Mode->CursorColumn) {
+      Warning = FALSE;
+      for (Column = TerminalDevice->RemoteColumn; Column < Mode->CursorColumn; Column++) {
+        Length = TerminalEncodeChar (TerminalDevice, Cell[Column].Char, &Utf8Char, &Warning);
+        Status = TerminalQueueOutput (TerminalDevice, &Utf8Char, Length);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+        TerminalDevice->BytesAvoided -= MIN (TerminalDevice->BytesAvoided, Length);
+      }
+      TerminalDevice->RemoteColumn = Mode->CursorColumn;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Status = TerminalQueueControlString (
+             TerminalDevice,
+             TerminalCursorPositionString (
+               TerminalDevice,
+               TerminalDevice->RemoteColumn,
+               TerminalDevice->RemoteRow,
+               (UINTN) Mode->CursorColumn,
+               (UINTN) Mode->CursorRow
+               )
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  TerminalDevice->RemoteColumn = Mode->CursorColumn;
+  TerminalDevice->RemoteRow    = Mode->CursorRow;
+
+  return EFI_SUCCESS;
+}
+
 //
 // Body of the ConOut functions
 //
@@ -178,20 +687,19 @@ TerminalConOutOutputString (
   UINTN                       MaxRow;
   UINTN                       Length;
   UTF8_CHAR                   Utf8Char;
-  CHAR8                       GraphicChar;
-  CHAR8                       AsciiChar;
   EFI_STATUS                  Status;
-  UINT8                       ValidBytes;
   CHAR8                       CrLfStr[2];
+  TERMINAL_SCREEN_CELL        *Cell;
+  BOOLEAN                     UseScreen;
+  BOOLEAN                     IsCell;
+  BOOLEAN                     Skip;
   //
   //  flag used to indicate whether condition happens which will cause
   //  return EFI_WARN_UNKNOWN_GLYPH
   //
   BOOLEAN                     Warning;
 
-  ValidBytes  = 0;
   Warning     = FALSE;
-  AsciiChar   = 0;
 
   //
   //  get Terminal device data structure pointer.
@@ -214,74 +722,64 @@ TerminalConOutOutputString (
           &MaxRow
           );
 
-  for (; *WString != CHAR_NULL; WString++) {
+  //
+  // Control strings of this driver bypass the screen model.
+  //
+  UseScreen = (BOOLEAN) (TerminalDevice->Screen != NULL &&
+                         !TerminalDevice->OutputEscChar &&
+                         TerminalDevice->ScreenColumns == MaxColumn &&
+                         TerminalDevice->ScreenRows == MaxRow);
 
-    switch (TerminalDevice->TerminalType) {
+  for (; *WString != CHAR_NULL; WString++) {
 
-    case TerminalTypePcAnsi:
-    case TerminalTypeVt100:
-    case TerminalTypeVt100Plus:
-    case TerminalTypeTtyTerm:
-    case TerminalTypeLinux:
-    case TerminalTypeXtermR6:
-    case TerminalTypeVt400:
-    case TerminalTypeSCO:
+    Length = TerminalEncodeChar (TerminalDevice, *WString, &Utf8Char, &Warning);
+    IsCell = (BOOLEAN) (*WString >= L' ' && *WString != DEL);
+    Skip   = FALSE;
 
-      if (!TerminalIsValidTextGraphics (*WString, &GraphicChar, &AsciiChar)) {
+    if (UseScreen) {
+      if (IsCell) {
         //
-        // If it's not a graphic character convert Unicode to ASCII.
+        // Skip the character if the terminal already shows it in this cell
+        // with the same attribute. The cursor of the terminal is moved before
+        // the next character that is sent.
         //
-        GraphicChar = (CHAR8) *WString;
-
-        if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
+        Cell = &TerminalDevice->Screen[Mode->CursorRow * MaxColumn + Mode->CursorColumn];
+        if (Cell->Char == *WString && Cell->Attribute == (UINT8) Mode->Attribute) {
+          TerminalDevice->BytesAvoided += Length;
+          Skip = TRUE;
+        } else {
+          Status = TerminalSyncAttribute (TerminalDevice);
+          if (!EFI_ERROR (Status)) {
+            Status = TerminalSyncCursor (TerminalDevice);
+          }
+          if (EFI_ERROR (Status)) {
+            goto OutputError;
+          }
+          Cell->Char      = *WString;
+          Cell->Attribute = (UINT8) Mode->Attribute;
+        }
+      } else {
+        if (*WString != CHAR_BACKSPACE && *WString != CHAR_LINEFEED && *WString != CHAR_CARRIAGE_RETURN) {
           //
-          // when this driver use the OutputString to output control string,
-          // TerminalDevice->OutputEscChar is set to let the Esc char
-          // to be output to the terminal emulation software.
+          // The terminal may draw a replacement glyph for other control
+          // characters.
           //
-          if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
-            GraphicChar = 27;
-          } else {
-            GraphicChar = '?';
-            Warning     = TRUE;
-          }
+          TerminalDevice->Screen[Mode->CursorRow * MaxColumn + Mode->CursorColumn].Char = CHAR_NULL;
+        }
+        Status = TerminalSyncCursor (TerminalDevice);
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
         }
-
-        AsciiChar = GraphicChar;
-
-      }
-
-      if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
-        GraphicChar = AsciiChar;
-      }
-
-      Length = 1;
-
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          &GraphicChar
-                                          );
-
-      if (EFI_ERROR (Status)) {
-        goto OutputError;
       }
+    }
 
-      break;
-
-    case TerminalTypeVtUtf8:
-      UnicodeToUtf8 (*WString, &Utf8Char, &ValidBytes);
-      Length = ValidBytes;
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          (UINT8 *) &Utf8Char
-                                          );
+    if (!Skip) {
+      Status = TerminalQueueOutput (TerminalDevice, &Utf8Char, Length);
       if (EFI_ERROR (Status)) {
         goto OutputError;
       }
-      break;
     }
+
     //
     //  Update cursor position.
     //
@@ -296,6 +794,16 @@ TerminalConOutOutputString (
     case CHAR_LINEFEED:
       if (Mode->CursorRow < (INT32) (MaxRow - 1)) {
         Mode->CursorRow++;
+      } else if (UseScreen) {
+        //
+        // The terminal scrolls up one line.
+        //
+        CopyMem (
+          TerminalDevice->Screen,
+          TerminalDevice->Screen + MaxColumn,
+          (MaxRow - 1) * MaxColumn * sizeof (TERMINAL_SCREEN_CELL)
+          );
+        ZeroMem (TerminalDevice->Screen + (MaxRow - 1) * MaxColumn, MaxColumn * sizeof (TERMINAL_SCREEN_CELL));
       }
       break;
 
@@ -310,13 +818,21 @@ TerminalConOutOutputString (
 
       } else {
 
+        if (UseScreen && !Skip && Mode->CursorRow == (INT32) (MaxRow - 1)) {
+          //
+          // Terminals differ on whether writing the last cell scrolls the
+          // screen, so the model can not be trusted any more.
+          //
+          ZeroMem (TerminalDevice->Screen, MaxRow * MaxColumn * sizeof (TERMINAL_SCREEN_CELL));
+        }
+
         Mode->CursorColumn = 0;
         if (Mode->CursorRow < (INT32) (MaxRow - 1)) {
           Mode->CursorRow++;
         }
 
         if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
-            !TerminalDevice->OutputEscChar) {
+            !TerminalDevice->OutputEscChar && !Skip) {
           //
           // We've written the last character on the line.  The
           // terminal doesn't actually wrap its cursor until we print
@@ -328,23 +844,60 @@ TerminalConOutOutputString (
           CrLfStr[0] = '\r';
           CrLfStr[1] = '\n';
 
-          Length = sizeof(CrLfStr);
-
-          Status = TerminalDevice->SerialIo->Write (
-                                                TerminalDevice->SerialIo,
-                                                &Length,
-                                                CrLfStr
-                                                );
-
+          Status = TerminalQueueOutput (TerminalDevice, CrLfStr, sizeof (CrLfStr));
           if (EFI_ERROR (Status)) {
             goto OutputError;
           }
+
+          TerminalDevice->RemoteColumn = Mode->CursorColumn;
+          TerminalDevice->RemoteRow    = Mode->CursorRow;
+          continue;
         }
       }
       break;
 
     };
 
+    if (UseScreen && !Skip) {
+      //
+      // Control characters other than these move the cursor of the terminal
+      // in ways the driver does not track.
+      //
+      if (IsCell || *WString == CHAR_BACKSPACE ||
+          *WString == CHAR_LINEFEED || *WString == CHAR_CARRIAGE_RETURN) {
+        TerminalDevice->RemoteColumn = Mode->CursorColumn;
+        TerminalDevice->RemoteRow    = Mode->CursorRow;
+      } else {
+        TerminalDevice->RemoteColumn = -1;
+        TerminalDevice->RemoteRow    = -1;
+      }
+      if (IsCell && Mode->CursorColumn == 0) {
+        //
+        // The terminal may defer the wrap after the last column.
+        //
+        TerminalDevice->RemoteColumn = -1;
+        TerminalDevice->RemoteRow    = -1;
+      }
+    }
+  }
+
+  if (UseScreen) {
+    //
+    // Leave the cursor of the terminal where the driver reports it.
+    //
+    Status = TerminalSyncCursor (TerminalDevice);
+    if (EFI_ERROR (Status)) {
+      goto OutputError;
+    }
+  } else if (TerminalDevice->Screen != NULL) {
+    TerminalDevice->RemoteColumn    = -1;
+    TerminalDevice->RemoteRow       = -1;
+    TerminalDevice->RemoteAttribute = -1;
+  }
+
+  Status = TerminalFlushOutput (TerminalDevice);
+  if (EFI_ERROR (Status)) {
+    goto OutputError;
   }
 
   if (Warning) {
@@ -354,6 +907,7 @@ TerminalConOutOutputString (
   return EFI_SUCCESS;
 
 OutputError:
+  TerminalDiscardOutput (TerminalDevice);
   REPORT_STATUS_CODE_WITH_DEVICE_PATH (
     EFI_ERROR_CODE | EFI_ERROR_MINOR,
     (EFI_PERIPHERAL_REMOTE_CONSOLE | EFI_P_EC_OUTPUT_ERROR),
@@ -496,6 +1050,8 @@ TerminalConOutSetMode (
   //
   This->Mode->Mode = (INT32) ModeNumber;
 
+  TerminalScreenReset (TerminalDevice);
+
   This->ClearScreen (This);
 
   TerminalDevice->OutputEscChar = TRUE;
@@ -537,9 +1093,6 @@ TerminalConOutSetAttribute (
   IN  UINTN                            Attribute
   )
 {
-  UINT8         ForegroundControl;
-  UINT8         BackgroundControl;
-  UINT8         BrightControl;
   INT32         SavedColumn;
   INT32         SavedRow;
   EFI_STATUS    Status;
@@ -568,101 +1121,17 @@ TerminalConOutSetAttribute (
     return EFI_SUCCESS;
   }
 
-  //
-  //  convert Attribute value to terminal emulator
-  //  understandable foreground color
-  //
-  switch (Attribute & 0x07) {
-
-  case EFI_BLACK:
-    ForegroundControl = 30;
-    break;
-
-  case EFI_BLUE:
-    ForegroundControl = 34;
-    break;
-
-  case EFI_GREEN:
-    ForegroundControl = 32;
-    break;
-
-  case EFI_CYAN:
-    ForegroundControl = 36;
-    break;
-
-  case EFI_RED:
-    ForegroundControl = 31;
-    break;
-
-  case EFI_MAGENTA:
-    ForegroundControl = 35;
-    break;
-
-  case EFI_BROWN:
-    ForegroundControl = 33;
-    break;
-
-  default:
-
-  case EFI_LIGHTGRAY:
-    ForegroundControl = 37;
-    break;
-
+  if (TerminalDevice->Screen != NULL) {
+    //
+    // The control sequence is sent before the next character that uses
+    // this attribute.
+    //
+    This->Mode->Attribute         = (INT32) Attribute;
+    TerminalDevice->BytesAvoided += StrLen (mSetAttributeString);
+    return EFI_SUCCESS;
   }
-  //
-  //  bit4 of the Attribute indicates bright control
-  //  of terminal emulator.
-  //
-  BrightControl = (UINT8) ((Attribute >> 3) & 1);
-
-  //
-  //  convert Attribute value to terminal emulator
-  //  understandable background color.
-  //
-  switch ((Attribute >> 4) & 0x07) {
-
-  case EFI_BLACK:
-    BackgroundControl = 40;
-    break;
 
-  case EFI_BLUE:
-    BackgroundControl = 44;
-    break;
-
-  case EFI_GREEN:
-    BackgroundControl = 42;
-    break;
-
-  case EFI_CYAN:
-    BackgroundControl = 46;
-    break;
-
-  case EFI_RED:
-    BackgroundControl = 41;
-    break;
-
-  case EFI_MAGENTA:
-    BackgroundControl = 45;
-    break;
-
-  case EFI_BROWN:
-    BackgroundControl = 43;
-    break;
-
-  default:
-
-  case EFI_LIGHTGRAY:
-    BackgroundControl = 47;
-    break;
-  }
-  //
-  // terminal emulator's control sequence to set attributes
-  //
-  mSetAttributeString[BRIGHT_CONTROL_OFFSET]          = (CHAR16) ('0' + BrightControl);
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (ForegroundControl / 10));
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (ForegroundControl % 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (BackgroundControl / 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (BackgroundControl % 10));
+  TerminalAttributeString (Attribute);
 
   //
   // save current column and row
@@ -711,9 +1180,32 @@ TerminalConOutClearScreen (
 {
   EFI_STATUS    Status;
   TERMINAL_DEV  *TerminalDevice;
+  UINTN         Index;
 
   TerminalDevice = TERMINAL_CON_OUT_DEV_FROM_THIS (This);
 
+  if (TerminalDevice->Screen != NULL) {
+    //
+    // The screen is cleared to the background color of the current attribute.
+    //
+    Status = TerminalSyncAttribute (TerminalDevice);
+    if (!EFI_ERROR (Status)) {
+      Status = TerminalQueueControlString (TerminalDevice, mClearScreenString);
+    }
+    if (EFI_ERROR (Status)) {
+      TerminalDiscardOutput (TerminalDevice);
+      return EFI_DEVICE_ERROR;
+    }
+    for (Index = 0; Index < TerminalDevice->ScreenColumns * TerminalDevice->ScreenRows; Index++) {
+      TerminalDevice->Screen[Index].Char      = L' ';
+      TerminalDevice->Screen[Index].Attribute = (UINT8) This->Mode->Attribute;
+    }
+    TerminalDevice->RemoteColumn = -1;
+    TerminalDevice->RemoteRow    = -1;
+
+    return This->SetCursorPosition (This, 0, 0);
+  }
+
   //
   //  control sequence for clear screen request
   //
@@ -782,36 +1274,32 @@ TerminalConOutSetCursorPosition (
   if (Column >= MaxColumn || Row >= MaxRow) {
     return EFI_UNSUPPORTED;
   }
-  //
-  // control sequence to move the cursor
-  //
-  // Optimize cursor motion control sequences for TtyTerm.  Move
-  // within the current line if possible, and don't output anyting if
-  // it isn't necessary.
-  //
-  if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
-      (UINTN)Mode->CursorRow == Row) {
-    if ((UINTN)Mode->CursorColumn > Column) {
-      mCursorBackwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((Mode->CursorColumn - Column) / 10));
-      mCursorBackwardString[FW_BACK_OFFSET + 1] = (CHAR16) ('0' + ((Mode->CursorColumn - Column) % 10));
-      String = mCursorBackwardString;
-    }
-    else if (Column > (UINTN)Mode->CursorColumn) {
-      mCursorForwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((Column - Mode->CursorColumn) / 10));
-      mCursorForwardString[FW_BACK_OFFSET + 1] = (CHAR16) ('0' + ((Column - Mode->CursorColumn) % 10));
-      String = mCursorForwardString;
+
+  if (TerminalDevice->Screen != NULL) {
+    Mode->CursorColumn  = (INT32) Column;
+    Mode->CursorRow     = (INT32) Row;
+
+    Status = TerminalSyncCursor (TerminalDevice);
+    if (!EFI_ERROR (Status)) {
+      Status = TerminalFlushOutput (TerminalDevice);
     }
-    else {
-      String = L"";  // No cursor motion necessary
+    if (EFI_ERROR (Status)) {
+      TerminalDiscardOutput (TerminalDevice);
+      return EFI_DEVICE_ERROR;
     }
+    return EFI_SUCCESS;
   }
-  else {
-    mSetCursorPositionString[ROW_OFFSET + 0]    = (CHAR16) ('0' + ((Row + 1) / 10));
-    mSetCursorPositionString[ROW_OFFSET + 1]    = (CHAR16) ('0' + ((Row + 1) % 10));
-    mSetCursorPositionString[COLUMN_OFFSET + 0] = (CHAR16) ('0' + ((Column + 1) / 10));
-    mSetCursorPositionString[COLUMN_OFFSET + 1] = (CHAR16) ('0' + ((Column + 1) % 10));
-    String = mSetCursorPositionString;
-  }
+
+  //
+  // control sequence to move the cursor
+  //
+  String = TerminalCursorPositionString (
+             TerminalDevice,
+             Mode->CursorColumn,
+             Mode->CursorRow,
+             Column,
+             Row
+             );
 
   TerminalDevice->OutputEscChar               = TRUE;
   Status = This->OutputString (This, String);
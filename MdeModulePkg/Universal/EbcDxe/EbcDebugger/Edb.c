@@ -91,6 +91,11 @@ EdbClearAllBreakpoint (
     ZeroMem (DebuggerPrivate->DebuggerBreakpointContext, sizeof(DebuggerPrivate->DebuggerBreakpointContext));
   }
 
+  //
+  // Drop the instructions decoded from the patched code
+  //
+  EbcFlushTranslationCache ();
+
   //
   // Done
   //
@@ -139,6 +144,11 @@ EdbSetAllBreakpoint (
     DebuggerPrivate->StatusFlags &= ~EFI_DEBUG_FLAG_EBC_B_BP;
   }
 
+  //
+  // Drop the instructions decoded from the patched code
+  //
+  EbcFlushTranslationCache ();
+
   //
   // Done
   //
@@ -190,6 +190,11 @@ EdbEnterMemory (
     break;
   }
 
+  //
+  // The memory may hold instructions the VM has decoded already.
+  //
+  EbcFlushTranslationCache ();
+
   return ;
 }
 
@@ -32,6 +32,17 @@ EbcDebugSignalException (
   IN VM_CONTEXT                           *VmPtr
   );
 
+/**
+  Flush the translation cache of pre-decoded instructions. This must be called
+  when EBC code is modified other than by the VM itself, for example when an
+  image is unloaded or a debugger patches code.
+
+**/
+VOID
+EbcFlushTranslationCache (
+  VOID
+  );
+
 /**
 
   The hook in InitializeEbcDriver.
@@ -11,16 +11,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "EbcDebuggerHook.h"
 
 
-//
-// Define some useful data size constants to allow switch statements based on
-// size of operands or data.
-//
-#define DATA_SIZE_INVALID 0
-#define DATA_SIZE_8       1
-#define DATA_SIZE_16      2
-#define DATA_SIZE_32      4
-#define DATA_SIZE_64      8
-#define DATA_SIZE_N       48  // 4 or 8
 //
 // Structure we'll use to dispatch opcodes to execute functions.
 //
@@ -37,6 +27,30 @@ UINT64
   IN UINT64     Op2
   );
 
+//
+// A basic block of pre-decoded instructions, looked up by the address of its
+// first instruction. Blocks of an older generation are stale.
+//
+typedef struct {
+  VMIP                          Ip;
+  UINTN                         Generation;
+  EBC_DECODED_INSTRUCTION       *Instructions;
+  UINTN                         Count;
+} EBC_DECODED_BLOCK;
+
+//
+// Most instructions decoded into one block. With the largest instruction being
+// 18 bytes, a block never spans more than two pages.
+//
+#define EBC_DECODED_BLOCK_MAX_INSTRUCTIONS  32
+
+//
+// Most code pages the translation cache tracks for self-modifying writes, and
+// the size of the bitmap used to filter writes to other pages.
+//
+#define EBC_CODE_PAGE_MAX                   64
+#define EBC_CODE_PAGE_FILTER_BITS           4096
+
 /**
   Decode a 16-bit index to determine the offset. Given an index value:
 
@@ -1241,6 +1255,41 @@ ExecuteEXTNDD (
   IN UINT64       Op2
   );
 
+/**
+  Look up the pre-decoded basic block starting at an instruction pointer in
+  the translation cache, and decode the block if it is not cached yet.
+
+  @param  Ip                The address of the first instruction of the block.
+  @param  BlockEnd          Returns the end of the pre-decoded instructions of
+                            the block.
+  @param  Generation        Returns the translation cache generation the block
+                            belongs to.
+
+  @return The first pre-decoded instruction of the block, or NULL if the
+          instruction at Ip has to be executed without the translation cache.
+
+**/
+EBC_DECODED_INSTRUCTION *
+EbcLookupDecodedBlock (
+  IN  VMIP                      Ip,
+  OUT EBC_DECODED_INSTRUCTION   **BlockEnd,
+  OUT UINTN                     *Generation
+  );
+
+/**
+  Flush the translation cache if a write by the VM hits a code page that
+  instructions were decoded from.
+
+  @param  Addr              Address the VM writes to.
+  @param  Size              Size of the write in bytes.
+
+**/
+VOID
+EbcCheckCodeWrite (
+  IN UINTN  Addr,
+  IN UINTN  Size
+  );
+
 //
 // Once we retrieve the operands for the data manipulation instructions,
 // call these functions to perform the operation.
@@ -1339,6 +1388,29 @@ CONST VM_TABLE_ENTRY           mVmOpcodeTable[] = {
 //
 CONST UINT8                    mJMPLen[] = { 2, 2, 6, 10 };
 
+//
+// Translation cache of pre-decoded basic blocks. The pool holds the decoded
+// instructions, and the block table maps the address of the first instruction
+// of a block to its decoded instructions. The cache is flushed by advancing
+// the generation, and the pool is only reused the next time a block is decoded
+// while no pre-decoded instruction is being executed.
+//
+EBC_DECODED_INSTRUCTION        *mEbcDecodedPool     = NULL;
+UINTN                          mEbcDecodedPoolSize  = 0;
+UINTN                          mEbcDecodedPoolUsed  = 0;
+EBC_DECODED_BLOCK              *mEbcDecodedBlocks   = NULL;
+UINTN                          mEbcDecodedBlockMask = 0;
+volatile UINTN                 mEbcTranslationCacheGeneration      = 1;
+UINTN                          mEbcTranslationCacheResetGeneration = 1;
+volatile UINTN                 mEbcTranslationCacheLock            = 0;
+
+//
+// Code pages instructions have been decoded from since the last reset.
+//
+UINTN                          mEbcCodePages[EBC_CODE_PAGE_MAX];
+UINTN                          mEbcCodePageCount = 0;
+UINT32                         mEbcCodePageFilter[EBC_CODE_PAGE_FILTER_BITS / 32];
+
 /**
   Given a pointer to a new VM context, execute one or more instructions. This
   function is only used for test purposes via the EBC VM test protocol.
@@ -1422,11 +1494,17 @@ EbcExecute (
   UINT8                             StackCorrupted;
   EFI_STATUS                        Status;
   EFI_EBC_SIMPLE_DEBUGGER_PROTOCOL  *EbcSimpleDebugger;
+  EBC_DECODED_INSTRUCTION           *Instruction;
+  EBC_DECODED_INSTRUCTION           *BlockEnd;
+  UINTN                             Generation;
 
   mVmPtr            = VmPtr;
   EbcSimpleDebugger = NULL;
   Status            = EFI_SUCCESS;
   StackCorrupted    = 0;
+  Instruction       = NULL;
+  BlockEnd          = NULL;
+  Generation        = 0;
 
   //
   // Make sure the magic value has been put on the stack before we got here.
@@ -1473,15 +1551,29 @@ EbcExecute (
       }
     DEBUG_CODE_END ();
 
+    //
+    // Continue with the next pre-decoded instruction of the current block if
+    // execution fell through to it. Otherwise look up the block starting at
+    // the IP in the translation cache.
+    //
+    if ((Instruction == NULL) ||
+        (Generation != mEbcTranslationCacheGeneration) ||
+        (Instruction == BlockEnd) ||
+        (Instruction->Ip != VmPtr->Ip)) {
+      Instruction = EbcLookupDecodedBlock (VmPtr->Ip, &BlockEnd, &Generation);
+    }
+
     //
     // Use the opcode bits to index into the opcode dispatch table. If the
     // function pointer is null then generate an exception.
     //
-    ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
-    if (ExecFunc == (UINTN) NULL) {
-      EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
-      Status = EFI_UNSUPPORTED;
-      goto Done;
+    if (Instruction == NULL) {
+      ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
+      if (ExecFunc == (UINTN) NULL) {
+        EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
+        Status = EFI_UNSUPPORTED;
+        goto Done;
+      }
     }
 
     EbcDebuggerHookExecuteStart (VmPtr);
@@ -1492,7 +1584,38 @@ EbcExecute (
     //
     MemoryFence ();
 
-    mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+    if ((Instruction != NULL) &&
+        (Instruction->Ip == VmPtr->Ip) &&
+        (Instruction->NativeCode != NULL) &&
+        (EbcSimpleDebugger == NULL) &&
+        !VMFLAG_ISSET (VmPtr, VMFLAGS_STEP)) {
+      //
+      // Run the native code of a run of instructions that only operate on VM
+      // registers. None of them can raise an exception, so the checks below
+      // are done once for the whole run.
+      //
+      mEbcTranslationCacheLock++;
+      Instruction += Instruction->NativeCode (VmPtr);
+      mEbcTranslationCacheLock--;
+    } else {
+      if ((Instruction != NULL) &&
+          (Instruction->Ip == VmPtr->Ip) &&
+          (Instruction->ExecuteFunction != NULL)) {
+        //
+        // Keep the pool from being reused while the pre-decoded instruction is
+        // executed. Handlers that may re-enter the VM have no pre-decoded form.
+        //
+        mEbcTranslationCacheLock++;
+        Instruction->ExecuteFunction (VmPtr, Instruction);
+        mEbcTranslationCacheLock--;
+      } else {
+        mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+      }
+
+      if (Instruction != NULL) {
+        Instruction++;
+      }
+    }
 
     MemoryFence ();
 
@@ -4650,6 +4773,7 @@ VmWriteMem8 (
   //
   Addr            = ConvertStackAddr (VmPtr, Addr);
   *(UINT8 *) Addr = Data;
+  EbcCheckCodeWrite (Addr, sizeof (UINT8));
   return EFI_SUCCESS;
 }
 
@@ -4695,6 +4819,7 @@ VmWriteMem16 (
   //
   if (IS_ALIGNED (Addr, sizeof (UINT16))) {
     *(UINT16 *) Addr = Data;
+    EbcCheckCodeWrite (Addr, sizeof (UINT16));
   } else {
     //
     // Write as two bytes
@@ -4758,6 +4883,7 @@ VmWriteMem32 (
   //
   if (IS_ALIGNED (Addr, sizeof (UINT32))) {
     *(UINT32 *) Addr = Data;
+    EbcCheckCodeWrite (Addr, sizeof (UINT32));
   } else {
     //
     // Write as two words
@@ -4821,6 +4947,7 @@ VmWriteMem64 (
   //
   if (IS_ALIGNED (Addr, sizeof (UINT64))) {
     *(UINT64 *) Addr = Data;
+    EbcCheckCodeWrite (Addr, sizeof (UINT64));
   } else {
     //
     // Write as two 32-bit words
@@ -4887,6 +5014,7 @@ VmWriteMemN (
   //
   if (IS_ALIGNED (Addr, sizeof (UINTN))) {
     *(UINTN *) Addr = Data;
+    EbcCheckCodeWrite (Addr, sizeof (UINTN));
   } else {
     for (Index = 0; Index < sizeof (UINTN) / sizeof (UINT32); Index++) {
       MemoryFence ();
@@ -5381,3 +5509,1280 @@ GetVmVersion (
 {
   return (UINT64) (((VM_MAJOR_VERSION & 0xFFFF) << 16) | ((VM_MINOR_VERSION & 0xFFFF)));
 }
+
+
+/**
+  Execute a pre-decoded JMP8 instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedJMP8 (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8 CompareSet;
+
+  //
+  // If we haven't met the condition, then simply advance the IP and return
+  //
+  if ((Instruction->Opcode & CONDITION_M_CONDITIONAL) != 0) {
+    CompareSet = (UINT8) (((Instruction->Opcode & JMP_M_CS) != 0) ? 1 : 0);
+    if (CompareSet != (UINT8) VMFLAG_ISSET (VmPtr, VMFLAGS_CC)) {
+      EbcDebuggerHookJMP8Start (VmPtr);
+      VmPtr->Ip += 2;
+      EbcDebuggerHookJMP8End (VmPtr);
+      return EFI_SUCCESS;
+    }
+  }
+  //
+  // Index2 holds the offset from the instruction to the jump target.
+  //
+  EbcDebuggerHookJMP8Start (VmPtr);
+  VmPtr->Ip += (INTN) Instruction->Index2;
+  EbcDebuggerHookJMP8End (VmPtr);
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded JMP instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_UNSUPPORTED   The jump target is not aligned.
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedJMP (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Operand;
+  UINT8   CompareSet;
+  UINT64  Data64;
+  INT32   Index32;
+  UINTN   Addr;
+
+  Operand = Instruction->Operands;
+
+  //
+  // If we haven't met the condition, then simply advance the IP and return.
+  //
+  if ((Operand & CONDITION_M_CONDITIONAL) != 0) {
+    CompareSet = (UINT8) (((Operand & JMP_M_CS) != 0) ? 1 : 0);
+    if (CompareSet != (UINT8) VMFLAG_ISSET (VmPtr, VMFLAGS_CC)) {
+      EbcDebuggerHookJMPStart (VmPtr);
+      VmPtr->Ip += Instruction->Size;
+      EbcDebuggerHookJMPEnd (VmPtr);
+      return EFI_SUCCESS;
+    }
+  }
+  //
+  // 64-bit form. The immediate data was checked for alignment when the
+  // instruction was decoded.
+  //
+  if ((Instruction->Opcode & OPCODE_M_IMMDATA64) != 0) {
+    Data64 = (UINT64) Instruction->Index2;
+    EbcDebuggerHookJMPStart (VmPtr);
+    if ((Operand & JMP_M_RELATIVE) != 0) {
+      VmPtr->Ip += (UINTN) Data64 + Instruction->Size;
+    } else {
+      VmPtr->Ip = (VMIP) (UINTN) Data64;
+    }
+    EbcDebuggerHookJMPEnd (VmPtr);
+    return EFI_SUCCESS;
+  }
+  //
+  // 32-bit forms: JMP32 @R1 {Index32} and JMP32 R1 {Immed32}. If R == 0,
+  // then the register is ignored.
+  //
+  Index32 = (INT32) Instruction->Index2;
+  if (OPERAND1_REGNUM (Operand) == 0) {
+    Data64 = 0;
+  } else {
+    Data64 = (UINT64) OPERAND1_REGDATA (VmPtr, Operand);
+  }
+
+  if (OPERAND1_INDIRECT (Operand)) {
+    Addr = VmReadMemN (VmPtr, (UINTN) Data64 + Index32);
+  } else {
+    Addr = (UINTN) (Data64 + Index32);
+  }
+
+  if (!IS_ALIGNED ((UINTN) Addr, sizeof (UINT16))) {
+    EbcDebugSignalException (
+      EXCEPT_EBC_ALIGNMENT_CHECK,
+      EXCEPTION_FLAG_FATAL,
+      VmPtr
+      );
+
+    return EFI_UNSUPPORTED;
+  }
+
+  EbcDebuggerHookJMPStart (VmPtr);
+  if ((Operand & JMP_M_RELATIVE) != 0) {
+    VmPtr->Ip += (UINTN) Addr + Instruction->Size;
+  } else {
+    VmPtr->Ip = (VMIP) Addr;
+  }
+  EbcDebuggerHookJMPEnd (VmPtr);
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Compare two operands of a CMP or CMPI instruction.
+
+  @param  Condition         The comparison, OPCODE_CMPEQ to OPCODE_CMPUGTE.
+  @param  Is64Bit           TRUE for a 64-bit comparison, FALSE for a 32-bit
+                            comparison.
+  @param  Op1               Operand 1 of the comparison.
+  @param  Op2               Operand 2 of the comparison.
+
+  @retval TRUE              The condition is met.
+  @retval FALSE             The condition is not met.
+
+**/
+BOOLEAN
+EbcDecodedCompare (
+  IN UINT8    Condition,
+  IN BOOLEAN  Is64Bit,
+  IN INT64    Op1,
+  IN INT64    Op2
+  )
+{
+  if (Is64Bit) {
+    switch (Condition) {
+    case OPCODE_CMPEQ:
+      return (BOOLEAN) (Op1 == Op2);
+    case OPCODE_CMPLTE:
+      return (BOOLEAN) (Op1 <= Op2);
+    case OPCODE_CMPGTE:
+      return (BOOLEAN) (Op1 >= Op2);
+    case OPCODE_CMPULTE:
+      return (BOOLEAN) ((UINT64) Op1 <= (UINT64) Op2);
+    case OPCODE_CMPUGTE:
+      return (BOOLEAN) ((UINT64) Op1 >= (UINT64) Op2);
+    default:
+      ASSERT (0);
+      return FALSE;
+    }
+  }
+
+  switch (Condition) {
+  case OPCODE_CMPEQ:
+    return (BOOLEAN) ((INT32) Op1 == (INT32) Op2);
+  case OPCODE_CMPLTE:
+    return (BOOLEAN) ((INT32) Op1 <= (INT32) Op2);
+  case OPCODE_CMPGTE:
+    return (BOOLEAN) ((INT32) Op1 >= (INT32) Op2);
+  case OPCODE_CMPULTE:
+    return (BOOLEAN) ((UINT32) Op1 <= (UINT32) Op2);
+  case OPCODE_CMPUGTE:
+    return (BOOLEAN) ((UINT32) Op1 >= (UINT32) Op2);
+  default:
+    ASSERT (0);
+    return FALSE;
+  }
+}
+
+
+/**
+  Execute a pre-decoded CMP instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedCMP (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  INT16   Index16;
+  INT64   Op1;
+  INT64   Op2;
+
+  Opcode    = Instruction->Opcode;
+  Operands  = Instruction->Operands;
+  Index16   = (INT16) Instruction->Index2;
+
+  Op1 = VmPtr->Gpr[OPERAND1_REGNUM (Operands)];
+  if (OPERAND2_INDIRECT (Operands)) {
+    if ((Opcode & OPCODE_M_64BIT) != 0) {
+      Op2 = (INT64) VmReadMem64 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Index16));
+    } else {
+      //
+      // 32-bit operations. 0-extend the values for all cases.
+      //
+      Op2 = (INT64) (UINT64) ((UINT32) VmReadMem32 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Index16)));
+    }
+  } else {
+    Op2 = VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Index16;
+  }
+
+  if (EbcDecodedCompare (Instruction->Param, (BOOLEAN) ((Opcode & OPCODE_M_64BIT) != 0), Op1, Op2)) {
+    VMFLAG_SET (VmPtr, VMFLAGS_CC);
+  } else {
+    VMFLAG_CLEAR (VmPtr, (UINT64)VMFLAGS_CC);
+  }
+
+  VmPtr->Ip += Instruction->Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded CMPI instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedCMPI (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  INT16   Index16;
+  INT64   Op1;
+
+  Opcode    = Instruction->Opcode;
+  Operands  = Instruction->Operands;
+  Index16   = (INT16) Instruction->Index1;
+
+  Op1 = (INT64) VmPtr->Gpr[OPERAND1_REGNUM (Operands)];
+  if (OPERAND1_INDIRECT (Operands)) {
+    //
+    // Indirect operand1. Fetch 32 or 64-bit value based on compare size.
+    //
+    if ((Opcode & OPCODE_M_CMPI64) != 0) {
+      Op1 = (INT64) VmReadMem64 (VmPtr, (UINTN) Op1 + Index16);
+    } else {
+      Op1 = (INT64) VmReadMem32 (VmPtr, (UINTN) Op1 + Index16);
+    }
+  }
+  //
+  // Index2 holds the immediate data, already zero-extended for the 64-bit
+  // unsigned comparisons.
+  //
+  if (EbcDecodedCompare (Instruction->Param, (BOOLEAN) ((Opcode & OPCODE_M_CMPI64) != 0), Op1, Instruction->Index2)) {
+    VMFLAG_SET (VmPtr, VMFLAGS_CC);
+  } else {
+    VMFLAG_CLEAR (VmPtr, (UINT64)VMFLAGS_CC);
+  }
+
+  VmPtr->Ip += Instruction->Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded data manipulation instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedDataManip (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  INT16   Index16;
+  BOOLEAN IsSignedOp;
+  UINT64  Op1;
+  UINT64  Op2;
+
+  Opcode     = Instruction->Opcode;
+  Operands   = Instruction->Operands;
+  Index16    = (INT16) Instruction->Index2;
+  IsSignedOp = (BOOLEAN) ((Instruction->Param & EBC_DECODED_DATAMANIP_SIGNED) != 0);
+
+  //
+  // Now get operand2 (source). It's of format {@}R2 {Index16|Immed16}
+  //
+  Op2 = (UINT64) VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Index16;
+  if (OPERAND2_INDIRECT (Operands)) {
+    if ((Opcode & DATAMANIP_M_64) != 0) {
+      Op2 = VmReadMem64 (VmPtr, (UINTN) Op2);
+    } else if (IsSignedOp) {
+      Op2 = (UINT64) (INT64) ((INT32) VmReadMem32 (VmPtr, (UINTN) Op2));
+    } else {
+      Op2 = (UINT64) VmReadMem32 (VmPtr, (UINTN) Op2);
+    }
+  } else if ((Opcode & DATAMANIP_M_64) == 0) {
+    if (IsSignedOp) {
+      Op2 = (UINT64) (INT64) ((INT32) Op2);
+    } else {
+      Op2 = (UINT64) ((UINT32) Op2);
+    }
+  }
+  //
+  // Get operand1 (destination and sometimes also an actual operand)
+  // of form {@}R1
+  //
+  Op1 = (UINT64) VmPtr->Gpr[OPERAND1_REGNUM (Operands)];
+  if (OPERAND1_INDIRECT (Operands)) {
+    if ((Opcode & DATAMANIP_M_64) != 0) {
+      Op1 = VmReadMem64 (VmPtr, (UINTN) Op1);
+    } else if (IsSignedOp) {
+      Op1 = (UINT64) (INT64) ((INT32) VmReadMem32 (VmPtr, (UINTN) Op1));
+    } else {
+      Op1 = (UINT64) VmReadMem32 (VmPtr, (UINTN) Op1);
+    }
+  } else if ((Opcode & DATAMANIP_M_64) == 0) {
+    if (IsSignedOp) {
+      Op1 = (UINT64) (INT64) ((INT32) Op1);
+    } else {
+      Op1 = (UINT64) ((UINT32) Op1);
+    }
+  }
+
+  Op2 = mDataManipDispatchTable[Instruction->Param & EBC_DECODED_DATAMANIP_M_INDEX](VmPtr, Op1, Op2);
+
+  //
+  // Write back the result.
+  //
+  if (OPERAND1_INDIRECT (Operands)) {
+    Op1 = (UINT64) VmPtr->Gpr[OPERAND1_REGNUM (Operands)];
+    if ((Opcode & DATAMANIP_M_64) != 0) {
+      VmWriteMem64 (VmPtr, (UINTN) Op1, Op2);
+    } else {
+      VmWriteMem32 (VmPtr, (UINTN) Op1, (UINT32) Op2);
+    }
+  } else {
+    VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Op2;
+    if ((Opcode & DATAMANIP_M_64) == 0) {
+      VmPtr->Gpr[OPERAND1_REGNUM (Operands)] &= 0xFFFFFFFF;
+    }
+  }
+
+  VmPtr->Ip += Instruction->Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded MOVxx instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction. Param holds the size
+                            of the move.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedMOVxx (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Operands;
+  UINT64  Data64;
+  UINTN   Source;
+
+  Operands = Instruction->Operands;
+  Data64   = 0;
+
+  if (OPERAND2_INDIRECT (Operands)) {
+    //
+    // Indirect form @R2. Always 0-extend and let the compiler sign-extend
+    // where required.
+    //
+    Source = (UINTN) (VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Instruction->Index2);
+    switch (Instruction->Param) {
+    case DATA_SIZE_8:
+      Data64 = (UINT64) (UINT8) VmReadMem8 (VmPtr, Source);
+      break;
+
+    case DATA_SIZE_16:
+      Data64 = (UINT64) (UINT16) VmReadMem16 (VmPtr, Source);
+      break;
+
+    case DATA_SIZE_32:
+      Data64 = (UINT64) (UINT32) VmReadMem32 (VmPtr, Source);
+      break;
+
+    case DATA_SIZE_64:
+      Data64 = (UINT64) VmReadMem64 (VmPtr, Source);
+      break;
+
+    case DATA_SIZE_N:
+      Data64 = (UINT64) (UINTN) VmReadMemN (VmPtr, Source);
+      break;
+    }
+  } else {
+    Data64 = (UINT64) (VmPtr->Gpr[OPERAND2_REGNUM (Operands)] + Instruction->Index2);
+    //
+    // Same stack gap special case as ExecuteMOVxx(), for the address of a
+    // function parameter stored on the stack.
+    //
+    if (((Instruction->Opcode & OPCODE_M_IMMED_OP2) != 0) &&
+        (OPERAND2_REGNUM (Operands) == 0) &&
+        (Instruction->Index2 > 0) &&
+        (OPERAND1_REGNUM (Operands) == 0) &&
+        (OPERAND1_INDIRECT (Operands))
+        ) {
+      Data64 = (UINT64) ConvertStackAddr (VmPtr, (UINTN) (INT64) Data64);
+    }
+  }
+
+  if (OPERAND1_INDIRECT (Operands)) {
+    Source = (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Instruction->Index1);
+    switch (Instruction->Param) {
+    case DATA_SIZE_8:
+      VmWriteMem8 (VmPtr, Source, (UINT8) Data64);
+      break;
+
+    case DATA_SIZE_16:
+      VmWriteMem16 (VmPtr, Source, (UINT16) Data64);
+      break;
+
+    case DATA_SIZE_32:
+      VmWriteMem32 (VmPtr, Source, (UINT32) Data64);
+      break;
+
+    case DATA_SIZE_64:
+      VmWriteMem64 (VmPtr, Source, Data64);
+      break;
+
+    case DATA_SIZE_N:
+      VmWriteMemN (VmPtr, Source, (UINTN) Data64);
+      break;
+    }
+  } else {
+    //
+    // Direct storage in register. Clear unused bits.
+    //
+    switch (Instruction->Param) {
+    case DATA_SIZE_8:
+      Data64 &= 0xFF;
+      break;
+
+    case DATA_SIZE_16:
+      Data64 &= 0xFFFF;
+      break;
+
+    case DATA_SIZE_32:
+      Data64 &= 0xFFFFFFFF;
+      break;
+
+    case DATA_SIZE_N:
+      Data64 &= (UINT64)~0 >> (64 - 8 * sizeof (UINTN));
+      break;
+    }
+
+    VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Data64;
+  }
+
+  VmPtr->Ip += Instruction->Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded MOVI, MOVIn or MOVREL instruction. Index2 holds the
+  value to store: the sign-extended immediate data, the decoded natural index,
+  or the IP relative address.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedMOVI (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Operands;
+  UINT64  Op1;
+
+  Operands = Instruction->Operands;
+
+  if (!OPERAND1_INDIRECT (Operands)) {
+    if ((Instruction->Opcode & OPCODE_M_OPCODE) == OPCODE_MOVI) {
+      //
+      // Writing directly to a register. Clear unused bits.
+      //
+      switch (Operands & MOVI_M_MOVEWIDTH) {
+      case MOVI_MOVEWIDTH8:
+        VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Instruction->Index2 & 0x000000FF;
+        break;
+
+      case MOVI_MOVEWIDTH16:
+        VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Instruction->Index2 & 0x0000FFFF;
+        break;
+
+      case MOVI_MOVEWIDTH32:
+        VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Instruction->Index2 & 0x00000000FFFFFFFF;
+        break;
+
+      default:
+        VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Instruction->Index2;
+        break;
+      }
+    } else {
+      VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = (VM_REGISTER) Instruction->Index2;
+    }
+  } else {
+    Op1 = (UINT64) VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + (INT16) Instruction->Index1;
+    if ((Instruction->Opcode & OPCODE_M_OPCODE) == OPCODE_MOVI) {
+      switch (Operands & MOVI_M_MOVEWIDTH) {
+      case MOVI_MOVEWIDTH8:
+        VmWriteMem8 (VmPtr, (UINTN) Op1, (UINT8) Instruction->Index2);
+        break;
+
+      case MOVI_MOVEWIDTH16:
+        VmWriteMem16 (VmPtr, (UINTN) Op1, (UINT16) Instruction->Index2);
+        break;
+
+      case MOVI_MOVEWIDTH32:
+        VmWriteMem32 (VmPtr, (UINTN) Op1, (UINT32) Instruction->Index2);
+        break;
+
+      default:
+        VmWriteMem64 (VmPtr, (UINTN) Op1, (UINT64) Instruction->Index2);
+        break;
+      }
+    } else {
+      //
+      // MOVIn and MOVREL always do a natural size write.
+      //
+      VmWriteMemN (VmPtr, (UINTN) Op1, (UINTN) Instruction->Index2);
+    }
+  }
+
+  VmPtr->Ip += Instruction->Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded PUSH or PUSHn instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedPUSH (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Operands;
+  INT16   Index16;
+  UINT32  Data32;
+  UINT64  Data64;
+  UINTN   DataN;
+
+  Operands = Instruction->Operands;
+  Index16  = (INT16) Instruction->Index1;
+  VmPtr->Ip += Instruction->Size;
+
+  if ((Instruction->Opcode & OPCODE_M_OPCODE) == OPCODE_PUSHN) {
+    if (OPERAND1_INDIRECT (Operands)) {
+      DataN = VmReadMemN (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16));
+    } else {
+      DataN = (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16);
+    }
+
+    VmPtr->Gpr[0] -= sizeof (UINTN);
+    VmWriteMemN (VmPtr, (UINTN) VmPtr->Gpr[0], DataN);
+  } else if ((Instruction->Opcode & PUSHPOP_M_64) != 0) {
+    if (OPERAND1_INDIRECT (Operands)) {
+      Data64 = VmReadMem64 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16));
+    } else {
+      Data64 = (UINT64) VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16;
+    }
+
+    VmPtr->Gpr[0] -= sizeof (UINT64);
+    VmWriteMem64 (VmPtr, (UINTN) VmPtr->Gpr[0], Data64);
+  } else {
+    if (OPERAND1_INDIRECT (Operands)) {
+      Data32 = VmReadMem32 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16));
+    } else {
+      Data32 = (UINT32) VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16;
+    }
+
+    VmPtr->Gpr[0] -= sizeof (UINT32);
+    VmWriteMem32 (VmPtr, (UINTN) VmPtr->Gpr[0], Data32);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Execute a pre-decoded POP or POPn instruction.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteDecodedPOP (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   Operands;
+  INT16   Index16;
+  INT32   Data32;
+  UINT64  Data64;
+  UINTN   DataN;
+
+  Operands = Instruction->Operands;
+  Index16  = (INT16) Instruction->Index1;
+  VmPtr->Ip += Instruction->Size;
+
+  if ((Instruction->Opcode & OPCODE_M_OPCODE) == OPCODE_POPN) {
+    DataN = VmReadMemN (VmPtr, (UINTN) VmPtr->Gpr[0]);
+    VmPtr->Gpr[0] += sizeof (UINTN);
+    if (OPERAND1_INDIRECT (Operands)) {
+      VmWriteMemN (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16), DataN);
+    } else {
+      VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = (INT64) (UINT64) (UINTN) (DataN + Index16);
+    }
+  } else if ((Instruction->Opcode & PUSHPOP_M_64) != 0) {
+    Data64 = VmReadMem64 (VmPtr, (UINTN) VmPtr->Gpr[0]);
+    VmPtr->Gpr[0] += sizeof (UINT64);
+    if (OPERAND1_INDIRECT (Operands)) {
+      VmWriteMem64 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16), Data64);
+    } else {
+      VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = Data64 + Index16;
+    }
+  } else {
+    Data32 = (INT32) VmReadMem32 (VmPtr, (UINTN) VmPtr->Gpr[0]);
+    VmPtr->Gpr[0] += sizeof (UINT32);
+    if (OPERAND1_INDIRECT (Operands)) {
+      VmWriteMem32 (VmPtr, (UINTN) (VmPtr->Gpr[OPERAND1_REGNUM (Operands)] + Index16), Data32);
+    } else {
+      VmPtr->Gpr[OPERAND1_REGNUM (Operands)] = (INT64) Data32 + Index16;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Decode one instruction into its pre-decoded form.
+
+  Instructions with an invalid encoding, and the instructions that may
+  re-enter the VM or change the IP in other ways than jumping, are left to
+  their regular handler by setting ExecuteFunction to NULL. Such an instruction
+  ends the block if its handler may not simply advance the IP.
+
+  @param  Ip                The address of the instruction to decode.
+  @param  Instruction       Returns the pre-decoded instruction.
+  @param  EndOfBlock        Returns TRUE if the instruction ends the block.
+
+  @retval TRUE              The instruction was decoded.
+  @retval FALSE             The instruction cannot be decoded, and must not be
+                            part of a block.
+
+**/
+BOOLEAN
+EbcDecodeInstruction (
+  IN  VMIP                      Ip,
+  OUT EBC_DECODED_INSTRUCTION   *Instruction,
+  OUT BOOLEAN                   *EndOfBlock
+  )
+{
+  VM_CONTEXT  Decoder;
+  UINT8       Opcode;
+  UINT8       OpcMasked;
+  UINT8       Operands;
+  UINT8       Size;
+  INT64       Data64;
+
+  //
+  // The code stream readers raise an alignment exception for immediate data
+  // that is not 16-bit aligned. Leave such code to the regular handlers, so
+  // that the exception is raised when the instruction is executed.
+  //
+  if (!IS_ALIGNED ((UINTN) Ip, sizeof (UINT16))) {
+    return FALSE;
+  }
+
+  Opcode    = *Ip;
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+  if (mVmOpcodeTable[OpcMasked].ExecuteFunction == NULL) {
+    return FALSE;
+  }
+
+  Operands   = *(Ip + 1);
+  Decoder.Ip = Ip;
+
+  Instruction->Ip              = Ip;
+  Instruction->ExecuteFunction = NULL;
+  Instruction->NativeCode      = NULL;
+  Instruction->Index1          = 0;
+  Instruction->Index2          = 0;
+  Instruction->Opcode          = Opcode;
+  Instruction->Operands        = Operands;
+  Instruction->Size            = 2;
+  Instruction->Param           = 0;
+  *EndOfBlock                  = FALSE;
+
+  switch (OpcMasked) {
+  case OPCODE_JMP8:
+    Instruction->Index2          = (INT64) VmReadImmed8 (&Decoder, 1) * 2 + 2;
+    Instruction->ExecuteFunction = ExecuteDecodedJMP8;
+    *EndOfBlock                  = TRUE;
+    break;
+
+  case OPCODE_JMP:
+    Instruction->Size = mJMPLen[(Opcode >> 6) & 0x03];
+    *EndOfBlock       = TRUE;
+    if ((Opcode & OPCODE_M_IMMDATA64) != 0) {
+      if ((Opcode & OPCODE_M_IMMDATA) == 0) {
+        break;
+      }
+
+      Data64 = VmReadImmed64 (&Decoder, 2);
+      if (!IS_ALIGNED ((UINTN) Data64, sizeof (UINT16))) {
+        break;
+      }
+
+      Instruction->Index2 = Data64;
+    } else if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+      if (OPERAND1_INDIRECT (Operands)) {
+        Instruction->Index2 = VmReadIndex32 (&Decoder, 2);
+      } else {
+        Instruction->Index2 = VmReadImmed32 (&Decoder, 2);
+      }
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedJMP;
+    break;
+
+  case OPCODE_CALL:
+    if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+      Instruction->Size = (UINT8) (((Opcode & OPCODE_M_IMMDATA64) != 0) ? 10 : 6);
+    }
+
+    *EndOfBlock = TRUE;
+    break;
+
+  case OPCODE_BREAK:
+  case OPCODE_RET:
+    *EndOfBlock = TRUE;
+    break;
+
+  case OPCODE_CMPEQ:
+  case OPCODE_CMPLTE:
+  case OPCODE_CMPGTE:
+  case OPCODE_CMPULTE:
+  case OPCODE_CMPUGTE:
+    if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+      if (OPERAND2_INDIRECT (Operands)) {
+        Instruction->Index2 = VmReadIndex16 (&Decoder, 2);
+      } else {
+        Instruction->Index2 = VmReadImmed16 (&Decoder, 2);
+      }
+
+      Instruction->Size = 4;
+    }
+
+    Instruction->Param           = OpcMasked;
+    Instruction->ExecuteFunction = ExecuteDecodedCMP;
+    break;
+
+  case OPCODE_CMPIEQ:
+  case OPCODE_CMPILTE:
+  case OPCODE_CMPIGTE:
+  case OPCODE_CMPIULTE:
+  case OPCODE_CMPIUGTE:
+    Size = 2;
+    if ((Operands & OPERAND_M_CMPI_INDEX) != 0) {
+      Instruction->Index1 = VmReadIndex16 (&Decoder, 2);
+      Size += 2;
+    }
+
+    if ((Opcode & OPCODE_M_CMPI32_DATA) != 0) {
+      Instruction->Index2 = VmReadImmed32 (&Decoder, Size);
+      Size += 4;
+    } else {
+      Instruction->Index2 = VmReadImmed16 (&Decoder, Size);
+      Size += 2;
+    }
+
+    Instruction->Size = Size;
+    if (!OPERAND1_INDIRECT (Operands) && ((Operands & OPERAND_M_CMPI_INDEX) != 0)) {
+      //
+      // CMPI R1 Index16, ... is illegal.
+      //
+      *EndOfBlock = TRUE;
+      break;
+    }
+
+    Instruction->Param = (UINT8) (OpcMasked - OPCODE_CMPIEQ + OPCODE_CMPEQ);
+    if (((Opcode & OPCODE_M_CMPI64) != 0) &&
+        ((Instruction->Param == OPCODE_CMPULTE) || (Instruction->Param == OPCODE_CMPUGTE))) {
+      Instruction->Index2 = (INT64) (UINT64) (UINT32) Instruction->Index2;
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedCMPI;
+    break;
+
+  case OPCODE_MOVBW:
+  case OPCODE_MOVWW:
+  case OPCODE_MOVDW:
+  case OPCODE_MOVQW:
+  case OPCODE_MOVNW:
+    Size = 2;
+    if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+      Instruction->Index1 = VmReadIndex16 (&Decoder, Size);
+      Size += sizeof (UINT16);
+    }
+
+    if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+      Instruction->Index2 = VmReadIndex16 (&Decoder, Size);
+      Size += sizeof (UINT16);
+    }
+
+    Instruction->Size = Size;
+    goto DecodeMove;
+
+  case OPCODE_MOVBD:
+  case OPCODE_MOVWD:
+  case OPCODE_MOVDD:
+  case OPCODE_MOVQD:
+  case OPCODE_MOVND:
+    Size = 2;
+    if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+      Instruction->Index1 = VmReadIndex32 (&Decoder, Size);
+      Size += sizeof (UINT32);
+    }
+
+    if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+      Instruction->Index2 = VmReadIndex32 (&Decoder, Size);
+      Size += sizeof (UINT32);
+    }
+
+    Instruction->Size = Size;
+    goto DecodeMove;
+
+  case OPCODE_MOVQQ:
+    Size = 2;
+    if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+      Instruction->Index1 = VmReadIndex64 (&Decoder, Size);
+      Size += sizeof (UINT64);
+    }
+
+    if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+      Instruction->Index2 = VmReadIndex64 (&Decoder, Size);
+      Size += sizeof (UINT64);
+    }
+
+    Instruction->Size = Size;
+
+DecodeMove:
+    //
+    // Operand1 direct with index is invalid.
+    //
+    if (!OPERAND1_INDIRECT (Operands) && ((Opcode & OPCODE_M_IMMED_OP1) != 0)) {
+      *EndOfBlock = TRUE;
+      break;
+    }
+
+    if ((OpcMasked == OPCODE_MOVBW) || (OpcMasked == OPCODE_MOVBD)) {
+      Instruction->Param = DATA_SIZE_8;
+    } else if ((OpcMasked == OPCODE_MOVWW) || (OpcMasked == OPCODE_MOVWD)) {
+      Instruction->Param = DATA_SIZE_16;
+    } else if ((OpcMasked == OPCODE_MOVDW) || (OpcMasked == OPCODE_MOVDD)) {
+      Instruction->Param = DATA_SIZE_32;
+    } else if ((OpcMasked == OPCODE_MOVNW) || (OpcMasked == OPCODE_MOVND)) {
+      Instruction->Param = DATA_SIZE_N;
+    } else {
+      Instruction->Param = DATA_SIZE_64;
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedMOVxx;
+    break;
+
+  case OPCODE_MOVSNW:
+  case OPCODE_MOVSND:
+    Size = (UINT8) ((OpcMasked == OPCODE_MOVSNW) ? sizeof (UINT16) : sizeof (UINT32));
+    Instruction->Size = (UINT8) (2 +
+                          (((Opcode & OPCODE_M_IMMED_OP1) != 0) ? Size : 0) +
+                          (((Opcode & OPCODE_M_IMMED_OP2) != 0) ? Size : 0));
+    break;
+
+  case OPCODE_LOADSP:
+  case OPCODE_STORESP:
+    break;
+
+  case OPCODE_PUSH:
+  case OPCODE_POP:
+  case OPCODE_PUSHN:
+  case OPCODE_POPN:
+    if ((Opcode & PUSHPOP_M_IMMDATA) != 0) {
+      if (OPERAND1_INDIRECT (Operands)) {
+        Instruction->Index1 = VmReadIndex16 (&Decoder, 2);
+      } else {
+        Instruction->Index1 = VmReadImmed16 (&Decoder, 2);
+      }
+
+      Instruction->Size = 4;
+    }
+
+    if ((OpcMasked == OPCODE_PUSH) || (OpcMasked == OPCODE_PUSHN)) {
+      Instruction->ExecuteFunction = ExecuteDecodedPUSH;
+    } else {
+      Instruction->ExecuteFunction = ExecuteDecodedPOP;
+    }
+    break;
+
+  case OPCODE_MOVI:
+  case OPCODE_MOVIN:
+  case OPCODE_MOVREL:
+    Size = 2;
+    if ((Operands & MOVI_M_IMMDATA) != 0) {
+      Instruction->Index1 = VmReadIndex16 (&Decoder, 2);
+      Size = 4;
+    }
+
+    if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH16) {
+      if (OpcMasked == OPCODE_MOVIN) {
+        Instruction->Index2 = VmReadIndex16 (&Decoder, Size);
+      } else {
+        Instruction->Index2 = VmReadImmed16 (&Decoder, Size);
+      }
+      Size += 2;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH32) {
+      if (OpcMasked == OPCODE_MOVIN) {
+        Instruction->Index2 = VmReadIndex32 (&Decoder, Size);
+      } else {
+        Instruction->Index2 = VmReadImmed32 (&Decoder, Size);
+      }
+      Size += 4;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH64) {
+      if (OpcMasked == OPCODE_MOVIN) {
+        Instruction->Index2 = VmReadIndex64 (&Decoder, Size);
+      } else {
+        Instruction->Index2 = VmReadImmed64 (&Decoder, Size);
+      }
+      Size += 8;
+    } else {
+      *EndOfBlock = TRUE;
+      break;
+    }
+
+    Instruction->Size = Size;
+    if (!OPERAND1_INDIRECT (Operands) && ((Operands & MOVI_M_IMMDATA) != 0)) {
+      //
+      // Operand1 direct with index is invalid.
+      //
+      *EndOfBlock = TRUE;
+      break;
+    }
+
+    if (OpcMasked == OPCODE_MOVREL) {
+      Instruction->Index2 = (INT64) ((INT64) ((UINT64) (UINTN) Ip) + Instruction->Index2 + Size);
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedMOVI;
+    break;
+
+  default:
+    //
+    // Data manipulation instructions, OPCODE_NOT to OPCODE_EXTNDD.
+    //
+    ASSERT ((OpcMasked >= OPCODE_NOT) && (OpcMasked <= OPCODE_EXTNDD));
+    if ((Opcode & DATAMANIP_M_IMMDATA) != 0) {
+      if (OPERAND2_INDIRECT (Operands)) {
+        Instruction->Index2 = VmReadIndex16 (&Decoder, 2);
+      } else {
+        Instruction->Index2 = VmReadImmed16 (&Decoder, 2);
+      }
+
+      Instruction->Size = 4;
+    }
+
+    Instruction->Param = (UINT8) (OpcMasked - OPCODE_NOT);
+    if (mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteSignedDataManip) {
+      Instruction->Param |= EBC_DECODED_DATAMANIP_SIGNED;
+    }
+
+    Instruction->ExecuteFunction = ExecuteDecodedDataManip;
+    break;
+  }
+
+  return TRUE;
+}
+
+
+/**
+  Check whether instructions have been decoded from a page since the last
+  reset of the translation cache.
+
+  @param  Page              The page number.
+
+  @retval TRUE              Instructions have been decoded from the page.
+  @retval FALSE             No instruction has been decoded from the page.
+
+**/
+BOOLEAN
+EbcIsCodePage (
+  IN UINTN  Page
+  )
+{
+  UINTN  Index;
+
+  if ((mEbcCodePageFilter[(Page % EBC_CODE_PAGE_FILTER_BITS) / 32] & (1u << (Page % 32))) == 0) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < mEbcCodePageCount; Index++) {
+    if (mEbcCodePages[Index] == Page) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+/**
+  Flush the translation cache if a write by the VM hits a code page that
+  instructions were decoded from.
+
+  @param  Addr              Address the VM writes to.
+  @param  Size              Size of the write in bytes.
+
+**/
+VOID
+EbcCheckCodeWrite (
+  IN UINTN  Addr,
+  IN UINTN  Size
+  )
+{
+  UINTN  Page;
+
+  for (Page = Addr >> EFI_PAGE_SHIFT; Page <= (Addr + Size - 1) >> EFI_PAGE_SHIFT; Page++) {
+    if (EbcIsCodePage (Page)) {
+      EbcFlushTranslationCache ();
+      return;
+    }
+  }
+}
+
+
+/**
+  Reset the translation cache after it has been flushed, so that the pool and
+  the code pages can be used again.
+
+**/
+VOID
+EbcResetTranslationCache (
+  VOID
+  )
+{
+  mEbcDecodedPoolUsed = 0;
+  mEbcCodePageCount   = 0;
+  ZeroMem (mEbcCodePageFilter, sizeof (mEbcCodePageFilter));
+  EbcJitReset ();
+  mEbcTranslationCacheResetGeneration = mEbcTranslationCacheGeneration;
+}
+
+
+/**
+  Look up the pre-decoded basic block starting at an instruction pointer in
+  the translation cache, and decode the block if it is not cached yet.
+
+  @param  Ip                The address of the first instruction of the block.
+  @param  BlockEnd          Returns the end of the pre-decoded instructions of
+                            the block.
+  @param  Generation        Returns the translation cache generation the block
+                            belongs to.
+
+  @return The first pre-decoded instruction of the block, or NULL if the
+          instruction at Ip has to be executed without the translation cache.
+
+**/
+EBC_DECODED_INSTRUCTION *
+EbcLookupDecodedBlock (
+  IN  VMIP                      Ip,
+  OUT EBC_DECODED_INSTRUCTION   **BlockEnd,
+  OUT UINTN                     *Generation
+  )
+{
+  EBC_DECODED_BLOCK        *Block;
+  EBC_DECODED_INSTRUCTION  *Instructions;
+  UINTN                    Count;
+  UINTN                    Page;
+  VMIP                     NextIp;
+  BOOLEAN                  EndOfBlock;
+
+  //
+  // The cache is disabled, or the VM has been re-entered while the cache is
+  // being updated, for example from a timer event.
+  //
+  if ((mEbcDecodedPool == NULL) || (mEbcTranslationCacheLock != 0)) {
+    return NULL;
+  }
+
+  Block = &mEbcDecodedBlocks[((UINTN) Ip >> 1) & mEbcDecodedBlockMask];
+  if ((Block->Ip == Ip) && (Block->Generation == mEbcTranslationCacheGeneration)) {
+    *BlockEnd   = Block->Instructions + Block->Count;
+    *Generation = Block->Generation;
+    return Block->Instructions;
+  }
+
+  mEbcTranslationCacheLock++;
+
+  if (mEbcTranslationCacheResetGeneration != mEbcTranslationCacheGeneration) {
+    EbcResetTranslationCache ();
+  }
+  //
+  // Start over with an empty cache if the pool or the code page list may not
+  // hold another block.
+  //
+  if ((mEbcDecodedPoolUsed + EBC_DECODED_BLOCK_MAX_INSTRUCTIONS > mEbcDecodedPoolSize) ||
+      (mEbcCodePageCount + 2 > EBC_CODE_PAGE_MAX)) {
+    EbcFlushTranslationCache ();
+    EbcResetTranslationCache ();
+  }
+
+  *Generation  = mEbcTranslationCacheGeneration;
+  Instructions = &mEbcDecodedPool[mEbcDecodedPoolUsed];
+  NextIp       = Ip;
+  EndOfBlock   = FALSE;
+  for (Count = 0; (Count < EBC_DECODED_BLOCK_MAX_INSTRUCTIONS) && !EndOfBlock; Count++) {
+    if (!EbcDecodeInstruction (NextIp, &Instructions[Count], &EndOfBlock)) {
+      break;
+    }
+
+    NextIp += Instructions[Count].Size;
+  }
+
+  if (Count == 0) {
+    mEbcTranslationCacheLock--;
+    return NULL;
+  }
+  //
+  // Track the pages the block was decoded from, so that writes to them
+  // flush the cache.
+  //
+  for (Page = (UINTN) Ip >> EFI_PAGE_SHIFT; Page <= ((UINTN) NextIp - 1) >> EFI_PAGE_SHIFT; Page++) {
+    if (!EbcIsCodePage (Page)) {
+      mEbcCodePages[mEbcCodePageCount++] = Page;
+      mEbcCodePageFilter[(Page % EBC_CODE_PAGE_FILTER_BITS) / 32] |= 1u << (Page % 32);
+    }
+  }
+  //
+  // Don't publish the block if the cache has been flushed meanwhile.
+  //
+  if (*Generation != mEbcTranslationCacheGeneration) {
+    mEbcTranslationCacheLock--;
+    return NULL;
+  }
+
+  EbcJitTranslateBlock (Instructions, Count);
+
+  mEbcDecodedPoolUsed += Count;
+  Block->Ip            = Ip;
+  Block->Generation    = *Generation;
+  Block->Instructions  = Instructions;
+  Block->Count         = Count;
+
+  mEbcTranslationCacheLock--;
+
+  *BlockEnd = Instructions + Count;
+  return Instructions;
+}
+
+
+/**
+  Flush the translation cache of pre-decoded instructions. This must be called
+  when EBC code is modified other than by the VM itself, for example when an
+  image is unloaded or a debugger patches code.
+
+**/
+VOID
+EbcFlushTranslationCache (
+  VOID
+  )
+{
+  mEbcTranslationCacheGeneration++;
+}
+
+
+/**
+  Allocate the translation cache of pre-decoded instructions. The size of the
+  cache is set by PcdEbcTranslationCacheSize, and the cache is disabled when
+  the PCD is 0 or the memory cannot be allocated.
+
+**/
+VOID
+EbcInitTranslationCache (
+  VOID
+  )
+{
+  UINTN  PoolSize;
+  UINTN  BlockCount;
+
+  PoolSize = PcdGet32 (PcdEbcTranslationCacheSize);
+  if (PoolSize < EBC_DECODED_BLOCK_MAX_INSTRUCTIONS) {
+    return;
+  }
+
+  BlockCount        = GetPowerOfTwo32 ((UINT32) (PoolSize / 4));
+  mEbcDecodedBlocks = AllocateZeroPool (BlockCount * sizeof (EBC_DECODED_BLOCK));
+  mEbcDecodedPool   = AllocatePool (PoolSize * sizeof (EBC_DECODED_INSTRUCTION));
+  if ((mEbcDecodedBlocks == NULL) || (mEbcDecodedPool == NULL)) {
+    if (mEbcDecodedBlocks != NULL) {
+      FreePool (mEbcDecodedBlocks);
+      mEbcDecodedBlocks = NULL;
+    }
+
+    if (mEbcDecodedPool != NULL) {
+      FreePool (mEbcDecodedPool);
+      mEbcDecodedPool = NULL;
+    }
+
+    return;
+  }
+
+  mEbcDecodedPoolSize  = PoolSize;
+  mEbcDecodedBlockMask = BlockCount - 1;
+
+  EbcJitInitialize (PoolSize);
+}
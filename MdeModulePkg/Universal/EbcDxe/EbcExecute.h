@@ -22,6 +22,62 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #define EBCMSG(s) gST->ConOut->OutputString (gST->ConOut, s)
 
+//
+// Define some useful data size constants to allow switch statements based on
+// size of operands or data.
+//
+#define DATA_SIZE_INVALID 0
+#define DATA_SIZE_8       1
+#define DATA_SIZE_16      2
+#define DATA_SIZE_32      4
+#define DATA_SIZE_64      8
+#define DATA_SIZE_N       48  // 4 or 8
+
+//
+// Param of the pre-decoded data manipulation instructions: index into
+// mDataManipDispatchTable, and whether the operation is signed.
+//
+#define EBC_DECODED_DATAMANIP_SIGNED        0x80
+#define EBC_DECODED_DATAMANIP_M_INDEX       0x1F
+
+//
+// Pre-decoded form of an instruction, kept in the translation cache. The
+// opcode, operands and index/immediate fields are decoded once, when the basic
+// block holding the instruction is first executed. ExecuteFunction is NULL for
+// the instructions that are left to their regular handler in mVmOpcodeTable.
+//
+typedef struct _EBC_DECODED_INSTRUCTION EBC_DECODED_INSTRUCTION;
+
+typedef
+EFI_STATUS
+(*EBC_DECODED_EXECUTE_FUNCTION) (
+  IN VM_CONTEXT                     *VmPtr,
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  );
+
+//
+// Native code a run of pre-decoded instructions has been translated to. It
+// executes the instructions, sets the IP, and returns the number of
+// pre-decoded instructions it has executed.
+//
+typedef
+UINTN
+(EFIAPI *EBC_NATIVE_CODE) (
+  IN VM_CONTEXT                     *VmPtr
+  );
+
+struct _EBC_DECODED_INSTRUCTION {
+  VMIP                          Ip;
+  EBC_DECODED_EXECUTE_FUNCTION  ExecuteFunction;
+  EBC_NATIVE_CODE               NativeCode;   // run of instructions starting here, or NULL
+  INT64                         Index1;   // operand 1 index
+  INT64                         Index2;   // operand 2 index, immediate data or target
+  UINT8                         Opcode;
+  UINT8                         Operands;
+  UINT8                         Size;
+  UINT8                         Param;    // instruction specific, see EbcDecodeInstruction()
+};
+
 
 /**
   Execute an EBC image from an entry point or from a published protocol.
@@ -110,6 +166,55 @@ VmWriteMem64 (
   IN UINT64       Data
   );
 
+/**
+  Allocate the translation cache of pre-decoded instructions. The size of the
+  cache is set by PcdEbcTranslationCacheSize, and the cache is disabled when
+  the PCD is 0 or the memory cannot be allocated.
+
+**/
+VOID
+EbcInitTranslationCache (
+  VOID
+  );
+
+/**
+  Set up the translation of pre-decoded instructions to native code. The JIT
+  is enabled by PcdEbcJitEnable, and is only available on X64.
+
+  @param  InstructionCount  The number of instructions the translation cache
+                            holds.
+
+**/
+VOID
+EbcJitInitialize (
+  IN UINTN  InstructionCount
+  );
+
+/**
+  Release the native code of all blocks. Called when the translation cache is
+  reset, while no native code is being executed.
+
+**/
+VOID
+EbcJitReset (
+  VOID
+  );
+
+/**
+  Translate the runs of instructions of a pre-decoded block that only operate
+  on VM registers to native code, and set the NativeCode of the first
+  instruction of each run.
+
+  @param  Instructions      The pre-decoded instructions of the block.
+  @param  Count             The number of instructions in the block.
+
+**/
+VOID
+EbcJitTranslateBlock (
+  IN OUT EBC_DECODED_INSTRUCTION  *Instructions,
+  IN     UINTN                    Count
+  );
+
 /**
   Given a pointer to a new VM context, execute one or more instructions. This
   function is only used for test purposes via the EBC VM test protocol.
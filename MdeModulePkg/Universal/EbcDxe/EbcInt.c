@@ -290,8 +290,8 @@ EbcDebugRegisterExceptionCallback (
   );
 
 /**
-  This EBC debugger protocol service is called by the debug agent.  Required
-  for DebugSupport compliance but is only stubbed out for EBC.
+  This EBC debugger protocol service is called by the debug agent after it has
+  modified code. The translation cache of pre-decoded instructions is flushed.
 
   @param  This                  A pointer to the EFI_DEBUG_SUPPORT_PROTOCOL
                                 instance.
@@ -424,6 +424,12 @@ EbcRegisterImage (
   EbcRegisterICacheFlush (NULL,
     (EBC_ICACHE_FLUSH)InvalidateInstructionCacheRange);
 
+  //
+  // The image may have been loaded over code that instructions were decoded
+  // from.
+  //
+  EbcFlushTranslationCache ();
+
   return EbcCreateThunk (NULL, (VOID *)(UINTN)ImageBase,
            (VOID *)(UINTN)*EntryPoint, (VOID **)EntryPoint);
 }
@@ -561,6 +567,8 @@ InitializeEbcDriver (
     goto ErrorExit;
   }
 
+  EbcInitTranslationCache ();
+
   //
   // Allocate memory for our debug protocol. Then fill in the blanks.
   //
@@ -803,8 +811,8 @@ EbcDebugRegisterExceptionCallback (
 
 
 /**
-  This EBC debugger protocol service is called by the debug agent.  Required
-  for DebugSupport compliance but is only stubbed out for EBC.
+  This EBC debugger protocol service is called by the debug agent after it has
+  modified code. The translation cache of pre-decoded instructions is flushed.
 
   @param  This                  A pointer to the EFI_DEBUG_SUPPORT_PROTOCOL
                                 instance.
@@ -827,6 +835,7 @@ EbcDebugInvalidateInstructionCache (
   IN UINT64                              Length
   )
 {
+  EbcFlushTranslationCache ();
   return EFI_SUCCESS;
 }
 
@@ -1205,6 +1214,11 @@ EbcUnloadImage (
   //
   FreePool (ImageList);
 
+  //
+  // The memory of the image may be reused for other code.
+  //
+  EbcFlushTranslationCache ();
+
   EbcDebuggerHookEbcUnloadImage (ImageHandle);
 
   return EFI_SUCCESS;
@@ -0,0 +1,59 @@
+/** @file
+  Contains the empty version of the EBC JIT, to be used on the architectures
+  the JIT does not support and when compiling the EBC Debugger.
+  The EBC Debugger hooks must see every instruction, so all EBC code is
+  interpreted.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+#include "EbcExecute.h"
+
+/**
+  Set up the translation of pre-decoded instructions to native code. The JIT
+  is enabled by PcdEbcJitEnable, and is only available on X64.
+
+  @param  InstructionCount  The number of instructions the translation cache
+                            holds.
+
+**/
+VOID
+EbcJitInitialize (
+  IN UINTN  InstructionCount
+  )
+{
+  return;
+}
+
+/**
+  Release the native code of all blocks. Called when the translation cache is
+  reset, while no native code is being executed.
+
+**/
+VOID
+EbcJitReset (
+  VOID
+  )
+{
+  return;
+}
+
+/**
+  Translate the runs of instructions of a pre-decoded block that only operate
+  on VM registers to native code, and set the NativeCode of the first
+  instruction of each run.
+
+  @param  Instructions      The pre-decoded instructions of the block.
+  @param  Count             The number of instructions in the block.
+
+**/
+VOID
+EbcJitTranslateBlock (
+  IN OUT EBC_DECODED_INSTRUCTION  *Instructions,
+  IN     UINTN                    Count
+  )
+{
+  return;
+}
@@ -0,0 +1,961 @@
+/** @file
+  Translation of pre-decoded EBC instructions to native X64 code.
+
+  Runs of instructions that only operate on VM registers are translated when
+  the basic block holding them is added to the translation cache: the data
+  manipulation and move instructions with a register destination, the compare
+  instructions, and the jumps to a fixed target. None of them writes memory or
+  raises an exception. The VM registers stay in the VM context, so the
+  interpreter can take over after any run.
+
+  The native code of a run is called as an EFIAPI function taking the VM
+  context, which it keeps in RBX. RAX, RCX and RDX are used as scratch
+  registers.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+#include "EbcExecute.h"
+
+//
+// Most bytes of native code one instruction is translated to, and most bytes
+// of native code a run adds to the code of its instructions.
+//
+#define EBC_JIT_MAX_INSTRUCTION_SIZE  64
+#define EBC_JIT_MAX_RUN_OVERHEAD      64
+
+//
+// Bytes of native code reserved per instruction of the translation cache.
+// Runs that don't fit are left to the interpreter until the cache is reset.
+//
+#define EBC_JIT_CODE_PER_INSTRUCTION  32
+
+//
+// Shortest run worth translating. The call of the native code costs about as
+// much as interpreting one instruction.
+//
+#define EBC_JIT_MIN_RUN_LENGTH        2
+
+//
+// Native registers, as encoded in the ModR/M byte.
+//
+#define JIT_RAX  0
+#define JIT_RCX  1
+#define JIT_RDX  2
+#define JIT_RBX  3
+
+#define JIT_GPR_OFFSET(Index)  (OFFSET_OF (VM_CONTEXT, Gpr) + (Index) * sizeof (VM_REGISTER))
+
+//
+// Buffer of native code. It is only reused when the translation cache is
+// reset, while no native code is being executed.
+//
+UINT8  *mEbcJitCode     = NULL;
+UINTN  mEbcJitCodeSize  = 0;
+UINTN  mEbcJitCodeUsed  = 0;
+
+/**
+  Append bytes to native code.
+
+  @param  Code              The native code pointer, advanced past the bytes.
+  @param  Bytes             The bytes to append.
+  @param  Length            The number of bytes.
+
+**/
+VOID
+JitEmit (
+  IN OUT UINT8        **Code,
+  IN     CONST UINT8  *Bytes,
+  IN     UINTN        Length
+  )
+{
+  CopyMem (*Code, Bytes, Length);
+  *Code += Length;
+}
+
+/**
+  Append a 32-bit value to native code.
+
+  @param  Code              The native code pointer, advanced past the value.
+  @param  Value             The value to append.
+
+**/
+VOID
+JitEmit32 (
+  IN OUT UINT8   **Code,
+  IN     UINT32  Value
+  )
+{
+  WriteUnaligned32 ((UINT32 *) *Code, Value);
+  *Code += sizeof (UINT32);
+}
+
+/**
+  Append a 64-bit value to native code.
+
+  @param  Code              The native code pointer, advanced past the value.
+  @param  Value             The value to append.
+
+**/
+VOID
+JitEmit64 (
+  IN OUT UINT8   **Code,
+  IN     UINT64  Value
+  )
+{
+  WriteUnaligned64 ((UINT64 *) *Code, Value);
+  *Code += sizeof (UINT64);
+}
+
+/**
+  Append an instruction accessing a field of the VM context, of the form
+  [REX] Opcode ModR/M disp32 with RBX as the base register.
+
+  @param  Code              The native code pointer.
+  @param  Rex               The REX prefix, or 0 for none.
+  @param  Opcode            The opcode.
+  @param  Reg               The register or opcode extension of the ModR/M byte.
+  @param  Offset            The offset of the field in VM_CONTEXT.
+
+**/
+VOID
+JitEmitContextAccess (
+  IN OUT UINT8  **Code,
+  IN     UINT8  Rex,
+  IN     UINT8  Opcode,
+  IN     UINT8  Reg,
+  IN     UINTN  Offset
+  )
+{
+  if (Rex != 0) {
+    *(*Code)++ = Rex;
+  }
+
+  *(*Code)++ = Opcode;
+  *(*Code)++ = (UINT8) (0x80 | (Reg << 3) | JIT_RBX);
+  JitEmit32 (Code, (UINT32) Offset);
+}
+
+/**
+  Append "mov Reg, [rbx + Offset]".
+
+  @param  Code              The native code pointer.
+  @param  Reg               The native register.
+  @param  Offset            The offset of the field in VM_CONTEXT.
+
+**/
+VOID
+JitEmitLoadContext (
+  IN OUT UINT8  **Code,
+  IN     UINT8  Reg,
+  IN     UINTN  Offset
+  )
+{
+  JitEmitContextAccess (Code, 0x48, 0x8B, Reg, Offset);
+}
+
+/**
+  Append "mov [rbx + Offset], Reg".
+
+  @param  Code              The native code pointer.
+  @param  Reg               The native register.
+  @param  Offset            The offset of the field in VM_CONTEXT.
+
+**/
+VOID
+JitEmitStoreContext (
+  IN OUT UINT8  **Code,
+  IN     UINT8  Reg,
+  IN     UINTN  Offset
+  )
+{
+  JitEmitContextAccess (Code, 0x48, 0x89, Reg, Offset);
+}
+
+/**
+  Append the shortest move of a 64-bit immediate value to a register.
+
+  @param  Code              The native code pointer.
+  @param  Reg               The native register.
+  @param  Value             The value.
+
+**/
+VOID
+JitEmitLoadImmediate (
+  IN OUT UINT8   **Code,
+  IN     UINT8   Reg,
+  IN     UINT64  Value
+  )
+{
+  if (Value <= MAX_UINT32) {
+    //
+    // mov r32, imm32 clears the upper half of the register.
+    //
+    *(*Code)++ = (UINT8) (0xB8 + Reg);
+    JitEmit32 (Code, (UINT32) Value);
+  } else if (((INT64) Value >= MIN_INT32) && ((INT64) Value <= MAX_INT32)) {
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0xC7;
+    *(*Code)++ = (UINT8) (0xC0 + Reg);
+    JitEmit32 (Code, (UINT32) Value);
+  } else {
+    *(*Code)++ = 0x48;
+    *(*Code)++ = (UINT8) (0xB8 + Reg);
+    JitEmit64 (Code, Value);
+  }
+}
+
+/**
+  Append the addition of a 64-bit immediate value to RAX or RDX. RCX is used
+  for values that don't fit in 32 bits.
+
+  @param  Code              The native code pointer.
+  @param  Reg               The native register, RAX or RDX.
+  @param  Value             The value to add.
+
+**/
+VOID
+JitEmitAddImmediate (
+  IN OUT UINT8  **Code,
+  IN     UINT8  Reg,
+  IN     INT64  Value
+  )
+{
+  if (Value == 0) {
+    return;
+  }
+
+  if ((Value >= MIN_INT32) && (Value <= MAX_INT32)) {
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0x81;
+    *(*Code)++ = (UINT8) (0xC0 + Reg);
+    JitEmit32 (Code, (UINT32) Value);
+  } else {
+    JitEmitLoadImmediate (Code, JIT_RCX, (UINT64) Value);
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0x01;
+    *(*Code)++ = (UINT8) (0xC0 | (JIT_RCX << 3) | Reg);
+  }
+}
+
+/**
+  Append the load of a value from the address in a register to the same
+  register, zero-extending values of less than 64 bits.
+
+  @param  Code              The native code pointer.
+  @param  Reg               The native register, RAX or RDX.
+  @param  DataSize          The size of the value, DATA_SIZE_8 to DATA_SIZE_N.
+
+**/
+VOID
+JitEmitLoadIndirect (
+  IN OUT UINT8  **Code,
+  IN     UINT8  Reg,
+  IN     UINT8  DataSize
+  )
+{
+  switch (DataSize) {
+  case DATA_SIZE_8:
+    *(*Code)++ = 0x0F;
+    *(*Code)++ = 0xB6;
+    break;
+
+  case DATA_SIZE_16:
+    *(*Code)++ = 0x0F;
+    *(*Code)++ = 0xB7;
+    break;
+
+  case DATA_SIZE_32:
+    *(*Code)++ = 0x8B;
+    break;
+
+  default:
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0x8B;
+    break;
+  }
+
+  *(*Code)++ = (UINT8) ((Reg << 3) | Reg);
+}
+
+/**
+  Append the computation of operand 2 of an instruction to RDX: the VM
+  register R2 plus the index, and the value at that address if operand 2 is
+  indirect.
+
+  @param  Code              The native code pointer.
+  @param  Instruction       The pre-decoded instruction.
+  @param  DataSize          The size of an indirect operand 2.
+
+**/
+VOID
+JitEmitOperand2 (
+  IN OUT UINT8                          **Code,
+  IN     CONST EBC_DECODED_INSTRUCTION  *Instruction,
+  IN     UINT8                          DataSize
+  )
+{
+  JitEmitLoadContext (Code, JIT_RDX, JIT_GPR_OFFSET (OPERAND2_REGNUM (Instruction->Operands)));
+  JitEmitAddImmediate (Code, JIT_RDX, Instruction->Index2);
+  if (OPERAND2_INDIRECT (Instruction->Operands)) {
+    JitEmitLoadIndirect (Code, JIT_RDX, DataSize);
+  }
+}
+
+/**
+  Append the comparison of RAX with RDX, and the update of the condition code
+  flag of the VM from its result.
+
+  @param  Code              The native code pointer.
+  @param  Condition         The comparison, OPCODE_CMPEQ to OPCODE_CMPUGTE.
+  @param  Is64Bit           TRUE for a 64-bit comparison, FALSE for a 32-bit
+                            comparison.
+
+**/
+VOID
+JitEmitCompare (
+  IN OUT UINT8    **Code,
+  IN     UINT8    Condition,
+  IN     BOOLEAN  Is64Bit
+  )
+{
+  STATIC CONST UINT8  SetCcAlMovzxEax[] = { 0x0F, 0x00, 0xC0, 0x0F, 0xB6, 0xC0 };
+  STATIC CONST UINT8  AndRdxNotCcOrRdxRax[] = { 0x48, 0x83, 0xE2, 0xFE, 0x48, 0x09, 0xC2 };
+  UINT8               *SetCc;
+
+  //
+  // cmp rax, rdx or cmp eax, edx
+  //
+  if (Is64Bit) {
+    *(*Code)++ = 0x48;
+  }
+
+  *(*Code)++ = 0x39;
+  *(*Code)++ = 0xD0;
+
+  //
+  // setcc al; movzx eax, al
+  //
+  SetCc = *Code + 1;
+  JitEmit (Code, SetCcAlMovzxEax, sizeof (SetCcAlMovzxEax));
+  switch (Condition) {
+  case OPCODE_CMPEQ:
+    *SetCc = 0x94;
+    break;
+  case OPCODE_CMPLTE:
+    *SetCc = 0x9E;
+    break;
+  case OPCODE_CMPGTE:
+    *SetCc = 0x9D;
+    break;
+  case OPCODE_CMPULTE:
+    *SetCc = 0x96;
+    break;
+  default:
+    ASSERT (Condition == OPCODE_CMPUGTE);
+    *SetCc = 0x93;
+    break;
+  }
+
+  //
+  // Flags = (Flags & ~VMFLAGS_CC) | Result
+  //
+  JitEmitLoadContext (Code, JIT_RDX, OFFSET_OF (VM_CONTEXT, Flags));
+  JitEmit (Code, AndRdxNotCcOrRdxRax, sizeof (AndRdxNotCcOrRdxRax));
+  JitEmitStoreContext (Code, JIT_RDX, OFFSET_OF (VM_CONTEXT, Flags));
+}
+
+/**
+  Append the update of the IP by a jump: the IP is set to Target, or to
+  NotTaken if the jump is conditional and the condition is not met. The new
+  IP is left in RAX.
+
+  @param  Code              The native code pointer.
+  @param  Condition         The condition bits of the jump, CONDITION_M_CONDITIONAL
+                            and JMP_M_CS.
+  @param  Target            The jump target.
+  @param  NotTaken          The address of the next instruction.
+
+**/
+VOID
+JitEmitJump (
+  IN OUT UINT8   **Code,
+  IN     UINT8   Condition,
+  IN     UINT64  Target,
+  IN     UINT64  NotTaken
+  )
+{
+  JitEmitLoadImmediate (Code, JIT_RAX, Target);
+  if ((Condition & CONDITION_M_CONDITIONAL) != 0) {
+    JitEmitLoadImmediate (Code, JIT_RDX, NotTaken);
+    //
+    // test byte [rbx + Flags], VMFLAGS_CC
+    //
+    JitEmitContextAccess (Code, 0, 0xF6, 0, OFFSET_OF (VM_CONTEXT, Flags));
+    *(*Code)++ = VMFLAGS_CC;
+    //
+    // cmovz rax, rdx if the jump is taken on a set condition code, else
+    // cmovnz rax, rdx.
+    //
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0x0F;
+    *(*Code)++ = (UINT8) (((Condition & JMP_M_CS) != 0) ? 0x44 : 0x45);
+    *(*Code)++ = 0xC2;
+  }
+
+  JitEmitStoreContext (Code, JIT_RAX, OFFSET_OF (VM_CONTEXT, Ip));
+}
+
+/**
+  Get the target of a jump instruction that can be translated.
+
+  @param  Instruction       The pre-decoded JMP or JMP8 instruction.
+  @param  Target            Returns the jump target.
+
+  @retval TRUE              The jump has a fixed, aligned target.
+  @retval FALSE             The jump must be interpreted.
+
+**/
+BOOLEAN
+JitGetJumpTarget (
+  IN  CONST EBC_DECODED_INSTRUCTION  *Instruction,
+  OUT UINT64                         *Target
+  )
+{
+  UINT64  Addr;
+
+  if ((Instruction->Opcode & OPCODE_M_OPCODE) == OPCODE_JMP8) {
+    *Target = (UINT64) (UINTN) Instruction->Ip + Instruction->Index2;
+    return TRUE;
+  }
+
+  if ((Instruction->Opcode & OPCODE_M_IMMDATA64) != 0) {
+    //
+    // The decoder has checked the alignment of the 64-bit immediate data.
+    //
+    Addr = (UINT64) Instruction->Index2;
+  } else {
+    //
+    // Only JMP32 R0 {Immed32}. The other forms read a VM register or memory,
+    // and check the alignment of the target when they are executed.
+    //
+    if ((OPERAND1_REGNUM (Instruction->Operands) != 0) ||
+        OPERAND1_INDIRECT (Instruction->Operands)) {
+      return FALSE;
+    }
+
+    Addr = (UINT64) (INT64) (INT32) Instruction->Index2;
+    if (!IS_ALIGNED ((UINTN) Addr, sizeof (UINT16))) {
+      return FALSE;
+    }
+  }
+
+  if ((Instruction->Operands & JMP_M_RELATIVE) != 0) {
+    *Target = (UINT64) (UINTN) Instruction->Ip + Addr + Instruction->Size;
+  } else {
+    *Target = Addr;
+  }
+
+  return TRUE;
+}
+
+/**
+  Check whether a pre-decoded instruction can be translated to native code.
+
+  @param  Instruction       The pre-decoded instruction.
+
+  @retval TRUE              The instruction can be translated.
+  @retval FALSE             The instruction must be interpreted.
+
+**/
+BOOLEAN
+JitCanTranslate (
+  IN CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT8   OpcMasked;
+  UINT64  Target;
+
+  if (Instruction->ExecuteFunction == NULL) {
+    return FALSE;
+  }
+
+  OpcMasked = (UINT8) (Instruction->Opcode & OPCODE_M_OPCODE);
+  switch (OpcMasked) {
+  case OPCODE_JMP8:
+  case OPCODE_JMP:
+    return JitGetJumpTarget (Instruction, &Target);
+
+  case OPCODE_CMPEQ:
+  case OPCODE_CMPLTE:
+  case OPCODE_CMPGTE:
+  case OPCODE_CMPULTE:
+  case OPCODE_CMPUGTE:
+  case OPCODE_CMPIEQ:
+  case OPCODE_CMPILTE:
+  case OPCODE_CMPIGTE:
+  case OPCODE_CMPIULTE:
+  case OPCODE_CMPIUGTE:
+    return TRUE;
+
+  case OPCODE_PUSH:
+  case OPCODE_POP:
+  case OPCODE_PUSHN:
+  case OPCODE_POPN:
+    return FALSE;
+
+  case OPCODE_NOT:
+  case OPCODE_NEG:
+  case OPCODE_ADD:
+  case OPCODE_SUB:
+  case OPCODE_MUL:
+  case OPCODE_MULU:
+  case OPCODE_AND:
+  case OPCODE_OR:
+  case OPCODE_XOR:
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+  case OPCODE_EXTNDB:
+  case OPCODE_EXTNDW:
+  case OPCODE_EXTNDD:
+    break;
+
+  case OPCODE_DIV:
+  case OPCODE_DIVU:
+  case OPCODE_MOD:
+  case OPCODE_MODU:
+    //
+    // Division by zero raises an exception.
+    //
+    return FALSE;
+
+  default:
+    //
+    // MOVxx, MOVI, MOVIn and MOVREL
+    //
+    break;
+  }
+
+  //
+  // Writes to memory and to R0, the stack pointer, are left to the
+  // interpreter.
+  //
+  return (BOOLEAN) (!OPERAND1_INDIRECT (Instruction->Operands) &&
+                    (OPERAND1_REGNUM (Instruction->Operands) != 0));
+}
+
+/**
+  Translate a pre-decoded instruction to native code. The IP is only updated
+  by jumps.
+
+  @param  Code              The native code pointer.
+  @param  Instruction       The pre-decoded instruction, which can be
+                            translated.
+
+**/
+VOID
+JitTranslateInstruction (
+  IN OUT UINT8                          **Code,
+  IN     CONST EBC_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  STATIC CONST UINT8  MovRaxRdx[]   = { 0x48, 0x89, 0xD0 };
+  STATIC CONST UINT8  MovRcxRdx[]   = { 0x48, 0x89, 0xD1 };
+  STATIC CONST UINT8  MovEaxEax[]   = { 0x89, 0xC0 };
+  UINT8               Opcode;
+  UINT8               OpcMasked;
+  UINT8               Operands;
+  UINTN               Gpr1;
+  BOOLEAN             Is64Bit;
+  UINT64              Target;
+  UINT64              Value;
+
+  Opcode    = Instruction->Opcode;
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+  Operands  = Instruction->Operands;
+  Gpr1      = JIT_GPR_OFFSET (OPERAND1_REGNUM (Operands));
+
+  switch (OpcMasked) {
+  case OPCODE_JMP8:
+    JitGetJumpTarget (Instruction, &Target);
+    JitEmitJump (Code, Opcode, Target, (UINT64) (UINTN) Instruction->Ip + Instruction->Size);
+    return;
+
+  case OPCODE_JMP:
+    JitGetJumpTarget (Instruction, &Target);
+    JitEmitJump (Code, Operands, Target, (UINT64) (UINTN) Instruction->Ip + Instruction->Size);
+    return;
+
+  case OPCODE_CMPEQ:
+  case OPCODE_CMPLTE:
+  case OPCODE_CMPGTE:
+  case OPCODE_CMPULTE:
+  case OPCODE_CMPUGTE:
+    //
+    // Operand 1 is always the register. An indirect operand 2 is read with
+    // the size of the comparison.
+    //
+    Is64Bit = (BOOLEAN) ((Opcode & OPCODE_M_64BIT) != 0);
+    JitEmitLoadContext (Code, JIT_RAX, Gpr1);
+    JitEmitOperand2 (Code, Instruction, (UINT8) (Is64Bit ? DATA_SIZE_64 : DATA_SIZE_32));
+    JitEmitCompare (Code, Instruction->Param, Is64Bit);
+    return;
+
+  case OPCODE_CMPIEQ:
+  case OPCODE_CMPILTE:
+  case OPCODE_CMPIGTE:
+  case OPCODE_CMPIULTE:
+  case OPCODE_CMPIUGTE:
+    Is64Bit = (BOOLEAN) ((Opcode & OPCODE_M_CMPI64) != 0);
+    JitEmitLoadContext (Code, JIT_RAX, Gpr1);
+    if (OPERAND1_INDIRECT (Operands)) {
+      JitEmitAddImmediate (Code, JIT_RAX, (INT16) Instruction->Index1);
+      JitEmitLoadIndirect (Code, JIT_RAX, (UINT8) (Is64Bit ? DATA_SIZE_64 : DATA_SIZE_32));
+    }
+
+    JitEmitLoadImmediate (Code, JIT_RDX, (UINT64) Instruction->Index2);
+    JitEmitCompare (Code, Instruction->Param, Is64Bit);
+    return;
+
+  case OPCODE_MOVI:
+  case OPCODE_MOVIN:
+  case OPCODE_MOVREL:
+    Value = (UINT64) Instruction->Index2;
+    if (OpcMasked == OPCODE_MOVI) {
+      switch (Operands & MOVI_M_MOVEWIDTH) {
+      case MOVI_MOVEWIDTH8:
+        Value &= 0x000000FF;
+        break;
+
+      case MOVI_MOVEWIDTH16:
+        Value &= 0x0000FFFF;
+        break;
+
+      case MOVI_MOVEWIDTH32:
+        Value &= 0xFFFFFFFF;
+        break;
+      }
+    }
+
+    JitEmitLoadImmediate (Code, JIT_RAX, Value);
+    JitEmitStoreContext (Code, JIT_RAX, Gpr1);
+    return;
+
+  case OPCODE_MOVBW:
+  case OPCODE_MOVWW:
+  case OPCODE_MOVDW:
+  case OPCODE_MOVQW:
+  case OPCODE_MOVNW:
+  case OPCODE_MOVBD:
+  case OPCODE_MOVWD:
+  case OPCODE_MOVDD:
+  case OPCODE_MOVQD:
+  case OPCODE_MOVND:
+  case OPCODE_MOVQQ:
+    //
+    // Param holds the size of the move. Loads zero-extend, and a register
+    // operand 2 is truncated to the size.
+    //
+    JitEmitOperand2 (Code, Instruction, Instruction->Param);
+    if (!OPERAND2_INDIRECT (Operands)) {
+      switch (Instruction->Param) {
+      case DATA_SIZE_8:
+        //
+        // movzx edx, dl
+        //
+        *(*Code)++ = 0x0F;
+        *(*Code)++ = 0xB6;
+        *(*Code)++ = 0xD2;
+        break;
+
+      case DATA_SIZE_16:
+        //
+        // movzx edx, dx
+        //
+        *(*Code)++ = 0x0F;
+        *(*Code)++ = 0xB7;
+        *(*Code)++ = 0xD2;
+        break;
+
+      case DATA_SIZE_32:
+        //
+        // mov edx, edx
+        //
+        *(*Code)++ = 0x89;
+        *(*Code)++ = 0xD2;
+        break;
+      }
+    }
+
+    JitEmitStoreContext (Code, JIT_RDX, Gpr1);
+    return;
+  }
+
+  //
+  // Data manipulation instructions. 32-bit operations only depend on the low
+  // halves of their operands, so they are done in 64 bits, and the result is
+  // truncated, except for the right shifts.
+  //
+  Is64Bit = (BOOLEAN) ((Opcode & DATAMANIP_M_64) != 0);
+  JitEmitOperand2 (Code, Instruction, (UINT8) (Is64Bit ? DATA_SIZE_64 : DATA_SIZE_32));
+  switch (OpcMasked) {
+  case OPCODE_NOT:
+  case OPCODE_NEG:
+    //
+    // mov rax, rdx; not rax or neg rax
+    //
+    JitEmit (Code, MovRaxRdx, sizeof (MovRaxRdx));
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0xF7;
+    *(*Code)++ = (UINT8) ((OpcMasked == OPCODE_NOT) ? 0xD0 : 0xD8);
+    break;
+
+  case OPCODE_EXTNDB:
+  case OPCODE_EXTNDW:
+  case OPCODE_EXTNDD:
+    //
+    // movsx rax, dl, movsx rax, dx or movsxd rax, edx
+    //
+    *(*Code)++ = 0x48;
+    if (OpcMasked == OPCODE_EXTNDD) {
+      *(*Code)++ = 0x63;
+    } else {
+      *(*Code)++ = 0x0F;
+      *(*Code)++ = (UINT8) ((OpcMasked == OPCODE_EXTNDB) ? 0xBE : 0xBF);
+    }
+    *(*Code)++ = 0xC2;
+    break;
+
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+    //
+    // mov rcx, rdx; shl, shr or sar of rax or eax by cl
+    //
+    JitEmitLoadContext (Code, JIT_RAX, Gpr1);
+    JitEmit (Code, MovRcxRdx, sizeof (MovRcxRdx));
+    if (Is64Bit) {
+      *(*Code)++ = 0x48;
+    }
+    *(*Code)++ = 0xD3;
+    if (OpcMasked == OPCODE_SHL) {
+      *(*Code)++ = 0xE0;
+    } else if (OpcMasked == OPCODE_SHR) {
+      *(*Code)++ = 0xE8;
+    } else {
+      *(*Code)++ = 0xF8;
+    }
+    break;
+
+  case OPCODE_MUL:
+  case OPCODE_MULU:
+    //
+    // imul rax, rdx. The low half of the product is the same for signed and
+    // unsigned operands.
+    //
+    JitEmitLoadContext (Code, JIT_RAX, Gpr1);
+    *(*Code)++ = 0x48;
+    *(*Code)++ = 0x0F;
+    *(*Code)++ = 0xAF;
+    *(*Code)++ = 0xC2;
+    break;
+
+  default:
+    //
+    // add, sub, and, or or xor rax, rdx
+    //
+    JitEmitLoadContext (Code, JIT_RAX, Gpr1);
+    *(*Code)++ = 0x48;
+    switch (OpcMasked) {
+    case OPCODE_ADD:
+      *(*Code)++ = 0x01;
+      break;
+    case OPCODE_SUB:
+      *(*Code)++ = 0x29;
+      break;
+    case OPCODE_AND:
+      *(*Code)++ = 0x21;
+      break;
+    case OPCODE_OR:
+      *(*Code)++ = 0x09;
+      break;
+    default:
+      ASSERT (OpcMasked == OPCODE_XOR);
+      *(*Code)++ = 0x31;
+      break;
+    }
+    *(*Code)++ = 0xD0;
+    break;
+  }
+
+  if (!Is64Bit) {
+    JitEmit (Code, MovEaxEax, sizeof (MovEaxEax));
+  }
+
+  JitEmitStoreContext (Code, JIT_RAX, Gpr1);
+}
+
+/**
+  Translate a run of pre-decoded instructions to native code.
+
+  A run that is a whole block ending with a jump back to its first instruction
+  loops in native code, for as long as the VM is not single-stepped.
+
+  @param  Instructions      The pre-decoded instructions of the run.
+  @param  Count             The number of instructions in the run.
+  @param  IsBlock           TRUE if the run starts at the first instruction of
+                            its block.
+
+  @return The native code of the run, or NULL if the code buffer is full.
+
+**/
+EBC_NATIVE_CODE
+JitTranslateRun (
+  IN CONST EBC_DECODED_INSTRUCTION  *Instructions,
+  IN UINTN                          Count,
+  IN BOOLEAN                        IsBlock
+  )
+{
+  STATIC CONST UINT8             Prologue[] = { 0x53, 0x48, 0x89, 0xCB };
+  STATIC CONST UINT8             Epilogue[] = { 0x5B, 0xC3 };
+  CONST EBC_DECODED_INSTRUCTION  *Last;
+  UINT8                          *Start;
+  UINT8                          *Code;
+  UINT8                          *Loop;
+  UINT8                          *Exit;
+  UINTN                          Index;
+  UINT64                         Target;
+  UINT8                          OpcMasked;
+
+  if (mEbcJitCodeUsed + Count * EBC_JIT_MAX_INSTRUCTION_SIZE + EBC_JIT_MAX_RUN_OVERHEAD > mEbcJitCodeSize) {
+    return NULL;
+  }
+
+  Start = mEbcJitCode + mEbcJitCodeUsed;
+  Code  = Start;
+
+  //
+  // push rbx; mov rbx, rcx
+  //
+  JitEmit (&Code, Prologue, sizeof (Prologue));
+  Loop = Code;
+  for (Index = 0; Index < Count; Index++) {
+    JitTranslateInstruction (&Code, &Instructions[Index]);
+  }
+
+  Last      = &Instructions[Count - 1];
+  OpcMasked = (UINT8) (Last->Opcode & OPCODE_M_OPCODE);
+  if ((OpcMasked != OPCODE_JMP8) && (OpcMasked != OPCODE_JMP)) {
+    JitEmitLoadImmediate (&Code, JIT_RAX, (UINT64) (UINTN) Last->Ip + Last->Size);
+    JitEmitStoreContext (&Code, JIT_RAX, OFFSET_OF (VM_CONTEXT, Ip));
+  } else if (IsBlock && JitGetJumpTarget (Last, &Target) && (Target == (UINT64) (UINTN) Instructions[0].Ip)) {
+    //
+    // cmp rax, rdx with the address of the block in RDX; jne Exit
+    //
+    JitEmitLoadImmediate (&Code, JIT_RDX, Target);
+    *Code++ = 0x48;
+    *Code++ = 0x39;
+    *Code++ = 0xD0;
+    *Code++ = 0x75;
+    Exit    = Code++;
+    //
+    // test byte [rbx + Flags], VMFLAGS_STEP; jz Loop
+    //
+    JitEmitContextAccess (&Code, 0, 0xF6, 0, OFFSET_OF (VM_CONTEXT, Flags));
+    *Code++ = VMFLAGS_STEP;
+    *Code++ = 0x0F;
+    *Code++ = 0x84;
+    JitEmit32 (&Code, (UINT32) (Loop - (Code + sizeof (UINT32))));
+    *Exit   = (UINT8) (Code - (Exit + 1));
+  }
+
+  //
+  // mov eax, Count; pop rbx; ret
+  //
+  JitEmitLoadImmediate (&Code, JIT_RAX, Count);
+  JitEmit (&Code, Epilogue, sizeof (Epilogue));
+
+  ASSERT ((UINTN) (Code - Start) <= Count * EBC_JIT_MAX_INSTRUCTION_SIZE + EBC_JIT_MAX_RUN_OVERHEAD);
+  mEbcJitCodeUsed += ALIGN_VALUE ((UINTN) (Code - Start), 16);
+  InvalidateInstructionCacheRange (Start, (UINTN) (Code - Start));
+
+  return (EBC_NATIVE_CODE) (UINTN) Start;
+}
+
+/**
+  Set up the translation of pre-decoded instructions to native code. The JIT
+  is enabled by PcdEbcJitEnable, and is only available on X64.
+
+  @param  InstructionCount  The number of instructions the translation cache
+                            holds.
+
+**/
+VOID
+EbcJitInitialize (
+  IN UINTN  InstructionCount
+  )
+{
+  if (!PcdGetBool (PcdEbcJitEnable)) {
+    return;
+  }
+
+  //
+  // The native code is executed from a buffer of the same type as the
+  // thunks.
+  //
+  mEbcJitCodeSize = InstructionCount * EBC_JIT_CODE_PER_INSTRUCTION;
+  mEbcJitCode     = EbcAllocatePoolForThunk (mEbcJitCodeSize);
+  if (mEbcJitCode == NULL) {
+    mEbcJitCodeSize = 0;
+  }
+
+  mEbcJitCodeUsed = 0;
+}
+
+/**
+  Release the native code of all blocks. Called when the translation cache is
+  reset, while no native code is being executed.
+
+**/
+VOID
+EbcJitReset (
+  VOID
+  )
+{
+  mEbcJitCodeUsed = 0;
+}
+
+/**
+  Translate the runs of instructions of a pre-decoded block that only operate
+  on VM registers to native code, and set the NativeCode of the first
+  instruction of each run.
+
+  @param  Instructions      The pre-decoded instructions of the block.
+  @param  Count             The number of instructions in the block.
+
+**/
+VOID
+EbcJitTranslateBlock (
+  IN OUT EBC_DECODED_INSTRUCTION  *Instructions,
+  IN     UINTN                    Count
+  )
+{
+  UINTN  Start;
+  UINTN  End;
+
+  if (mEbcJitCode == NULL) {
+    return;
+  }
+
+  for (Start = 0; Start < Count; Start = End + 1) {
+    for (End = Start; (End < Count) && JitCanTranslate (&Instructions[End]); End++) {
+    }
+
+    if (End - Start >= EBC_JIT_MIN_RUN_LENGTH) {
+      Instructions[Start].NativeCode = JitTranslateRun (&Instructions[Start], End - Start, (BOOLEAN) (Start == 0));
+    }
+  }
+}
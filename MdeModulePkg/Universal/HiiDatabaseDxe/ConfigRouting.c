@@ -1600,142 +1600,448 @@ GetFormPackageData (
 
 
 /**
-  This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
+  Free the block array and default values of a varstore.
+
+  @param  VarStorageData         The varstore data to be freed, or NULL.
 
-  @param  DataBaseRecord        The DataBaseRecord instance contains the found Hii handle and package.
-  @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
-                                the first found varstore will be as ConfigHdr.
-  @param  IsEfiVarstore         Whether the request storage type is efi varstore type.
-  @param  EfiVarStore           The efi varstore info which will return.
+**/
+VOID
+FreeVarStorageData (
+  IN IFR_VARSTORAGE_DATA  *VarStorageData
+  )
+{
+  IFR_BLOCK_DATA               *BlockData;
+  IFR_DEFAULT_DATA             *DefaultValueData;
+
+  if (VarStorageData == NULL) {
+    return;
+  }
+
+  //
+  // Free link array VarStorageData
+  //
+  while (!IsListEmpty (&VarStorageData->BlockEntry)) {
+    BlockData = BASE_CR (VarStorageData->BlockEntry.ForwardLink, IFR_BLOCK_DATA, Entry);
+    RemoveEntryList (&BlockData->Entry);
+    if (BlockData->Name != NULL) {
+      FreePool (BlockData->Name);
+    }
+    //
+    // Free default value link array
+    //
+    while (!IsListEmpty (&BlockData->DefaultValueEntry)) {
+      DefaultValueData = BASE_CR (BlockData->DefaultValueEntry.ForwardLink, IFR_DEFAULT_DATA, Entry);
+      RemoveEntryList (&DefaultValueData->Entry);
+      FreePool (DefaultValueData);
+    }
+    FreePool (BlockData);
+  }
+  if (VarStorageData ->Name != NULL) {
+    FreePool (VarStorageData ->Name);
+    VarStorageData ->Name = NULL;
+  }
+  FreePool (VarStorageData);
+}
+
+/**
+  Free the map between default id and default name.
+
+  @param  DefaultIdArray         The default id array to be freed, or NULL.
+
+**/
+VOID
+FreeDefaultIdArray (
+  IN IFR_DEFAULT_DATA  *DefaultIdArray
+  )
+{
+  IFR_DEFAULT_DATA             *DefaultId;
+
+  if (DefaultIdArray == NULL) {
+    return;
+  }
+
+  while (!IsListEmpty (&DefaultIdArray->Entry)) {
+    DefaultId = BASE_CR (DefaultIdArray->Entry.ForwardLink, IFR_DEFAULT_DATA, Entry);
+    RemoveEntryList (&DefaultId->Entry);
+    FreePool (DefaultId);
+  }
+  FreePool (DefaultIdArray);
+}
+
+/**
+  Copy a list of IFR_DEFAULT_DATA entries.
+
+  @param  DestinationList        The initialized list the entries are appended to.
+  @param  SourceList             The list to copy.
+
+  @retval EFI_SUCCESS            The entries are copied.
+  @retval EFI_OUT_OF_RESOURCES   No enough memory.
 **/
 EFI_STATUS
-GetVarStoreType (
-  IN     HII_DATABASE_RECORD        *DataBaseRecord,
-  IN     EFI_STRING                 ConfigHdr,
-  OUT    BOOLEAN                    *IsEfiVarstore,
-  OUT    EFI_IFR_VARSTORE_EFI       **EfiVarStore
+CopyDefaultDataList (
+  IN OUT LIST_ENTRY  *DestinationList,
+  IN     LIST_ENTRY  *SourceList
+  )
+{
+  LIST_ENTRY                   *Link;
+  IFR_DEFAULT_DATA             *DefaultData;
+
+  for (Link = SourceList->ForwardLink; Link != SourceList; Link = Link->ForwardLink) {
+    DefaultData = AllocateCopyPool (sizeof (IFR_DEFAULT_DATA), BASE_CR (Link, IFR_DEFAULT_DATA, Entry));
+    if (DefaultData == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    InsertTailList (DestinationList, &DefaultData->Entry);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy the varstore data and the default id array got by ParseIfrData.
+
+  @param  VarStorageData         The initialized varstore data the copy is saved in.
+  @param  DefaultIdArray         The initialized default id array the copy is saved in.
+  @param  SourceVarStorageData   The varstore data to copy.
+  @param  SourceDefaultIdArray   The default id array to copy.
+
+  @retval EFI_SUCCESS            The data is copied.
+  @retval EFI_OUT_OF_RESOURCES   No enough memory. The caller frees what is copied.
+**/
+EFI_STATUS
+CopyIfrData (
+  IN OUT IFR_VARSTORAGE_DATA  *VarStorageData,
+  IN OUT IFR_DEFAULT_DATA     *DefaultIdArray,
+  IN     IFR_VARSTORAGE_DATA  *SourceVarStorageData,
+  IN     IFR_DEFAULT_DATA     *SourceDefaultIdArray
+  )
+{
+  LIST_ENTRY                   *Link;
+  IFR_BLOCK_DATA               *BlockData;
+  IFR_BLOCK_DATA               *SourceBlockData;
+
+  CopyGuid (&VarStorageData->Guid, &SourceVarStorageData->Guid);
+  VarStorageData->Size = SourceVarStorageData->Size;
+  VarStorageData->Type = SourceVarStorageData->Type;
+  if (SourceVarStorageData->Name != NULL) {
+    VarStorageData->Name = AllocateCopyPool (StrSize (SourceVarStorageData->Name), SourceVarStorageData->Name);
+    if (VarStorageData->Name == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  for (Link = SourceVarStorageData->BlockEntry.ForwardLink; Link != &SourceVarStorageData->BlockEntry; Link = Link->ForwardLink) {
+    SourceBlockData = BASE_CR (Link, IFR_BLOCK_DATA, Entry);
+    BlockData = AllocateCopyPool (sizeof (IFR_BLOCK_DATA), SourceBlockData);
+    if (BlockData == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    BlockData->Name = NULL;
+    InitializeListHead (&BlockData->DefaultValueEntry);
+    InsertTailList (&VarStorageData->BlockEntry, &BlockData->Entry);
+
+    if (SourceBlockData->Name != NULL) {
+      BlockData->Name = AllocateCopyPool (StrSize (SourceBlockData->Name), SourceBlockData->Name);
+      if (BlockData->Name == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+    if (EFI_ERROR (CopyDefaultDataList (&BlockData->DefaultValueEntry, &SourceBlockData->DefaultValueEntry))) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  return CopyDefaultDataList (&DefaultIdArray->Entry, &SourceDefaultIdArray->Entry);
+}
+
+/**
+  Free the varstore <ConfigHdr> cache and the question table cache of a
+  package list.
+
+  It must be called whenever form packages are added to or removed from the
+  package list, and before the package list itself is freed.
+
+  @param  PackageList            The package list whose cache is freed.
+
+**/
+VOID
+FreeVarStoreHdrCache (
+  IN OUT HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList
+  )
+{
+  UINTN                          Index;
+  HII_VARSTORE_HDR_CACHE_ENTRY   *Entry;
+  HII_QUESTION_TABLE_CACHE_ENTRY *QuestionTable;
+
+  while (!IsListEmpty (&PackageList->QuestionTableCache)) {
+    QuestionTable = BASE_CR (PackageList->QuestionTableCache.ForwardLink, HII_QUESTION_TABLE_CACHE_ENTRY, Entry);
+    RemoveEntryList (&QuestionTable->Entry);
+    if (QuestionTable->ConfigHdr != NULL) {
+      FreePool (QuestionTable->ConfigHdr);
+    }
+    FreeVarStorageData (QuestionTable->VarStorageData);
+    FreeDefaultIdArray (QuestionTable->DefaultIdArray);
+    FreePool (QuestionTable);
+  }
+
+  if (PackageList->VarStoreHdrCache != NULL) {
+    for (Index = 0; Index < PackageList->VarStoreHdrCount; Index++) {
+      Entry = &PackageList->VarStoreHdrCache[Index];
+      if (Entry->ConfigHdr != NULL) {
+        FreePool (Entry->ConfigHdr);
+      }
+      if (Entry->VarStoreOp != NULL) {
+        FreePool (Entry->VarStoreOp);
+      }
+    }
+    FreePool (PackageList->VarStoreHdrCache);
+  }
+
+  PackageList->VarStoreHdrCache      = NULL;
+  PackageList->VarStoreHdrCount      = 0;
+  PackageList->VarStoreHdrCacheValid = FALSE;
+}
+
+/**
+  Generate the "GUID=...&NAME=..." part of <ConfigHdr> for a varstore.
+
+  @param  VarstoreGuid           Varstore guid.
+  @param  AsciiName              Varstore name in ASCII, NULL for a name/value varstore.
+
+  @return The generated string, NULL if out of resources. The caller must free it.
+
+**/
+EFI_STRING
+GenerateVarStoreHdr (
+  IN EFI_GUID    *VarstoreGuid,
+  IN CHAR8       *AsciiName    OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  UINTN                    IfrOffset;
-  UINTN                    PackageOffset;
-  EFI_IFR_OP_HEADER        *IfrOpHdr;
-  CHAR16                   *VarStoreName;
-  UINTN                    NameSize;
   EFI_STRING               GuidStr;
   EFI_STRING               NameStr;
   EFI_STRING               TempStr;
+  CHAR16                   *VarStoreName;
+  UINTN                    NameSize;
   UINTN                    LengthString;
-  UINT8                    *HiiFormPackage;
-  UINTN                    PackageSize;
-  EFI_IFR_VARSTORE_EFI     *IfrEfiVarStore;
-  EFI_HII_PACKAGE_HEADER   *PackageHeader;
 
-  HiiFormPackage = NULL;
-  LengthString     = 0;
-  Status           = EFI_SUCCESS;
-  GuidStr          = NULL;
-  NameStr          = NULL;
-  TempStr          = NULL;
-  *IsEfiVarstore   = FALSE;
+  if (AsciiName != NULL) {
+    NameSize = AsciiStrSize (AsciiName);
+    VarStoreName = AllocateZeroPool (NameSize * sizeof (CHAR16));
+    if (VarStoreName == NULL) {
+      return NULL;
+    }
+    AsciiStrToUnicodeStrS (AsciiName, VarStoreName, NameSize);
+    GenerateSubStr (L"NAME=", StrLen (VarStoreName) * sizeof (CHAR16), (VOID *) VarStoreName, 2, &NameStr);
+    FreePool (VarStoreName);
+  } else {
+    GenerateSubStr (L"NAME=", 0, NULL, 2, &NameStr);
+  }
+  GenerateSubStr (L"GUID=", sizeof (EFI_GUID), (VOID *) VarstoreGuid, 1, &GuidStr);
 
-  Status = GetFormPackageData(DataBaseRecord, &HiiFormPackage, &PackageSize);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  LengthString = StrLen (GuidStr);
+  LengthString = LengthString + StrLen (NameStr) + 1;
+  TempStr = AllocateZeroPool (LengthString * sizeof (CHAR16));
+  if (TempStr != NULL) {
+    StrCpyS (TempStr, LengthString, GuidStr);
+    StrCatS (TempStr, LengthString, NameStr);
   }
 
-  IfrOffset     = sizeof (EFI_HII_PACKAGE_HEADER);
-  PackageOffset = IfrOffset;
-  PackageHeader = (EFI_HII_PACKAGE_HEADER *) HiiFormPackage;
+  FreePool (GuidStr);
+  FreePool (NameStr);
 
-  while (IfrOffset < PackageSize) {
-    //
-    // More than one form packages exist.
-    //
-    if (PackageOffset >= PackageHeader->Length) {
-        //
-        // Process the new form package.
-        //
-        PackageOffset = sizeof (EFI_HII_PACKAGE_HEADER);
-        IfrOffset    += PackageOffset;
-        PackageHeader = (EFI_HII_PACKAGE_HEADER *) (HiiFormPackage + IfrOffset);
-    }
+  return TempStr;
+}
 
-    IfrOpHdr  = (EFI_IFR_OP_HEADER *) (HiiFormPackage + IfrOffset);
-    IfrOffset += IfrOpHdr->Length;
-    PackageOffset += IfrOpHdr->Length;
+/**
+  Build the varstore <ConfigHdr> cache of the package list if it is not valid.
 
-    if (IfrOpHdr->OpCode == EFI_IFR_VARSTORE_EFI_OP ) {
-      IfrEfiVarStore = (EFI_IFR_VARSTORE_EFI *) IfrOpHdr;
-      //
-      // If the length is small than the structure, this is from old efi
-      // varstore definition. Old efi varstore get config directly from
-      // GetVariable function.
-      //
-      if (IfrOpHdr->Length < sizeof (EFI_IFR_VARSTORE_EFI)) {
-        continue;
-      }
+  The form packages are exported and walked once, every varstore opcode is
+  recorded with its "GUID=...&NAME=..." string. Later <ConfigHdr> matching on
+  this package list only compares against the cached strings.
 
-      NameSize = AsciiStrSize ((CHAR8 *)IfrEfiVarStore->Name);
-      VarStoreName = AllocateZeroPool (NameSize * sizeof (CHAR16));
-      if (VarStoreName == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-        goto Done;
+  @param  DataBaseRecord         The DataBaseRecord instance contains the found Hii handle and package.
+
+  @retval EFI_SUCCESS            The cache is valid.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory to build the cache.
+  @retval Others                 Fail to get the form package data.
+
+**/
+EFI_STATUS
+BuildVarStoreHdrCache (
+  IN     HII_DATABASE_RECORD        *DataBaseRecord
+  )
+{
+  EFI_STATUS                         Status;
+  HII_DATABASE_PACKAGE_LIST_INSTANCE *PackageList;
+  HII_VARSTORE_HDR_CACHE_ENTRY       *Entry;
+  UINTN                              IfrOffset;
+  UINTN                              PackageOffset;
+  EFI_IFR_OP_HEADER                  *IfrOpHdr;
+  UINT8                              *HiiFormPackage;
+  UINTN                              PackageSize;
+  EFI_HII_PACKAGE_HEADER             *PackageHeader;
+  EFI_GUID                           *VarStoreGuid;
+  CHAR8                              *VarStoreName;
+  UINTN                              Count;
+  UINTN                              Pass;
+  BOOLEAN                            BeforeForm;
+
+  PackageList = DataBaseRecord->PackageList;
+  if (PackageList->VarStoreHdrCacheValid) {
+    return EFI_SUCCESS;
+  }
+
+  HiiFormPackage = NULL;
+  Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // First pass counts the varstores, second pass fills the cache.
+  //
+  Count = 0;
+  for (Pass = 0; Pass < 2; Pass++) {
+    if (Pass == 1) {
+      if (Count == 0) {
+        break;
       }
-      AsciiStrToUnicodeStrS ((CHAR8 *) IfrEfiVarStore->Name, VarStoreName, NameSize);
-
-      GenerateSubStr (L"GUID=", sizeof (EFI_GUID), (VOID *) &IfrEfiVarStore->Guid, 1, &GuidStr);
-      GenerateSubStr (L"NAME=", StrLen (VarStoreName) * sizeof (CHAR16), (VOID *) VarStoreName, 2, &NameStr);
-      LengthString = StrLen (GuidStr);
-      LengthString = LengthString + StrLen (NameStr) + 1;
-      TempStr = AllocateZeroPool (LengthString * sizeof (CHAR16));
-      if (TempStr == NULL) {
-        FreePool (GuidStr);
-        FreePool (NameStr);
-        FreePool (VarStoreName);
+      PackageList->VarStoreHdrCache = AllocateZeroPool (Count * sizeof (HII_VARSTORE_HDR_CACHE_ENTRY));
+      if (PackageList->VarStoreHdrCache == NULL) {
         Status = EFI_OUT_OF_RESOURCES;
         goto Done;
       }
-      StrCpyS (TempStr, LengthString, GuidStr);
-      StrCatS (TempStr, LengthString, NameStr);
-      if (ConfigHdr == NULL || StrnCmp (ConfigHdr, TempStr, StrLen (TempStr)) == 0) {
-        *EfiVarStore = (EFI_IFR_VARSTORE_EFI *) AllocateZeroPool (IfrOpHdr->Length);
-        if (*EfiVarStore == NULL) {
-          FreePool (VarStoreName);
-          FreePool (GuidStr);
-          FreePool (NameStr);
-          FreePool (TempStr);
-          Status = EFI_OUT_OF_RESOURCES;
-          goto Done;
-        }
-        *IsEfiVarstore = TRUE;
-        CopyMem (*EfiVarStore, IfrEfiVarStore, IfrOpHdr->Length);
-      }
+      PackageList->VarStoreHdrCount = Count;
+      Count = 0;
+    }
 
-      //
-      // Free allocated temp string.
-      //
-      FreePool (VarStoreName);
-      FreePool (GuidStr);
-      FreePool (NameStr);
-      FreePool (TempStr);
+    BeforeForm    = TRUE;
+    IfrOffset     = sizeof (EFI_HII_PACKAGE_HEADER);
+    PackageOffset = IfrOffset;
+    PackageHeader = (EFI_HII_PACKAGE_HEADER *) HiiFormPackage;
 
+    while (IfrOffset < PackageSize) {
       //
-      // Already found the varstore, break;
+      // More than one form packages exist.
       //
-      if (*IsEfiVarstore) {
+      if (PackageOffset >= PackageHeader->Length) {
+          //
+          // Process the new form package.
+          //
+          PackageOffset = sizeof (EFI_HII_PACKAGE_HEADER);
+          IfrOffset    += PackageOffset;
+          PackageHeader = (EFI_HII_PACKAGE_HEADER *) (HiiFormPackage + IfrOffset);
+      }
+
+      IfrOpHdr  = (EFI_IFR_OP_HEADER *) (HiiFormPackage + IfrOffset);
+      IfrOffset += IfrOpHdr->Length;
+      PackageOffset += IfrOpHdr->Length;
+
+      switch (IfrOpHdr->OpCode) {
+      case EFI_IFR_VARSTORE_OP:
+        VarStoreGuid = &((EFI_IFR_VARSTORE *) IfrOpHdr)->Guid;
+        VarStoreName = (CHAR8 *) ((EFI_IFR_VARSTORE *) IfrOpHdr)->Name;
+        break;
+
+      case EFI_IFR_VARSTORE_EFI_OP:
+        VarStoreGuid = &((EFI_IFR_VARSTORE_EFI *) IfrOpHdr)->Guid;
+        VarStoreName = (CHAR8 *) ((EFI_IFR_VARSTORE_EFI *) IfrOpHdr)->Name;
+        break;
+
+      case EFI_IFR_VARSTORE_NAME_VALUE_OP:
+        VarStoreGuid = &((EFI_IFR_VARSTORE_NAME_VALUE *) IfrOpHdr)->Guid;
+        VarStoreName = NULL;
         break;
+
+      case EFI_IFR_FORM_OP:
+      case EFI_IFR_FORM_MAP_OP:
+        BeforeForm = FALSE;
+        continue;
+
+      default:
+        continue;
+      }
+
+      if (Pass == 1) {
+        Entry = &PackageList->VarStoreHdrCache[Count];
+        Entry->BeforeForm = BeforeForm;
+        Entry->ConfigHdr  = GenerateVarStoreHdr (VarStoreGuid, VarStoreName);
+        Entry->VarStoreOp = AllocateCopyPool (IfrOpHdr->Length, IfrOpHdr);
+        if (Entry->ConfigHdr == NULL || Entry->VarStoreOp == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          goto Done;
+        }
       }
+      Count++;
     }
   }
+
+  PackageList->VarStoreHdrCacheValid = TRUE;
+
 Done:
-  if (HiiFormPackage != NULL) {
-    FreePool (HiiFormPackage);
+  if (EFI_ERROR (Status)) {
+    FreeVarStoreHdrCache (PackageList);
   }
+  FreePool (HiiFormPackage);
 
   return Status;
 }
 
+/**
+  This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
+
+  @param  DataBaseRecord        The DataBaseRecord instance contains the found Hii handle and package.
+  @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
+                                the first found varstore will be as ConfigHdr.
+  @param  IsEfiVarstore         Whether the request storage type is efi varstore type.
+  @param  EfiVarStore           The efi varstore info which will return.
+**/
+EFI_STATUS
+GetVarStoreType (
+  IN     HII_DATABASE_RECORD        *DataBaseRecord,
+  IN     EFI_STRING                 ConfigHdr,
+  OUT    BOOLEAN                    *IsEfiVarstore,
+  OUT    EFI_IFR_VARSTORE_EFI       **EfiVarStore
+  )
+{
+  EFI_STATUS                         Status;
+  HII_DATABASE_PACKAGE_LIST_INSTANCE *PackageList;
+  HII_VARSTORE_HDR_CACHE_ENTRY       *Entry;
+  UINTN                              Index;
+
+  *IsEfiVarstore   = FALSE;
+
+  Status = BuildVarStoreHdrCache (DataBaseRecord);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  PackageList = DataBaseRecord->PackageList;
+  for (Index = 0; Index < PackageList->VarStoreHdrCount; Index++) {
+    Entry = &PackageList->VarStoreHdrCache[Index];
+    //
+    // If the length is small than the structure, this is from old efi
+    // varstore definition. Old efi varstore get config directly from
+    // GetVariable function.
+    //
+    if (Entry->VarStoreOp->OpCode != EFI_IFR_VARSTORE_EFI_OP ||
+        Entry->VarStoreOp->Length < sizeof (EFI_IFR_VARSTORE_EFI)) {
+      continue;
+    }
+
+    if (ConfigHdr == NULL || StrnCmp (ConfigHdr, Entry->ConfigHdr, StrLen (Entry->ConfigHdr)) == 0) {
+      *EfiVarStore = (EFI_IFR_VARSTORE_EFI *) AllocateCopyPool (Entry->VarStoreOp->Length, Entry->VarStoreOp);
+      if (*EfiVarStore == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      *IsEfiVarstore = TRUE;
+      break;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Check whether the ConfigRequest string has the request elements.
   For EFI_HII_VARSTORE_BUFFER type, the request has "&OFFSET=****&WIDTH=****..." format.
@@ -1838,6 +2144,9 @@ Done:
 /**
   This function parses Form Package to get the efi varstore info according to the request ConfigHdr.
 
+  The varstores of the package list are looked up in its varstore <ConfigHdr>
+  cache, which is built on first use and rebuilt after form packages change.
+
   @param  DataBaseRecord        The DataBaseRecord instance contains the found Hii handle and package.
   @param  ConfigHdr             Request string ConfigHdr. If it is NULL,
                                 the first found varstore will be as ConfigHdr.
@@ -1850,120 +2159,38 @@ IsThisPackageList (
   IN     EFI_STRING                 ConfigHdr
   )
 {
-  EFI_STATUS               Status;
-  UINTN                    IfrOffset;
-  UINTN                    PackageOffset;
-  EFI_IFR_OP_HEADER        *IfrOpHdr;
-  CHAR16                   *VarStoreName;
-  UINTN                    NameSize;
-  UINT8                    *HiiFormPackage;
-  UINTN                    PackageSize;
-  EFI_IFR_VARSTORE_EFI     *IfrEfiVarStore;
-  EFI_HII_PACKAGE_HEADER   *PackageHeader;
-  EFI_IFR_VARSTORE         *IfrVarStore;
-  EFI_IFR_VARSTORE_NAME_VALUE *IfrNameValueVarStore;
-  BOOLEAN                  FindVarstore;
+  HII_DATABASE_PACKAGE_LIST_INSTANCE *PackageList;
+  HII_VARSTORE_HDR_CACHE_ENTRY       *Entry;
+  UINTN                              Index;
 
-  HiiFormPackage   = NULL;
-  VarStoreName     = NULL;
-  Status           = EFI_SUCCESS;
-  FindVarstore     = FALSE;
-
-  Status = GetFormPackageData(DataBaseRecord, &HiiFormPackage, &PackageSize);
-  if (EFI_ERROR (Status)) {
+  if (EFI_ERROR (BuildVarStoreHdrCache (DataBaseRecord))) {
     return FALSE;
   }
 
-  IfrOffset     = sizeof (EFI_HII_PACKAGE_HEADER);
-  PackageOffset = IfrOffset;
-  PackageHeader = (EFI_HII_PACKAGE_HEADER *) HiiFormPackage;
-
-  while (IfrOffset < PackageSize) {
+  PackageList = DataBaseRecord->PackageList;
+  for (Index = 0; Index < PackageList->VarStoreHdrCount; Index++) {
+    Entry = &PackageList->VarStoreHdrCache[Index];
     //
-    // More than one form packages exist.
+    // Only the varstores before the first form are checked.
     //
-    if (PackageOffset >= PackageHeader->Length) {
-        //
-        // Process the new form package.
-        //
-        PackageOffset = sizeof (EFI_HII_PACKAGE_HEADER);
-        IfrOffset    += PackageOffset;
-        PackageHeader = (EFI_HII_PACKAGE_HEADER *) (HiiFormPackage + IfrOffset);
-    }
-
-    IfrOpHdr  = (EFI_IFR_OP_HEADER *) (HiiFormPackage + IfrOffset);
-    IfrOffset += IfrOpHdr->Length;
-    PackageOffset += IfrOpHdr->Length;
-
-    switch (IfrOpHdr->OpCode) {
-
-    case EFI_IFR_VARSTORE_OP:
-      IfrVarStore = (EFI_IFR_VARSTORE *) IfrOpHdr;
-
-      NameSize = AsciiStrSize ((CHAR8 *)IfrVarStore->Name);
-      VarStoreName = AllocateZeroPool (NameSize * sizeof (CHAR16));
-      if (VarStoreName == NULL) {
-        goto Done;
-      }
-      AsciiStrToUnicodeStrS ((CHAR8 *)IfrVarStore->Name, VarStoreName, NameSize);
-
-      if (IsThisVarstore((VOID *)&IfrVarStore->Guid, VarStoreName, ConfigHdr)) {
-        FindVarstore = TRUE;
-        goto Done;
-      } else {
-        FreePool (VarStoreName);
-        VarStoreName = NULL;
-      }
-      break;
-
-    case EFI_IFR_VARSTORE_EFI_OP:
-      IfrEfiVarStore = (EFI_IFR_VARSTORE_EFI *) IfrOpHdr;
-      NameSize = AsciiStrSize ((CHAR8 *)IfrEfiVarStore->Name);
-      VarStoreName = AllocateZeroPool (NameSize * sizeof (CHAR16));
-      if (VarStoreName == NULL) {
-        goto Done;
-      }
-      AsciiStrToUnicodeStrS ((CHAR8 *)IfrEfiVarStore->Name, VarStoreName, NameSize);
-
-      if (IsThisVarstore (&IfrEfiVarStore->Guid, VarStoreName, ConfigHdr)) {
-        FindVarstore = TRUE;
-        goto Done;
-      } else {
-        FreePool (VarStoreName);
-        VarStoreName = NULL;
-      }
-      break;
-
-    case EFI_IFR_VARSTORE_NAME_VALUE_OP:
-      IfrNameValueVarStore = (EFI_IFR_VARSTORE_NAME_VALUE *) IfrOpHdr;
-
-      if (IsThisVarstore (&IfrNameValueVarStore->Guid, NULL, ConfigHdr)) {
-        FindVarstore = TRUE;
-        goto Done;
-      }
+    if (!Entry->BeforeForm) {
       break;
+    }
 
-    case EFI_IFR_FORM_OP:
-    case EFI_IFR_FORM_MAP_OP:
-      //
-      // No matched varstore is found and directly return.
-      //
-      goto Done;
-
-    default:
-      break;
+    //
+    // If ConfigHdr has name field and varstore not has name, skip it.
+    //
+    if (Entry->VarStoreOp->OpCode == EFI_IFR_VARSTORE_NAME_VALUE_OP &&
+        ConfigHdr != NULL && StrStr (ConfigHdr, L"NAME=&") == NULL) {
+      continue;
     }
-  }
-Done:
-  if (HiiFormPackage != NULL) {
-    FreePool (HiiFormPackage);
-  }
 
-  if (VarStoreName != NULL) {
-    FreePool (VarStoreName);
+    if (ConfigHdr == NULL || StrnCmp (ConfigHdr, Entry->ConfigHdr, StrLen (Entry->ConfigHdr)) == 0) {
+      return TRUE;
+    }
   }
 
-  return FindVarstore;
+  return FALSE;
 }
 
 /**
@@ -3985,6 +4212,138 @@ GenerateAltConfigResp (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the length of the "GUID=...&NAME=..." part of a request, which selects
+  the varstore ParseIfrData parses.
+
+  @param  Request                The request string.
+
+  @return The length of the part in characters.
+**/
+UINTN
+GetQuestionTableKeyLength (
+  IN EFI_STRING  Request
+  )
+{
+  EFI_STRING                   PathStr;
+
+  PathStr = StrStr (Request, L"&PATH=");
+  if (PathStr == NULL) {
+    return StrLen (Request);
+  }
+  return PathStr - Request;
+}
+
+/**
+  Find the questions of the requested varstore in the question table cache of
+  a package list.
+
+  @param  PackageList            The package list.
+  @param  Request                The request string, NULL for the first varstore.
+
+  @return The cached questions, or NULL if they are not cached.
+**/
+HII_QUESTION_TABLE_CACHE_ENTRY *
+FindQuestionTable (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList,
+  IN EFI_STRING                          Request
+  )
+{
+  LIST_ENTRY                     *Link;
+  HII_QUESTION_TABLE_CACHE_ENTRY *QuestionTable;
+  UINTN                          KeyLength;
+
+  KeyLength = (Request == NULL) ? 0 : GetQuestionTableKeyLength (Request);
+  for (Link = PackageList->QuestionTableCache.ForwardLink; Link != &PackageList->QuestionTableCache; Link = Link->ForwardLink) {
+    QuestionTable = BASE_CR (Link, HII_QUESTION_TABLE_CACHE_ENTRY, Entry);
+    if (Request == NULL || QuestionTable->ConfigHdr == NULL) {
+      if (Request == QuestionTable->ConfigHdr) {
+        return QuestionTable;
+      }
+    } else if ((StrLen (QuestionTable->ConfigHdr) == KeyLength) &&
+               (StrnCmp (QuestionTable->ConfigHdr, Request, KeyLength) == 0)) {
+      return QuestionTable;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Save a copy of the questions ParseIfrData got for a whole varstore in the
+  question table cache of the package list, so that the next request for the
+  whole varstore does not parse the form packages again.
+
+  The questions of a name/value varstore are not cached: their names are
+  strings, which can change while the form packages stay the same. Nothing is
+  cached when memory runs out.
+
+  @param  PackageList            The package list.
+  @param  Request                The request string, NULL for the first varstore.
+  @param  VarStorageData         The varstore data got by ParseIfrData.
+  @param  DefaultIdArray         The default id array got by ParseIfrData.
+
+**/
+VOID
+CacheQuestionTable (
+  IN HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList,
+  IN EFI_STRING                          Request,
+  IN IFR_VARSTORAGE_DATA                 *VarStorageData,
+  IN IFR_DEFAULT_DATA                    *DefaultIdArray
+  )
+{
+  HII_QUESTION_TABLE_CACHE_ENTRY *QuestionTable;
+  UINTN                          KeyLength;
+
+  if (VarStorageData->Type == EFI_HII_VARSTORE_NAME_VALUE) {
+    return;
+  }
+
+  QuestionTable = AllocateZeroPool (sizeof (HII_QUESTION_TABLE_CACHE_ENTRY));
+  if (QuestionTable == NULL) {
+    return;
+  }
+  QuestionTable->VarStorageData = AllocateZeroPool (sizeof (IFR_VARSTORAGE_DATA));
+  QuestionTable->DefaultIdArray = AllocateZeroPool (sizeof (IFR_DEFAULT_DATA));
+  if (QuestionTable->VarStorageData == NULL || QuestionTable->DefaultIdArray == NULL) {
+    if (QuestionTable->VarStorageData != NULL) {
+      FreePool (QuestionTable->VarStorageData);
+    }
+    if (QuestionTable->DefaultIdArray != NULL) {
+      FreePool (QuestionTable->DefaultIdArray);
+    }
+    FreePool (QuestionTable);
+    return;
+  }
+  InitializeListHead (&QuestionTable->VarStorageData->Entry);
+  InitializeListHead (&QuestionTable->VarStorageData->BlockEntry);
+  InitializeListHead (&QuestionTable->DefaultIdArray->Entry);
+
+  if (Request != NULL) {
+    KeyLength = GetQuestionTableKeyLength (Request);
+    QuestionTable->ConfigHdr = AllocateZeroPool ((KeyLength + 1) * sizeof (CHAR16));
+    if (QuestionTable->ConfigHdr == NULL) {
+      goto Error;
+    }
+    CopyMem (QuestionTable->ConfigHdr, Request, KeyLength * sizeof (CHAR16));
+  }
+
+  if (EFI_ERROR (CopyIfrData (QuestionTable->VarStorageData, QuestionTable->DefaultIdArray, VarStorageData, DefaultIdArray))) {
+    goto Error;
+  }
+
+  InsertTailList (&PackageList->QuestionTableCache, &QuestionTable->Entry);
+  return;
+
+Error:
+  if (QuestionTable->ConfigHdr != NULL) {
+    FreePool (QuestionTable->ConfigHdr);
+  }
+  FreeVarStorageData (QuestionTable->VarStorageData);
+  FreeDefaultIdArray (QuestionTable->DefaultIdArray);
+  FreePool (QuestionTable);
+}
+
 /**
   This function gets the full request string and full default value string by
   parsing IFR data in HII form packages.
@@ -4043,14 +4402,13 @@ GetFullStringFromHiiFormPackages (
   UINTN                        PackageSize;
   IFR_BLOCK_DATA               *RequestBlockArray;
   IFR_BLOCK_DATA               *BlockData;
-  IFR_DEFAULT_DATA             *DefaultValueData;
-  IFR_DEFAULT_DATA             *DefaultId;
   IFR_DEFAULT_DATA             *DefaultIdArray;
   IFR_VARSTORAGE_DATA          *VarStorageData;
   EFI_STRING                   DefaultAltCfgResp;
   EFI_STRING                   ConfigHdr;
   EFI_STRING                   StringPtr;
   EFI_STRING                   Progress;
+  HII_QUESTION_TABLE_CACHE_ENTRY *QuestionTable;
 
   if (DataBaseRecord == NULL || DevicePath == NULL || Request == NULL || AltCfgResp == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -4068,11 +4426,6 @@ GetFullStringFromHiiFormPackages (
   PackageSize       = 0;
   Progress          = *Request;
 
-  Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-
   //
   // 1. Get the request block array by Request String when Request string contains the block array.
   //
@@ -4157,17 +4510,42 @@ GetFullStringFromHiiFormPackages (
   //
 
   //
-  // Parse the opcode in form package to get the default setting.
+  // A request for the whole varstore gets the questions from the question
+  // table cache of the package list when they have been parsed before.
   //
-  Status = ParseIfrData (DataBaseRecord->Handle,
-                         HiiFormPackage,
-                         (UINT32) PackageSize,
-                         *Request,
-                         RequestBlockArray,
-                         VarStorageData,
-                         DefaultIdArray);
-  if (EFI_ERROR (Status)) {
-    goto Done;
+  QuestionTable = NULL;
+  if (RequestBlockArray == NULL) {
+    QuestionTable = FindQuestionTable (DataBaseRecord->PackageList, *Request);
+  }
+
+  if (QuestionTable != NULL) {
+    Status = CopyIfrData (VarStorageData, DefaultIdArray, QuestionTable->VarStorageData, QuestionTable->DefaultIdArray);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  } else {
+    Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+
+    //
+    // Parse the opcode in form package to get the default setting.
+    //
+    Status = ParseIfrData (DataBaseRecord->Handle,
+                           HiiFormPackage,
+                           (UINT32) PackageSize,
+                           *Request,
+                           RequestBlockArray,
+                           VarStorageData,
+                           DefaultIdArray);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+
+    if (RequestBlockArray == NULL) {
+      CacheQuestionTable (DataBaseRecord->PackageList, *Request, VarStorageData, DefaultIdArray);
+    }
   }
 
   //
@@ -4229,44 +4607,8 @@ Done:
     FreePool (RequestBlockArray);
   }
 
-  if (VarStorageData != NULL) {
-    //
-    // Free link array VarStorageData
-    //
-    while (!IsListEmpty (&VarStorageData->BlockEntry)) {
-      BlockData = BASE_CR (VarStorageData->BlockEntry.ForwardLink, IFR_BLOCK_DATA, Entry);
-      RemoveEntryList (&BlockData->Entry);
-      if (BlockData->Name != NULL) {
-        FreePool (BlockData->Name);
-      }
-      //
-      // Free default value link array
-      //
-      while (!IsListEmpty (&BlockData->DefaultValueEntry)) {
-        DefaultValueData = BASE_CR (BlockData->DefaultValueEntry.ForwardLink, IFR_DEFAULT_DATA, Entry);
-        RemoveEntryList (&DefaultValueData->Entry);
-        FreePool (DefaultValueData);
-      }
-      FreePool (BlockData);
-    }
-    if (VarStorageData ->Name != NULL) {
-      FreePool (VarStorageData ->Name);
-      VarStorageData ->Name = NULL;
-    }
-    FreePool (VarStorageData);
-  }
-
-  if (DefaultIdArray != NULL) {
-    //
-    // Free DefaultId Array
-    //
-    while (!IsListEmpty (&DefaultIdArray->Entry)) {
-      DefaultId = BASE_CR (DefaultIdArray->Entry.ForwardLink, IFR_DEFAULT_DATA, Entry);
-      RemoveEntryList (&DefaultId->Entry);
-      FreePool (DefaultId);
-    }
-    FreePool (DefaultIdArray);
-  }
+  FreeVarStorageData (VarStorageData);
+  FreeDefaultIdArray (DefaultIdArray);
 
   //
   // Free the allocated string
@@ -73,6 +73,7 @@ GenerateHiiDatabaseRecord (
   InitializeListHead (&PackageList->StringPkgHdr);
   InitializeListHead (&PackageList->FontPkgHdr);
   InitializeListHead (&PackageList->SimpleFontPkgHdr);
+  InitializeListHead (&PackageList->QuestionTableCache);
   PackageList->ImagePkg      = NULL;
   PackageList->DevicePathPkg = NULL;
 
@@ -1126,6 +1127,7 @@ InsertFormPackage (
 
   InsertTailList (&PackageList->FormPkgHdr, &FormPackage->IfrEntry);
   *Package = FormPackage;
+  FreeVarStoreHdrCache (PackageList);
 
   //
   // Update FormPackage with the default setting
@@ -1271,6 +1273,7 @@ RemoveFormPackages (
     PackageList->PackageListHdr.PackageLength -= Package->FormPkgHdr.Length;
     FreePool (Package->IfrData);
     FreePool (Package);
+    FreeVarStoreHdrCache (PackageList);
     //
     // If Hii runtime support feature is enabled,
     // will export Hii info for runtime use after ReadyToBoot event triggered.
@@ -1762,6 +1765,12 @@ InsertFontPackage (
     goto Error;
   }
 
+  //
+  // Index the glyphs of this font package. Glyph lookups walk the glyph blocks
+  // if the index can not be built.
+  //
+  BuildGlyphIndex (FontPackage);
+
   //
   // This font package describes an unique EFI_FONT_INFO. Backup it in global
   // font info list.
@@ -1801,6 +1810,7 @@ Error:
     if (FontPackage->GlyphBlock != NULL) {
       FreePool (FontPackage->GlyphBlock);
     }
+    FreeGlyphIndex (&FontPackage->GlyphIndex);
     FreePool (FontPackage);
   }
   if (GlobalFont != NULL) {
@@ -1949,6 +1959,7 @@ RemoveFontPackages (
     if (Package->GlyphBlock != NULL) {
       FreePool (Package->GlyphBlock);
     }
+    FreeGlyphIndex (&Package->GlyphIndex);
     FreePool (Package->FontPkgHdr);
     //
     // Delete default character cell information
@@ -2319,6 +2330,7 @@ InsertSimpleFontPackage (
   //
   InsertTailList (&PackageList->SimpleFontPkgHdr, &SimpleFontPackage->SimpleFontEntry);
   *Package = SimpleFontPackage;
+  InvalidateSimpleGlyphIndex ();
 
   if (NotifyType == EFI_HII_DATABASE_NOTIFY_ADD_PACK) {
     PackageList->PackageListHdr.PackageLength += Header.Length;
@@ -2460,6 +2472,7 @@ RemoveSimpleFontPackages (
     PackageList->PackageListHdr.PackageLength -= Package->SimpleFontPkgHdr->Header.Length;
     FreePool (Package->SimpleFontPkgHdr);
     FreePool (Package);
+    InvalidateSimpleGlyphIndex ();
   }
 
   return EFI_SUCCESS;
@@ -3355,6 +3368,8 @@ HiiGetConfigRespInfo(
 
   Private = HII_DATABASE_DATABASE_PRIVATE_DATA_FROM_THIS (This);
 
+  PERF_INMODULE_BEGIN ("HiiExportConfigResp");
+
   //
   // Get ConfigResp string
   //
@@ -3380,6 +3395,7 @@ HiiGetConfigRespInfo(
         // Remove from the System Table when the configuration runtime buffer is freed.
         //
         gBS->InstallConfigurationTable (&gEfiHiiConfigRoutingProtocolGuid, NULL);
+        PERF_INMODULE_END ("HiiExportConfigResp");
         return EFI_OUT_OF_RESOURCES;
       }
     } else {
@@ -3390,6 +3406,7 @@ HiiGetConfigRespInfo(
     FreePool(ConfigAltResp);
   }
 
+  PERF_INMODULE_END ("HiiExportConfigResp");
   return EFI_SUCCESS;
 
 }
@@ -3415,6 +3432,8 @@ HiiGetDatabaseInfo(
   DatabaseInfo         = NULL;
   DatabaseInfoSize     = 0;
 
+  PERF_INMODULE_BEGIN ("HiiExportDatabase");
+
   //
   // Get HiiDatabase information.
   //
@@ -3439,6 +3458,7 @@ HiiGetDatabaseInfo(
       // Remove from the System Table when the configuration runtime buffer is freed.
       //
       gBS->InstallConfigurationTable (&gEfiHiiDatabaseProtocolGuid, NULL);
+      PERF_INMODULE_END ("HiiExportDatabase");
       return EFI_OUT_OF_RESOURCES;
     }
   } else {
@@ -3448,6 +3468,7 @@ HiiGetDatabaseInfo(
   ASSERT_EFI_ERROR (Status);
   gBS->InstallConfigurationTable (&gEfiHiiDatabaseProtocolGuid, gRTDatabaseInfoBuffer);
 
+  PERF_INMODULE_END ("HiiExportDatabase");
   return EFI_SUCCESS;
 
 }
@@ -3553,26 +3574,10 @@ HiiNewPackageList (
   // Only after ReadyToBoot, need to do the export.
   //
   if (gExportAfterReadyToBoot) {
-    HiiGetDatabaseInfo (This);
+    HiiRequestDatabaseExport ();
   }
   EfiReleaseLock (&mHiiDatabaseLock);
 
-  //
-  // Notes:
-  // HiiGetDatabaseInfo () will get the contents of HII data base,
-  // belong to the atomic behavior of Hii Database update.
-  // And since HiiGetConfigRespInfo () will get the configuration setting info from HII drivers
-  // we can not think it belong to the atomic behavior of Hii Database update.
-  // That's why EfiReleaseLock (&mHiiDatabaseLock) is callled before HiiGetConfigRespInfo ().
-  //
-
-  // Check whether need to get the configuration setting info from HII drivers.
-  // When after ReadyToBoot and need to do the export for form package add.
-  //
-  if (gExportAfterReadyToBoot && gExportConfigResp) {
-    HiiGetConfigRespInfo (This);
-  }
-
   return EFI_SUCCESS;
 }
 
@@ -3685,6 +3690,7 @@ HiiRemovePackageList (
 
       HiiHandle->Signature = 0;
       FreePool (HiiHandle);
+      FreeVarStoreHdrCache (Node->PackageList);
       FreePool (Node->PackageList);
       FreePool (Node);
 
@@ -3693,26 +3699,9 @@ HiiRemovePackageList (
       // Only after ReadyToBoot, need to do the export.
       //
       if (gExportAfterReadyToBoot) {
-        HiiGetDatabaseInfo (This);
+        HiiRequestDatabaseExport ();
       }
       EfiReleaseLock (&mHiiDatabaseLock);
-
-      //
-      // Notes:
-      // HiiGetDatabaseInfo () will get the contents of HII data base,
-      // belong to the atomic behavior of Hii Database update.
-      // And since HiiGetConfigRespInfo () will get the configuration setting info from HII drivers
-      // we can not think it belong to the atomic behavior of Hii Database update.
-      // That's why EfiReleaseLock (&mHiiDatabaseLock) is callled before HiiGetConfigRespInfo ().
-      //
-
-      //
-      // Check whether need to get the configuration setting info from HII drivers.
-      // When after ReadyToBoot and need to do the export for form package remove.
-      //
-      if (gExportAfterReadyToBoot && gExportConfigResp) {
-        HiiGetConfigRespInfo (This);
-      }
       return EFI_SUCCESS;
     }
   }
@@ -3830,27 +3819,10 @@ HiiUpdatePackageList (
       // Only after ReadyToBoot, need to do the export.
       //
       if (gExportAfterReadyToBoot && Status == EFI_SUCCESS) {
-        HiiGetDatabaseInfo (This);
+        HiiRequestDatabaseExport ();
       }
       EfiReleaseLock (&mHiiDatabaseLock);
 
-      //
-      // Notes:
-      // HiiGetDatabaseInfo () will get the contents of HII data base,
-      // belong to the atomic behavior of Hii Database update.
-      // And since HiiGetConfigRespInfo () will get the configuration setting info from HII drivers
-      // we can not think it belong to the atomic behavior of Hii Database update.
-      // That's why EfiReleaseLock (&mHiiDatabaseLock) is callled before HiiGetConfigRespInfo ().
-      //
-
-      //
-      // Check whether need to get the configuration setting info from HII drivers.
-      // When after ReadyToBoot and need to do the export for form package update.
-      //
-      if (gExportAfterReadyToBoot && gExportConfigResp && Status == EFI_SUCCESS) {
-        HiiGetConfigRespInfo (This);
-      }
-
       return Status;
     }
   }
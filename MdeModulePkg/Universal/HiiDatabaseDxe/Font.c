@@ -32,6 +32,33 @@ EFI_GRAPHICS_OUTPUT_BLT_PIXEL        mHiiEfiColors[16] = {
   {0xff, 0xff, 0xff, 0x00},  // WHITE
 };
 
+//
+// Cache of glyphs already expanded to blt pixels for a foreground/background
+// color pair. It is keyed on the glyph bitmap itself, so the entries never
+// become stale when font packages are added or removed.
+//
+#define HII_GLYPH_TILE_CACHE_SIZE  256
+
+typedef struct {
+  UINT8                          *Bitmap;
+  UINTN                          BitmapSize;
+  UINT16                         Width;
+  UINT16                         Height;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Foreground;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Tile;
+} HII_GLYPH_TILE;
+
+HII_GLYPH_TILE                 mHiiGlyphTileCache[HII_GLYPH_TILE_CACHE_SIZE];
+
+//
+// Character to glyph index of all simple font packages in the database.
+// Cell.Width tells whether Bitmap points to an EFI_NARROW_GLYPH or an
+// EFI_WIDE_GLYPH.
+//
+HII_GLYPH_INDEX_ENTRY          **mSimpleGlyphIndex      = NULL;
+BOOLEAN                        mSimpleGlyphIndexValid   = FALSE;
+
 
 /**
   Insert a character cell information to the list specified by GlyphInfoList.
@@ -130,6 +157,203 @@ GetCell (
 }
 
 
+/**
+  Look up a character in a character to glyph index.
+
+  This is a internal function.
+
+  @param  GlyphIndex              The index to search.
+  @param  CharValue               Unicode character value.
+
+  @return The index entry of the character, or NULL if the index holds no
+          glyph for it.
+
+**/
+HII_GLYPH_INDEX_ENTRY *
+GlyphIndexLookup (
+  IN  HII_GLYPH_INDEX_ENTRY          **GlyphIndex,
+  IN  CHAR16                         CharValue
+  )
+{
+  HII_GLYPH_INDEX_ENTRY    *Page;
+  HII_GLYPH_INDEX_ENTRY    *Entry;
+
+  ASSERT (GlyphIndex != NULL);
+
+  Page = GlyphIndex[CharValue / HII_GLYPH_INDEX_PAGE_SIZE];
+  if (Page == NULL) {
+    return NULL;
+  }
+
+  Entry = &Page[CharValue % HII_GLYPH_INDEX_PAGE_SIZE];
+  if (Entry->Bitmap == NULL) {
+    return NULL;
+  }
+
+  return Entry;
+}
+
+
+/**
+  Get the entry of a character in a character to glyph index, allocating
+  its page if needed.
+
+  This is a internal function.
+
+  @param  GlyphIndex              The index to update.
+  @param  CharValue               Unicode character value.
+
+  @return The index entry of the character, or NULL if the page can not be
+          allocated.
+
+**/
+HII_GLYPH_INDEX_ENTRY *
+GlyphIndexGetEntry (
+  IN  HII_GLYPH_INDEX_ENTRY          **GlyphIndex,
+  IN  CHAR16                         CharValue
+  )
+{
+  HII_GLYPH_INDEX_ENTRY    **Page;
+
+  ASSERT (GlyphIndex != NULL);
+
+  Page = &GlyphIndex[CharValue / HII_GLYPH_INDEX_PAGE_SIZE];
+  if (*Page == NULL) {
+    *Page = AllocateZeroPool (HII_GLYPH_INDEX_PAGE_SIZE * sizeof (HII_GLYPH_INDEX_ENTRY));
+    if (*Page == NULL) {
+      return NULL;
+    }
+  }
+
+  return &(*Page)[CharValue % HII_GLYPH_INDEX_PAGE_SIZE];
+}
+
+
+/**
+  Free a character to glyph index.
+
+  @param  GlyphIndex              Pointer to the index to free, set to NULL on
+                                  return.
+
+**/
+VOID
+FreeGlyphIndex (
+  IN OUT HII_GLYPH_INDEX_ENTRY       ***GlyphIndex
+  )
+{
+  UINTN                    Index;
+
+  ASSERT (GlyphIndex != NULL);
+
+  if (*GlyphIndex == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < HII_GLYPH_INDEX_PAGE_COUNT; Index++) {
+    if ((*GlyphIndex)[Index] != NULL) {
+      FreePool ((*GlyphIndex)[Index]);
+    }
+  }
+  FreePool (*GlyphIndex);
+  *GlyphIndex = NULL;
+}
+
+
+/**
+  Discard the character to glyph index of the simple font packages. It is
+  rebuilt on the next lookup.
+
+**/
+VOID
+InvalidateSimpleGlyphIndex (
+  VOID
+  )
+{
+  FreeGlyphIndex (&mSimpleGlyphIndex);
+  mSimpleGlyphIndexValid = FALSE;
+}
+
+
+/**
+  Build the character to glyph index of all simple font packages. When a
+  character is defined more than once, the first definition found in database
+  order wins, which matches a linear search of the packages.
+
+  This is a internal function.
+
+  @param  Private                 HII database driver private structure.
+
+  @retval TRUE                    mSimpleGlyphIndex is valid.
+  @retval FALSE                   The index can not be built.
+
+**/
+BOOLEAN
+BuildSimpleGlyphIndex (
+  IN  HII_DATABASE_PRIVATE_DATA      *Private
+  )
+{
+  HII_DATABASE_RECORD                *Node;
+  LIST_ENTRY                         *Link;
+  LIST_ENTRY                         *Link1;
+  HII_SIMPLE_FONT_PACKAGE_INSTANCE   *SimpleFont;
+  HII_GLYPH_INDEX_ENTRY              *Entry;
+  EFI_NARROW_GLYPH                   *NarrowPtr;
+  EFI_WIDE_GLYPH                     *WidePtr;
+  CHAR16                             UnicodeWeight;
+  UINT16                             Index;
+
+  if (mSimpleGlyphIndexValid) {
+    return TRUE;
+  }
+
+  mSimpleGlyphIndex = AllocateZeroPool (HII_GLYPH_INDEX_PAGE_COUNT * sizeof (HII_GLYPH_INDEX_ENTRY *));
+  if (mSimpleGlyphIndex == NULL) {
+    return FALSE;
+  }
+
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    for (Link1 = Node->PackageList->SimpleFontPkgHdr.ForwardLink;
+         Link1 != &Node->PackageList->SimpleFontPkgHdr;
+         Link1 = Link1->ForwardLink
+        ) {
+      SimpleFont = CR (Link1, HII_SIMPLE_FONT_PACKAGE_INSTANCE, SimpleFontEntry, HII_S_FONT_PACKAGE_SIGNATURE);
+      NarrowPtr  = (EFI_NARROW_GLYPH *) ((UINT8 *) (SimpleFont->SimpleFontPkgHdr) + sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR));
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs; Index++) {
+        CopyMem (&UnicodeWeight, &NarrowPtr[Index].UnicodeWeight, sizeof (CHAR16));
+        Entry = GlyphIndexGetEntry (mSimpleGlyphIndex, UnicodeWeight);
+        if (Entry == NULL) {
+          FreeGlyphIndex (&mSimpleGlyphIndex);
+          return FALSE;
+        }
+        if (Entry->Bitmap == NULL) {
+          Entry->Bitmap      = (UINT8 *) &NarrowPtr[Index];
+          Entry->Cell.Width  = EFI_GLYPH_WIDTH;
+          Entry->Cell.Height = EFI_GLYPH_HEIGHT;
+        }
+      }
+      WidePtr = (EFI_WIDE_GLYPH *) (NarrowPtr + SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs);
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfWideGlyphs; Index++) {
+        CopyMem (&UnicodeWeight, &WidePtr[Index].UnicodeWeight, sizeof (CHAR16));
+        Entry = GlyphIndexGetEntry (mSimpleGlyphIndex, UnicodeWeight);
+        if (Entry == NULL) {
+          FreeGlyphIndex (&mSimpleGlyphIndex);
+          return FALSE;
+        }
+        if (Entry->Bitmap == NULL) {
+          Entry->Bitmap      = (UINT8 *) &WidePtr[Index];
+          Entry->Cell.Width  = EFI_GLYPH_WIDTH * 2;
+          Entry->Cell.Height = EFI_GLYPH_HEIGHT;
+        }
+      }
+    }
+  }
+
+  mSimpleGlyphIndexValid = TRUE;
+  return TRUE;
+}
+
+
 /**
   Convert the glyph for a single character into a bitmap.
 
@@ -171,6 +395,7 @@ GetGlyphBuffer (
   UINTN                              HeaderSize;
   EFI_NARROW_GLYPH                   *NarrowPtr;
   EFI_WIDE_GLYPH                     *WidePtr;
+  HII_GLYPH_INDEX_ENTRY              *Entry;
 
   if (GlyphBuffer == NULL || Cell == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -195,6 +420,33 @@ GetGlyphBuffer (
       *Attributes = PROPORTIONAL_GLYPH;
     }
     return FindGlyphBlock (GlobalFont->FontPackage, Char, GlyphBuffer, Cell, NULL);
+  } else if (BuildSimpleGlyphIndex (Private)) {
+    Entry = GlyphIndexLookup (mSimpleGlyphIndex, Char);
+    if (Entry == NULL) {
+      return EFI_NOT_FOUND;
+    }
+    *GlyphBuffer = (UINT8 *) AllocateZeroPool (BITMAP_LEN_1_BIT (Entry->Cell.Width, Entry->Cell.Height));
+    if (*GlyphBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Cell->Width    = Entry->Cell.Width;
+    Cell->Height   = Entry->Cell.Height;
+    Cell->AdvanceX = Cell->Width;
+    if (Entry->Cell.Width == EFI_GLYPH_WIDTH) {
+      CopyMem (&Narrow, Entry->Bitmap, sizeof (EFI_NARROW_GLYPH));
+      CopyMem (*GlyphBuffer, Narrow.GlyphCol1, EFI_GLYPH_HEIGHT);
+      if (Attributes != NULL) {
+        *Attributes = (UINT8) (Narrow.Attributes | NARROW_GLYPH);
+      }
+    } else {
+      CopyMem (&Wide, Entry->Bitmap, sizeof (EFI_WIDE_GLYPH));
+      CopyMem (*GlyphBuffer, Wide.GlyphCol1, EFI_GLYPH_HEIGHT);
+      CopyMem (*GlyphBuffer + EFI_GLYPH_HEIGHT, Wide.GlyphCol2, EFI_GLYPH_HEIGHT);
+      if (Attributes != NULL) {
+        *Attributes = (UINT8) (Wide.Attributes | EFI_GLYPH_WIDE);
+      }
+    }
+    return EFI_SUCCESS;
   } else {
     HeaderSize = sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR);
 
@@ -255,6 +507,117 @@ GetGlyphBuffer (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Get the glyph expanded to blt pixels for a foreground/background color pair
+  from the glyph tile cache, rasterizing it on a cache miss.
+
+  This is a internal function.
+
+  @param  GlyphBuffer             Buffer points to bitmap data of glyph.
+  @param  Width                   Width of the glyph in pixels.
+  @param  Height                  Height of the glyph in pixels.
+  @param  Foreground              The color of the "on" pixels in the glyph in the
+                                  bitmap.
+  @param  Background              The color of the "off" pixels in the glyph in the
+                                  bitmap.
+
+  @return Width * Height blt pixels of the glyph, owned by the cache, or NULL
+          if the tile can not be allocated.
+
+**/
+EFI_GRAPHICS_OUTPUT_BLT_PIXEL *
+GetGlyphTile (
+  IN     UINT8                         *GlyphBuffer,
+  IN     UINT16                        Width,
+  IN     UINT16                        Height,
+  IN     EFI_GRAPHICS_OUTPUT_BLT_PIXEL Foreground,
+  IN     EFI_GRAPHICS_OUTPUT_BLT_PIXEL Background
+  )
+{
+  HII_GLYPH_TILE                       *Tile;
+  UINTN                                BitmapSize;
+  UINTN                                Index;
+  UINT32                               Hash;
+  UINT16                               Xpos;
+  UINT16                               Ypos;
+  UINTN                                OffsetY;
+
+  BitmapSize = BITMAP_LEN_1_BIT (Width, Height);
+  if (BitmapSize == 0) {
+    return NULL;
+  }
+
+  //
+  // FNV-1a hash of the bitmap, the glyph size and the colors.
+  //
+  Hash = 0x811C9DC5;
+  for (Index = 0; Index < BitmapSize; Index++) {
+    Hash = (Hash ^ GlyphBuffer[Index]) * 0x01000193;
+  }
+  Hash = (Hash ^ Width) * 0x01000193;
+  Hash = (Hash ^ (Foreground.Blue | Foreground.Green << 8 | Foreground.Red << 16)) * 0x01000193;
+  Hash = (Hash ^ (Background.Blue | Background.Green << 8 | Background.Red << 16)) * 0x01000193;
+
+  Tile = &mHiiGlyphTileCache[Hash % HII_GLYPH_TILE_CACHE_SIZE];
+  if (Tile->Tile != NULL &&
+      Tile->Width == Width &&
+      Tile->Height == Height &&
+      CompareMem (&Tile->Foreground, &Foreground, sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) == 0 &&
+      CompareMem (&Tile->Background, &Background, sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) == 0 &&
+      CompareMem (Tile->Bitmap, GlyphBuffer, BitmapSize) == 0) {
+    return Tile->Tile;
+  }
+
+  //
+  // Replace the entry. The buffers are reused when the glyph size matches.
+  //
+  if (Tile->Tile != NULL && (Tile->Width != Width || Tile->Height != Height)) {
+    FreePool (Tile->Tile);
+    FreePool (Tile->Bitmap);
+    Tile->Tile   = NULL;
+    Tile->Bitmap = NULL;
+  }
+  if (Tile->Tile == NULL) {
+    Tile->Bitmap = AllocatePool (BitmapSize);
+    Tile->Tile   = AllocatePool ((UINTN) Width * Height * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    if (Tile->Bitmap == NULL || Tile->Tile == NULL) {
+      if (Tile->Bitmap != NULL) {
+        FreePool (Tile->Bitmap);
+      }
+      if (Tile->Tile != NULL) {
+        FreePool (Tile->Tile);
+      }
+      ZeroMem (Tile, sizeof (HII_GLYPH_TILE));
+      return NULL;
+    }
+  }
+
+  CopyMem (Tile->Bitmap, GlyphBuffer, BitmapSize);
+  Tile->BitmapSize = BitmapSize;
+  Tile->Width      = Width;
+  Tile->Height     = Height;
+  Tile->Foreground = Foreground;
+  Tile->Background = Background;
+
+  //
+  // The glyph's upper left hand corner pixel is the most significant bit of the
+  // first bitmap byte.
+  //
+  for (Ypos = 0; Ypos < Height; Ypos++) {
+    OffsetY = BITMAP_LEN_1_BIT (Width, Ypos);
+    for (Xpos = 0; Xpos < Width; Xpos++) {
+      if ((GlyphBuffer[OffsetY + Xpos / 8] & (1 << (8 - Xpos % 8 - 1))) != 0) {
+        Tile->Tile[(UINTN) Ypos * Width + Xpos] = Foreground;
+      } else {
+        Tile->Tile[(UINTN) Ypos * Width + Xpos] = Background;
+      }
+    }
+  }
+
+  return Tile->Tile;
+}
+
+
 /**
   Convert bitmap data of the glyph to blt structure.
 
@@ -293,6 +656,7 @@ NarrowGlyphToBlt (
   UINT8                                Height;
   UINT8                                Width;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Buffer;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Tile;
 
   ASSERT (GlyphBuffer != NULL && Origin != NULL && *Origin != NULL);
 
@@ -314,6 +678,20 @@ NarrowGlyphToBlt (
     Width = (UINT8) RowWidth;
   }
 
+  //
+  // Opaque glyphs are copied line by line from the cached tile.
+  //
+  if (!Transparent) {
+    Tile = GetGlyphTile (GlyphBuffer, EFI_GLYPH_WIDTH, EFI_GLYPH_HEIGHT, Foreground, Background);
+    if (Tile != NULL) {
+      for (Ypos = 0; Ypos < Height; Ypos++) {
+        CopyMem (&Buffer[Ypos * ImageWidth], &Tile[Ypos * EFI_GLYPH_WIDTH], Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+      }
+      *Origin = *Origin + EFI_GLYPH_WIDTH;
+      return;
+    }
+  }
+
   for (Ypos = 0; Ypos < Height; Ypos++) {
     for (Xpos = 0; Xpos < Width; Xpos++) {
       if ((GlyphBuffer[Ypos] & (1 << (EFI_GLYPH_WIDTH - Xpos - 1))) != 0) {
@@ -376,7 +754,9 @@ GlyphToBlt (
   UINT16                                Index;
   UINT16                                YposOffset;
   UINTN                                 OffsetY;
+  UINTN                                 VisibleWidth;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL         *BltBuffer;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL         *Tile;
 
   ASSERT (Origin != NULL && *Origin != NULL && Cell != NULL);
 
@@ -401,6 +781,29 @@ GlyphToBlt (
     Transparent = TRUE;
   }
 
+  //
+  // Opaque glyphs are copied line by line from the cached tile. Glyphs with a
+  // negative OffsetX are clipped per byte below and keep that path.
+  //
+  if (!Transparent && Cell->OffsetX >= 0) {
+    Tile = GetGlyphTile (GlyphBuffer, Cell->Width, Cell->Height, Foreground, Background);
+    if (Tile != NULL) {
+      VisibleWidth = 0;
+      if (RowWidth > (UINTN) Cell->OffsetX) {
+        VisibleWidth = MIN (Cell->Width, RowWidth - Cell->OffsetX);
+      }
+      for (Ypos = 0; Ypos < Cell->Height && (((UINT32) Ypos + YposOffset) < RowHeight); Ypos++) {
+        CopyMem (
+          &BltBuffer[Ypos * ImageWidth],
+          &Tile[(UINTN) Ypos * Cell->Width],
+          VisibleWidth * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+          );
+      }
+      *Origin = *Origin + Cell->AdvanceX;
+      return;
+    }
+  }
+
   //
   // The glyph's upper left hand corner pixel is the most significant bit of the
   // first bitmap byte.
@@ -674,12 +1077,28 @@ FindGlyphBlock (
   EFI_HII_GLYPH_INFO                  LocalCell;
   INT16                               MinOffsetY;
   UINT16                              BaseLine;
+  HII_GLYPH_INDEX_ENTRY               *Entry;
 
   ASSERT (FontPackage != NULL);
   ASSERT (FontPackage->Signature == HII_FONT_PACKAGE_SIGNATURE);
   BaseLine  = 0;
   MinOffsetY = 0;
 
+  if (CharValue != (CHAR16) (-1) && FontPackage->GlyphIndex != NULL) {
+    Entry = GlyphIndexLookup (FontPackage->GlyphIndex, CharValue);
+    if (Entry == NULL) {
+      return EFI_NOT_FOUND;
+    }
+    return WriteOutputParam (
+             Entry->Bitmap,
+             BITMAP_LEN_1_BIT (Entry->Cell.Width, Entry->Cell.Height),
+             &Entry->Cell,
+             GlyphBuffer,
+             Cell,
+             GlyphBufferLen
+             );
+  }
+
   if (CharValue == (CHAR16) (-1)) {
     //
     // Collect the cell information specified in font package fixed header.
@@ -918,6 +1337,242 @@ FindGlyphBlock (
 }
 
 
+/**
+  Record the bitmap of a character in a character to glyph index.
+
+  This is a internal function.
+
+  @param  GlyphIndex              The index to update.
+  @param  CharValue               Unicode character value.
+  @param  Bitmap                  Bitmap data of the glyph in the glyph blocks.
+  @param  Cell                    Cell information of the glyph.
+
+  @retval EFI_SUCCESS             The glyph is recorded.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+EFI_STATUS
+GlyphIndexAdd (
+  IN  HII_GLYPH_INDEX_ENTRY          **GlyphIndex,
+  IN  CHAR16                         CharValue,
+  IN  UINT8                          *Bitmap,
+  IN  EFI_HII_GLYPH_INFO             *Cell
+  )
+{
+  HII_GLYPH_INDEX_ENTRY               *Entry;
+
+  Entry = GlyphIndexGetEntry (GlyphIndex, CharValue);
+  if (Entry == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Entry->Bitmap = Bitmap;
+  CopyMem (&Entry->Cell, Cell, sizeof (EFI_HII_GLYPH_INFO));
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Build the direct character to glyph index of a font package so that
+  FindGlyphBlock() does not need to walk the glyph blocks for each lookup.
+
+  @param  FontPackage             Hii font package instance.
+
+  @retval EFI_SUCCESS             The index is built.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task. FindGlyphBlock() falls back to walking
+                                  the glyph blocks.
+
+**/
+EFI_STATUS
+BuildGlyphIndex (
+  IN OUT HII_FONT_PACKAGE_INSTANCE   *FontPackage
+  )
+{
+  EFI_STATUS                          Status;
+  HII_GLYPH_INDEX_ENTRY               **GlyphIndex;
+  HII_GLYPH_INDEX_ENTRY               *Entry;
+  HII_GLYPH_INDEX_ENTRY               *Target;
+  UINT8                               *BlockPtr;
+  UINT16                              CharCurrent;
+  UINT16                              Length16;
+  UINT32                              Length32;
+  EFI_HII_GIBT_GLYPHS_BLOCK           Glyphs;
+  UINTN                               BufferLen;
+  UINT16                              Index;
+  UINTN                               Page;
+  UINTN                               Pass;
+  BOOLEAN                             Resolved;
+  EFI_HII_GLYPH_INFO                  LocalCell;
+
+  ASSERT (FontPackage != NULL);
+  ASSERT (FontPackage->Signature == HII_FONT_PACKAGE_SIGNATURE);
+
+  FreeGlyphIndex (&FontPackage->GlyphIndex);
+
+  GlyphIndex = AllocateZeroPool (HII_GLYPH_INDEX_PAGE_COUNT * sizeof (HII_GLYPH_INDEX_ENTRY *));
+  if (GlyphIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status      = EFI_SUCCESS;
+  BlockPtr    = FontPackage->GlyphBlock;
+  CharCurrent = 1;
+
+  while (*BlockPtr != EFI_HII_GIBT_END && !EFI_ERROR (Status)) {
+    switch (*BlockPtr) {
+    case EFI_HII_GIBT_DEFAULTS:
+      BlockPtr += sizeof (EFI_HII_GIBT_DEFAULTS_BLOCK);
+      break;
+
+    case EFI_HII_GIBT_DUPLICATE:
+      //
+      // The duplicated character may come later in the glyph blocks, so it is
+      // resolved once all glyphs are known.
+      //
+      Entry = GlyphIndexGetEntry (GlyphIndex, CharCurrent);
+      if (Entry == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+      CopyMem (&Entry->Duplicate, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (CHAR16));
+      CharCurrent++;
+      BlockPtr += sizeof (EFI_HII_GIBT_DUPLICATE_BLOCK);
+      break;
+
+    case EFI_HII_GIBT_EXT1:
+      BlockPtr += *(UINT8*)((UINTN)BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8));
+      break;
+    case EFI_HII_GIBT_EXT2:
+      CopyMem (
+        &Length16,
+        (UINT8*)((UINTN)BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8)),
+        sizeof (UINT16)
+        );
+      BlockPtr += Length16;
+      break;
+    case EFI_HII_GIBT_EXT4:
+      CopyMem (
+        &Length32,
+        (UINT8*)((UINTN)BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK) + sizeof (UINT8)),
+        sizeof (UINT32)
+        );
+      BlockPtr += Length32;
+      break;
+
+    case EFI_HII_GIBT_GLYPH:
+      CopyMem (
+        &LocalCell,
+        BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK),
+        sizeof (EFI_HII_GLYPH_INFO)
+        );
+      BufferLen = BITMAP_LEN_1_BIT (LocalCell.Width, LocalCell.Height);
+      Status = GlyphIndexAdd (
+                 GlyphIndex,
+                 CharCurrent,
+                 (UINT8*)((UINTN)BlockPtr + sizeof (EFI_HII_GIBT_GLYPH_BLOCK) - sizeof (UINT8)),
+                 &LocalCell
+                 );
+      CharCurrent++;
+      BlockPtr += sizeof (EFI_HII_GIBT_GLYPH_BLOCK) - sizeof (UINT8) + BufferLen;
+      break;
+
+    case EFI_HII_GIBT_GLYPHS:
+      BlockPtr += sizeof (EFI_HII_GLYPH_BLOCK);
+      CopyMem (&Glyphs.Cell, BlockPtr, sizeof (EFI_HII_GLYPH_INFO));
+      BlockPtr += sizeof (EFI_HII_GLYPH_INFO);
+      CopyMem (&Glyphs.Count, BlockPtr, sizeof (UINT16));
+      BlockPtr += sizeof (UINT16);
+
+      BufferLen = BITMAP_LEN_1_BIT (Glyphs.Cell.Width, Glyphs.Cell.Height);
+      for (Index = 0; Index < Glyphs.Count && !EFI_ERROR (Status); Index++) {
+        Status = GlyphIndexAdd (GlyphIndex, (CHAR16) (CharCurrent + Index), BlockPtr, &Glyphs.Cell);
+        BlockPtr += BufferLen;
+      }
+      CharCurrent = (UINT16) (CharCurrent + Glyphs.Count);
+      break;
+
+    case EFI_HII_GIBT_GLYPH_DEFAULT:
+      Status = GetCell (CharCurrent, &FontPackage->GlyphInfoList, &LocalCell);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      BufferLen = BITMAP_LEN_1_BIT (LocalCell.Width, LocalCell.Height);
+      Status = GlyphIndexAdd (GlyphIndex, CharCurrent, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), &LocalCell);
+      CharCurrent++;
+      BlockPtr += sizeof (EFI_HII_GLYPH_BLOCK) + BufferLen;
+      break;
+
+    case EFI_HII_GIBT_GLYPHS_DEFAULT:
+      CopyMem (&Length16, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (UINT16));
+      Status = GetCell (CharCurrent, &FontPackage->GlyphInfoList, &LocalCell);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      BufferLen = BITMAP_LEN_1_BIT (LocalCell.Width, LocalCell.Height);
+      BlockPtr += sizeof (EFI_HII_GIBT_GLYPHS_DEFAULT_BLOCK) - sizeof (UINT8);
+      for (Index = 0; Index < Length16 && !EFI_ERROR (Status); Index++) {
+        Status = GlyphIndexAdd (GlyphIndex, (CHAR16) (CharCurrent + Index), BlockPtr, &LocalCell);
+        BlockPtr += BufferLen;
+      }
+      CharCurrent = (UINT16) (CharCurrent + Length16);
+      break;
+
+    case EFI_HII_GIBT_SKIP1:
+      CharCurrent = (UINT16) (CharCurrent + (UINT16) (*(BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK))));
+      BlockPtr    += sizeof (EFI_HII_GIBT_SKIP1_BLOCK);
+      break;
+    case EFI_HII_GIBT_SKIP2:
+      CopyMem (&Length16, BlockPtr + sizeof (EFI_HII_GLYPH_BLOCK), sizeof (UINT16));
+      CharCurrent = (UINT16) (CharCurrent + Length16);
+      BlockPtr    += sizeof (EFI_HII_GIBT_SKIP2_BLOCK);
+      break;
+    default:
+      ASSERT (FALSE);
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreeGlyphIndex (&GlyphIndex);
+    return Status;
+  }
+
+  //
+  // Resolve EFI_HII_GIBT_DUPLICATE blocks. A duplicate may refer to another
+  // duplicate, so repeat until nothing changes. Duplicates whose target is not
+  // defined stay without a glyph.
+  //
+  for (Pass = 0; Pass < HII_GLYPH_INDEX_PAGE_COUNT; Pass++) {
+    Resolved = FALSE;
+    for (Page = 0; Page < HII_GLYPH_INDEX_PAGE_COUNT; Page++) {
+      if (GlyphIndex[Page] == NULL) {
+        continue;
+      }
+      for (Index = 0; Index < HII_GLYPH_INDEX_PAGE_SIZE; Index++) {
+        Entry = &GlyphIndex[Page][Index];
+        if (Entry->Bitmap != NULL || Entry->Duplicate == 0) {
+          continue;
+        }
+        Target = GlyphIndexLookup (GlyphIndex, Entry->Duplicate);
+        if (Target != NULL) {
+          Entry->Bitmap    = Target->Bitmap;
+          Entry->Duplicate = 0;
+          CopyMem (&Entry->Cell, &Target->Cell, sizeof (EFI_HII_GLYPH_INFO));
+          Resolved = TRUE;
+        }
+      }
+    }
+    if (!Resolved) {
+      break;
+    }
+  }
+
+  FontPackage->GlyphIndex = GlyphIndex;
+  return EFI_SUCCESS;
+}
+
+
 /**
   Copy a Font Name to a new created EFI_FONT_INFO structure.
 
@@ -40,6 +40,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/PcdLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PerformanceLib.h>
 
 #define MAX_STRING_LENGTH                  1024
 #define MAX_FONT_NAME_LEN                  256
@@ -183,6 +184,19 @@ typedef struct _HII_SIMPLE_FONT_PACKAGE_INSTANCE {
   LIST_ENTRY                            SimpleFontEntry;
 } HII_SIMPLE_FONT_PACKAGE_INSTANCE;
 
+//
+// Direct character to glyph index. The index is split into pages of 256
+// characters which are only allocated when at least one glyph falls in them.
+//
+#define HII_GLYPH_INDEX_PAGE_COUNT      256
+#define HII_GLYPH_INDEX_PAGE_SIZE       256
+
+typedef struct _HII_GLYPH_INDEX_ENTRY {
+  UINT8                                 *Bitmap;    // NULL if no glyph is defined
+  EFI_HII_GLYPH_INFO                    Cell;
+  CHAR16                                Duplicate;  // Pending EFI_HII_GIBT_DUPLICATE target
+} HII_GLYPH_INDEX_ENTRY;
+
 //
 // Font Package definitions
 //
@@ -195,6 +209,7 @@ typedef struct _HII_FONT_PACKAGE_INSTANCE {
   UINT8                                 *GlyphBlock;
   LIST_ENTRY                            FontEntry;
   LIST_ENTRY                            GlyphInfoList;
+  HII_GLYPH_INDEX_ENTRY                 **GlyphIndex;
 } HII_FONT_PACKAGE_INSTANCE;
 
 #define HII_GLYPH_INFO_SIGNATURE        SIGNATURE_32 ('h','g','i','s')
@@ -256,6 +271,28 @@ typedef struct _HII_GUID_PACKAGE_INSTANCE {
   LIST_ENTRY                            GuidEntry;
 } HII_GUID_PACKAGE_INSTANCE;
 
+//
+// Varstore information cached per package list. It is used by the config
+// routing code to match a <ConfigHdr> against the package list without
+// exporting and walking its form packages again.
+//
+typedef struct {
+  EFI_STRING                            ConfigHdr;   // "GUID=...&NAME=..." of the varstore
+  EFI_IFR_OP_HEADER                     *VarStoreOp; // Copy of the varstore opcode
+  BOOLEAN                               BeforeForm;  // Varstore is declared before the first form
+} HII_VARSTORE_HDR_CACHE_ENTRY;
+
+//
+// Questions and default stores of a varstore parsed from the form packages of
+// a package list, kept for the requests that ask for the whole varstore.
+//
+typedef struct {
+  LIST_ENTRY                            Entry;
+  EFI_STRING                            ConfigHdr;       // "GUID=...&NAME=..." of the request, NULL for the first varstore
+  IFR_VARSTORAGE_DATA                   *VarStorageData;
+  IFR_DEFAULT_DATA                      *DefaultIdArray;
+} HII_QUESTION_TABLE_CACHE_ENTRY;
+
 //
 // A package list can contain only one or less than one device path package.
 // This rule also applies to image package since ImageId can not be duplicate.
@@ -270,6 +307,10 @@ typedef struct _HII_DATABASE_PACKAGE_LIST_INSTANCE {
   HII_IMAGE_PACKAGE_INSTANCE            *ImagePkg;
   LIST_ENTRY                            SimpleFontPkgHdr;
   UINT8                                 *DevicePathPkg;
+  HII_VARSTORE_HDR_CACHE_ENTRY          *VarStoreHdrCache;
+  UINTN                                 VarStoreHdrCount;
+  BOOLEAN                               VarStoreHdrCacheValid;
+  LIST_ENTRY                            QuestionTableCache;
 } HII_DATABASE_PACKAGE_LIST_INSTANCE;
 
 #define HII_HANDLE_SIGNATURE            SIGNATURE_32 ('h','i','h','l')
@@ -540,6 +581,45 @@ FindStringBlock (
   );
 
 
+/**
+  Build the direct character to glyph index of a font package so that
+  FindGlyphBlock() does not need to walk the glyph blocks for each lookup.
+
+  @param  FontPackage             Hii font package instance.
+
+  @retval EFI_SUCCESS             The index is built.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task. FindGlyphBlock() falls back to walking
+                                  the glyph blocks.
+
+**/
+EFI_STATUS
+BuildGlyphIndex (
+  IN OUT HII_FONT_PACKAGE_INSTANCE   *FontPackage
+  );
+
+/**
+  Free a character to glyph index.
+
+  @param  GlyphIndex              Pointer to the index to free, set to NULL on
+                                  return.
+
+**/
+VOID
+FreeGlyphIndex (
+  IN OUT HII_GLYPH_INDEX_ENTRY       ***GlyphIndex
+  );
+
+/**
+  Discard the character to glyph index of the simple font packages. It is
+  rebuilt on the next lookup.
+
+**/
+VOID
+InvalidateSimpleGlyphIndex (
+  VOID
+  );
+
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
   If CharValue = (CHAR16) (-1), collect all default character cell information
@@ -2315,6 +2395,21 @@ GetSupportedLanguages (
   IN EFI_HII_HANDLE           HiiHandle
   );
 
+/**
+  Free the varstore <ConfigHdr> cache and the question table cache of a
+  package list.
+
+  It must be called whenever form packages are added to or removed from the
+  package list, and before the package list itself is freed.
+
+  @param  PackageList            The package list whose cache is freed.
+
+**/
+VOID
+FreeVarStoreHdrCache (
+  IN OUT HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList
+  );
+
 /**
 This function mainly use to get HiiDatabase information.
 
@@ -2343,10 +2438,43 @@ HiiGetConfigRespInfo (
   IN CONST EFI_HII_DATABASE_PROTOCOL        *This
   );
 
+/**
+  Mark the exported HiiDatabase information as out of date and signal the
+  export event, so that the changes made before the TPL drops below
+  TPL_CALLBACK are exported once.
+
+  The caller must hold mHiiDatabaseLock.
+
+**/
+VOID
+HiiRequestDatabaseExport (
+  VOID
+  );
+
+/**
+  Export notification handler.
+
+  Export the HiiDatabase information, and the ConfigResp string if form
+  packages were changed, since the last successful export.
+
+  @param[in]  Event     Event whose notification function is being invoked
+  @param[in]  Context   Pointer to the notification function's context
+
+**/
+VOID
+EFIAPI
+HiiExportNotify (
+  IN      EFI_EVENT                         Event,
+  IN      VOID                              *Context
+  );
+
 //
 // Global variables
 //
 extern EFI_EVENT gHiiKeyboardLayoutChanged;
+extern EFI_EVENT gHiiExportEvent;
 extern BOOLEAN   gExportAfterReadyToBoot;
+extern BOOLEAN   gExportConfigResp;
+extern BOOLEAN   gDatabaseInfoDirty;
 
 #endif
@@ -14,7 +14,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Global variables
 //
 EFI_EVENT gHiiKeyboardLayoutChanged;
+EFI_EVENT gHiiExportEvent = NULL;
 BOOLEAN   gExportAfterReadyToBoot = FALSE;
+BOOLEAN   gDatabaseInfoDirty = FALSE;
 
 HII_DATABASE_PRIVATE_DATA mPrivate = {
   HII_DATABASE_PRIVATE_DATA_SIGNATURE,
@@ -145,6 +147,72 @@ OnReadyToBoot (
   gBS->CloseEvent (Event);
 }
 
+/**
+  Mark the exported HiiDatabase information as out of date and signal the
+  export event, so that the changes made before the TPL drops below
+  TPL_CALLBACK are exported once.
+
+  The caller must hold mHiiDatabaseLock.
+
+**/
+VOID
+HiiRequestDatabaseExport (
+  VOID
+  )
+{
+  gDatabaseInfoDirty = TRUE;
+  gBS->SignalEvent (gHiiExportEvent);
+}
+
+/**
+  Export notification handler.
+
+  Export the HiiDatabase information, and the ConfigResp string if form
+  packages were changed, since the last successful export.
+
+  @param[in]  Event     Event whose notification function is being invoked
+  @param[in]  Context   Pointer to the notification function's context
+
+**/
+VOID
+EFIAPI
+HiiExportNotify (
+  IN      EFI_EVENT                         Event,
+  IN      VOID                              *Context
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // HiiGetDatabaseInfo () will get the contents of HII data base,
+  // belong to the atomic behavior of Hii Database update.
+  // A failed export stays pending and is retried after the next change.
+  //
+  EfiAcquireLock (&mHiiDatabaseLock);
+  if (gDatabaseInfoDirty) {
+    Status = HiiGetDatabaseInfo (&mPrivate.HiiDatabase);
+    if (!EFI_ERROR (Status)) {
+      gDatabaseInfoDirty = FALSE;
+    }
+  }
+  EfiReleaseLock (&mHiiDatabaseLock);
+
+  //
+  // HiiGetConfigRespInfo () will get the configuration setting info from HII drivers,
+  // we can not think it belong to the atomic behavior of Hii Database update.
+  // That's why it is called after EfiReleaseLock (&mHiiDatabaseLock).
+  // The HII drivers may change form packages meanwhile, so the flag is cleared
+  // before the export, and set again if the export fails.
+  //
+  if (gExportConfigResp) {
+    gExportConfigResp = FALSE;
+    Status = HiiGetConfigRespInfo (&mPrivate.HiiDatabase);
+    if (EFI_ERROR (Status)) {
+      gExportConfigResp = TRUE;
+    }
+  }
+}
+
 /**
   Initialize HII Database.
 
@@ -235,6 +303,24 @@ InitializeHiiDatabase (
   }
 
   if (FeaturePcdGet(PcdHiiOsRuntimeSupport)) {
+    //
+    // Package list changes after ReadyToBoot mark the exported data as out
+    // of date and signal this event. Changes made at TPL_CALLBACK or above,
+    // as by notification functions or by the HII drivers called back during
+    // an export, are exported once when the TPL drops. A change made at
+    // TPL_APPLICATION is still exported when the call that made it returns.
+    //
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    HiiExportNotify,
+                    NULL,
+                    &gHiiExportEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
     Status = EfiCreateEventReadyToBootEx (
                TPL_CALLBACK,
                OnReadyToBoot,
@@ -796,7 +796,7 @@ HiiNewImage (
   // Only after ReadyToBoot to do the export.
   //
   if (gExportAfterReadyToBoot) {
-    HiiGetDatabaseInfo(&Private->HiiDatabase);
+    HiiRequestDatabaseExport ();
   }
 
   EfiReleaseLock (&mHiiDatabaseLock);
@@ -1215,7 +1215,7 @@ HiiSetImage (
   // Only after ReadyToBoot to do the export.
   //
   if (gExportAfterReadyToBoot) {
-    HiiGetDatabaseInfo(&Private->HiiDatabase);
+    HiiRequestDatabaseExport ();
   }
 
   EfiReleaseLock (&mHiiDatabaseLock);
@@ -1572,7 +1572,7 @@ Done:
   //
   if (gExportAfterReadyToBoot) {
     if (!EFI_ERROR (Status)) {
-      HiiGetDatabaseInfo(&Private->HiiDatabase);
+      HiiRequestDatabaseExport ();
     }
   }
 
@@ -1780,7 +1780,7 @@ HiiSetString (
         // Only after ReadyToBoot to do the export.
         //
         if (gExportAfterReadyToBoot) {
-          HiiGetDatabaseInfo(&Private->HiiDatabase);
+          HiiRequestDatabaseExport ();
         }
         EfiReleaseLock (&mHiiDatabaseLock);
         return EFI_SUCCESS;
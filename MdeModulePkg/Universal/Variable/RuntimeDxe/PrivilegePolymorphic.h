@@ -139,6 +139,27 @@ VariableSmmIsBufferOutsideSmmValid (
   IN UINT64                Length
   );
 
+/**
+  Make the update sequence odd before a variable is changed.
+
+  Readers outside SMRAM that see an odd sequence, or a sequence different from
+  the one their copy of the variable names was taken at, discard that copy.
+
+**/
+VOID
+BeginVariableUpdate (
+  VOID
+  );
+
+/**
+  Make the update sequence even again after a variable has been changed.
+
+**/
+VOID
+EndVariableUpdate (
+  VOID
+  );
+
 /**
   Whether the TCG or TCG2 protocols are installed in the UEFI protocol database.
   This information is used by the MorLock code to infer whether an existing
@@ -482,6 +482,7 @@ MorLockInitAtEndOfDxe (
       ));
 
     mMorPassThru = TRUE;
+    BeginVariableUpdate ();
     VariableServiceSetVariable (
       MEMORY_OVERWRITE_REQUEST_VARIABLE_NAME,
       &gEfiMemoryOverwriteControlDataGuid,
@@ -489,6 +490,7 @@ MorLockInitAtEndOfDxe (
       0,                                      // DataSize
       NULL                                    // Data
       );
+    EndVariableUpdate ();
     mMorPassThru = FALSE;
   }
 
@@ -521,6 +523,7 @@ MorLockInitAtEndOfDxe (
   // reason) and prevent other modules from creating it.
   //
   mMorLockPassThru = TRUE;
+  BeginVariableUpdate ();
   VariableServiceSetVariable (
     MEMORY_OVERWRITE_REQUEST_CONTROL_LOCK_NAME,
     &gEfiMemoryOverwriteRequestControlLockGuid,
@@ -528,6 +531,7 @@ MorLockInitAtEndOfDxe (
     0,                                          // DataSize
     NULL                                        // Data
     );
+  EndVariableUpdate ();
   mMorLockPassThru = FALSE;
 
   NewPolicy = NULL;
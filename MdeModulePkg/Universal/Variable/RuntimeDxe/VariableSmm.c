@@ -39,6 +39,7 @@ extern VARIABLE_STORE_HEADER                         *mNvVariableCache;
 BOOLEAN                                              mAtRuntime              = FALSE;
 UINT8                                                *mVariableBufferPayload = NULL;
 UINTN                                                mVariableBufferPayloadSize;
+volatile UINT32                                      *mVariableUpdateSequence = NULL;
 
 /**
   SecureBoot Hook for SetVariable.
@@ -57,6 +58,39 @@ SecureBootHook (
   return ;
 }
 
+/**
+  Make the update sequence odd before a variable is changed.
+
+  Readers outside SMRAM that see an odd sequence, or a sequence different from
+  the one their copy of the variable names was taken at, discard that copy.
+
+**/
+VOID
+BeginVariableUpdate (
+  VOID
+  )
+{
+  if (mVariableUpdateSequence != NULL) {
+    *mVariableUpdateSequence = *mVariableUpdateSequence + 1;
+    MemoryFence ();
+  }
+}
+
+/**
+  Make the update sequence even again after a variable has been changed.
+
+**/
+VOID
+EndVariableUpdate (
+  VOID
+  )
+{
+  if (mVariableUpdateSequence != NULL) {
+    MemoryFence ();
+    *mVariableUpdateSequence = *mVariableUpdateSequence + 1;
+  }
+}
+
 /**
 
   This code sets variable in storage blocks (Volatile or Non-Volatile).
@@ -91,6 +125,7 @@ SmmVariableSetVariable (
   // Disable write protection when the calling SetVariable() through EFI_SMM_VARIABLE_PROTOCOL.
   //
   mRequestSource = VarCheckFromTrusted;
+  BeginVariableUpdate ();
   Status         = VariableServiceSetVariable (
                      VariableName,
                      VendorGuid,
@@ -98,6 +133,7 @@ SmmVariableSetVariable (
                      DataSize,
                      Data
                      );
+  EndVariableUpdate ();
   mRequestSource = VarCheckFromUntrusted;
   return Status;
 }
@@ -425,6 +461,87 @@ SmmVariableGetStatistics (
   return EFI_SUCCESS;
 }
 
+/**
+  Pack the names of the variables that follow a given variable into the payload
+  of one GetNextVariableName batch request.
+
+  Caution: This function may receive untrusted input.
+  Batch is a copy of the communicate buffer payload in SMRAM. The caller has
+  checked that the start variable name fits in PayloadSize and is a
+  Null-terminated string.
+
+  @param[in, out]  Batch          The batch request. On output, the entries hold
+                                  the variables that follow the start variable.
+  @param[in]       PayloadSize    The size of the payload Batch points to.
+
+  @retval EFI_SUCCESS             At least one entry was packed, or EndOfList is
+                                  TRUE.
+  @retval EFI_BUFFER_TOO_SMALL    The name of the next variable does not fit in
+                                  the payload.
+  @retval Others                  VariableServiceGetNextVariableName() failed
+                                  before an entry was packed.
+
+**/
+EFI_STATUS
+SmmVariableGetNextVariableNameBatch (
+  IN OUT SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH  *Batch,
+  IN     UINTN                                                  PayloadSize
+  )
+{
+  EFI_STATUS                       Status;
+  SMM_VARIABLE_NAME_BATCH_ENTRY    *Entry;
+  CHAR16                           *PreviousName;
+  EFI_GUID                         *PreviousGuid;
+  UINTN                            PreviousNameSize;
+  UINTN                            NameSize;
+  UINTN                            Offset;
+
+  Batch->EntriesSize = 0;
+  Batch->Count       = 0;
+  Batch->EndOfList   = FALSE;
+  Batch->Sequence    = (mVariableUpdateSequence != NULL) ? *mVariableUpdateSequence : 0;
+
+  PreviousName     = Batch->Name;
+  PreviousGuid     = &Batch->Guid;
+  PreviousNameSize = Batch->NameSize;
+  Offset           = SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (Batch->NameSize);
+  Status           = EFI_BUFFER_TOO_SMALL;
+
+  while (Offset + OFFSET_OF (SMM_VARIABLE_NAME_BATCH_ENTRY, Name) + PreviousNameSize <= PayloadSize) {
+    //
+    // Each entry is filled in place: the previous name is copied into it and
+    // replaced by the name of the variable that follows.
+    //
+    Entry    = (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Batch + Offset);
+    NameSize = PayloadSize - Offset - OFFSET_OF (SMM_VARIABLE_NAME_BATCH_ENTRY, Name);
+    CopyGuid (&Entry->Guid, PreviousGuid);
+    CopyMem (Entry->Name, PreviousName, PreviousNameSize);
+
+    Status = VariableServiceGetNextVariableName (&NameSize, Entry->Name, &Entry->Guid);
+    if (Status == EFI_NOT_FOUND) {
+      Batch->EndOfList = TRUE;
+      Status           = EFI_SUCCESS;
+      break;
+    }
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Entry->NameSize  = (UINT32) NameSize;
+    Entry->Reserved  = 0;
+    Batch->Count++;
+    PreviousName     = Entry->Name;
+    PreviousGuid     = &Entry->Guid;
+    PreviousNameSize = NameSize;
+    Offset          += SMM_VARIABLE_NAME_BATCH_ENTRY_SIZE (NameSize);
+    Batch->EntriesSize = MIN (Offset, PayloadSize) - SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (Batch->NameSize);
+  }
+
+  if (Batch->Count > 0) {
+    return EFI_SUCCESS;
+  }
+  return Status;
+}
 
 /**
   Communication service SMI Handler entry.
@@ -465,6 +582,8 @@ SmmVariableHandler (
   SMM_VARIABLE_COMMUNICATE_HEADER                         *SmmVariableFunctionHeader;
   SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE                *SmmVariableHeader;
   SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME         *GetNextVariableName;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH   *GetNextVariableNameBatch;
+  SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE                *UpdateSequence;
   SMM_VARIABLE_COMMUNICATE_QUERY_VARIABLE_INFO            *QueryVariableInfo;
   SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE               *GetPayloadSize;
   SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT *RuntimeVariableCacheContext;
@@ -604,6 +723,53 @@ SmmVariableHandler (
       CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
       break;
 
+    case SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME_BATCH:
+      if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH, Name)) {
+        DEBUG ((DEBUG_ERROR, "GetNextVariableNameBatch: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      //
+      // Copy the input communicate buffer payload to pre-allocated SMM variable buffer payload.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      GetNextVariableNameBatch = (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *) mVariableBufferPayload;
+      if ((UINTN)(~0) - GetNextVariableNameBatch->NameSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH, Name)) {
+        //
+        // Prevent InfoSize overflow happen
+        //
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+      InfoSize = OFFSET_OF(SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH, Name) + GetNextVariableNameBatch->NameSize;
+
+      //
+      // SMRAM range check already covered before
+      //
+      if (InfoSize > CommBufferPayloadSize) {
+        DEBUG ((DEBUG_ERROR, "GetNextVariableNameBatch: Data size exceed communication buffer size limit!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      //
+      // The VariableSpeculationBarrier() call here is to ensure the previous
+      // range/content checks for the CommBuffer have been completed before the
+      // subsequent consumption of the CommBuffer content.
+      //
+      VariableSpeculationBarrier ();
+      if (GetNextVariableNameBatch->NameSize < sizeof (CHAR16) ||
+          GetNextVariableNameBatch->Name[GetNextVariableNameBatch->NameSize/sizeof (CHAR16) - 1] != L'\0') {
+        //
+        // Make sure input VariableName is A Null-terminated string.
+        //
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      Status = SmmVariableGetNextVariableNameBatch (GetNextVariableNameBatch, CommBufferPayloadSize);
+      CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
+      break;
+
     case SMM_VARIABLE_FUNCTION_SET_VARIABLE:
       if (CommBufferPayloadSize < OFFSET_OF(SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name)) {
         DEBUG ((EFI_D_ERROR, "SetVariable: SMM communication buffer size invalid!\n"));
@@ -649,6 +815,7 @@ SmmVariableHandler (
         goto EXIT;
       }
 
+      BeginVariableUpdate ();
       Status = VariableServiceSetVariable (
                  SmmVariableHeader->Name,
                  &SmmVariableHeader->Guid,
@@ -656,6 +823,7 @@ SmmVariableHandler (
                  SmmVariableHeader->DataSize,
                  (UINT8 *)SmmVariableHeader->Name + SmmVariableHeader->NameSize
                  );
+      EndVariableUpdate ();
       break;
 
     case SMM_VARIABLE_FUNCTION_QUERY_VARIABLE_INFO:
@@ -704,7 +872,13 @@ SmmVariableHandler (
       break;
 
     case SMM_VARIABLE_FUNCTION_EXIT_BOOT_SERVICE:
+      //
+      // GetNextVariableName() hides the boot service variables from now on,
+      // so the batches of variable names taken before are discarded.
+      //
+      BeginVariableUpdate ();
       mAtRuntime = TRUE;
+      EndVariableUpdate ();
       Status = EFI_SUCCESS;
       break;
 
@@ -925,6 +1099,33 @@ SmmVariableHandler (
     case SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE:
       Status = FlushPendingRuntimeVariableCacheUpdates ();
       break;
+    case SMM_VARIABLE_FUNCTION_INIT_UPDATE_SEQUENCE:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE)) {
+        DEBUG ((DEBUG_ERROR, "InitUpdateSequence: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      if (mEndOfDxe) {
+        DEBUG ((DEBUG_ERROR, "InitUpdateSequence: Cannot init update sequence after end of DXE!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+      //
+      // Copy the input communicate buffer payload to the pre-allocated SMM variable payload buffer.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      UpdateSequence = (SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE *) mVariableBufferPayload;
+      if (UpdateSequence->UpdateSequence == NULL ||
+          !VariableSmmIsBufferOutsideSmmValid (
+            (UINTN) UpdateSequence->UpdateSequence,
+            sizeof (*(UpdateSequence->UpdateSequence)))) {
+        DEBUG ((DEBUG_ERROR, "InitUpdateSequence: Update sequence buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+      mVariableUpdateSequence  = UpdateSequence->UpdateSequence;
+      *mVariableUpdateSequence = 0;
+      Status = EFI_SUCCESS;
+      break;
     case SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO:
       if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO)) {
         DEBUG ((DEBUG_ERROR, "GetRuntimeCacheInfo: SMM communication buffer size invalid!\n"));
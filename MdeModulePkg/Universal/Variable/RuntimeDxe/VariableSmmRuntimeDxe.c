@@ -61,6 +61,12 @@ BOOLEAN                          mVariableRuntimeCachePendingUpdate;
 BOOLEAN                          mVariableRuntimeCacheReadLock;
 BOOLEAN                          mVariableAuthFormat;
 BOOLEAN                          mHobFlushComplete;
+volatile UINT32                  mVariableUpdateSequence;
+UINT8                           *mVariableNameBatchBuffer         = NULL;
+UINT8                           *mVariableNameBatchBufferPhysical = NULL;
+BOOLEAN                          mVariableNameBatchValid;
+UINTN                            mVariableNameBatchCursor;
+UINT32                           mVariableNameBatchCursorIndex;
 EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
@@ -1012,6 +1018,299 @@ Done:
   return Status;
 }
 
+/**
+  Return the GetNextVariableName batch request in the batch communicate buffer.
+
+  @return The batch request.
+
+**/
+SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *
+GetVariableNameBatch (
+  VOID
+  )
+{
+  EFI_MM_COMMUNICATE_HEADER                 *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER           *SmmVariableFunctionHeader;
+
+  SmmCommunicateHeader      = (EFI_MM_COMMUNICATE_HEADER *) mVariableNameBatchBuffer;
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  return (SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *) SmmVariableFunctionHeader->Data;
+}
+
+/**
+  Fetch the names of the variables that follow a variable into the batch
+  communicate buffer, using one SMI.
+
+  The entries are used in place from the batch communicate buffer until the SMM
+  variable driver changes a variable.
+
+  @param[in] VariableName            The variable to start after. An empty name
+                                     starts at the first variable.
+  @param[in] VendorGuid              The vendor GUID of VariableName.
+
+  @retval EFI_SUCCESS                At least one entry was fetched, or there is
+                                     no variable after VariableName.
+  @retval EFI_INVALID_PARAMETER      VariableName does not fit in the payload.
+  @retval Others                     The SMM variable driver could not return a
+                                     batch.
+
+**/
+EFI_STATUS
+FetchVariableNameBatch (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid
+  )
+{
+  EFI_STATUS                                            Status;
+  EFI_MM_COMMUNICATE_HEADER                             *SmmCommunicateHeader;
+  SMM_VARIABLE_COMMUNICATE_HEADER                       *SmmVariableFunctionHeader;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *SmmGetNextVariableNameBatch;
+  UINTN                                                 InVariableNameSize;
+  UINTN                                                 EntriesOffset;
+  UINTN                                                 CommSize;
+
+  mVariableNameBatchValid = FALSE;
+
+  InVariableNameSize = StrSize (VariableName);
+  EntriesOffset      = SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (InVariableNameSize);
+  if (EntriesOffset > mVariableBufferPayloadSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SmmCommunicateHeader = (EFI_MM_COMMUNICATE_HEADER *) mVariableNameBatchBuffer;
+  CopyGuid (&SmmCommunicateHeader->HeaderGuid, &gEfiSmmVariableProtocolGuid);
+  SmmCommunicateHeader->MessageLength = SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + mVariableBufferPayloadSize;
+
+  SmmVariableFunctionHeader = (SMM_VARIABLE_COMMUNICATE_HEADER *) SmmCommunicateHeader->Data;
+  SmmVariableFunctionHeader->Function = SMM_VARIABLE_FUNCTION_GET_NEXT_VARIABLE_NAME_BATCH;
+
+  SmmGetNextVariableNameBatch = GetVariableNameBatch ();
+  CopyGuid (&SmmGetNextVariableNameBatch->Guid, VendorGuid);
+  SmmGetNextVariableNameBatch->NameSize = InVariableNameSize;
+  CopyMem (SmmGetNextVariableNameBatch->Name, VariableName, InVariableNameSize);
+
+  //
+  // Send data to SMM. The entries are written straight into the batch
+  // communicate buffer and are not copied again.
+  //
+  CommSize = SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + mVariableBufferPayloadSize;
+  Status = mMmCommunication2->Communicate (
+                                mMmCommunication2,
+                                mVariableNameBatchBufferPhysical,
+                                mVariableNameBatchBuffer,
+                                &CommSize
+                                );
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = SmmVariableFunctionHeader->ReturnStatus;
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (SmmGetNextVariableNameBatch->EntriesSize > mVariableBufferPayloadSize - EntriesOffset) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  mVariableNameBatchCursor      = 0;
+  mVariableNameBatchCursorIndex = 0;
+  mVariableNameBatchValid       = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the variable that follows a variable in the batch of variable names.
+
+  @param[in]  VariableName           The variable to start after. An empty name
+                                     starts at the first variable.
+  @param[in]  VendorGuid             The vendor GUID of VariableName.
+  @param[out] Index                  The index of the returned entry in the batch.
+  @param[out] EndOfList              TRUE if the batch shows that there is no
+                                     variable after VariableName.
+
+  @return The entry of the variable that follows VariableName, or NULL if the
+          batch does not have it.
+
+**/
+SMM_VARIABLE_NAME_BATCH_ENTRY *
+FindNextInVariableNameBatch (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid,
+  OUT     UINT32                            *Index,
+  OUT     BOOLEAN                           *EndOfList
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *Batch;
+  SMM_VARIABLE_NAME_BATCH_ENTRY                         *Entries;
+  SMM_VARIABLE_NAME_BATCH_ENTRY                         *Entry;
+  UINTN                                                 NameSize;
+  UINT32                                                Sequence;
+  UINT32                                                EntryIndex;
+
+  *Index     = 0;
+  *EndOfList = FALSE;
+
+  //
+  // The batch is only current while the SMM variable driver has not started
+  // or finished a variable update since it was fetched.
+  //
+  Sequence = mVariableUpdateSequence;
+  Batch    = GetVariableNameBatch ();
+  if (!mVariableNameBatchValid || (Sequence & BIT0) != 0 || Sequence != Batch->Sequence) {
+    return NULL;
+  }
+
+  Entries = (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Batch + SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (Batch->NameSize));
+  if (VariableName[0] == L'\0') {
+    if (Batch->Name[0] != L'\0') {
+      return NULL;
+    }
+    if (Batch->Count == 0) {
+      *EndOfList = Batch->EndOfList;
+      return NULL;
+    }
+    return Entries;
+  }
+
+  //
+  // Callers enumerate in order, so the variable is most likely the entry that
+  // was returned last.
+  //
+  NameSize   = StrSize (VariableName);
+  Entry      = (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Entries + mVariableNameBatchCursor);
+  EntryIndex = mVariableNameBatchCursorIndex;
+  if (EntryIndex >= Batch->Count ||
+      Entry->NameSize != NameSize ||
+      !CompareGuid (&Entry->Guid, VendorGuid) ||
+      CompareMem (Entry->Name, VariableName, NameSize) != 0) {
+    Entry = Entries;
+    for (EntryIndex = 0; EntryIndex < Batch->Count; EntryIndex++) {
+      if (Entry->NameSize == NameSize &&
+          CompareGuid (&Entry->Guid, VendorGuid) &&
+          CompareMem (Entry->Name, VariableName, NameSize) == 0) {
+        break;
+      }
+      Entry = (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Entry + SMM_VARIABLE_NAME_BATCH_ENTRY_SIZE (Entry->NameSize));
+    }
+    if (EntryIndex == Batch->Count) {
+      return NULL;
+    }
+  }
+
+  if (EntryIndex + 1 == Batch->Count) {
+    *EndOfList = Batch->EndOfList;
+    return NULL;
+  }
+  *Index = EntryIndex + 1;
+  return (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Entry + SMM_VARIABLE_NAME_BATCH_ENTRY_SIZE (Entry->NameSize));
+}
+
+/**
+  Finds the next available variable from a batch of variable names fetched
+  from the SMM variable store.
+
+  A new batch is only fetched when the current batch does not hold the next
+  variable, or when a variable has been changed since it was fetched.
+
+  @param[in, out] VariableNameSize   Size of the variable name.
+  @param[in, out] VariableName       Pointer to variable name.
+  @param[in, out] VendorGuid         Variable Vendor Guid.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+
+**/
+EFI_STATUS
+GetNextVariableNameInBatch (
+  IN OUT  UINTN                             *VariableNameSize,
+  IN OUT  CHAR16                            *VariableName,
+  IN OUT  EFI_GUID                          *VendorGuid
+  )
+{
+  EFI_STATUS                                            Status;
+  SMM_VARIABLE_COMMUNICATE_GET_NEXT_VARIABLE_NAME_BATCH *Batch;
+  SMM_VARIABLE_NAME_BATCH_ENTRY                         *Entry;
+  UINT32                                                Index;
+  BOOLEAN                                               EndOfList;
+
+  Entry = FindNextInVariableNameBatch (VariableName, VendorGuid, &Index, &EndOfList);
+  if (Entry == NULL && !EndOfList) {
+    Status = FetchVariableNameBatch (VariableName, VendorGuid);
+    if (EFI_ERROR (Status)) {
+      //
+      // The SMM variable driver reports errors such as an unknown start
+      // variable, or a name that does not fit in a batch, the same way as
+      // for a single variable request.
+      //
+      return GetNextVariableNameInSmm (VariableNameSize, VariableName, VendorGuid);
+    }
+    Batch = GetVariableNameBatch ();
+    Index = 0;
+    if (Batch->Count > 0) {
+      Entry = (SMM_VARIABLE_NAME_BATCH_ENTRY *) ((UINT8 *) Batch + SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (Batch->NameSize));
+    }
+  }
+
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Entry->NameSize > *VariableNameSize) {
+    *VariableNameSize = Entry->NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  CopyMem (VariableName, Entry->Name, Entry->NameSize);
+  CopyGuid (VendorGuid, &Entry->Guid);
+  *VariableNameSize = Entry->NameSize;
+
+  Batch = GetVariableNameBatch ();
+  mVariableNameBatchCursor      = (UINTN) Entry - ((UINTN) Batch + SMM_VARIABLE_NAME_BATCH_ENTRIES_OFFSET (Batch->NameSize));
+  mVariableNameBatchCursorIndex = Index;
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate the batch communicate buffer and share the update sequence with the
+  SMM variable driver.
+
+  If the SMM variable driver does not support the update sequence, no batch is
+  used and GetNextVariableName() sends one request per variable.
+
+**/
+VOID
+InitVariableNameBatch (
+  VOID
+  )
+{
+  EFI_STATUS                                Status;
+  SMM_VARIABLE_COMMUNICATE_UPDATE_SEQUENCE  *SmmUpdateSequence;
+
+  mVariableNameBatchBuffer = AllocateRuntimePool (mVariableBufferSize);
+  if (mVariableNameBatchBuffer == NULL) {
+    return;
+  }
+  mVariableNameBatchBufferPhysical = mVariableNameBatchBuffer;
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+  Status = InitCommunicateBuffer ((VOID **) &SmmUpdateSequence, sizeof (*SmmUpdateSequence), SMM_VARIABLE_FUNCTION_INIT_UPDATE_SEQUENCE);
+  if (!EFI_ERROR (Status)) {
+    SmmUpdateSequence->UpdateSequence = (UINT32 *) &mVariableUpdateSequence;
+    Status = SendCommunicateBuffer (sizeof (*SmmUpdateSequence));
+  }
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "Variable driver GetNextVariableName batch is not supported - %r\n", Status));
+    FreePool (mVariableNameBatchBuffer);
+    mVariableNameBatchBuffer         = NULL;
+    mVariableNameBatchBufferPhysical = NULL;
+  }
+}
+
 /**
   This code Finds the Next available variable.
 
@@ -1057,6 +1356,8 @@ RuntimeServiceGetNextVariableName (
   AcquireLockOnlyAtBootTime (&mVariableServicesLock);
   if (FeaturePcdGet (PcdEnableVariableRuntimeCache)) {
     Status = GetNextVariableNameInRuntimeCache (VariableNameSize, VariableName, VendorGuid);
+  } else if (mVariableNameBatchBuffer != NULL) {
+    Status = GetNextVariableNameInBatch (VariableNameSize, VariableName, VendorGuid);
   } else {
     Status = GetNextVariableNameInSmm (VariableNameSize, VariableName, VendorGuid);
   }
@@ -1250,6 +1551,12 @@ OnExitBootServices (
   IN      VOID                              *Context
   )
 {
+  //
+  // The batch of variable names may hold boot service variables, which must
+  // not be returned at runtime.
+  //
+  mVariableNameBatchValid = FALSE;
+
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE.
@@ -1327,6 +1634,7 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeVolatileCacheBuffer);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableNameBatchBuffer);
 }
 
 /**
@@ -1628,6 +1936,7 @@ SmmVariableReady (
     ASSERT_EFI_ERROR (Status);
   } else {
     DEBUG ((DEBUG_INFO, "Variable driver runtime cache is disabled.\n"));
+    InitVariableNameBatch ();
   }
 
   gRT->GetVariable         = RuntimeServiceGetVariable;
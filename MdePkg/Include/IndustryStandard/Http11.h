@@ -76,6 +76,20 @@
 ///
 #define HTTP_HEADER_ACCEPT_RANGES      "Accept-Ranges"
 
+///
+/// Range Request Header
+/// The Range request-header field allows the client to request only
+/// one or more sub-ranges of the entity, instead of the entire entity.
+///
+#define HTTP_HEADER_RANGE              "Range"
+
+///
+/// Content-Range Header
+/// The Content-Range entity-header is sent with a partial entity-body
+/// to specify where in the full entity-body the partial body should be applied.
+///
+#define HTTP_HEADER_CONTENT_RANGE      "Content-Range"
+
 
 ///
 /// Accept-Encoding Request Header
@@ -0,0 +1,852 @@
+/** @file
+  Produce EFI_BLOCK_IO_PROTOCOL on a boot image read over HTTP on demand.
+
+  Instead of downloading the whole image into a RAM disk before it is booted,
+  the blocks are requested in byte ranges as the partition and file system
+  drivers read them, and kept in a cache of PcdHttpBootBlockCacheSize bytes.
+
+  The reads wait for the HTTP responses, so the block device may only be called
+  at TPL_CALLBACK or below. The reads share one connection and the cache, so a
+  read issued while another one is in progress, from an event notification
+  function, fails with EFI_NOT_READY.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpBootDxe.h"
+
+//
+// The EFI_BLOCK_IO_PROTOCOL instance that is installed onto the handle
+// of the block device.
+//
+EFI_BLOCK_IO_PROTOCOL  mHttpBootBlockIoTemplate = {
+  EFI_BLOCK_IO_PROTOCOL_REVISION,
+  (EFI_BLOCK_IO_MEDIA *) 0,
+  HttpBootBlockIoReset,
+  HttpBootBlockIoReadBlocks,
+  HttpBootBlockIoWriteBlocks,
+  HttpBootBlockIoFlushBlocks
+};
+
+//
+// The EFI_BLOCK_IO2_PROTOCOL instance that is installed onto the handle
+// of the block device.
+//
+EFI_BLOCK_IO2_PROTOCOL  mHttpBootBlockIo2Template = {
+  (EFI_BLOCK_IO_MEDIA *) 0,
+  HttpBootBlockIo2Reset,
+  HttpBootBlockIo2ReadBlocksEx,
+  HttpBootBlockIo2WriteBlocksEx,
+  HttpBootBlockIo2FlushBlocksEx
+};
+
+/**
+  Find the cache line holding the image data at Offset.
+
+  @param[in]  Device         The block device.
+  @param[in]  Offset         The offset of the cache line in the image.
+
+  @return The cache line, or NULL if the data is not cached.
+
+**/
+HTTP_BOOT_CACHE_LINE *
+HttpBootFindCacheLine (
+  IN HTTP_BOOT_BLOCK_DEVICE       *Device,
+  IN UINTN                        Offset
+  )
+{
+  UINTN                           Index;
+
+  for (Index = 0; Index < Device->LineCount; Index++) {
+    if (Device->Lines[Index].Offset == Offset) {
+      return &Device->Lines[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Take the least recently used cache line to hold the image data at Offset.
+
+  @param[in]  Device         The block device.
+  @param[in]  Offset         The offset of the cache line in the image.
+
+  @return The cache line, or NULL if its buffer could not be allocated.
+
+**/
+HTTP_BOOT_CACHE_LINE *
+HttpBootAllocateCacheLine (
+  IN HTTP_BOOT_BLOCK_DEVICE       *Device,
+  IN UINTN                        Offset
+  )
+{
+  HTTP_BOOT_CACHE_LINE            *Line;
+  HTTP_BOOT_CACHE_LINE            *Victim;
+  UINTN                           Index;
+
+  Victim = NULL;
+  for (Index = 0; Index < Device->LineCount; Index++) {
+    Line = &Device->Lines[Index];
+    if (Line->Offset == HTTP_BOOT_CACHE_LINE_EMPTY) {
+      Victim = Line;
+      break;
+    }
+    if (Victim == NULL || Line->LastUse < Victim->LastUse) {
+      Victim = Line;
+    }
+  }
+
+  //
+  // The buffers are allocated as the lines are first used, so the memory used
+  // grows with the data read rather than with the size of the cache.
+  //
+  if (Victim->Data == NULL) {
+    Victim->Data = AllocatePool (HTTP_BOOT_CACHE_LINE_SIZE);
+    if (Victim->Data == NULL) {
+      return NULL;
+    }
+  }
+
+  Victim->Offset  = Offset;
+  Victim->LastUse = ++Device->UseCount;
+  return Victim;
+}
+
+/**
+  Read the cache line holding the image data at Offset from the server, and
+  the following lines if the image is read sequentially.
+
+  @param[in]   Device        The block device.
+  @param[in]   Offset        The offset of the cache line in the image.
+  @param[out]  Line          The cache line read.
+
+  @retval EFI_SUCCESS            The cache line was read.
+  @retval EFI_UNSUPPORTED        The server did not answer with the requested range.
+  @retval EFI_OUT_OF_RESOURCES   Could not allocate the cache line.
+  @retval Others                 Failed to read the data from the server.
+
+**/
+EFI_STATUS
+HttpBootFillCache (
+  IN     HTTP_BOOT_BLOCK_DEVICE   *Device,
+  IN     UINTN                    Offset,
+     OUT HTTP_BOOT_CACHE_LINE     **Line
+  )
+{
+  EFI_STATUS                      Status;
+  HTTP_BOOT_CACHE_LINE            *Run[HTTP_BOOT_READ_AHEAD_MAX / HTTP_BOOT_CACHE_LINE_SIZE];
+  UINTN                           RunCount;
+  UINTN                           RunOffset;
+  UINTN                           Length;
+  UINTN                           Index;
+  UINTN                           Retry;
+
+  //
+  // Double the read-ahead while the misses follow the last range requested,
+  // so that reading a large file takes a few large ranges, and go back to a
+  // single line on a random access.
+  //
+  if (Offset == Device->NextOffset) {
+    Device->ReadAheadLines = MIN (Device->ReadAheadLines * 2, Device->MaxReadAheadLines);
+  } else {
+    Device->ReadAheadLines = 1;
+  }
+
+  //
+  // The range ends at the end of the image, or before a line already cached.
+  //
+  RunCount  = 0;
+  RunOffset = Offset;
+  while (RunCount < Device->ReadAheadLines && RunOffset < Device->ImageSize) {
+    if (RunCount != 0 && HttpBootFindCacheLine (Device, RunOffset) != NULL) {
+      break;
+    }
+    Run[RunCount] = HttpBootAllocateCacheLine (Device, RunOffset);
+    if (Run[RunCount] == NULL) {
+      break;
+    }
+    RunCount++;
+    RunOffset += HTTP_BOOT_CACHE_LINE_SIZE;
+  }
+  if (RunCount == 0) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Length = MIN (RunOffset, Device->ImageSize) - Offset;
+
+  //
+  // The server may have closed the connection since the last range, so a
+  // failed request is retried once on a new connection.
+  //
+  Status = EFI_SUCCESS;
+  for (Retry = 0; Retry < 2; Retry++) {
+    if (!Device->Connection.HttpCreated) {
+      Status = HttpBootInitSegment (Device->Private, &Device->Connection, Device->Url, Device->HostName);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    Status = HttpBootRequestSegment (&Device->Connection, Offset, Length);
+    if (!EFI_ERROR (Status) || Status == EFI_UNSUPPORTED) {
+      break;
+    }
+    HttpBootFreeSegment (&Device->Connection);
+  }
+
+  for (Index = 0; Index < RunCount && !EFI_ERROR (Status); Index++) {
+    Status = HttpBootReadSegment (
+               &Device->Connection,
+               Run[Index]->Data,
+               MIN (HTTP_BOOT_CACHE_LINE_SIZE, Length - Index * HTTP_BOOT_CACHE_LINE_SIZE)
+               );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "HttpBootFillCache: Failed to read %Lu bytes at %Lu - %r\n", (UINT64) Length, (UINT64) Offset, Status));
+    for (Index = 0; Index < RunCount; Index++) {
+      Run[Index]->Offset  = HTTP_BOOT_CACHE_LINE_EMPTY;
+      Run[Index]->LastUse = 0;
+    }
+    HttpBootFreeSegment (&Device->Connection);
+    Device->NextOffset = HTTP_BOOT_CACHE_LINE_EMPTY;
+    return Status;
+  }
+
+  Device->NextOffset = Offset + Length;
+  *Line = Run[0];
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy BufferSize bytes of the image at Offset into Buffer, reading the data
+  missing from the cache from the server.
+
+  @param[in]   Device        The block device.
+  @param[in]   Offset        The offset of the data in the image.
+  @param[in]   BufferSize    The number of bytes to read.
+  @param[out]  Buffer        The buffer to copy the data to.
+
+  @retval EFI_SUCCESS        The data was read.
+  @retval Others             Failed to read the data from the server.
+
+**/
+EFI_STATUS
+HttpBootReadImage (
+  IN     HTTP_BOOT_BLOCK_DEVICE   *Device,
+  IN     UINTN                    Offset,
+  IN     UINTN                    BufferSize,
+     OUT UINT8                    *Buffer
+  )
+{
+  EFI_STATUS                      Status;
+  HTTP_BOOT_CACHE_LINE            *Line;
+  UINTN                           LineOffset;
+  UINTN                           CopySize;
+
+  while (BufferSize > 0) {
+    LineOffset = Offset & ~((UINTN) HTTP_BOOT_CACHE_LINE_SIZE - 1);
+    Line = HttpBootFindCacheLine (Device, LineOffset);
+    if (Line == NULL) {
+      Status = HttpBootFillCache (Device, LineOffset, &Line);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+    Line->LastUse = ++Device->UseCount;
+
+    CopySize = MIN (BufferSize, LineOffset + HTTP_BOOT_CACHE_LINE_SIZE - Offset);
+    CopyMem (Buffer, Line->Data + (Offset - LineOffset), CopySize);
+    Offset     += CopySize;
+    Buffer     += CopySize;
+    BufferSize -= CopySize;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the resources of a block device that is not installed.
+
+  @param[in]   Device        The block device.
+
+**/
+VOID
+HttpBootFreeBlockDevice (
+  IN HTTP_BOOT_BLOCK_DEVICE       *Device
+  )
+{
+  UINTN                           Index;
+
+  HttpBootFreeSegment (&Device->Connection);
+
+  if (Device->Lines != NULL) {
+    for (Index = 0; Index < Device->LineCount; Index++) {
+      if (Device->Lines[Index].Data != NULL) {
+        FreePool (Device->Lines[Index].Data);
+      }
+    }
+    FreePool (Device->Lines);
+  }
+  if (Device->Url != NULL) {
+    FreePool (Device->Url);
+  }
+  if (Device->HostName != NULL) {
+    FreePool (Device->HostName);
+  }
+  if (Device->DevicePath != NULL) {
+    FreePool (Device->DevicePath);
+  }
+
+  FreePool (Device);
+}
+
+/**
+  Create a block device reading the boot image over HTTP on demand, instead of
+  downloading the whole image into a RAM disk. The block device is enabled by
+  PcdHttpBootBlockCacheSize, and needs a server answering range requests.
+
+  @param[in]   Private         The pointer to the driver's private data.
+  @param[in]   ImageType       The image type of the boot file.
+
+  @retval EFI_SUCCESS          The block device was created, or already exists.
+  @retval EFI_UNSUPPORTED      The block device is disabled, or the server does not
+                               answer range requests for the boot file.
+  @retval Others               Failed to create the block device.
+
+**/
+EFI_STATUS
+HttpBootCreateBlockDevice (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_BOOT_IMAGE_TYPE         ImageType
+  )
+{
+  EFI_STATUS                      Status;
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+  HTTP_BOOT_CACHE_LINE            *Line;
+  EFI_BLOCK_IO_MEDIA              *Media;
+  VENDOR_DEVICE_PATH              VendorNode;
+  UINTN                           UrlSize;
+  UINTN                           Index;
+  UINT32                          Remainder;
+
+  ASSERT (Private != NULL);
+
+  if (Private->BlockDevice != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if (PcdGet32 (PcdHttpBootBlockCacheSize) == 0 ||
+      !Private->AcceptRanges ||
+      Private->BootFileSize == 0 ||
+      (ImageType != ImageTypeVirtualCd && ImageType != ImageTypeVirtualDisk)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Device = AllocateZeroPool (sizeof (HTTP_BOOT_BLOCK_DEVICE));
+  if (Device == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Device->Signature  = HTTP_BOOT_BLOCK_DEVICE_SIGNATURE;
+  Device->Private    = Private;
+  Device->ImageSize  = Private->BootFileSize;
+  Device->NextOffset = HTTP_BOOT_CACHE_LINE_EMPTY;
+
+  UrlSize = AsciiStrSize (Private->BootFileUri);
+  Device->Url = AllocatePool (UrlSize * sizeof (CHAR16));
+  if (Device->Url == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_ERROR;
+  }
+  AsciiStrToUnicodeStrS (Private->BootFileUri, Device->Url, UrlSize);
+
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &Device->HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  //
+  // Keep at least two lines, and read ahead into no more than half of them,
+  // so that a read-ahead does not evict the lines it is reading.
+  //
+  Device->LineCount = MAX (PcdGet32 (PcdHttpBootBlockCacheSize) / HTTP_BOOT_CACHE_LINE_SIZE, 2);
+  Device->Lines = AllocatePool (Device->LineCount * sizeof (HTTP_BOOT_CACHE_LINE));
+  if (Device->Lines == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_ERROR;
+  }
+  for (Index = 0; Index < Device->LineCount; Index++) {
+    Device->Lines[Index].Offset  = HTTP_BOOT_CACHE_LINE_EMPTY;
+    Device->Lines[Index].LastUse = 0;
+    Device->Lines[Index].Data    = NULL;
+  }
+  Device->ReadAheadLines    = 1;
+  Device->MaxReadAheadLines = MIN (HTTP_BOOT_READ_AHEAD_MAX / HTTP_BOOT_CACHE_LINE_SIZE, Device->LineCount / 2);
+
+  //
+  // Read the first line of the image, so that a server not answering the
+  // range requests is detected before the block device is installed, and
+  // the image is downloaded into a RAM disk instead.
+  //
+  Status = HttpBootFillCache (Device, 0, &Line);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  CopyMem (&Device->BlockIo, &mHttpBootBlockIoTemplate, sizeof (EFI_BLOCK_IO_PROTOCOL));
+  CopyMem (&Device->BlockIo2, &mHttpBootBlockIo2Template, sizeof (EFI_BLOCK_IO2_PROTOCOL));
+
+  Media                   = &Device->Media;
+  Device->BlockIo.Media   = Media;
+  Device->BlockIo2.Media  = Media;
+  Media->RemovableMedia   = FALSE;
+  Media->MediaPresent     = TRUE;
+  Media->LogicalPartition = FALSE;
+  Media->ReadOnly         = TRUE;
+  Media->WriteCaching     = FALSE;
+
+  for (Media->BlockSize = HTTP_BOOT_DEFAULT_BLOCK_SIZE;
+       Media->BlockSize >= 1;
+       Media->BlockSize = Media->BlockSize >> 1) {
+    Media->LastBlock = DivU64x32Remainder (Device->ImageSize, Media->BlockSize, &Remainder) - 1;
+    if (Remainder == 0) {
+      break;
+    }
+  }
+  ASSERT (Media->BlockSize != 0);
+
+  //
+  // The image is a child of the virtual NIC, the same as the RAM disk it
+  // would otherwise be downloaded to.
+  //
+  VendorNode.Header.Type    = MEDIA_DEVICE_PATH;
+  VendorNode.Header.SubType = MEDIA_VENDOR_DP;
+  SetDevicePathNodeLength (&VendorNode.Header, sizeof (VENDOR_DEVICE_PATH));
+  CopyGuid (&VendorNode.Guid, (ImageType == ImageTypeVirtualCd) ? &gEfiVirtualCdGuid : &gEfiVirtualDiskGuid);
+  Device->DevicePath = AppendDevicePathNode (
+                         Private->UsingIpv6 ? Private->Ip6Nic->DevicePath : Private->Ip4Nic->DevicePath,
+                         (EFI_DEVICE_PATH_PROTOCOL *) &VendorNode
+                         );
+  if (Device->DevicePath == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_ERROR;
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Device->Handle,
+                  &gEfiDevicePathProtocolGuid,
+                  Device->DevicePath,
+                  &gEfiBlockIoProtocolGuid,
+                  &Device->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &Device->BlockIo2,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Private->BlockDevice = Device;
+  gBS->ConnectController (Device->Handle, NULL, NULL, TRUE);
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  DEBUG ((DEBUG_INFO, "HTTP Boot: Reading the image on demand is not possible - %r\n", Status));
+  HttpBootFreeBlockDevice (Device);
+  return Status;
+}
+
+/**
+  Check whether FilePath asks for the boot image to be read on demand through
+  a block device, instead of being loaded into the buffer given to LoadFile().
+  The request is a vendor media node with the virtual CD or disk GUID.
+
+  @param[in]   FilePath        The device specific path of the file to load.
+  @param[out]  ImageType       The image type of the block device requested.
+
+  @retval TRUE                 FilePath asks for a block device.
+  @retval FALSE                FilePath does not ask for a block device.
+
+**/
+BOOLEAN
+HttpBootIsBlockDeviceRequest (
+  IN     EFI_DEVICE_PATH_PROTOCOL     *FilePath,
+     OUT HTTP_BOOT_IMAGE_TYPE         *ImageType
+  )
+{
+  VENDOR_DEVICE_PATH              *VendorNode;
+
+  for (; !IsDevicePathEnd (FilePath); FilePath = NextDevicePathNode (FilePath)) {
+    if ((DevicePathType (FilePath) != MEDIA_DEVICE_PATH) ||
+        (DevicePathSubType (FilePath) != MEDIA_VENDOR_DP) ||
+        (DevicePathNodeLength (FilePath) < sizeof (VENDOR_DEVICE_PATH))) {
+      continue;
+    }
+
+    VendorNode = (VENDOR_DEVICE_PATH *) FilePath;
+    if (CompareGuid (&VendorNode->Guid, &gEfiVirtualCdGuid)) {
+      *ImageType = ImageTypeVirtualCd;
+      return TRUE;
+    }
+    if (CompareGuid (&VendorNode->Guid, &gEfiVirtualDiskGuid)) {
+      *ImageType = ImageTypeVirtualDisk;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Uninstall and free the block device created by HttpBootCreateBlockDevice().
+
+  @param[in]   Private         The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          The block device was destroyed, or there is none.
+  @retval Others               The block device is still in use.
+
+**/
+EFI_STATUS
+HttpBootDestroyBlockDevice (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  )
+{
+  EFI_STATUS                      Status;
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+
+  Device = Private->BlockDevice;
+  if (Device == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (
+                  Device->Handle,
+                  &gEfiDevicePathProtocolGuid,
+                  Device->DevicePath,
+                  &gEfiBlockIoProtocolGuid,
+                  &Device->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &Device->BlockIo2,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Private->BlockDevice = NULL;
+  HttpBootFreeBlockDevice (Device);
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the Block Device.
+
+  @param[in]  This                 Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification Driver may perform diagnostics on reset.
+
+  @retval EFI_SUCCESS          The device was reset.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN BOOLEAN                      ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Read BufferSize bytes from Lba into Buffer. The data is read through the
+  network stack, so this must be called at TPL_CALLBACK or below.
+
+  @param[in]  This           Indicates a pointer to the calling context.
+  @param[in]  MediaId        Id of the media, changes every time the media is
+                             replaced.
+  @param[in]  Lba            The starting Logical Block Address to read from.
+  @param[in]  BufferSize     Size of Buffer, must be a multiple of device block
+                             size.
+  @param[out] Buffer         A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS             The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR        The data could not be read from the server.
+  @retval EFI_MEDIA_CHANGED       The MediaId does not matched the current
+                                  device.
+  @retval EFI_BAD_BUFFER_SIZE     The Buffer was not a multiple of the block
+                                  size of the device.
+  @retval EFI_INVALID_PARAMETER   The read request contains LBAs that are not
+                                  valid, or the buffer is not on proper alignment.
+  @retval EFI_NOT_READY           Another read is in progress on the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoReadBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN EFI_LBA                      Lba,
+  IN UINTN                        BufferSize,
+  OUT VOID                        *Buffer
+  )
+{
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+  UINTN                           NumberOfBlocks;
+  EFI_STATUS                      Status;
+
+  Device = HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO (This);
+
+  if (MediaId != Device->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (BufferSize == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if ((BufferSize % Device->Media.BlockSize) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if (Lba > Device->Media.LastBlock) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NumberOfBlocks = BufferSize / Device->Media.BlockSize;
+  if ((Lba + NumberOfBlocks - 1) > Device->Media.LastBlock) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Device->InUse) {
+    return EFI_NOT_READY;
+  }
+
+  Device->InUse = TRUE;
+  Status = HttpBootReadImage (
+             Device,
+             (UINTN) MultU64x32 (Lba, Device->Media.BlockSize),
+             BufferSize,
+             Buffer
+             );
+  Device->InUse = FALSE;
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Write BufferSize bytes from Buffer into Lba. The image is read-only.
+
+  @param[in] This            Indicates a pointer to the calling context.
+  @param[in] MediaId         The media ID that the write request is for.
+  @param[in] Lba             The starting logical block address to be written.
+  @param[in] BufferSize      Size of Buffer, must be a multiple of device block
+                             size.
+  @param[in] Buffer          A pointer to the source buffer for the data.
+
+  @retval EFI_WRITE_PROTECTED     The device can not be written to.
+  @retval EFI_MEDIA_CHANGED       The MediaId does not matched the current
+                                  device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN EFI_LBA                      Lba,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  )
+{
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+
+  Device = HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO (This);
+
+  if (MediaId != Device->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+  Flush the Block Device.
+
+  @param[in] This            Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS        All outstanding data was written to the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Resets the block device hardware.
+
+  @param[in] This                 The pointer of EFI_BLOCK_IO2_PROTOCOL.
+  @param[in] ExtendedVerification The flag about if extend verificate.
+
+  @retval EFI_SUCCESS             The device was reset.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2Reset (
+  IN EFI_BLOCK_IO2_PROTOCOL       *This,
+  IN BOOLEAN                      ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads the requested number of blocks from the device. The read completes
+  before the function returns, and Token->Event is signaled if given. This
+  must be called at TPL_CALLBACK or below.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in]      MediaId         The media ID that the read request is for.
+  @param[in]      Lba             The starting logical block address to read
+                                  from on the device.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+  @param[in]      BufferSize      The size of the Buffer in bytes. This must be
+                                  a multiple of the intrinsic block size of the
+                                  device.
+  @param[out]     Buffer          A pointer to the destination buffer for the
+                                  data.
+
+  @retval EFI_SUCCESS             The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR        The data could not be read from the server.
+  @retval EFI_MEDIA_CHANGED       The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE     The BufferSize parameter is not a multiple of
+                                  the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER   The read request contains LBAs that are not
+                                  valid, or the buffer is not on proper
+                                  alignment.
+  @retval EFI_NOT_READY           Another read is in progress on the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2ReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+     OUT VOID                     *Buffer
+  )
+{
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+  EFI_STATUS                      Status;
+
+  Device = HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO2 (This);
+
+  Status = HttpBootBlockIoReadBlocks (
+             &Device->BlockIo,
+             MediaId,
+             Lba,
+             BufferSize,
+             Buffer
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // If caller's event is given, signal it after the read completes.
+  //
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Writes a specified number of blocks to the device. The image is read-only.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in]      MediaId         The media ID that the write request is for.
+  @param[in]      Lba             The starting logical block address to be
+                                  written.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+  @param[in]      BufferSize      The size in bytes of Buffer.
+  @param[in]      Buffer          A pointer to the source buffer for the data.
+
+  @retval EFI_WRITE_PROTECTED     The device cannot be written to.
+  @retval EFI_MEDIA_CHANGED       The MediaId is not for the current media.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2WriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+  IN     VOID                     *Buffer
+  )
+{
+  HTTP_BOOT_BLOCK_DEVICE          *Device;
+
+  Device = HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO2 (This);
+
+  return HttpBootBlockIoWriteBlocks (
+           &Device->BlockIo,
+           MediaId,
+           Lba,
+           BufferSize,
+           Buffer
+           );
+}
+
+/**
+  Flushes all modified data to a physical block device.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+
+  @retval EFI_SUCCESS             All outstanding data was written to the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2FlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token
+  )
+{
+  //
+  // The image is read-only, there is no data to flush.
+  //
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,309 @@
+/** @file
+  Declaration of the block device reading a boot image over HTTP on demand.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_BLOCK_IO_H__
+#define __EFI_HTTP_BOOT_BLOCK_IO_H__
+
+#define HTTP_BOOT_BLOCK_DEVICE_SIGNATURE     SIGNATURE_32 ('H', 'B', 'B', 'D')
+#define HTTP_BOOT_DEFAULT_BLOCK_SIZE         512
+
+//
+// The image is read in cache lines of this size. Sequential reads make the
+// block device read ahead up to HTTP_BOOT_READ_AHEAD_MAX bytes in one range
+// request.
+//
+#define HTTP_BOOT_CACHE_LINE_SIZE            SIZE_64KB
+#define HTTP_BOOT_READ_AHEAD_MAX             SIZE_4MB
+#define HTTP_BOOT_CACHE_LINE_EMPTY           MAX_UINTN
+
+//
+// A cache line holding HTTP_BOOT_CACHE_LINE_SIZE bytes of the image.
+//
+typedef struct {
+  UINTN                           Offset;       // Offset of the line in the image, HTTP_BOOT_CACHE_LINE_EMPTY if unused.
+  UINT64                          LastUse;      // Use count of the last read hitting the line.
+  UINT8                           *Data;
+} HTTP_BOOT_CACHE_LINE;
+
+struct _HTTP_BOOT_BLOCK_DEVICE {
+  UINT32                          Signature;
+  EFI_HANDLE                      Handle;
+  EFI_DEVICE_PATH_PROTOCOL        *DevicePath;
+  EFI_BLOCK_IO_PROTOCOL           BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL          BlockIo2;
+  EFI_BLOCK_IO_MEDIA              Media;
+
+  //
+  // The connection the image is read on, opened again when the server
+  // closes it.
+  //
+  HTTP_BOOT_PRIVATE_DATA          *Private;
+  HTTP_BOOT_SEGMENT               Connection;
+  CHAR16                          *Url;
+  CHAR8                           *HostName;
+  UINTN                           ImageSize;
+
+  //
+  // The cache lines, replaced in least recently used order.
+  //
+  HTTP_BOOT_CACHE_LINE            *Lines;
+  UINTN                           LineCount;
+  UINT64                          UseCount;
+  UINTN                           ReadAheadLines;
+  UINTN                           MaxReadAheadLines;
+  UINTN                           NextOffset;   // Offset following the last range requested.
+
+  //
+  // Set while a read uses the connection and the cache, so that a read issued
+  // from an event notification function in the meantime fails.
+  //
+  BOOLEAN                         InUse;
+};
+
+#define HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO(a)   CR (a, HTTP_BOOT_BLOCK_DEVICE, BlockIo, HTTP_BOOT_BLOCK_DEVICE_SIGNATURE)
+#define HTTP_BOOT_BLOCK_DEVICE_FROM_BLOCK_IO2(a)  CR (a, HTTP_BOOT_BLOCK_DEVICE, BlockIo2, HTTP_BOOT_BLOCK_DEVICE_SIGNATURE)
+
+/**
+  Create a block device reading the boot image over HTTP on demand, instead of
+  downloading the whole image into a RAM disk. The block device is enabled by
+  PcdHttpBootBlockCacheSize, and needs a server answering range requests.
+
+  @param[in]   Private         The pointer to the driver's private data.
+  @param[in]   ImageType       The image type of the boot file.
+
+  @retval EFI_SUCCESS          The block device was created, or already exists.
+  @retval EFI_UNSUPPORTED      The block device is disabled, or the server does not
+                               answer range requests for the boot file.
+  @retval Others               Failed to create the block device.
+
+**/
+EFI_STATUS
+HttpBootCreateBlockDevice (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_BOOT_IMAGE_TYPE         ImageType
+  );
+
+/**
+  Check whether FilePath asks for the boot image to be read on demand through
+  a block device, instead of being loaded into the buffer given to LoadFile().
+  The request is a vendor media node with the virtual CD or disk GUID.
+
+  @param[in]   FilePath        The device specific path of the file to load.
+  @param[out]  ImageType       The image type of the block device requested.
+
+  @retval TRUE                 FilePath asks for a block device.
+  @retval FALSE                FilePath does not ask for a block device.
+
+**/
+BOOLEAN
+HttpBootIsBlockDeviceRequest (
+  IN     EFI_DEVICE_PATH_PROTOCOL     *FilePath,
+     OUT HTTP_BOOT_IMAGE_TYPE         *ImageType
+  );
+
+/**
+  Uninstall and free the block device created by HttpBootCreateBlockDevice().
+
+  @param[in]   Private         The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          The block device was destroyed, or there is none.
+  @retval Others               The block device is still in use.
+
+**/
+EFI_STATUS
+HttpBootDestroyBlockDevice (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  );
+
+/**
+  Reset the Block Device.
+
+  @param[in]  This                 Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification Driver may perform diagnostics on reset.
+
+  @retval EFI_SUCCESS          The device was reset.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN BOOLEAN                      ExtendedVerification
+  );
+
+/**
+  Read BufferSize bytes from Lba into Buffer. The data is read through the
+  network stack, so this must be called at TPL_CALLBACK or below.
+
+  @param[in]  This           Indicates a pointer to the calling context.
+  @param[in]  MediaId        Id of the media, changes every time the media is
+                             replaced.
+  @param[in]  Lba            The starting Logical Block Address to read from.
+  @param[in]  BufferSize     Size of Buffer, must be a multiple of device block
+                             size.
+  @param[out] Buffer         A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS             The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR        The data could not be read from the server.
+  @retval EFI_MEDIA_CHANGED       The MediaId does not matched the current
+                                  device.
+  @retval EFI_BAD_BUFFER_SIZE     The Buffer was not a multiple of the block
+                                  size of the device.
+  @retval EFI_INVALID_PARAMETER   The read request contains LBAs that are not
+                                  valid, or the buffer is not on proper alignment.
+  @retval EFI_NOT_READY           Another read is in progress on the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoReadBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN EFI_LBA                      Lba,
+  IN UINTN                        BufferSize,
+  OUT VOID                        *Buffer
+  );
+
+/**
+  Write BufferSize bytes from Buffer into Lba. The image is read-only.
+
+  @param[in] This            Indicates a pointer to the calling context.
+  @param[in] MediaId         The media ID that the write request is for.
+  @param[in] Lba             The starting logical block address to be written.
+  @param[in] BufferSize      Size of Buffer, must be a multiple of device block
+                             size.
+  @param[in] Buffer          A pointer to the source buffer for the data.
+
+  @retval EFI_WRITE_PROTECTED     The device can not be written to.
+  @retval EFI_MEDIA_CHANGED       The MediaId does not matched the current
+                                  device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This,
+  IN UINT32                       MediaId,
+  IN EFI_LBA                      Lba,
+  IN UINTN                        BufferSize,
+  IN VOID                         *Buffer
+  );
+
+/**
+  Flush the Block Device.
+
+  @param[in] This            Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS        All outstanding data was written to the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL        *This
+  );
+
+/**
+  Resets the block device hardware.
+
+  @param[in] This                 The pointer of EFI_BLOCK_IO2_PROTOCOL.
+  @param[in] ExtendedVerification The flag about if extend verificate.
+
+  @retval EFI_SUCCESS             The device was reset.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2Reset (
+  IN EFI_BLOCK_IO2_PROTOCOL       *This,
+  IN BOOLEAN                      ExtendedVerification
+  );
+
+/**
+  Reads the requested number of blocks from the device. The read completes
+  before the function returns, and Token->Event is signaled if given. This
+  must be called at TPL_CALLBACK or below.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in]      MediaId         The media ID that the read request is for.
+  @param[in]      Lba             The starting logical block address to read
+                                  from on the device.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+  @param[in]      BufferSize      The size of the Buffer in bytes. This must be
+                                  a multiple of the intrinsic block size of the
+                                  device.
+  @param[out]     Buffer          A pointer to the destination buffer for the
+                                  data.
+
+  @retval EFI_SUCCESS             The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR        The data could not be read from the server.
+  @retval EFI_MEDIA_CHANGED       The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE     The BufferSize parameter is not a multiple of
+                                  the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER   The read request contains LBAs that are not
+                                  valid, or the buffer is not on proper
+                                  alignment.
+  @retval EFI_NOT_READY           Another read is in progress on the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2ReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+     OUT VOID                     *Buffer
+  );
+
+/**
+  Writes a specified number of blocks to the device. The image is read-only.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in]      MediaId         The media ID that the write request is for.
+  @param[in]      Lba             The starting logical block address to be
+                                  written.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+  @param[in]      BufferSize      The size in bytes of Buffer.
+  @param[in]      Buffer          A pointer to the source buffer for the data.
+
+  @retval EFI_WRITE_PROTECTED     The device cannot be written to.
+  @retval EFI_MEDIA_CHANGED       The MediaId is not for the current media.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2WriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+  IN     VOID                     *Buffer
+  );
+
+/**
+  Flushes all modified data to a physical block device.
+
+  @param[in]      This            Indicates a pointer to the calling context.
+  @param[in, out] Token           A pointer to the token associated with the
+                                  transaction.
+
+  @retval EFI_SUCCESS             All outstanding data was written to the device.
+
+**/
+EFI_STATUS
+EFIAPI
+HttpBootBlockIo2FlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token
+  );
+
+#endif
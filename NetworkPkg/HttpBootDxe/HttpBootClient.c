@@ -580,21 +580,24 @@ HttpBootHttpIoCallback (
 }
 
 /**
-  Create a HttpIo instance for the file download.
+  Create a HttpIo instance on the station address of the boot session.
 
   @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       The callback function of the HttpIo, or NULL.
+  @param[out]   HttpIo         The HttpIo instance to create.
 
   @retval EFI_SUCCESS          Successfully created.
   @retval Others               Failed to create HttpIo.
 
 **/
 EFI_STATUS
-HttpBootCreateHttpIo (
-  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+HttpBootCreateHttpIoInstance (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback,   OPTIONAL
+     OUT HTTP_IO                      *HttpIo
   )
 {
   HTTP_IO_CONFIG_DATA          ConfigData;
-  EFI_STATUS                   Status;
   EFI_HANDLE                   ImageHandle;
 
   ASSERT (Private != NULL);
@@ -613,15 +616,36 @@ HttpBootCreateHttpIo (
     ImageHandle = Private->Ip6Nic->ImageHandle;
   }
 
-  Status = HttpIoCreateIo (
-             ImageHandle,
-             Private->Controller,
-             Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
-             &ConfigData,
-             HttpBootHttpIoCallback,
-             (VOID *) Private,
-             &Private->HttpIo
-             );
+  return HttpIoCreateIo (
+           ImageHandle,
+           Private->Controller,
+           Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
+           &ConfigData,
+           Callback,
+           (VOID *) Private,
+           HttpIo
+           );
+}
+
+/**
+  Create a HttpIo instance for the file download.
+
+  @param[in]    Private        The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootCreateHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  )
+{
+  EFI_STATUS                   Status;
+
+  ASSERT (Private != NULL);
+
+  Status = HttpBootCreateHttpIoInstance (Private, HttpBootHttpIoCallback, &Private->HttpIo);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -920,6 +944,7 @@ HttpBootGetBootFile (
   CHAR16                     *Url;
   BOOLEAN                    IdentityMode;
   UINTN                      ReceivedSize;
+  EFI_HTTP_HEADER            *HttpHeader;
 
   ASSERT (Private != NULL);
   ASSERT (Private->HttpCreated);
@@ -1103,6 +1128,13 @@ HttpBootGetBootFile (
     goto ERROR_5;
   }
 
+  //
+  // Remember whether the server accepts byte range requests, which the
+  // segmented download relies on.
+  //
+  HttpHeader = HttpFindHeader (ResponseData->HeaderCount, ResponseData->Headers, HTTP_HEADER_ACCEPT_RANGES);
+  Private->AcceptRanges = (BOOLEAN) (HttpHeader != NULL && AsciiStrStr (HttpHeader->FieldValue, "bytes") != NULL);
+
   //
   // 3.2 Cache the response header.
   //
@@ -1304,3 +1336,531 @@ ERROR_1:
   return Status;
 }
 
+/**
+  Create the HTTP child of a byte range connection, and set up the request
+  headers it sends for every range of the boot file.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[out]      Segment         The connection to initialize.
+  @param[in]       Url             The URL of the boot file.
+  @param[in]       HostName        The host name of the boot file URL.
+
+  @retval EFI_SUCCESS              The connection was initialized.
+  @retval Others                   Failed to create the HTTP child.
+
+**/
+EFI_STATUS
+HttpBootInitSegment (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+     OUT HTTP_BOOT_SEGMENT        *Segment,
+  IN     CHAR16                   *Url,
+  IN     CHAR8                    *HostName
+  )
+{
+  EFI_STATUS                 Status;
+
+  ZeroMem (Segment, sizeof (HTTP_BOOT_SEGMENT));
+
+  //
+  // No HttpIo callback is installed, the response of every range would
+  // otherwise be reported as a new file.
+  //
+  Status = HttpBootCreateHttpIoInstance (Private, NULL, &Segment->HttpIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Segment->HttpCreated    = TRUE;
+  Segment->HttpIo.Timeout = HTTP_BOOT_RESPONSE_TIMEOUT;
+
+  Segment->RequestData.Method    = HttpMethodGet;
+  Segment->RequestData.Url       = Url;
+  Segment->Headers[0].FieldName  = HTTP_HEADER_HOST;
+  Segment->Headers[0].FieldValue = HostName;
+  Segment->Headers[1].FieldName  = HTTP_HEADER_ACCEPT;
+  Segment->Headers[1].FieldValue = "*/*";
+  Segment->Headers[2].FieldName  = HTTP_HEADER_USER_AGENT;
+  Segment->Headers[2].FieldValue = HTTP_USER_AGENT_EFI_HTTP_BOOT;
+  Segment->Headers[3].FieldName  = HTTP_HEADER_RANGE;
+  Segment->Headers[3].FieldValue = Segment->Range;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Cancel the pending transfer of a byte range connection, and destroy its
+  HTTP child.
+
+  @param[in, out]  Segment         The connection to release.
+
+**/
+VOID
+HttpBootFreeSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment
+  )
+{
+  if (!Segment->HttpCreated) {
+    return;
+  }
+
+  Segment->HttpIo.Http->Cancel (Segment->HttpIo.Http, NULL);
+  HttpIoDestroyIo (&Segment->HttpIo);
+  Segment->HttpCreated = FALSE;
+  Segment->Length      = 0;
+
+  //
+  // Run the DPCs queued by the cancelled tokens before the flags they set
+  // are released with the connection.
+  //
+  DispatchDpc ();
+}
+
+/**
+  Request a byte range of the boot file on a connection, and receive the
+  response header.
+
+  @param[in, out]  Segment         The connection to request the range on.
+  @param[in]       Offset          The offset of the range in the boot file.
+  @param[in]       Length          The length of the range.
+
+  @retval EFI_SUCCESS              The server answered with the requested range, the
+                                   message-body can be received with HttpBootReadSegment().
+  @retval EFI_UNSUPPORTED          The server did not answer with the requested range.
+  @retval Others                   Failed to request the range.
+
+**/
+EFI_STATUS
+HttpBootRequestSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+  IN     UINTN                    Offset,
+  IN     UINTN                    Length
+  )
+{
+  EFI_STATUS                 Status;
+  HTTP_IO_RESPONSE_DATA      ResponseData;
+  EFI_HTTP_HEADER            *HttpHeader;
+
+  ASSERT (Length != 0);
+
+  Segment->Offset       = Offset;
+  Segment->Length       = Length;
+  Segment->ReceivedSize = 0;
+  AsciiSPrint (
+    Segment->Range,
+    sizeof (Segment->Range),
+    "bytes=%Lu-%Lu",
+    (UINT64) Offset,
+    (UINT64) (Offset + Length - 1)
+    );
+
+  Status = HttpIoSendRequest (
+             &Segment->HttpIo,
+             &Segment->RequestData,
+             HTTP_BOOT_SEGMENT_HEADER_COUNT,
+             Segment->Headers,
+             0,
+             NULL
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&ResponseData, sizeof (HTTP_IO_RESPONSE_DATA));
+  Status = HttpIoRecvResponse (&Segment->HttpIo, TRUE, &ResponseData);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // A server without range support answers with the whole file, so only a
+  // 206 response carrying exactly the requested range can be used.
+  //
+  Status = EFI_UNSUPPORTED;
+  if (!EFI_ERROR (ResponseData.Status) &&
+      ResponseData.Response.StatusCode == HTTP_STATUS_206_PARTIAL_CONTENT) {
+    HttpHeader = HttpFindHeader (ResponseData.HeaderCount, ResponseData.Headers, HTTP_HEADER_CONTENT_RANGE);
+    if (HttpHeader != NULL &&
+        AsciiStrnCmp (HttpHeader->FieldValue, "bytes ", 6) == 0 &&
+        AsciiStrDecimalToUintn (HttpHeader->FieldValue + 6) == Offset) {
+      HttpHeader = HttpFindHeader (ResponseData.HeaderCount, ResponseData.Headers, HTTP_HEADER_CONTENT_LENGTH);
+      if (HttpHeader != NULL && AsciiStrDecimalToUintn (HttpHeader->FieldValue) == Length) {
+        Status = EFI_SUCCESS;
+      }
+    }
+  }
+
+  if (ResponseData.Headers != NULL) {
+    HttpFreeHeaderFields (ResponseData.Headers, ResponseData.HeaderCount);
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "HttpBootRequestSegment: Range %a not honored by the server.\n", Segment->Range));
+  }
+
+  return Status;
+}
+
+/**
+  Queue the receive of the next part of the message-body of the range
+  requested on a connection.
+
+  @param[in, out]  Segment         The connection to receive on.
+  @param[out]      Buffer          The buffer to receive the data to.
+  @param[in]       BufferSize      The size of Buffer, no more than the rest of the range.
+
+  @retval EFI_SUCCESS              The receive was queued, the connection is polled until
+                                   its HttpIo.IsRxDone is set.
+  @retval Others                   Failed to queue the receive.
+
+**/
+EFI_STATUS
+HttpBootReceiveSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+     OUT UINT8                    *Buffer,
+  IN     UINTN                    BufferSize
+  )
+{
+  HTTP_IO                    *HttpIo;
+
+  ASSERT (BufferSize <= Segment->Length - Segment->ReceivedSize);
+
+  HttpIo = &Segment->HttpIo;
+  HttpIo->RspToken.Status                 = EFI_NOT_READY;
+  HttpIo->RspToken.Message->Data.Response = NULL;
+  HttpIo->RspToken.Message->HeaderCount   = 0;
+  HttpIo->RspToken.Message->Headers       = NULL;
+  HttpIo->RspToken.Message->BodyLength    = BufferSize;
+  HttpIo->RspToken.Message->Body          = (CHAR8 *) Buffer;
+
+  HttpIo->IsRxDone = FALSE;
+  return HttpIo->Http->Response (HttpIo->Http, &HttpIo->RspToken);
+}
+
+/**
+  Receive a part of the message-body of the range requested on a connection,
+  and wait until BufferSize bytes have arrived.
+
+  @param[in, out]  Segment         The connection to receive on.
+  @param[out]      Buffer          The buffer to receive the data to.
+  @param[in]       BufferSize      The size of Buffer, no more than the rest of the range.
+
+  @retval EFI_SUCCESS              BufferSize bytes were received.
+  @retval EFI_TIMEOUT              The server stopped sending data.
+  @retval Others                   Failed to receive the data.
+
+**/
+EFI_STATUS
+HttpBootReadSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+     OUT UINT8                    *Buffer,
+  IN     UINTN                    BufferSize
+  )
+{
+  EFI_STATUS                 Status;
+  HTTP_IO                    *HttpIo;
+  UINTN                      ReceivedSize;
+
+  HttpIo       = &Segment->HttpIo;
+  ReceivedSize = 0;
+  while (ReceivedSize < BufferSize) {
+    Status = HttpBootReceiveSegment (Segment, Buffer + ReceivedSize, BufferSize - ReceivedSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = gBS->SetTimer (HttpIo->TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    while (!HttpIo->IsRxDone && EFI_ERROR (gBS->CheckEvent (HttpIo->TimeoutEvent))) {
+      HttpIo->Http->Poll (HttpIo->Http);
+    }
+    gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+
+    if (!HttpIo->IsRxDone) {
+      HttpIo->Http->Cancel (HttpIo->Http, &HttpIo->RspToken);
+      return EFI_TIMEOUT;
+    }
+    if (EFI_ERROR (HttpIo->RspToken.Status)) {
+      return HttpIo->RspToken.Status;
+    }
+
+    ReceivedSize          += HttpIo->RspToken.Message->BodyLength;
+    Segment->ReceivedSize += HttpIo->RspToken.Message->BodyLength;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Request a byte range of the boot file on a connection of the segmented
+  download, and start receiving its message-body into Buffer.
+
+  @param[in, out]  Segment         The connection to request the range on.
+  @param[in]       Offset          The offset of the range in the boot file.
+  @param[in]       Length          The length of the range.
+  @param[out]      Buffer          The buffer to receive the range to.
+
+  @retval EFI_SUCCESS              The range was requested.
+  @retval EFI_UNSUPPORTED          The server did not answer with the requested range.
+  @retval Others                   Failed to request the range.
+
+**/
+EFI_STATUS
+HttpBootStartSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+  IN     UINTN                    Offset,
+  IN     UINTN                    Length,
+     OUT UINT8                    *Buffer
+  )
+{
+  EFI_STATUS                 Status;
+
+  Status = HttpBootRequestSegment (Segment, Offset, Length);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Segment->Buffer = Buffer;
+  return HttpBootReceiveSegment (Segment, Buffer, Length);
+}
+
+/**
+  Download the boot file into Buffer in byte ranges requested concurrently
+  over several HTTP connections. The number of connections is given by
+  PcdHttpBootSegmentCount.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The segmented download is disabled, the file is too small to
+                                   be split, or the server did not honor the range requests.
+                                   The caller should download the file with HttpBootGetBootFile().
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small to hold the boot file.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources
+  @retval EFI_TIMEOUT              The server stopped sending data.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileSegmented (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer,
+     OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      FileSize;
+  UINTN                      SegmentCount;
+  HTTP_BOOT_SEGMENT          *Segments;
+  HTTP_BOOT_SEGMENT          *Segment;
+  EFI_HTTP_PROTOCOL          *Http;
+  EFI_EVENT                  TimeoutEvent;
+  CHAR8                      *HostName;
+  UINTN                      UrlSize;
+  CHAR16                     *Url;
+  UINTN                      Index;
+  UINTN                      NextOffset;
+  UINTN                      Length;
+  UINTN                      ActiveCount;
+  UINTN                      BodyLength;
+  BOOLEAN                    Progress;
+
+  ASSERT (Private != NULL);
+
+  if (BufferSize == NULL || ImageType == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  FileSize = Private->BootFileSize;
+  if (FileSize == 0 || Buffer == NULL || !Private->AcceptRanges) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (*BufferSize < FileSize) {
+    *BufferSize = FileSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // Use as many connections as configured, but no more than the number of
+  // ranges the file is split into.
+  //
+  SegmentCount = MIN (PcdGet8 (PcdHttpBootSegmentCount), HTTP_BOOT_SEGMENT_MAX_COUNT);
+  SegmentCount = MIN (SegmentCount, (FileSize + HTTP_BOOT_SEGMENT_SIZE - 1) / HTTP_BOOT_SEGMENT_SIZE);
+  if (SegmentCount < 2) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // The file may already be in the cache if it was downloaded to get its size.
+  //
+  UrlSize = AsciiStrSize (Private->BootFileUri);
+  Url = AllocatePool (UrlSize * sizeof (CHAR16));
+  if (Url == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  AsciiStrToUnicodeStrS (Private->BootFileUri, Url, UrlSize);
+  Status = HttpBootGetFileFromCache (Private, Url, BufferSize, Buffer, ImageType);
+  if (Status != EFI_NOT_FOUND) {
+    FreePool (Url);
+    return Status;
+  }
+
+  Segments     = NULL;
+  TimeoutEvent = NULL;
+  HostName     = NULL;
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Segments = AllocateZeroPool (SegmentCount * sizeof (HTTP_BOOT_SEGMENT));
+  if (Segments == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER,
+                  TPL_CALLBACK,
+                  NULL,
+                  NULL,
+                  &TimeoutEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  for (Index = 0; Index < SegmentCount; Index++) {
+    Status = HttpBootInitSegment (Private, &Segments[Index], Url, HostName);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+  }
+
+  //
+  // The ranges complete out of order, so the progress of the default HTTP
+  // Boot callback is counted against the size of the whole file.
+  //
+  Private->FileSize     = FileSize;
+  Private->ReceivedSize = 0;
+  Private->Percentage   = 0;
+
+  //
+  // Request the first range on every connection.
+  //
+  NextOffset = 0;
+  for (Index = 0; Index < SegmentCount; Index++) {
+    Length = MIN (HTTP_BOOT_SEGMENT_SIZE, FileSize - NextOffset);
+    Status = HttpBootStartSegment (&Segments[Index], NextOffset, Length, Buffer + NextOffset);
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+    NextOffset += Length;
+  }
+
+  //
+  // Poll all connections, and hand the next range to a connection as soon as
+  // it has received its current one. The download times out when none of the
+  // connections receives any data for HTTP_BOOT_RESPONSE_TIMEOUT.
+  //
+  ActiveCount = SegmentCount;
+  Status = gBS->SetTimer (TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  while (ActiveCount > 0) {
+    Progress = FALSE;
+    for (Index = 0; Index < SegmentCount; Index++) {
+      Segment = &Segments[Index];
+      if (Segment->Length == 0) {
+        continue;
+      }
+
+      Http = Segment->HttpIo.Http;
+      Http->Poll (Http);
+      if (!Segment->HttpIo.IsRxDone) {
+        continue;
+      }
+
+      Status = Segment->HttpIo.RspToken.Status;
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+
+      BodyLength = Segment->HttpIo.RspToken.Message->BodyLength;
+      if (Private->HttpBootCallback != NULL && BodyLength != 0) {
+        Status = Private->HttpBootCallback->Callback (
+                   Private->HttpBootCallback,
+                   HttpBootHttpEntityBody,
+                   TRUE,
+                   (UINT32) BodyLength,
+                   Segment->Buffer + Segment->ReceivedSize
+                   );
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+      }
+      Segment->ReceivedSize += BodyLength;
+      Progress = TRUE;
+
+      if (Segment->ReceivedSize < Segment->Length) {
+        Status = HttpBootReceiveSegment (
+                   Segment,
+                   Segment->Buffer + Segment->ReceivedSize,
+                   Segment->Length - Segment->ReceivedSize
+                   );
+      } else if (NextOffset < FileSize) {
+        Length = MIN (HTTP_BOOT_SEGMENT_SIZE, FileSize - NextOffset);
+        Status = HttpBootStartSegment (Segment, NextOffset, Length, Buffer + NextOffset);
+        NextOffset += Length;
+      } else {
+        Segment->Length = 0;
+        ActiveCount--;
+      }
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+    }
+
+    if (Progress) {
+      gBS->SetTimer (TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+    } else if (!EFI_ERROR (gBS->CheckEvent (TimeoutEvent))) {
+      Status = EFI_TIMEOUT;
+      goto ON_EXIT;
+    }
+  }
+
+  Status      = EFI_SUCCESS;
+  *BufferSize = FileSize;
+  *ImageType  = Private->ImageType;
+
+ON_EXIT:
+  if (Segments != NULL) {
+    for (Index = 0; Index < SegmentCount; Index++) {
+      HttpBootFreeSegment (&Segments[Index]);
+    }
+    FreePool (Segments);
+  }
+  if (TimeoutEvent != NULL) {
+    gBS->SetTimer (TimeoutEvent, TimerCancel, 0);
+    gBS->CloseEvent (TimeoutEvent);
+  }
+  if (HostName != NULL) {
+    FreePool (HostName);
+  }
+  FreePool (Url);
+
+  return Status;
+}
+
@@ -14,6 +14,15 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define HTTP_BOOT_RESPONSE_TIMEOUT           5000      // 5 seconds in uints of millisecond.
 #define HTTP_BOOT_BLOCK_SIZE                 1500
 
+//
+// Segmented download: the boot file is requested in ranges of this size,
+// over at most HTTP_BOOT_SEGMENT_MAX_COUNT connections.
+//
+#define HTTP_BOOT_SEGMENT_SIZE               SIZE_4MB
+#define HTTP_BOOT_SEGMENT_MAX_COUNT          16
+#define HTTP_BOOT_SEGMENT_HEADER_COUNT       4
+#define HTTP_BOOT_RANGE_LENGTH               48
+
 
 
 #define HTTP_USER_AGENT_EFI_HTTP_BOOT        "UefiHttpBoot/1.0"
@@ -62,6 +71,22 @@ typedef struct {
   HTTP_BOOT_PRIVATE_DATA     *Private;
 } HTTP_BOOT_CALLBACK_DATA;
 
+//
+// A connection requesting byte ranges of the boot file, and the range it is
+// receiving.
+//
+typedef struct {
+  HTTP_IO                    HttpIo;
+  BOOLEAN                    HttpCreated;
+  EFI_HTTP_REQUEST_DATA      RequestData;
+  EFI_HTTP_HEADER            Headers[HTTP_BOOT_SEGMENT_HEADER_COUNT];
+  CHAR8                      Range[HTTP_BOOT_RANGE_LENGTH];
+  UINTN                      Offset;          // Offset of the range in the boot file.
+  UINTN                      Length;          // Length of the range, 0 if the connection is idle.
+  UINTN                      ReceivedSize;
+  UINT8                      *Buffer;         // Buffer the range is received to.
+} HTTP_BOOT_SEGMENT;
+
 /**
   Discover all the boot information for boot file.
 
@@ -123,6 +148,110 @@ HttpBootGetBootFile (
      OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
   );
 
+/**
+  Create the HTTP child of a byte range connection, and set up the request
+  headers it sends for every range of the boot file.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[out]      Segment         The connection to initialize.
+  @param[in]       Url             The URL of the boot file.
+  @param[in]       HostName        The host name of the boot file URL.
+
+  @retval EFI_SUCCESS              The connection was initialized.
+  @retval Others                   Failed to create the HTTP child.
+
+**/
+EFI_STATUS
+HttpBootInitSegment (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+     OUT HTTP_BOOT_SEGMENT        *Segment,
+  IN     CHAR16                   *Url,
+  IN     CHAR8                    *HostName
+  );
+
+/**
+  Cancel the pending transfer of a byte range connection, and destroy its
+  HTTP child.
+
+  @param[in, out]  Segment         The connection to release.
+
+**/
+VOID
+HttpBootFreeSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment
+  );
+
+/**
+  Request a byte range of the boot file on a connection, and receive the
+  response header.
+
+  @param[in, out]  Segment         The connection to request the range on.
+  @param[in]       Offset          The offset of the range in the boot file.
+  @param[in]       Length          The length of the range.
+
+  @retval EFI_SUCCESS              The server answered with the requested range, the
+                                   message-body can be received with HttpBootReadSegment().
+  @retval EFI_UNSUPPORTED          The server did not answer with the requested range.
+  @retval Others                   Failed to request the range.
+
+**/
+EFI_STATUS
+HttpBootRequestSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+  IN     UINTN                    Offset,
+  IN     UINTN                    Length
+  );
+
+/**
+  Receive a part of the message-body of the range requested on a connection,
+  and wait until BufferSize bytes have arrived.
+
+  @param[in, out]  Segment         The connection to receive on.
+  @param[out]      Buffer          The buffer to receive the data to.
+  @param[in]       BufferSize      The size of Buffer, no more than the rest of the range.
+
+  @retval EFI_SUCCESS              BufferSize bytes were received.
+  @retval EFI_TIMEOUT              The server stopped sending data.
+  @retval Others                   Failed to receive the data.
+
+**/
+EFI_STATUS
+HttpBootReadSegment (
+  IN OUT HTTP_BOOT_SEGMENT        *Segment,
+     OUT UINT8                    *Buffer,
+  IN     UINTN                    BufferSize
+  );
+
+/**
+  Download the boot file into Buffer in byte ranges requested concurrently
+  over several HTTP connections. The number of connections is given by
+  PcdHttpBootSegmentCount.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[out]      ImageType       The image type of the downloaded file.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The segmented download is disabled, the file is too small to
+                                   be split, or the server did not honor the range requests.
+                                   The caller should download the file with HttpBootGetBootFile().
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small to hold the boot file.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources
+  @retval EFI_TIMEOUT              The server stopped sending data.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileSegmented (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer,
+     OUT HTTP_BOOT_IMAGE_TYPE     *ImageType
+  );
+
 /**
   Clean up all cached data.
 
@@ -60,6 +60,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #include <Protocol/LoadFile.h>
 #include <Protocol/HttpBootCallback.h>
+#include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 
 //
 // Consumed Guids
@@ -91,6 +93,7 @@ extern EFI_COMPONENT_NAME_PROTOCOL  gHttpBootDxeComponentName;
 //
 typedef struct _HTTP_BOOT_PRIVATE_DATA      HTTP_BOOT_PRIVATE_DATA;
 typedef struct _HTTP_BOOT_VIRTUAL_NIC       HTTP_BOOT_VIRTUAL_NIC;
+typedef struct _HTTP_BOOT_BLOCK_DEVICE      HTTP_BOOT_BLOCK_DEVICE;
 
 typedef enum  {
   ImageTypeEfi,
@@ -108,6 +111,7 @@ typedef enum  {
 #include "HttpBootImpl.h"
 #include "HttpBootSupport.h"
 #include "HttpBootClient.h"
+#include "HttpBootBlockIo.h"
 #include "HttpBootConfig.h"
 
 typedef union {
@@ -176,6 +180,7 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   UINT32                                    Id;
   EFI_HTTP_BOOT_CALLBACK_PROTOCOL           *HttpBootCallback;
   EFI_HTTP_BOOT_CALLBACK_PROTOCOL           LoadFileCallback;
+  HTTP_BOOT_BLOCK_DEVICE                    *BlockDevice;
 
   //
   // Data for the default HTTP Boot callback protocol
@@ -209,6 +214,7 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   CHAR8                                     *BootFileUri;
   VOID                                      *BootFileUriParser;
   UINTN                                     BootFileSize;
+  BOOLEAN                                   AcceptRanges;
   BOOLEAN                                   NoGateway;
   HTTP_BOOT_IMAGE_TYPE                      ImageType;
 
@@ -382,15 +382,28 @@ HttpBootLoadFile (
   }
 
   //
-  // Load the boot file into Buffer
+  // Load the boot file into Buffer, in concurrent byte ranges if the platform
+  // enables it and the server supports range requests.
   //
-  Status = HttpBootGetBootFile (
-             Private,
-             FALSE,
-             BufferSize,
-             Buffer,
-             ImageType
-             );
+  Status = EFI_UNSUPPORTED;
+  if (PcdGet8 (PcdHttpBootSegmentCount) > 1) {
+    Status = HttpBootGetBootFileSegmented (
+               Private,
+               BufferSize,
+               Buffer,
+               ImageType
+               );
+  }
+
+  if (Status == EFI_UNSUPPORTED) {
+    Status = HttpBootGetBootFile (
+               Private,
+               FALSE,
+               BufferSize,
+               Buffer,
+               ImageType
+               );
+  }
 
 ON_EXIT:
   HttpBootUninstallCallback (Private);
@@ -432,6 +445,7 @@ HttpBootStop (
   IN HTTP_BOOT_PRIVATE_DATA           *Private
   )
 {
+  EFI_STATUS       Status;
   UINTN            Index;
 
   if (Private == NULL) {
@@ -442,6 +456,15 @@ HttpBootStop (
     return EFI_NOT_STARTED;
   }
 
+  //
+  // The block device reads the boot file on demand, so it is destroyed before
+  // the boot file information is discarded.
+  //
+  Status = HttpBootDestroyBlockDevice (Private);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   if (Private->HttpCreated) {
     HttpIoDestroyIo (&Private->HttpIo);
     Private->HttpCreated = FALSE;
@@ -455,6 +478,7 @@ HttpBootStop (
   Private->BootFileUri = NULL;
   Private->BootFileUriParser = NULL;
   Private->BootFileSize = 0;
+  Private->AcceptRanges = FALSE;
   Private->SelectIndex = 0;
   Private->SelectProxyType = HttpOfferTypeMax;
 
@@ -509,6 +533,12 @@ HttpBootStop (
 /**
   Causes the driver to load a specified file.
 
+  If FilePath ends with a vendor media node with the virtual CD or disk GUID,
+  and the boot file is an image of that type, the image is not loaded into
+  Buffer. A block device reading it on demand is produced instead, and
+  EFI_WARN_FILE_SYSTEM is returned with a zero BufferSize. A plain size query
+  never produces the block device.
+
   @param  This       Protocol instance pointer.
   @param  FilePath   The device specific path of the file to load.
   @param  BootPolicy If TRUE, indicates that the request originates from the
@@ -535,6 +565,8 @@ HttpBootStop (
   @retval EFI_BUFFER_TOO_SMALL  The BufferSize is too small to read the current directory entry.
                                 BufferSize has been updated with the size needed to complete
                                 the request.
+  @retval EFI_WARN_FILE_SYSTEM  The image was registered as a RAM disk, or a block device
+                                reading it on demand was produced as FilePath requested.
 
 **/
 EFI_STATUS
@@ -553,6 +585,9 @@ HttpBootDxeLoadFile (
   BOOLEAN                       UsingIpv6;
   EFI_STATUS                    Status;
   HTTP_BOOT_IMAGE_TYPE          ImageType;
+  HTTP_BOOT_IMAGE_TYPE          RequestedType;
+  BOOLEAN                       BlockDeviceRequest;
+  UINTN                         FileSize;
 
   if (This == NULL || BufferSize == NULL || FilePath == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -565,6 +600,16 @@ HttpBootDxeLoadFile (
     return EFI_UNSUPPORTED;
   }
 
+  //
+  // The block device reading the image on demand is only produced when the
+  // platform enables it and the caller asks for it in FilePath.
+  //
+  RequestedType = ImageTypeMax;
+  BlockDeviceRequest = HttpBootIsBlockDeviceRequest (FilePath, &RequestedType);
+  if (BlockDeviceRequest && PcdGet32 (PcdHttpBootBlockCacheSize) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
   VirtualNic = HTTP_BOOT_VIRTUAL_NIC_FROM_LOADFILE (This);
   Private = VirtualNic->Private;
 
@@ -594,10 +639,36 @@ HttpBootDxeLoadFile (
     return Status;
   }
 
+  ImageType = ImageTypeMax;
+  if (BlockDeviceRequest) {
+    //
+    // Only the size and the type of the boot file are needed to produce the
+    // block device. If it cannot be produced, HTTP boot is kept started so
+    // that the caller can load the image into a buffer instead.
+    //
+    FileSize = 0;
+    Status = HttpBootLoadFile (Private, &FileSize, NULL, &ImageType);
+    if (Status != EFI_BUFFER_TOO_SMALL) {
+      HttpBootStop (Private);
+      return EFI_ERROR (Status) ? Status : EFI_UNSUPPORTED;
+    }
+
+    if (ImageType != RequestedType) {
+      return EFI_UNSUPPORTED;
+    }
+
+    Status = HttpBootCreateBlockDevice (Private, ImageType);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    *BufferSize = 0;
+    return EFI_WARN_FILE_SYSTEM;
+  }
+
   //
   // Load the boot file.
   //
-  ImageType = ImageTypeMax;
   Status = HttpBootLoadFile (Private, BufferSize, Buffer, &ImageType);
   if (EFI_ERROR (Status)) {
     if (Status == EFI_BUFFER_TOO_SMALL && (ImageType == ImageTypeVirtualCd || ImageType == ImageTypeVirtualDisk)) {
@@ -155,6 +155,7 @@ Routine Description:
   QEMU_VIDEO_MODE_DATA          *ModeData;
   RETURN_STATUS                 Status;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL Black;
+  UINTN                         ShadowBufferSize;
 
   Private = QEMU_VIDEO_PRIVATE_DATA_FROM_GRAPHICS_OUTPUT_THIS (This);
 
@@ -217,6 +218,30 @@ Routine Description:
   }
   ASSERT (Status == RETURN_SUCCESS);
 
+  //
+  // Keep a shadow copy of the frame buffer in system memory so that Blt
+  // operations, especially the Video to Video scrolling of the console,
+  // never read back from the frame buffer.
+  //
+  if (FeaturePcdGet (PcdFrameBufferShadowEnable)) {
+    FrameBufferBltSetShadowBuffer (Private->FrameBufferBltConfigure, NULL, &ShadowBufferSize);
+    if (ShadowBufferSize > Private->ShadowBufferSize) {
+      if (Private->ShadowBuffer != NULL) {
+        FreePool (Private->ShadowBuffer);
+      }
+      Private->ShadowBuffer     = AllocatePool (ShadowBufferSize);
+      Private->ShadowBufferSize = (Private->ShadowBuffer != NULL) ? ShadowBufferSize : 0;
+    }
+    if (Private->ShadowBuffer != NULL) {
+      Status = FrameBufferBltSetShadowBuffer (
+                 Private->FrameBufferBltConfigure,
+                 Private->ShadowBuffer,
+                 &Private->ShadowBufferSize
+                 );
+      ASSERT (Status == RETURN_SUCCESS);
+    }
+  }
+
   //
   // Per UEFI Spec, need to clear the visible portions of the output display to black.
   //
@@ -357,6 +382,8 @@ QemuVideoGraphicsOutputConstructor (
   Private->GraphicsOutput.Mode->Mode    = GRAPHICS_OUTPUT_INVALIDE_MODE_NUMBER;
   Private->FrameBufferBltConfigure      = NULL;
   Private->FrameBufferBltConfigureSize  = 0;
+  Private->ShadowBuffer                 = NULL;
+  Private->ShadowBufferSize             = 0;
 
   //
   // Initialize the hardware
@@ -404,6 +431,10 @@ Returns:
     FreePool (Private->FrameBufferBltConfigure);
   }
 
+  if (Private->ShadowBuffer != NULL) {
+    FreePool (Private->ShadowBuffer);
+  }
+
   if (Private->GraphicsOutput.Mode != NULL) {
     if (Private->GraphicsOutput.Mode->Info != NULL) {
       gBS->FreePool (Private->GraphicsOutput.Mode->Info);
@@ -116,6 +116,8 @@ typedef struct {
   FRAME_BUFFER_CONFIGURE                *FrameBufferBltConfigure;
   UINTN                                 FrameBufferBltConfigureSize;
   UINT8                                 FrameBufferVramBarIndex;
+  VOID                                  *ShadowBuffer;
+  UINTN                                 ShadowBufferSize;
 } QEMU_VIDEO_PRIVATE_DATA;
 
 ///
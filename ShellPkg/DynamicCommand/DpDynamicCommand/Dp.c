@@ -84,6 +84,7 @@ STATIC CONST SHELL_PARAM_ITEM ParamList[] = {
   {L"-c", TypeValue},  // -c   Display cumulative data.
   {L"-n", TypeValue},  // -n # Number of records to display for A and R
   {L"-t", TypeValue},  // -t # Threshold of interest
+  {L"-o", TypeValue},  // -o   Write trace events to a file
   {NULL, TypeMax}
   };
 
@@ -637,6 +638,7 @@ RunDp (
   BOOLEAN                   CumulativeMode;
   CONST CHAR16              *CustomCumulativeToken;
   PERF_CUM_DATA             *CustomCumulativeData;
+  CONST CHAR16              *TraceFileName;
   UINTN                     NameSize;
   SHELL_STATUS              ShellStatus;
   TIMER_INFO                TimerInfo;
@@ -650,6 +652,7 @@ RunDp (
   ExcludeMode = FALSE;
   CumulativeMode = FALSE;
   CustomCumulativeData = NULL;
+  TraceFileName = NULL;
   ShellStatus = SHELL_SUCCESS;
 
   //
@@ -756,6 +759,15 @@ RunDp (
     }
   }
 
+  if (ShellCommandLineGetFlag (ParamPackage, L"-o")) {
+    TraceFileName = ShellCommandLineGetValue (ParamPackage, L"-o");
+    if (TraceFileName == NULL) {
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_TOO_FEW), mDpHiiHandle);
+      ShellStatus = SHELL_INVALID_PARAMETER;
+      goto Done;
+    }
+  }
+
   //
   // DP dump performance data by parsing FPDT table in ACPI table.
   // Folloing 3 steps are to get the measurement form the FPDT table.
@@ -848,13 +860,23 @@ RunDp (
 ****                      Default is 0 for All and Raw mode
 ****                      Default is DEFAULT_THRESHOLD for "Cooked" mode
 ****    n Number2Display  Used by All and Raw mode.  Otherwise ignored.
+****    o Trace file  --  Other display options are ignored
 ****    A All         --  R and S options are ignored
 ****    R Raw         --  S option is ignored
 ****    s Summary     --  Modifies "Cooked" output only
 ****    Cooked (Default)
 ****************************************************************************/
   GatherStatistics (CustomCumulativeData);
-  if (CumulativeMode) {
+  if (TraceFileName != NULL) {
+    Status = DumpTraceEvents (TraceFileName);
+    if (Status == EFI_ABORTED) {
+      ShellStatus = SHELL_ABORTED;
+      goto Done;
+    } else if (EFI_ERROR (Status)) {
+      ShellStatus = SHELL_DEVICE_ERROR;
+      goto Done;
+    }
+  } else if (CumulativeMode) {
     ProcessCumulative (CustomCumulativeData);
   } else if (AllMode) {
     Status = DumpAllTrace( Number2Display, ExcludeMode);
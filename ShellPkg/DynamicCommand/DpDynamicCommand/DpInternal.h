@@ -15,6 +15,11 @@
 
 #define DP_GAUGE_STRING_LENGTH   36
 
+//
+/// Size of the buffer one trace event is printed into.
+//
+#define DP_TRACE_EVENT_LENGTH    512
+
 //
 /// Module-Global Variables
 ///@{
@@ -312,4 +317,23 @@ ProcessCumulative(
   IN PERF_CUM_DATA                  *CustomCumulativeData OPTIONAL
   );
 
+/**
+  Write all measurements to a file in the Chrome trace event format.
+
+  The file can be opened in chrome://tracing or in the Perfetto UI. Each
+  complete measurement becomes a complete event, so nested measurements show
+  up nested. Measurements without a start or an end become instant events.
+
+  @param[in]    FileName    The name of the file to write. An existing file
+                            is replaced.
+
+  @retval EFI_SUCCESS       The file has been written.
+  @retval EFI_ABORTED       The user aborts the operation.
+  @retval Others            The file could not be written.
+**/
+EFI_STATUS
+DumpTraceEvents (
+  IN CONST CHAR16           *FileName
+  );
+
 #endif
@@ -902,3 +902,251 @@ ProcessCumulative(
                 );
   }
 }
+
+/**
+  Copy a string into a buffer as the content of a JSON string.
+
+  Quotes and backslashes are escaped, other control characters are replaced
+  with spaces, and characters outside of ASCII are replaced with '?'. The
+  string is truncated if it does not fit in the buffer.
+
+  @param[in]  String      The Null-terminated string to copy.
+  @param[out] Buffer      The buffer receiving the Null-terminated result.
+  @param[in]  BufferSize  The size of Buffer in bytes.
+**/
+VOID
+DpEscapeJsonString (
+  IN  CONST CHAR16     *String,
+  OUT CHAR8            *Buffer,
+  IN  UINTN            BufferSize
+  )
+{
+  UINTN                Index;
+
+  Index = 0;
+  for (; *String != L'\0' && Index + 2 < BufferSize; String++) {
+    if ((*String == L'"') || (*String == L'\\')) {
+      Buffer[Index++] = '\\';
+      Buffer[Index++] = (CHAR8) *String;
+    } else if (*String < L' ') {
+      Buffer[Index++] = ' ';
+    } else if (*String > 0x7E) {
+      Buffer[Index++] = '?';
+    } else {
+      Buffer[Index++] = (CHAR8) *String;
+    }
+  }
+  Buffer[Index] = '\0';
+}
+
+/**
+  Print formatted ASCII text to a trace event file.
+
+  @param[in]  FileHandle  The file to write to.
+  @param[in]  Format      The ASCII format string.
+  @param[in]  ...         The arguments of Format.
+
+  @retval EFI_SUCCESS     The text has been written.
+  @retval Others          The text could not be written.
+**/
+EFI_STATUS
+EFIAPI
+DpWriteTrace (
+  IN SHELL_FILE_HANDLE FileHandle,
+  IN CONST CHAR8       *Format,
+  ...
+  )
+{
+  VA_LIST              Marker;
+  CHAR8                Buffer[DP_TRACE_EVENT_LENGTH];
+  UINTN                Size;
+
+  VA_START (Marker, Format);
+  Size = AsciiVSPrint (Buffer, sizeof (Buffer), Format, Marker);
+  VA_END (Marker);
+
+  return ShellWriteFile (FileHandle, &Size, Buffer);
+}
+
+/**
+  Write all measurements to a file in the Chrome trace event format.
+
+  The file can be opened in chrome://tracing or in the Perfetto UI. Each
+  complete measurement becomes a complete event; nested measurements, like
+  DB:Start of a driver inside the ConnectController() of BDS, show up nested.
+  Measurements without a start or an end become instant events. The major
+  phases, the PEIMs and the other measurements are put on separate threads.
+  The threshold and the count limit of the other modes do not apply.
+
+  @param[in]    FileName    The name of the file to write. An existing file
+                            is replaced.
+
+  @retval EFI_SUCCESS       The file has been written.
+  @retval EFI_ABORTED       The user aborts the operation.
+  @retval Others            The file could not be written.
+**/
+EFI_STATUS
+DumpTraceEvents (
+  IN CONST CHAR16           *FileName
+  )
+{
+  EFI_STATUS                Status;
+  SHELL_FILE_HANDLE         FileHandle;
+  MEASUREMENT_RECORD        Measurement;
+  UINTN                     LogEntryKey;
+  UINTN                     TIndex;
+  UINTN                     Length;
+  EFI_HANDLE                *HandleBuffer;
+  UINTN                     HandleCount;
+  UINTN                     Thread;
+  UINT64                    TimeStamp;
+  UINT32                    Remainder;
+  UINT32                    DurRemainder;
+  UINT64                    Duration;
+  CHAR16                    ModuleString[DXE_PERFORMANCE_STRING_SIZE];
+  CHAR8                     Name[DP_GAUGE_STRING_LENGTH * 2 + 1];
+  CHAR8                     Token[DXE_PERFORMANCE_STRING_SIZE * 2];
+  CHAR8                     Module[DXE_PERFORMANCE_STRING_SIZE * 2];
+  STATIC CONST CHAR8        *ThreadNames[] = { "Phases", "PEIMs", "Drivers and events" };
+
+  //
+  // Replace an existing file.
+  //
+  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  if (!EFI_ERROR (Status)) {
+    ShellDeleteFile (&FileHandle);
+  }
+  Status = ShellOpenFileByName (FileName, &FileHandle, EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
+  if (EFI_ERROR (Status)) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_TRACE_FILE_ERROR), mDpHiiHandle, FileName, Status);
+    return Status;
+  }
+
+  Status = gBS->LocateHandleBuffer (AllHandles, NULL, NULL, &HandleCount, &HandleBuffer);
+  if (EFI_ERROR (Status)) {
+    HandleBuffer = NULL;
+    HandleCount  = 0;
+  }
+
+  Status = DpWriteTrace (FileHandle, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (Thread = 0; Thread < ARRAY_SIZE (ThreadNames) && !EFI_ERROR (Status); Thread++) {
+    Status = DpWriteTrace (
+               FileHandle,
+               "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%a\"}},\n",
+               (UINT32) Thread,
+               ThreadNames[Thread]
+               );
+  }
+
+  LogEntryKey = 0;
+  while (!EFI_ERROR (Status) &&
+         ((LogEntryKey = GetPerformanceMeasurementRecord (
+                           LogEntryKey,
+                           &Measurement.Handle,
+                           &Measurement.Token,
+                           &Measurement.Module,
+                           &Measurement.StartTimeStamp,
+                           &Measurement.EndTimeStamp,
+                           &Measurement.Identifier)) != 0)
+        )
+  {
+    //
+    // Name the records with handles after their drivers, as DumpAllTrace() does.
+    //
+    ModuleString[0]  = L'\0';
+    mUnicodeToken[0] = L'\0';
+    if (Measurement.Module != NULL) {
+      AsciiStrnToUnicodeStrS (Measurement.Module, ARRAY_SIZE (ModuleString) - 1, ModuleString, ARRAY_SIZE (ModuleString), &Length);
+    }
+    if (Measurement.Token != NULL) {
+      AsciiStrnToUnicodeStrS (Measurement.Token, ARRAY_SIZE (mUnicodeToken) - 1, mUnicodeToken, ARRAY_SIZE (mUnicodeToken), &Length);
+    }
+    StrnCpyS (mGaugeString, ARRAY_SIZE (mGaugeString), ModuleString, DP_GAUGE_STRING_LENGTH);
+    if (Measurement.Handle != NULL) {
+      for (TIndex = 0; TIndex < HandleCount; TIndex++) {
+        if (Measurement.Handle == HandleBuffer[TIndex]) {
+          DpGetNameFromHandle (HandleBuffer[TIndex]);
+          break;
+        }
+      }
+    }
+
+    if (IsPhase (&Measurement)) {
+      Thread = 0;
+    } else if ((Measurement.Token != NULL) && (AsciiStrCmp (Measurement.Token, ALit_PEIM) == 0)) {
+      UnicodeSPrint (mGaugeString, sizeof (mGaugeString), L"%g", Measurement.Handle);
+      Thread = 1;
+    } else {
+      Thread = 2;
+    }
+    if (mGaugeString[0] == L'\0') {
+      StrCpyS (mGaugeString, ARRAY_SIZE (mGaugeString), mUnicodeToken);
+    }
+
+    DpEscapeJsonString (mGaugeString, Name, sizeof (Name));
+    DpEscapeJsonString (mUnicodeToken, Token, sizeof (Token));
+    DpEscapeJsonString (ModuleString, Module, sizeof (Module));
+
+    //
+    // Time stamps are in nanoseconds, trace events in microseconds.
+    //
+    if ((Measurement.StartTimeStamp != 0) && (Measurement.EndTimeStamp != 0)) {
+      TimeStamp = DivU64x32Remainder (Measurement.StartTimeStamp, 1000, &Remainder);
+      Duration  = DivU64x32Remainder (GetDuration (&Measurement), 1000, &DurRemainder);
+      Status = DpWriteTrace (
+                 FileHandle,
+                 "{\"name\":\"%a\",\"cat\":\"%a\",\"ph\":\"X\",\"ts\":%ld.%03d,\"dur\":%ld.%03d,\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"module\":\"%a\",\"handle\":\"0x%p\",\"id\":%d}},\n",
+                 Name,
+                 Token,
+                 TimeStamp,
+                 Remainder,
+                 Duration,
+                 DurRemainder,
+                 (UINT32) Thread,
+                 Module,
+                 Measurement.Handle,
+                 Measurement.Identifier
+                 );
+    } else {
+      TimeStamp = (Measurement.EndTimeStamp != 0) ? Measurement.EndTimeStamp : Measurement.StartTimeStamp;
+      TimeStamp = DivU64x32Remainder (TimeStamp, 1000, &Remainder);
+      Status = DpWriteTrace (
+                 FileHandle,
+                 "{\"name\":\"%a\",\"cat\":\"%a\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%ld.%03d,\"pid\":1,\"tid\":%d,"
+                 "\"args\":{\"module\":\"%a\",\"handle\":\"0x%p\",\"id\":%d}},\n",
+                 Name,
+                 Token,
+                 TimeStamp,
+                 Remainder,
+                 (UINT32) Thread,
+                 Module,
+                 Measurement.Handle,
+                 Measurement.Identifier
+                 );
+    }
+
+    if (ShellGetExecutionBreakFlag ()) {
+      Status = EFI_ABORTED;
+    }
+  }
+
+  //
+  // A final metadata event keeps the array free of a trailing comma.
+  //
+  if (!EFI_ERROR (Status)) {
+    Status = DpWriteTrace (FileHandle, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Boot\"}}\n]}\n");
+  }
+
+  if (HandleBuffer != NULL) {
+    FreePool (HandleBuffer);
+  }
+  ShellCloseFile (&FileHandle);
+
+  if (!EFI_ERROR (Status)) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_TRACE_FILE_WRITTEN), mDpHiiHandle, mMeasurementNum, FileName);
+  } else if (Status != EFI_ABORTED) {
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_DP_TRACE_FILE_ERROR), mDpHiiHandle, FileName, Status);
+  }
+  return Status;
+}
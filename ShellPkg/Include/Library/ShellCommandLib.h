@@ -663,6 +663,91 @@ ShellFileHandleEof(
   IN SHELL_FILE_HANDLE Handle
   );
 
+///
+/// A file read sequentially in buffers of PcdShellCopyBufferSize bytes.
+///
+typedef struct _SHELL_FILE_STREAM SHELL_FILE_STREAM;
+
+/**
+  Open a stream reading a file from its current position.
+
+  When the file supports ReadEx(), the next buffer of the file is read while
+  the caller consumes the data of the current one.
+
+  @param[in] Handle             The file to read.
+  @param[out] Stream            Returns the stream.
+
+  @retval EFI_SUCCESS           The stream was opened.
+  @retval EFI_INVALID_PARAMETER Handle or Stream is NULL.
+  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+  @return other                 The first read of the file could not be started.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandOpenFileStream (
+  IN  SHELL_FILE_HANDLE  Handle,
+  OUT SHELL_FILE_STREAM  **Stream
+  );
+
+/**
+  Read data from a stream opened by ShellCommandOpenFileStream().
+
+  @param[in] Stream             The stream to read.
+  @param[in, out] BufferSize    On input, the size of Buffer. On output, the
+                                number of bytes read, 0 at the end of the file.
+  @param[out] Buffer            The buffer receiving the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @return other                 Reading the file failed.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandReadFileStream (
+  IN     SHELL_FILE_STREAM  *Stream,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  );
+
+/**
+  Close a stream opened by ShellCommandOpenFileStream(). The file itself is
+  left open.
+
+  @param[in] Stream             The stream to close.
+**/
+VOID
+EFIAPI
+ShellCommandCloseFileStream (
+  IN SHELL_FILE_STREAM  *Stream
+  );
+
+/**
+  Copy the data of a file to another one, from the current positions of both
+  files to the end of the source file.
+
+  Two buffers of PcdShellCopyBufferSize bytes are used, so that the next
+  buffer of the source file is read while the previous one is written. The
+  reads and writes are done with ReadEx() and WriteEx() when the files support
+  them.
+
+  @param[in] SourceHandle       The file to read.
+  @param[in] DestHandle         The file to write.
+  @param[out] BytesCopied       Returns the number of bytes written.
+  @param[out] ReadFailed        Returns TRUE when the copy failed because of a
+                                read of the source file.
+
+  @retval EFI_SUCCESS           The data was copied.
+  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+  @return other                 Reading or writing a file failed.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandCopyFileData (
+  IN  SHELL_FILE_HANDLE  SourceHandle,
+  IN  SHELL_FILE_HANDLE  DestHandle,
+  OUT UINT64             *BytesCopied,
+  OUT BOOLEAN            *ReadFailed
+  );
+
 typedef struct {
   LIST_ENTRY    Link;
   void          *Buffer;
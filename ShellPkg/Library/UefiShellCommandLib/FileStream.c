@@ -0,0 +1,397 @@
+/** @file
+  Provides double-buffered reading and copying of files for shell commands.
+
+  Files are read and written in buffers of PcdShellCopyBufferSize bytes. When
+  the file system supports the EFI_FILE_PROTOCOL revision 2 functions ReadEx()
+  and WriteEx(), the next buffer is read while the previous one is processed,
+  so that the latency of the device is hidden behind the work of the command.
+  Other files are read and written synchronously.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UefiShellCommandLib.h"
+
+/**
+  Prepare a request for the reads or the writes of a file.
+
+  @param[out] Request   The request to prepare.
+  @param[in] File       The file the request reads or writes.
+**/
+VOID
+FileIoRequestInit (
+  OUT SHELL_FILE_IO_REQUEST  *Request,
+  IN  EFI_FILE_PROTOCOL      *File
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (Request, sizeof (*Request));
+  Request->File = File;
+
+  if (File->Revision >= EFI_FILE_PROTOCOL_REVISION2) {
+    Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Request->Token.Event);
+    if (EFI_ERROR (Status)) {
+      Request->Token.Event = NULL;
+    }
+  }
+}
+
+/**
+  Start the read or the write of Request->Token.Buffer. A synchronous request
+  is complete when the function returns.
+
+  @param[in, out] Request   The request.
+  @param[in] Write          TRUE to write the buffer, FALSE to read it.
+
+  @retval EFI_SUCCESS       The request was started.
+  @return other             The request could not be started.
+**/
+EFI_STATUS
+FileIoRequestStart (
+  IN OUT SHELL_FILE_IO_REQUEST  *Request,
+  IN     BOOLEAN                Write
+  )
+{
+  EFI_STATUS  Status;
+
+  ASSERT (!Request->Pending);
+
+  if (Request->Token.Event != NULL) {
+    if (Write) {
+      Status = Request->File->WriteEx (Request->File, &Request->Token);
+    } else {
+      Status = Request->File->ReadEx (Request->File, &Request->Token);
+    }
+    if (!EFI_ERROR (Status)) {
+      Request->Pending = TRUE;
+      return EFI_SUCCESS;
+    }
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+
+    //
+    // The file system does not implement the asynchronous functions.
+    //
+    gBS->CloseEvent (Request->Token.Event);
+    Request->Token.Event = NULL;
+  }
+
+  if (Write) {
+    Status = Request->File->Write (Request->File, &Request->Token.BufferSize, Request->Token.Buffer);
+  } else {
+    Status = Request->File->Read (Request->File, &Request->Token.BufferSize, Request->Token.Buffer);
+  }
+  Request->Token.Status = Status;
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait for a request started by FileIoRequestStart() to complete.
+
+  @param[in, out] Request   The request.
+
+  @return The status of the read or the write.
+**/
+EFI_STATUS
+FileIoRequestWait (
+  IN OUT SHELL_FILE_IO_REQUEST  *Request
+  )
+{
+  UINTN  Index;
+
+  if (Request->Pending) {
+    gBS->WaitForEvent (1, &Request->Token.Event, &Index);
+    Request->Pending = FALSE;
+  }
+  return Request->Token.Status;
+}
+
+/**
+  Release the event of a request. The request must not be pending.
+
+  @param[in, out] Request   The request.
+**/
+VOID
+FileIoRequestFree (
+  IN OUT SHELL_FILE_IO_REQUEST  *Request
+  )
+{
+  ASSERT (!Request->Pending);
+
+  if (Request->Token.Event != NULL) {
+    gBS->CloseEvent (Request->Token.Event);
+    Request->Token.Event = NULL;
+  }
+}
+
+/**
+  Make the buffer read in the background the current buffer of a stream, and
+  start the read of the following one.
+
+  @param[in, out] Stream    The stream.
+
+  @retval EFI_SUCCESS       The current buffer was refilled. Stream->Length is
+                            0 at the end of the file.
+  @return other             Reading the file failed.
+**/
+EFI_STATUS
+FileStreamFill (
+  IN OUT SHELL_FILE_STREAM  *Stream
+  )
+{
+  EFI_STATUS  Status;
+
+  if (EFI_ERROR (Stream->Status)) {
+    return Stream->Status;
+  }
+  Status = FileIoRequestWait (&Stream->Request);
+  if (EFI_ERROR (Status)) {
+    Stream->Status = Status;
+    return Status;
+  }
+
+  Stream->Index ^= 1;
+  Stream->Offset = 0;
+  Stream->Length = Stream->Request.Token.BufferSize;
+  if (Stream->Length == 0) {
+    Stream->EndOfFile = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  Stream->Request.Token.Buffer     = Stream->Buffer[Stream->Index ^ 1];
+  Stream->Request.Token.BufferSize = Stream->BufferSize;
+  Stream->Status = FileIoRequestStart (&Stream->Request, FALSE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Open a stream reading a file from its current position.
+
+  When the file supports ReadEx(), the next buffer of the file is read while
+  the caller consumes the data of the current one.
+
+  @param[in] Handle             The file to read.
+  @param[out] Stream            Returns the stream.
+
+  @retval EFI_SUCCESS           The stream was opened.
+  @retval EFI_INVALID_PARAMETER Handle or Stream is NULL.
+  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+  @return other                 The first read of the file could not be started.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandOpenFileStream (
+  IN  SHELL_FILE_HANDLE  Handle,
+  OUT SHELL_FILE_STREAM  **Stream
+  )
+{
+  EFI_STATUS         Status;
+  SHELL_FILE_STREAM  *NewStream;
+
+  if (Handle == NULL || Stream == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NewStream = AllocateZeroPool (sizeof (SHELL_FILE_STREAM));
+  if (NewStream == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  NewStream->BufferSize = PcdGet32 (PcdShellCopyBufferSize);
+  NewStream->Buffer[0]  = AllocatePool (NewStream->BufferSize);
+  NewStream->Buffer[1]  = AllocatePool (NewStream->BufferSize);
+  if (NewStream->Buffer[0] == NULL || NewStream->Buffer[1] == NULL) {
+    SHELL_FREE_NON_NULL (NewStream->Buffer[0]);
+    SHELL_FREE_NON_NULL (NewStream->Buffer[1]);
+    FreePool (NewStream);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Start the read of the first buffer. It becomes the current buffer on the
+  // first call to ShellCommandReadFileStream().
+  //
+  FileIoRequestInit (&NewStream->Request, ConvertShellHandleToEfiFileProtocol (Handle));
+  NewStream->Index                    = 1;
+  NewStream->Request.Token.Buffer     = NewStream->Buffer[0];
+  NewStream->Request.Token.BufferSize = NewStream->BufferSize;
+  Status = FileIoRequestStart (&NewStream->Request, FALSE);
+  if (EFI_ERROR (Status)) {
+    ShellCommandCloseFileStream (NewStream);
+    return Status;
+  }
+
+  *Stream = NewStream;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read data from a stream opened by ShellCommandOpenFileStream().
+
+  @param[in] Stream             The stream to read.
+  @param[in, out] BufferSize    On input, the size of Buffer. On output, the
+                                number of bytes read, 0 at the end of the file.
+  @param[out] Buffer            The buffer receiving the data.
+
+  @retval EFI_SUCCESS           The data was read.
+  @return other                 Reading the file failed.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandReadFileStream (
+  IN     SHELL_FILE_STREAM  *Stream,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Copied;
+  UINTN       Size;
+
+  Copied = 0;
+  while (Copied < *BufferSize) {
+    if (Stream->Offset == Stream->Length) {
+      if (Stream->EndOfFile) {
+        break;
+      }
+      Status = FileStreamFill (Stream);
+      if (EFI_ERROR (Status)) {
+        *BufferSize = Copied;
+        return Status;
+      }
+      continue;
+    }
+
+    Size = MIN (*BufferSize - Copied, Stream->Length - Stream->Offset);
+    CopyMem ((UINT8 *)Buffer + Copied, Stream->Buffer[Stream->Index] + Stream->Offset, Size);
+    Stream->Offset += Size;
+    Copied         += Size;
+  }
+
+  *BufferSize = Copied;
+  return EFI_SUCCESS;
+}
+
+/**
+  Close a stream opened by ShellCommandOpenFileStream(). The file itself is
+  left open.
+
+  @param[in] Stream             The stream to close.
+**/
+VOID
+EFIAPI
+ShellCommandCloseFileStream (
+  IN SHELL_FILE_STREAM  *Stream
+  )
+{
+  if (Stream == NULL) {
+    return;
+  }
+
+  //
+  // The file system may still be writing to the buffers.
+  //
+  FileIoRequestWait (&Stream->Request);
+  FileIoRequestFree (&Stream->Request);
+  FreePool (Stream->Buffer[0]);
+  FreePool (Stream->Buffer[1]);
+  FreePool (Stream);
+}
+
+/**
+  Copy the data of a file to another one, from the current positions of both
+  files to the end of the source file.
+
+  Two buffers of PcdShellCopyBufferSize bytes are used, so that the next
+  buffer of the source file is read while the previous one is written. The
+  reads and writes are done with ReadEx() and WriteEx() when the files support
+  them.
+
+  @param[in] SourceHandle       The file to read.
+  @param[in] DestHandle         The file to write.
+  @param[out] BytesCopied       Returns the number of bytes written.
+  @param[out] ReadFailed        Returns TRUE when the copy failed because of a
+                                read of the source file.
+
+  @retval EFI_SUCCESS           The data was copied.
+  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+  @return other                 Reading or writing a file failed.
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandCopyFileData (
+  IN  SHELL_FILE_HANDLE  SourceHandle,
+  IN  SHELL_FILE_HANDLE  DestHandle,
+  OUT UINT64             *BytesCopied,
+  OUT BOOLEAN            *ReadFailed
+  )
+{
+  EFI_STATUS             Status;
+  EFI_STATUS             ReadStatus;
+  SHELL_FILE_IO_REQUEST  Read;
+  SHELL_FILE_IO_REQUEST  Write;
+  UINT8                  *Buffer[2];
+  UINTN                  BufferSize;
+  UINTN                  Index;
+
+  *BytesCopied = 0;
+  *ReadFailed  = FALSE;
+
+  BufferSize = PcdGet32 (PcdShellCopyBufferSize);
+  Buffer[0]  = AllocatePool (BufferSize);
+  Buffer[1]  = AllocatePool (BufferSize);
+  if (Buffer[0] == NULL || Buffer[1] == NULL) {
+    SHELL_FREE_NON_NULL (Buffer[0]);
+    SHELL_FREE_NON_NULL (Buffer[1]);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  FileIoRequestInit (&Read, ConvertShellHandleToEfiFileProtocol (SourceHandle));
+  FileIoRequestInit (&Write, ConvertShellHandleToEfiFileProtocol (DestHandle));
+
+  Index                  = 0;
+  Read.Token.Buffer      = Buffer[Index];
+  Read.Token.BufferSize  = BufferSize;
+  Status = FileIoRequestStart (&Read, FALSE);
+  if (!EFI_ERROR (Status)) {
+    Status = FileIoRequestWait (&Read);
+  }
+  *ReadFailed = EFI_ERROR (Status);
+
+  while (!EFI_ERROR (Status) && Read.Token.BufferSize != 0) {
+    //
+    // Write the buffer just read, and read the next one into the other buffer
+    // at the same time.
+    //
+    Write.Token.Buffer     = Buffer[Index];
+    Write.Token.BufferSize = Read.Token.BufferSize;
+    Status = FileIoRequestStart (&Write, TRUE);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Index                 ^= 1;
+    Read.Token.Buffer      = Buffer[Index];
+    Read.Token.BufferSize  = BufferSize;
+    ReadStatus = FileIoRequestStart (&Read, FALSE);
+
+    Status = FileIoRequestWait (&Write);
+    if (!EFI_ERROR (ReadStatus)) {
+      ReadStatus = FileIoRequestWait (&Read);
+    }
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    *BytesCopied += Write.Token.BufferSize;
+
+    Status      = ReadStatus;
+    *ReadFailed = EFI_ERROR (Status);
+  }
+
+  FileIoRequestFree (&Read);
+  FileIoRequestFree (&Write);
+  FreePool (Buffer[0]);
+  FreePool (Buffer[1]);
+  return Status;
+}
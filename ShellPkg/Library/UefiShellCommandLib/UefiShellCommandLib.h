@@ -60,6 +60,27 @@ typedef struct {
   CHAR16            *Path;
 } SHELL_COMMAND_FILE_HANDLE;
 
+///
+/// A read or write of a file, done with ReadEx() or WriteEx() when Token.Event
+/// is not NULL.
+///
+typedef struct {
+  EFI_FILE_PROTOCOL           *File;
+  EFI_FILE_IO_TOKEN           Token;
+  BOOLEAN                     Pending;
+} SHELL_FILE_IO_REQUEST;
+
+struct _SHELL_FILE_STREAM {
+  SHELL_FILE_IO_REQUEST       Request;    ///< The read of the next buffer.
+  EFI_STATUS                  Status;     ///< The status of starting Request.
+  BOOLEAN                     EndOfFile;
+  UINT8                       *Buffer[2];
+  UINTN                       BufferSize;
+  UINTN                       Index;      ///< The buffer holding the current data.
+  UINTN                       Offset;     ///< The offset of the next byte to return.
+  UINTN                       Length;     ///< The size of the current data.
+};
+
 
 #endif //_UEFI_COMMAND_LIB_INTERNAL_HEADER_
 
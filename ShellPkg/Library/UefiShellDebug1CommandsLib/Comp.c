@@ -98,6 +98,8 @@ ShellCommandRunComp (
   SHELL_STATUS        ShellStatus;
   SHELL_FILE_HANDLE   FileHandle1;
   SHELL_FILE_HANDLE   FileHandle2;
+  SHELL_FILE_STREAM   *Stream1;
+  SHELL_FILE_STREAM   *Stream2;
   UINT64              Size1;
   UINT64              Size2;
   UINT64              DifferentBytes;
@@ -122,6 +124,8 @@ ShellCommandRunComp (
   FileName2           = NULL;
   FileHandle1         = NULL;
   FileHandle2         = NULL;
+  Stream1             = NULL;
+  Stream2             = NULL;
   DataFromFile1       = NULL;
   DataFromFile2       = NULL;
   ReadStatus          = OutOfDiffPoint;
@@ -241,15 +245,31 @@ ShellCommandRunComp (
         }
       }
 
+      if (ShellStatus == SHELL_SUCCESS) {
+        //
+        // Read both files in large buffers, the next buffer of each file being
+        // read while the current ones are compared.
+        //
+        Status = ShellCommandOpenFileStream (FileHandle1, &Stream1);
+        if (!EFI_ERROR (Status)) {
+          Status = ShellCommandOpenFileStream (FileHandle2, &Stream2);
+        }
+        if (EFI_ERROR (Status)) {
+          ShellStatus = SHELL_OUT_OF_RESOURCES;
+          SHELL_FREE_NON_NULL (DataFromFile1);
+          SHELL_FREE_NON_NULL (DataFromFile2);
+        }
+      }
+
       if (ShellStatus == SHELL_SUCCESS) {
         while (DiffPointNumber < DifferentCount) {
           DataSizeFromFile1 = 1;
           DataSizeFromFile2 = 1;
           OneByteFromFile1 = 0;
           OneByteFromFile2 = 0;
-          Status = gEfiShellProtocol->ReadFile (FileHandle1, &DataSizeFromFile1, &OneByteFromFile1);
+          Status = ShellCommandReadFileStream (Stream1, &DataSizeFromFile1, &OneByteFromFile1);
           ASSERT_EFI_ERROR (Status);
-          Status = gEfiShellProtocol->ReadFile (FileHandle2, &DataSizeFromFile2, &OneByteFromFile2);
+          Status = ShellCommandReadFileStream (Stream2, &DataSizeFromFile2, &OneByteFromFile2);
           ASSERT_EFI_ERROR (Status);
 
           TempAddress++;
@@ -361,6 +381,8 @@ ShellCommandRunComp (
   SHELL_FREE_NON_NULL(FileName1);
   SHELL_FREE_NON_NULL(FileName2);
 
+  ShellCommandCloseFileStream (Stream1);
+  ShellCommandCloseFileStream (Stream2);
   if (FileHandle1 != NULL) {
     gEfiShellProtocol->CloseFile(FileHandle1);
   }
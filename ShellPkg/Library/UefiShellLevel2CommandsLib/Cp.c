@@ -37,6 +37,32 @@ ValidateAndCopyFiles(
   IN VOID                       **Resp
   );
 
+/**
+  Return the number of milliseconds elapsed between two times read from the
+  real time clock. The times are expected to be less than a day apart.
+
+  @param[in] Start      The earlier time.
+  @param[in] End        The later time.
+
+  @return The number of milliseconds from Start to End.
+**/
+UINT64
+GetElapsedMilliseconds (
+  IN CONST EFI_TIME *Start,
+  IN CONST EFI_TIME *End
+  )
+{
+  UINT64  StartTime;
+  UINT64  EndTime;
+
+  StartTime = (((UINT64)Start->Hour * 60 + Start->Minute) * 60 + Start->Second) * 1000 + Start->Nanosecond / 1000000;
+  EndTime   = (((UINT64)End->Hour * 60 + End->Minute) * 60 + End->Second) * 1000 + End->Nanosecond / 1000000;
+  if (End->Day != Start->Day) {
+    EndTime += 24 * 60 * 60 * 1000;
+  }
+  return EndTime - StartTime;
+}
+
 /**
   Function to Copy one file to another location
 
@@ -60,11 +86,9 @@ CopySingleFile(
   )
 {
   VOID                  *Response;
-  UINTN                 ReadSize;
   SHELL_FILE_HANDLE     SourceHandle;
   SHELL_FILE_HANDLE     DestHandle;
   EFI_STATUS            Status;
-  VOID                  *Buffer;
   CHAR16                *TempName;
   UINTN                 Size;
   EFI_SHELL_FILE_INFO   *List;
@@ -74,6 +98,13 @@ CopySingleFile(
   EFI_FILE_PROTOCOL     *DestVolumeFP;
   EFI_FILE_SYSTEM_INFO  *DestVolumeInfo;
   UINTN                 DestVolumeInfoSize;
+  UINT64                BytesCopied;
+  BOOLEAN               ReadFailed;
+  EFI_TIME              StartTime;
+  EFI_TIME              EndTime;
+  BOOLEAN               CanMeasureTime;
+  UINT64                ElapsedTime;
+  UINT32                Milliseconds;
 
   ASSERT(Resp != NULL);
 
@@ -84,7 +115,6 @@ CopySingleFile(
   DestVolumeInfo  = NULL;
   ShellStatus     = SHELL_SUCCESS;
 
-  ReadSize = PcdGet32(PcdShellFileOperationSize);
   // Why bother copying a file to itself
   if (StrCmp(Source, Dest) == 0) {
     return (SHELL_SUCCESS);
@@ -223,24 +253,34 @@ CopySingleFile(
       //
       // copy data between files
       //
-      Buffer = AllocateZeroPool(ReadSize);
-      if (Buffer == NULL) {
+      CanMeasureTime = !SilentMode && !EFI_ERROR (gRT->GetTime (&StartTime, NULL));
+      Status = ShellCommandCopyFileData (SourceHandle, DestHandle, &BytesCopied, &ReadFailed);
+      if (Status == EFI_OUT_OF_RESOURCES) {
+        ShellStatus = SHELL_OUT_OF_RESOURCES;
         ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_OUT_MEM), gShellLevel2HiiHandle, CmdName);
-        return SHELL_OUT_OF_RESOURCES;
-      }
-      while (ReadSize == PcdGet32(PcdShellFileOperationSize) && !EFI_ERROR(Status)) {
-        Status = ShellReadFile(SourceHandle, &ReadSize, Buffer);
-        if (!EFI_ERROR(Status)) {
-          Status = ShellWriteFile(DestHandle, &ReadSize, Buffer);
-          if (EFI_ERROR(Status)) {
-            ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
-            ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_WRITE_ERROR), gShellLevel2HiiHandle, CmdName, Dest);
-            break;
-          }
-        } else {
-          ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
+      } else if (EFI_ERROR (Status)) {
+        ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
+        if (ReadFailed) {
           ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_READ_ERROR), gShellLevel2HiiHandle, CmdName, Source);
-          break;
+        } else {
+          ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_WRITE_ERROR), gShellLevel2HiiHandle, CmdName, Dest);
+        }
+      } else if (CanMeasureTime
+              && BytesCopied >= PcdGet32 (PcdShellCopyBufferSize)
+              && !EFI_ERROR (gRT->GetTime (&EndTime, NULL))) {
+        //
+        // Report the throughput of the copies long enough to be measured with
+        // the real time clock.
+        //
+        ElapsedTime = GetElapsedMilliseconds (&StartTime, &EndTime);
+        if (ElapsedTime != 0) {
+          ShellPrintHiiEx (
+            -1, -1, NULL, STRING_TOKEN (STR_CP_THROUGHPUT), gShellLevel2HiiHandle,
+            BytesCopied,
+            DivU64x32Remainder (ElapsedTime, 1000, &Milliseconds),
+            Milliseconds,
+            DivU64x64Remainder (MultU64x32 (BytesCopied, 1000), MultU64x32 (ElapsedTime, 1024), NULL)
+            );
         }
       }
     }
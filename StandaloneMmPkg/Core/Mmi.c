@@ -19,13 +19,21 @@
 
 #define MMI_ENTRY_SIGNATURE  SIGNATURE_32('m','m','i','e')
 
-typedef struct {
+typedef struct _MMI_ENTRY  MMI_ENTRY;
+
+struct _MMI_ENTRY {
   UINTN       Signature;
   LIST_ENTRY  AllEntries;  // All entries
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  MmiHandlers; // All handlers
-} MMI_ENTRY;
+  MMI_ENTRY   *HashNext;   // Next entry in the same hash bucket
+};
+
+//
+// Number of buckets of the MMI entry hash table. Must be a power of 2.
+//
+#define MMI_ENTRY_HASH_SIZE  64
 
 #define MMI_HANDLER_SIGNATURE  SIGNATURE_32('m','m','i','h')
 
@@ -39,6 +47,35 @@ typedef struct {
 LIST_ENTRY  mRootMmiHandlerList = INITIALIZE_LIST_HEAD_VARIABLE (mRootMmiHandlerList);
 LIST_ENTRY  mMmiEntryList       = INITIALIZE_LIST_HEAD_VARIABLE (mMmiEntryList);
 
+//
+// Hash table of the entries in mMmiEntryList, indexed by MmiEntryHash().
+//
+MMI_ENTRY   *mMmiEntryHash[MMI_ENTRY_HASH_SIZE];
+
+/**
+  Compute the hash bucket of an MMI handler type.
+
+  @param  HandlerType            The type of the interrupt
+
+  @return The index in mMmiEntryHash.
+
+**/
+UINTN
+MmiEntryHash (
+  IN CONST EFI_GUID  *HandlerType
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *)HandlerType) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (MMI_ENTRY_HASH_SIZE - 1);
+}
+
 /**
   Finds the MMI entry for the requested handler type.
 
@@ -55,19 +92,17 @@ MmCoreFindMmiEntry (
   IN BOOLEAN   Create
   )
 {
-  LIST_ENTRY  *Link;
   MMI_ENTRY   *Item;
   MMI_ENTRY   *MmiEntry;
+  UINTN       Hash;
 
   //
-  // Search the MMI entry list for the matching GUID
+  // Search the hash bucket of the GUID for the matching entry
   //
   MmiEntry = NULL;
-  for (Link = mMmiEntryList.ForwardLink;
-       Link != &mMmiEntryList;
-       Link = Link->ForwardLink) {
-
-    Item = CR (Link, MMI_ENTRY, AllEntries, MMI_ENTRY_SIGNATURE);
+  Hash     = MmiEntryHash (HandlerType);
+  for (Item = mMmiEntryHash[Hash]; Item != NULL; Item = Item->HashNext) {
+    ASSERT (Item->Signature == MMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the MMI entry
@@ -92,9 +127,11 @@ MmCoreFindMmiEntry (
       InitializeListHead (&MmiEntry->MmiHandlers);
 
       //
-      // Add it to MMI entry list
+      // Add it to MMI entry list and to the hash table
       //
       InsertTailList (&mMmiEntryList, &MmiEntry->AllEntries);
+      MmiEntry->HashNext  = mMmiEntryHash[Hash];
+      mMmiEntryHash[Hash] = MmiEntry;
     }
   }
   return MmiEntry;
@@ -295,6 +332,7 @@ MmiHandlerUnRegister (
 {
   MMI_HANDLER  *MmiHandler;
   MMI_ENTRY    *MmiEntry;
+  MMI_ENTRY    **HashLink;
 
   MmiHandler = (MMI_HANDLER *) DispatchHandle;
 
@@ -323,6 +361,14 @@ MmiHandlerUnRegister (
     // No handler registered for this interrupt now, remove the MMI_ENTRY
     //
     RemoveEntryList (&MmiEntry->AllEntries);
+    for (HashLink = &mMmiEntryHash[MmiEntryHash (&MmiEntry->HandlerType)];
+         *HashLink != NULL;
+         HashLink = &(*HashLink)->HashNext) {
+      if (*HashLink == MmiEntry) {
+        *HashLink = MmiEntry->HashNext;
+        break;
+      }
+    }
 
     FreePool (MmiEntry);
   }
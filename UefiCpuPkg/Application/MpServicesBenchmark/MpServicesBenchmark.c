@@ -0,0 +1,225 @@
+/** @file
+  UEFI Application to measure the latency of MP services StartupAllAPs().
+
+  The application enables 2, 4, 8, ... processors in turn, and for each count
+  times blocking StartupAllAPs() calls with an empty procedure. The processors
+  that were enabled when the application started are enabled again before it
+  exits.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Protocol/MpService.h>
+
+///
+/// Number of timed StartupAllAPs() calls for each processor count.
+///
+#define MP_BENCHMARK_ITERATIONS  1000
+
+///
+/// Number of untimed StartupAllAPs() calls before the timed ones.
+///
+#define MP_BENCHMARK_WARMUP      16
+
+/**
+  Empty procedure run on the APs.
+
+  @param[in] Buffer  Not used.
+**/
+VOID
+EFIAPI
+EmptyProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+}
+
+/**
+  Enable the BSP and the first ApCount APs that were enabled at start, and
+  disable the other APs that were enabled at start.
+
+  @param[in] MpServices   The MP services protocol.
+  @param[in] Enabled      Whether each processor was enabled at start.
+  @param[in] CpuCount     The number of processors.
+  @param[in] BspNumber    The processor number of the BSP.
+  @param[in] ApCount      The number of APs to enable.
+
+  @retval EFI_SUCCESS     The processors have been enabled or disabled.
+  @retval Others          EnableDisableAP() failed.
+**/
+EFI_STATUS
+SelectProcessors (
+  IN EFI_MP_SERVICES_PROTOCOL  *MpServices,
+  IN BOOLEAN                   *Enabled,
+  IN UINTN                     CpuCount,
+  IN UINTN                     BspNumber,
+  IN UINTN                     ApCount
+  )
+{
+  EFI_STATUS                   Status;
+  UINTN                        Index;
+
+  for (Index = 0; Index < CpuCount; Index++) {
+    if (Index == BspNumber || !Enabled[Index]) {
+      continue;
+    }
+    Status = MpServices->EnableDisableAP (MpServices, Index, (BOOLEAN) (ApCount > 0), NULL);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    if (ApCount > 0) {
+      ApCount--;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Time blocking StartupAllAPs() calls with the APs that are enabled.
+
+  @param[in]  MpServices   The MP services protocol.
+  @param[out] Average      The average time of one call, in nanoseconds.
+  @param[out] Minimum      The shortest call, in nanoseconds.
+  @param[out] Maximum      The longest call, in nanoseconds.
+
+  @retval EFI_SUCCESS      All calls succeeded.
+  @retval Others           StartupAllAPs() failed.
+**/
+EFI_STATUS
+MeasureStartupAllAps (
+  IN  EFI_MP_SERVICES_PROTOCOL  *MpServices,
+  OUT UINT64                    *Average,
+  OUT UINT64                    *Minimum,
+  OUT UINT64                    *Maximum
+  )
+{
+  EFI_STATUS                    Status;
+  UINTN                         Index;
+  UINT64                        Begin;
+  UINT64                        Elapsed;
+  UINT64                        Total;
+
+  for (Index = 0; Index < MP_BENCHMARK_WARMUP; Index++) {
+    Status = MpServices->StartupAllAPs (MpServices, EmptyProcedure, FALSE, NULL, 0, NULL, NULL);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Total    = 0;
+  *Minimum = MAX_UINT64;
+  *Maximum = 0;
+  for (Index = 0; Index < MP_BENCHMARK_ITERATIONS; Index++) {
+    Begin  = GetPerformanceCounter ();
+    Status = MpServices->StartupAllAPs (MpServices, EmptyProcedure, FALSE, NULL, 0, NULL, NULL);
+    Elapsed = GetTimeInNanoSecond (GetPerformanceCounter () - Begin);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Total   += Elapsed;
+    *Minimum = MIN (*Minimum, Elapsed);
+    *Maximum = MAX (*Maximum, Elapsed);
+  }
+
+  *Average = DivU64x32 (Total, MP_BENCHMARK_ITERATIONS);
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the application.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_MP_SERVICES_PROTOCOL   *MpServices;
+  EFI_PROCESSOR_INFORMATION  ProcessorInfo;
+  BOOLEAN                    *Enabled;
+  UINTN                      CpuCount;
+  UINTN                      EnabledCount;
+  UINTN                      BspNumber;
+  UINTN                      Index;
+  UINTN                      ApCount;
+  UINT64                     Average;
+  UINT64                     Minimum;
+  UINT64                     Maximum;
+
+  Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+  if (EFI_ERROR (Status)) {
+    Print (L"MP services protocol not found - %r\n", Status);
+    return Status;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &CpuCount, &EnabledCount);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Status = MpServices->WhoAmI (MpServices, &BspNumber);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (EnabledCount < 2) {
+    Print (L"At least 2 enabled processors are needed, %d found\n", EnabledCount);
+    return EFI_UNSUPPORTED;
+  }
+
+  Enabled = AllocateZeroPool (CpuCount * sizeof (BOOLEAN));
+  if (Enabled == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (Index = 0; Index < CpuCount; Index++) {
+    Status = MpServices->GetProcessorInfo (MpServices, Index, &ProcessorInfo);
+    if (!EFI_ERROR (Status)) {
+      Enabled[Index] = (BOOLEAN) ((ProcessorInfo.StatusFlag & PROCESSOR_ENABLED_BIT) != 0);
+    }
+  }
+
+  Print (L"StartupAllAPs() latency, %d calls per row\n", MP_BENCHMARK_ITERATIONS);
+  Print (L"%8s %14s %14s %14s\n", L"CPUs", L"Average (ns)", L"Min (ns)", L"Max (ns)");
+
+  ApCount = 1;
+  while (TRUE) {
+    Status = SelectProcessors (MpServices, Enabled, CpuCount, BspNumber, ApCount);
+    if (!EFI_ERROR (Status)) {
+      Status = MeasureStartupAllAps (MpServices, &Average, &Minimum, &Maximum);
+    }
+    if (EFI_ERROR (Status)) {
+      Print (L"%8d failed - %r\n", ApCount + 1, Status);
+      break;
+    }
+    Print (L"%8d %14ld %14ld %14ld\n", ApCount + 1, Average, Minimum, Maximum);
+
+    if (ApCount == EnabledCount - 1) {
+      break;
+    }
+    ApCount = MIN (ApCount * 2 + 1, EnabledCount - 1);
+  }
+
+  //
+  // Enable the processors that were enabled at start again.
+  //
+  SelectProcessors (MpServices, Enabled, CpuCount, BspNumber, CpuCount);
+  FreePool (Enabled);
+
+  return Status;
+}
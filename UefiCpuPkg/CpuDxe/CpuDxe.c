@@ -21,6 +21,16 @@ UINT64                    mValidMtrrAddressMask;
 UINT64                    mValidMtrrBitsMask;
 UINT64                    mTimerPeriod = 0;
 
+//
+// AP MTRR synchronization state. When PcdCpuDeferApMtrrSync is TRUE, MTRR
+// changes are copied to the APs at the next sync point instead of at once.
+//
+BOOLEAN                   mApMtrrSyncPending = FALSE;
+BOOLEAN                   mApMtrrSyncInProgress = FALSE;
+BOOLEAN                   mApMtrrSyncImmediate = FALSE;
+UINTN                     mMtrrChangeCount = 0;
+UINTN                     mApMtrrSyncCount = 0;
+
 FIXED_MTRR    mFixedMtrrTable[] = {
   {
     MSR_IA32_MTRR_FIX64K_00000,
@@ -345,6 +355,103 @@ SetMtrrsFromBuffer (
   MtrrSetAllMtrrs (Buffer);
 }
 
+/**
+  Copy the MTRR settings of the BSP to all APs.
+
+  If the APs are busy running a procedure started without waiting for it, the
+  copy is left pending until the next MP services call.
+**/
+VOID
+SyncApMtrrs (
+  VOID
+  )
+{
+  EFI_STATUS                MpStatus;
+  EFI_MP_SERVICES_PROTOCOL  *MpService;
+  MTRR_SETTINGS             MtrrSettings;
+
+  MpStatus = gBS->LocateProtocol (
+                    &gEfiMpServiceProtocolGuid,
+                    NULL,
+                    (VOID **)&MpService
+                    );
+  if (EFI_ERROR (MpStatus)) {
+    mApMtrrSyncPending = FALSE;
+    return;
+  }
+
+  //
+  // StartupAllAPs() below checks for a pending copy again, which must not
+  // start another one.
+  //
+  mApMtrrSyncInProgress = TRUE;
+  MtrrGetAllMtrrs (&MtrrSettings);
+  MpStatus = MpService->StartupAllAPs (
+                          MpService,          // This
+                          SetMtrrsFromBuffer, // Procedure
+                          FALSE,              // SingleThread
+                          NULL,               // WaitEvent
+                          0,                  // TimeoutInMicrosecsond
+                          &MtrrSettings,      // ProcedureArgument
+                          NULL                // FailedCpuList
+                          );
+  mApMtrrSyncInProgress = FALSE;
+  ASSERT (MpStatus == EFI_SUCCESS || MpStatus == EFI_NOT_STARTED || MpStatus == EFI_NOT_READY);
+
+  if (MpStatus == EFI_NOT_READY) {
+    mApMtrrSyncPending = TRUE;
+  } else {
+    mApMtrrSyncPending = FALSE;
+    mApMtrrSyncCount++;
+  }
+}
+
+/**
+  Copy the MTRR settings of the BSP to all APs if they have been changed
+  since the last copy.
+
+  It is called before the APs are started through the MP services, so that
+  the APs run with the same MTRR settings as the BSP.
+**/
+VOID
+SyncPendingApMtrrs (
+  VOID
+  )
+{
+  if (mApMtrrSyncPending && !mApMtrrSyncInProgress) {
+    SyncApMtrrs ();
+  }
+}
+
+/**
+  End of DXE callback. Copy pending MTRR changes to the APs, and copy the
+  later changes at once, as third party code may run after it.
+
+  @param[in] Event      The event that was signaled.
+  @param[in] Context    Not used.
+**/
+VOID
+EFIAPI
+ApMtrrSyncOnEndOfDxe (
+  IN EFI_EVENT          Event,
+  IN VOID               *Context
+  )
+{
+  gBS->CloseEvent (Event);
+
+  SyncPendingApMtrrs ();
+  mApMtrrSyncImmediate = TRUE;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %d MTRR changes, %d AP syncs, %d AP syncs avoided\n",
+    __FUNCTION__,
+    mMtrrChangeCount,
+    mApMtrrSyncCount,
+    mMtrrChangeCount - MIN (mMtrrChangeCount, mApMtrrSyncCount)
+    ));
+}
+
 /**
   Implementation of SetMemoryAttributes() service of CPU Architecture Protocol.
 
@@ -381,9 +488,6 @@ CpuSetMemoryAttributes (
 {
   RETURN_STATUS             Status;
   MTRR_MEMORY_CACHE_TYPE    CacheType;
-  EFI_STATUS                MpStatus;
-  EFI_MP_SERVICES_PROTOCOL  *MpService;
-  MTRR_SETTINGS             MtrrSettings;
   UINT64                    CacheAttributes;
   UINT64                    MemoryAttributes;
   MTRR_MEMORY_CACHE_TYPE    CurrentCacheType;
@@ -462,26 +566,15 @@ CpuSetMemoryAttributes (
                  );
 
       if (!RETURN_ERROR (Status)) {
-        MpStatus = gBS->LocateProtocol (
-                          &gEfiMpServiceProtocolGuid,
-                          NULL,
-                          (VOID **)&MpService
-                          );
+        mMtrrChangeCount++;
         //
-        // Synchronize the update with all APs
+        // Synchronize the update with all APs. The APs only run code started
+        // through the MP services, so the update may wait for the next call.
         //
-        if (!EFI_ERROR (MpStatus)) {
-          MtrrGetAllMtrrs (&MtrrSettings);
-          MpStatus = MpService->StartupAllAPs (
-                                  MpService,          // This
-                                  SetMtrrsFromBuffer, // Procedure
-                                  FALSE,              // SingleThread
-                                  NULL,               // WaitEvent
-                                  0,                  // TimeoutInMicrosecsond
-                                  &MtrrSettings,      // ProcedureArgument
-                                  NULL                // FailedCpuList
-                                  );
-          ASSERT (MpStatus == EFI_SUCCESS || MpStatus == EFI_NOT_STARTED);
+        if (FeaturePcdGet (PcdCpuDeferApMtrrSync) && !mApMtrrSyncImmediate) {
+          mApMtrrSyncPending = TRUE;
+        } else {
+          SyncApMtrrs ();
         }
       }
       if (EFI_ERROR(Status)) {
@@ -1155,6 +1248,7 @@ InitializeCpu (
 {
   EFI_STATUS  Status;
   EFI_EVENT   IdleLoopEvent;
+  EFI_EVENT   EndOfDxeEvent;
 
   InitializePageTableLib();
 
@@ -1210,6 +1304,18 @@ InitializeCpu (
 
   InitializeMpSupport ();
 
+  if (FeaturePcdGet (PcdCpuDeferApMtrrSync)) {
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    ApMtrrSyncOnEndOfDxe,
+                    NULL,
+                    &gEfiEndOfDxeEventGroupGuid,
+                    &EndOfDxeEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+
   return Status;
 }
 
@@ -38,6 +38,7 @@
 
 #include <Guid/IdleLoopEvent.h>
 #include <Guid/VectorHandoffTable.h>
+#include <Guid/EventGroup.h>
 
 #define HEAP_GUARD_NONSTOP_MODE       \
         ((PcdGet8 (PcdHeapGuardPropertyMask) & (BIT6|BIT4|BIT1|BIT0)) > BIT6)
@@ -253,6 +254,18 @@ SetDataSelectors (
   UINT16 Selector
   );
 
+/**
+  Copy the MTRR settings of the BSP to all APs if they have been changed
+  since the last copy.
+
+  It is called before the APs are started through the MP services, so that
+  the APs run with the same MTRR settings as the BSP.
+**/
+VOID
+SyncPendingApMtrrs (
+  VOID
+  );
+
 /**
   Update GCD memory space attributes according to current page table setup.
 **/
@@ -261,6 +261,7 @@ StartupAllAPs (
   OUT UINTN                     **FailedCpuList         OPTIONAL
   )
 {
+  SyncPendingApMtrrs ();
   return MpInitLibStartupAllAPs (
            Procedure,
            SingleThread,
@@ -369,6 +370,7 @@ StartupThisAP (
   OUT BOOLEAN                   *Finished               OPTIONAL
   )
 {
+  SyncPendingApMtrrs ();
   return MpInitLibStartupThisAP (
            Procedure,
            ProcessorNumber,
@@ -422,6 +424,7 @@ SwitchBSP (
   IN  BOOLEAN                  EnableOldBSP
   )
 {
+  SyncPendingApMtrrs ();
   return MpInitLibSwitchBSP (ProcessorNumber, EnableOldBSP);
 }
 
@@ -475,6 +478,7 @@ EnableDisableAP (
   IN  UINT32                    *HealthFlag OPTIONAL
   )
 {
+  SyncPendingApMtrrs ();
   return MpInitLibEnableDisableAP (ProcessorNumber, EnableAP, HealthFlag);
 }
 
@@ -0,0 +1,75 @@
+/** @file
+  SMI latency histograms collected by the SMM CPU driver when SMM profile is
+  enabled, and the SMM communication interface used to retrieve them.
+
+  The communication buffer starts with an EFI_MM_COMMUNICATE_HEADER whose
+  HeaderGuid is gEdkiiSmmProfileLatencyGuid, followed by an
+  SMM_PROFILE_LATENCY_COMMUNICATE structure.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _SMM_PROFILE_LATENCY_H_
+#define _SMM_PROFILE_LATENCY_H_
+
+#define EDKII_SMM_PROFILE_LATENCY_GUID \
+  { \
+    0x7f0e6b35, 0x2b71, 0x4d0c, { 0x9a, 0x5e, 0x41, 0x8c, 0x3b, 0xd2, 0x60, 0xf4 } \
+  }
+
+extern EFI_GUID gEdkiiSmmProfileLatencyGuid;
+
+//
+// Number of histogram buckets. Bucket 0 counts SMIs shorter than 1
+// microsecond, bucket N (N > 0) counts SMIs of [2^(N-1), 2^N) microseconds,
+// and the last bucket also counts all longer SMIs.
+//
+#define SMM_PROFILE_LATENCY_BUCKET_COUNT  24
+
+//
+// Communication functions.
+//
+#define SMM_PROFILE_LATENCY_FUNCTION_GET    1
+#define SMM_PROFILE_LATENCY_FUNCTION_RESET  2
+
+typedef struct {
+  //
+  // The number of SMIs recorded.
+  //
+  UINT64    NumSmis;
+  //
+  // The longest time, in nanoseconds, from the BSP entering the SMI handler
+  // until all processors that take part in the SMI are synchronized.
+  //
+  UINT64    MaxRendezvousTime;
+  //
+  // The longest time, in nanoseconds, the BSP spent in the SMI handler.
+  //
+  UINT64    MaxSmiTime;
+  //
+  // Histogram of the rendezvous time.
+  //
+  UINT64    RendezvousHistogram[SMM_PROFILE_LATENCY_BUCKET_COUNT];
+  //
+  // Histogram of the time the BSP spent in the SMI handler.
+  //
+  UINT64    SmiHistogram[SMM_PROFILE_LATENCY_BUCKET_COUNT];
+} SMM_PROFILE_LATENCY_DATA;
+
+typedef struct {
+  //
+  // SMM_PROFILE_LATENCY_FUNCTION_GET or SMM_PROFILE_LATENCY_FUNCTION_RESET.
+  //
+  UINT64                      Function;
+  //
+  // Status returned by the SMM CPU driver.
+  //
+  EFI_STATUS                  ReturnStatus;
+  //
+  // Filled in by SMM_PROFILE_LATENCY_FUNCTION_GET.
+  //
+  SMM_PROFILE_LATENCY_DATA    Data;
+} SMM_PROFILE_LATENCY_COMMUNICATE;
+
+#endif
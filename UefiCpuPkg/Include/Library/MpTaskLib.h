@@ -0,0 +1,198 @@
+/** @file
+  Fork-join task library on top of the MP services.
+
+  The library runs a root procedure on the BSP while all enabled APs wait for
+  work. Tasks spawned by the root procedure, or by other tasks, are queued on
+  a per-processor deque. Every processor takes work from its own deque first
+  and steals from the other processors when its own deque is empty.
+
+  Task procedures run on the BSP and on APs. They must only use services that
+  are safe to call from an AP: no memory allocation, no Boot Services or PEI
+  Services, and only small amounts of stack.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __MP_TASK_LIB_H__
+#define __MP_TASK_LIB_H__
+
+///
+/// Opaque handle for the processor that runs a task.
+///
+typedef struct _MP_TASK_WORKER  MP_TASK_WORKER;
+
+///
+/// Tracks a set of spawned tasks so that the spawning task can wait for them.
+/// Initialize it with MpTaskGroupInitialize() before first use.
+///
+typedef struct {
+  volatile UINT32    Pending;
+} MP_TASK_GROUP;
+
+/**
+  Prototype of a task procedure.
+
+  @param[in]  Worker     The processor that runs the task. Pass it to
+                         MpTaskSpawn(), MpTaskWait() and MpTaskParallelFor().
+  @param[in]  Context    The context passed when the task was created.
+**/
+typedef
+VOID
+(EFIAPI *MP_TASK_PROCEDURE) (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context
+  );
+
+/**
+  Prototype of a procedure that handles one chunk of a parallel loop.
+
+  @param[in]  Worker     The processor that runs the chunk.
+  @param[in]  Context    The context passed to MpTaskParallelFor().
+  @param[in]  Begin      The first index of the chunk.
+  @param[in]  End        One past the last index of the chunk.
+**/
+typedef
+VOID
+(EFIAPI *MP_TASK_RANGE_PROCEDURE) (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context,
+  IN UINTN                   Begin,
+  IN UINTN                   End
+  );
+
+/**
+  Return the number of processors that run tasks, including the BSP.
+
+  This function may only be called from the BSP, outside of MpTaskRun().
+
+  @return The number of enabled processors. 1 if no MP services are available.
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerCount (
+  VOID
+  );
+
+/**
+  Return the index of the processor that runs a task.
+
+  The index is smaller than the total number of processors reported by the MP
+  services, and can be used to select per-processor scratch data.
+
+  @param[in]  Worker     The processor that runs the task.
+
+  @return The processor number of Worker.
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerIndex (
+  IN MP_TASK_WORKER          *Worker
+  );
+
+/**
+  Run Procedure on the BSP with all enabled APs available to run the tasks it
+  spawns.
+
+  The function returns after Procedure and every task spawned while it ran
+  have completed. This function may only be called from the BSP, and must not
+  be called from a task.
+
+  @param[in]  Procedure  The root procedure.
+  @param[in]  Context    The context passed to Procedure.
+
+  @retval EFI_SUCCESS            Procedure and all spawned tasks completed.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There is not enough memory for the per-processor
+                                 deques.
+  @retval Others                 The APs could not be started. Nothing was run.
+**/
+EFI_STATUS
+EFIAPI
+MpTaskRun (
+  IN MP_TASK_PROCEDURE       Procedure,
+  IN VOID                    *Context  OPTIONAL
+  );
+
+/**
+  Initialize a task group.
+
+  @param[out] Group      The task group to initialize.
+**/
+VOID
+EFIAPI
+MpTaskGroupInitialize (
+  OUT MP_TASK_GROUP          *Group
+  );
+
+/**
+  Create a task that runs Procedure, and add it to Group.
+
+  The task is queued on the deque of Worker. If that deque is full, the task
+  runs before this function returns.
+
+  @param[in]  Worker     The processor that runs the calling task.
+  @param[in]  Group      The group the new task is added to.
+  @param[in]  Procedure  The task procedure.
+  @param[in]  Context    The context passed to Procedure.
+**/
+VOID
+EFIAPI
+MpTaskSpawn (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK_GROUP           *Group,
+  IN MP_TASK_PROCEDURE       Procedure,
+  IN VOID                    *Context  OPTIONAL
+  );
+
+/**
+  Wait for all tasks in Group to complete.
+
+  While waiting, the calling processor runs queued tasks, its own first.
+
+  @param[in]  Worker     The processor that runs the calling task.
+  @param[in]  Group      The task group to wait for.
+**/
+VOID
+EFIAPI
+MpTaskWait (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK_GROUP           *Group
+  );
+
+/**
+  Call Procedure on chunks of the index range [Begin, End) in parallel.
+
+  The range is split in halves until the chunks are not larger than Grain.
+  One half is queued and can be stolen by other processors, and the calling
+  processor keeps splitting the other half. The function returns after all
+  chunks have been handled.
+
+  If Worker is NULL, this function must be called from the BSP, outside of
+  MpTaskRun(), and it brings up the APs for the loop. Otherwise it must be
+  called from a task and uses the processors of that MpTaskRun() call.
+
+  @param[in]  Worker     The processor that runs the calling task, or NULL.
+  @param[in]  Begin      The first index of the range.
+  @param[in]  End        One past the last index of the range.
+  @param[in]  Grain      The largest chunk size. 0 picks a chunk size from the
+                         number of processors.
+  @param[in]  Procedure  The procedure that handles a chunk.
+  @param[in]  Context    The context passed to Procedure.
+
+  @retval EFI_SUCCESS            All chunks have been handled.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL, or End is smaller than Begin.
+  @retval Others                 See MpTaskRun().
+**/
+EFI_STATUS
+EFIAPI
+MpTaskParallelFor (
+  IN MP_TASK_WORKER          *Worker  OPTIONAL,
+  IN UINTN                   Begin,
+  IN UINTN                   End,
+  IN UINTN                   Grain,
+  IN MP_TASK_RANGE_PROCEDURE Procedure,
+  IN VOID                    *Context  OPTIONAL
+  );
+
+#endif
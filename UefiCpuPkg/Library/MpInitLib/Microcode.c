@@ -27,7 +27,7 @@ GetCurrentMicrocodeSignature (
 }
 
 /**
-  Detect whether specified processor can find matching microcode patch and load it.
+  Find the latest microcode patch for a processor signature and platform ID.
 
   Microcode Payload as the following format:
   +----------------------------------------+------------------+
@@ -65,15 +65,18 @@ GetCurrentMicrocodeSignature (
          It does not guarantee that the data has not been modified.
          CPU has its own mechanism to verify Microcode Binary part.
 
-  @param[in]  CpuMpData        The pointer to CPU MP Data structure.
-  @param[in]  ProcessorNumber  The handle number of the processor. The range is
-                               from 0 to the total number of logical processors
-                               minus 1.
+  @param[in]  CpuMpData           The pointer to CPU MP Data structure.
+  @param[in]  ProcessorSignature  The processor signature, CPUID leaf 1 EAX.
+  @param[in]  PlatformId          The platform ID from MSR IA32_PLATFORM_ID.
+
+  @return  The header of the microcode patch with the highest revision, or
+           NULL if no microcode patch matches.
 **/
-VOID
-MicrocodeDetect (
+CPU_MICROCODE_HEADER *
+FindMicrocodePatch (
   IN CPU_MP_DATA             *CpuMpData,
-  IN UINTN                   ProcessorNumber
+  IN UINT32                  ProcessorSignature,
+  IN UINT8                   PlatformId
   )
 {
   UINT32                                  ExtendedTableLength;
@@ -81,75 +84,18 @@ MicrocodeDetect (
   CPU_MICROCODE_EXTENDED_TABLE            *ExtendedTable;
   CPU_MICROCODE_EXTENDED_TABLE_HEADER     *ExtendedTableHeader;
   CPU_MICROCODE_HEADER                    *MicrocodeEntryPoint;
+  CPU_MICROCODE_HEADER                    *LatestPatch;
   UINTN                                   MicrocodeEnd;
   UINTN                                   Index;
-  UINT8                                   PlatformId;
-  CPUID_VERSION_INFO_EAX                  Eax;
-  CPU_AP_DATA                             *CpuData;
-  UINT32                                  CurrentRevision;
   UINT32                                  LatestRevision;
   UINTN                                   TotalSize;
   UINT32                                  CheckSum32;
   UINT32                                  InCompleteCheckSum32;
   BOOLEAN                                 CorrectMicrocode;
-  VOID                                    *MicrocodeData;
-  MSR_IA32_PLATFORM_ID_REGISTER           PlatformIdMsr;
-  UINT32                                  ThreadId;
-  BOOLEAN                                 IsBspCallIn;
-
-  if (CpuMpData->MicrocodePatchRegionSize == 0) {
-    //
-    // There is no microcode patches
-    //
-    return;
-  }
-
-  CurrentRevision = GetCurrentMicrocodeSignature ();
-  IsBspCallIn     = (ProcessorNumber == (UINTN)CpuMpData->BspNumber) ? TRUE : FALSE;
-
-  GetProcessorLocationByApicId (GetInitialApicId (), NULL, NULL, &ThreadId);
-  if (ThreadId != 0) {
-    //
-    // Skip loading microcode if it is not the first thread in one core.
-    //
-    return;
-  }
 
   ExtendedTableLength = 0;
-  //
-  // Here data of CPUID leafs have not been collected into context buffer, so
-  // GetProcessorCpuid() cannot be used here to retrieve CPUID data.
-  //
-  AsmCpuid (CPUID_VERSION_INFO, &Eax.Uint32, NULL, NULL, NULL);
-
-  //
-  // The index of platform information resides in bits 50:52 of MSR IA32_PLATFORM_ID
-  //
-  PlatformIdMsr.Uint64 = AsmReadMsr64 (MSR_IA32_PLATFORM_ID);
-  PlatformId = (UINT8) PlatformIdMsr.Bits.PlatformId;
-
-
-  //
-  // Check whether AP has same processor with BSP.
-  // If yes, direct use microcode info saved by BSP.
-  //
-  if (!IsBspCallIn) {
-    //
-    // Get the CPU data for BSP
-    //
-    CpuData = &(CpuMpData->CpuData[CpuMpData->BspNumber]);
-    if ((CpuData->ProcessorSignature == Eax.Uint32) &&
-        (CpuData->PlatformId == PlatformId) &&
-        (CpuData->MicrocodeEntryAddr != 0)) {
-      MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *)(UINTN) CpuData->MicrocodeEntryAddr;
-      MicrocodeData       = (VOID *) (MicrocodeEntryPoint + 1);
-      LatestRevision      = MicrocodeEntryPoint->UpdateRevision;
-      goto Done;
-    }
-  }
-
   LatestRevision = 0;
-  MicrocodeData  = NULL;
+  LatestPatch    = NULL;
   MicrocodeEnd = (UINTN) (CpuMpData->MicrocodePatchAddress + CpuMpData->MicrocodePatchRegionSize);
   MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *) (UINTN) CpuMpData->MicrocodePatchAddress;
 
@@ -199,7 +145,7 @@ MicrocodeDetect (
       // because the padding data should not include 0x00000001 and it should be the repeated
       // byte format (like 0xXYXYXYXY....).
       //
-      if (MicrocodeEntryPoint->ProcessorSignature.Uint32 == Eax.Uint32 &&
+      if (MicrocodeEntryPoint->ProcessorSignature.Uint32 == ProcessorSignature &&
           MicrocodeEntryPoint->UpdateRevision > LatestRevision &&
           (MicrocodeEntryPoint->ProcessorFlags & (1 << PlatformId))
           ) {
@@ -249,7 +195,7 @@ MicrocodeDetect (
                   //
                   // Verify Header
                   //
-                  if ((ExtendedTable->ProcessorSignature.Uint32 == Eax.Uint32) &&
+                  if ((ExtendedTable->ProcessorSignature.Uint32 == ProcessorSignature) &&
                       (ExtendedTable->ProcessorFlag & (1 << PlatformId)) ) {
                     //
                     // Find one
@@ -286,23 +232,90 @@ MicrocodeDetect (
 
     if (CorrectMicrocode) {
       LatestRevision = MicrocodeEntryPoint->UpdateRevision;
-      MicrocodeData = (VOID *) ((UINTN) MicrocodeEntryPoint + sizeof (CPU_MICROCODE_HEADER));
+      LatestPatch    = MicrocodeEntryPoint;
     }
 
     MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *) (((UINTN) MicrocodeEntryPoint) + TotalSize);
   } while (((UINTN) MicrocodeEntryPoint < MicrocodeEnd));
 
-Done:
-  if (LatestRevision != 0) {
+
+  return LatestPatch;
+}
+
+/**
+  Detect whether specified processor can find matching microcode patch and load it.
+
+  If IndexMicrocodePatches() has run, the microcode patch found for the
+  processor is used directly. Otherwise the microcode patch region is scanned.
+
+  @param[in]  CpuMpData        The pointer to CPU MP Data structure.
+  @param[in]  ProcessorNumber  The handle number of the processor. The range is
+                               from 0 to the total number of logical processors
+                               minus 1.
+**/
+VOID
+MicrocodeDetect (
+  IN CPU_MP_DATA             *CpuMpData,
+  IN UINTN                   ProcessorNumber
+  )
+{
+  CPU_MICROCODE_HEADER                    *MicrocodeEntryPoint;
+  UINT8                                   PlatformId;
+  CPUID_VERSION_INFO_EAX                  Eax;
+  CPU_AP_DATA                             *CpuData;
+  CPU_INFO_IN_HOB                         *CpuInfoInHob;
+  UINT32                                  CurrentRevision;
+  UINT32                                  LatestRevision;
+  MSR_IA32_PLATFORM_ID_REGISTER           PlatformIdMsr;
+  UINT32                                  ThreadId;
+  UINT64                                  StartTicks;
+
+  if (CpuMpData->MicrocodePatchRegionSize == 0) {
+    //
+    // There is no microcode patches
+    //
+    return;
+  }
+
+  StartTicks      = AsmReadTsc ();
+  CurrentRevision = GetCurrentMicrocodeSignature ();
+
+  GetProcessorLocationByApicId (GetInitialApicId (), NULL, NULL, &ThreadId);
+  if (ThreadId != 0) {
+    //
+    // Skip loading microcode if it is not the first thread in one core.
+    //
+    return;
+  }
+
+  //
+  // Here data of CPUID leafs have not been collected into context buffer, so
+  // GetProcessorCpuid() cannot be used here to retrieve CPUID data.
+  //
+  AsmCpuid (CPUID_VERSION_INFO, &Eax.Uint32, NULL, NULL, NULL);
+
+  //
+  // The index of platform information resides in bits 50:52 of MSR IA32_PLATFORM_ID
+  //
+  PlatformIdMsr.Uint64 = AsmReadMsr64 (MSR_IA32_PLATFORM_ID);
+  PlatformId = (UINT8) PlatformIdMsr.Bits.PlatformId;
+
+  CpuData = &CpuMpData->CpuData[ProcessorNumber];
+  if (CpuMpData->MicrocodeIndexed &&
+      (CpuData->ProcessorSignature == Eax.Uint32) &&
+      (CpuData->PlatformId == PlatformId)) {
+    MicrocodeEntryPoint = (CPU_MICROCODE_HEADER *) (UINTN) CpuData->MicrocodeEntryAddr;
+  } else {
+    MicrocodeEntryPoint = FindMicrocodePatch (CpuMpData, Eax.Uint32, PlatformId);
     //
     // Save the detected microcode patch entry address (including the
     // microcode patch header) for each processor.
     // It will be used when building the microcode patch cache HOB.
     //
-    CpuMpData->CpuData[ProcessorNumber].MicrocodeEntryAddr =
-      (UINTN) MicrocodeData -  sizeof (CPU_MICROCODE_HEADER);
+    CpuData->MicrocodeEntryAddr = (UINTN) MicrocodeEntryPoint;
   }
 
+  LatestRevision = (MicrocodeEntryPoint == NULL) ? 0 : MicrocodeEntryPoint->UpdateRevision;
   if (LatestRevision > CurrentRevision) {
     //
     // BIOS only authenticate updates that contain a numerically larger revision
@@ -310,10 +323,9 @@ Done:
     // Revision. A processor with no loaded update is considered to have a
     // revision equal to zero.
     //
-    ASSERT (MicrocodeData != NULL);
     AsmWriteMsr64 (
         MSR_IA32_BIOS_UPDT_TRIG,
-        (UINT64) (UINTN) MicrocodeData
+        (UINT64) (UINTN) (MicrocodeEntryPoint + 1)
         );
     //
     // Get and check new microcode signature
@@ -326,6 +338,99 @@ Done:
       ReleaseSpinLock(&CpuMpData->MpLock);
     }
   }
+
+  CpuInfoInHob = (CPU_INFO_IN_HOB *) (UINTN) CpuMpData->CpuInfoInHob;
+  CpuInfoInHob[ProcessorNumber].MicrocodeLoadTicks = AsmReadTsc () - StartTicks;
+}
+
+/**
+  Find the microcode patch of every processor on the BSP.
+
+  The microcode patch region is scanned once for each distinct pair of
+  processor signature and platform ID, and the result is saved in the
+  MicrocodeEntryAddr field of all processors with that pair.
+
+  @param[in, out]  CpuMpData    The pointer to CPU MP Data structure.
+**/
+VOID
+IndexMicrocodePatches (
+  IN OUT CPU_MP_DATA             *CpuMpData
+  )
+{
+  UINTN          Index;
+  UINTN          Index2;
+  CPU_AP_DATA    *CpuData;
+
+  CpuMpData->MicrocodeIndexed = FALSE;
+  if (CpuMpData->MicrocodePatchRegionSize == 0) {
+    return;
+  }
+
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    CpuData = &CpuMpData->CpuData[Index];
+    for (Index2 = 0; Index2 < Index; Index2++) {
+      if ((CpuMpData->CpuData[Index2].ProcessorSignature == CpuData->ProcessorSignature) &&
+          (CpuMpData->CpuData[Index2].PlatformId == CpuData->PlatformId)) {
+        break;
+      }
+    }
+    if (Index2 < Index) {
+      CpuData->MicrocodeEntryAddr = CpuMpData->CpuData[Index2].MicrocodeEntryAddr;
+    } else {
+      CpuData->MicrocodeEntryAddr = (UINTN) FindMicrocodePatch (
+                                              CpuMpData,
+                                              CpuData->ProcessorSignature,
+                                              CpuData->PlatformId
+                                              );
+      DEBUG ((
+        DEBUG_INFO,
+        "%a: Signature 0x%08x, PlatformId %d: microcode patch at 0x%lx\n",
+        __FUNCTION__, CpuData->ProcessorSignature, CpuData->PlatformId, CpuData->MicrocodeEntryAddr
+        ));
+    }
+  }
+
+  CpuMpData->MicrocodeIndexed = TRUE;
+}
+
+/**
+  Report the time spent loading microcode on each processor.
+
+  @param[in]  CpuMpData    The pointer to CPU MP Data structure.
+**/
+VOID
+ReportMicrocodeLoadTime (
+  IN CPU_MP_DATA                 *CpuMpData
+  )
+{
+  UINTN            Index;
+  UINTN            LoadCount;
+  UINTN            SlowestProcessor;
+  UINT64           Ticks;
+  CPU_INFO_IN_HOB  *CpuInfoInHob;
+
+  CpuInfoInHob     = (CPU_INFO_IN_HOB *) (UINTN) CpuMpData->CpuInfoInHob;
+  LoadCount        = 0;
+  SlowestProcessor = 0;
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    Ticks = CpuInfoInHob[Index].MicrocodeLoadTicks;
+    if (Ticks == 0) {
+      continue;
+    }
+    DEBUG ((DEBUG_VERBOSE, "Microcode load on processor %d: 0x%lx ticks\n", Index, Ticks));
+    LoadCount++;
+    if (Ticks > CpuInfoInHob[SlowestProcessor].MicrocodeLoadTicks) {
+      SlowestProcessor = Index;
+    }
+  }
+
+  if (LoadCount != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "Microcode loaded on %d cores, slowest is processor %d with 0x%lx ticks\n",
+      LoadCount, SlowestProcessor, CpuInfoInHob[SlowestProcessor].MicrocodeLoadTicks
+      ));
+  }
 }
 
 /**
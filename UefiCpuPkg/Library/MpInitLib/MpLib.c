@@ -374,6 +374,15 @@ SortApicId (
       }
     }
 
+    //
+    // The processor signature and platform ID were saved by processor number
+    // before the sort, take them from the sorted CPU information.
+    //
+    for (Index1 = 0; Index1 < CpuMpData->CpuCount; Index1++) {
+      CpuMpData->CpuData[Index1].ProcessorSignature = CpuInfoInHob[Index1].ProcessorSignature;
+      CpuMpData->CpuData[Index1].PlatformId         = CpuInfoInHob[Index1].PlatformId;
+    }
+
     //
     // Get the processor number for the BSP
     //
@@ -594,6 +603,13 @@ InitializeApData (
     NULL
     );
 
+  //
+  // The CPU information HOB has the same layout in PEI and DXE, so DXE takes
+  // the processor signature and platform ID from there.
+  //
+  CpuInfoInHob[ProcessorNumber].ProcessorSignature = CpuMpData->CpuData[ProcessorNumber].ProcessorSignature;
+  CpuInfoInHob[ProcessorNumber].PlatformId         = CpuMpData->CpuData[ProcessorNumber].PlatformId;
+
   InitializeSpinLock(&CpuMpData->CpuData[ProcessorNumber].ApLock);
   SetApState (&CpuMpData->CpuData[ProcessorNumber], CpuStateIdle);
 }
@@ -709,6 +725,110 @@ MpInitLibSevEsAPReset (
   APResetFn (BufferStart, Code16, Code32, StackStart);
 }
 
+/**
+  Get a node of the completion barrier.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] NodeIndex          The index of the node.
+
+  @return Pointer to the barrier node.
+**/
+MP_BARRIER_NODE *
+GetBarrierNode (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN UINTN                     NodeIndex
+  )
+{
+  return (MP_BARRIER_NODE *) (CpuMpData->BarrierNodes + CpuMpData->BarrierNodeSize * NodeIndex);
+}
+
+/**
+  Count the nodes of the completion barrier, and link them into a tree.
+
+  Processor N arrives at leaf node N / MP_BARRIER_FAN_IN. The nodes are stored
+  level by level starting from the leaves, so the parent of a node always
+  comes after the node, and the root is the last node.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data. If it is NULL, the
+                                nodes are only counted.
+  @param[in] ProcessorCount     The maximum number of processors.
+
+  @return The number of barrier nodes.
+**/
+UINT32
+InitializeBarrier (
+  IN CPU_MP_DATA               *CpuMpData,  OPTIONAL
+  IN UINT32                    ProcessorCount
+  )
+{
+  UINT32                       LevelStart;
+  UINT32                       LevelCount;
+  UINT32                       NodeCount;
+  UINT32                       Index;
+
+  LevelStart = 0;
+  LevelCount = (ProcessorCount + MP_BARRIER_FAN_IN - 1) / MP_BARRIER_FAN_IN;
+  while (TRUE) {
+    NodeCount = LevelStart + LevelCount;
+    for (Index = 0; Index < LevelCount && CpuMpData != NULL; Index++) {
+      GetBarrierNode (CpuMpData, LevelStart + Index)->Parent =
+        (LevelCount == 1) ? MAX_UINT32 : NodeCount + Index / MP_BARRIER_FAN_IN;
+    }
+    if (LevelCount == 1) {
+      break;
+    }
+    LevelStart = NodeCount;
+    LevelCount = (LevelCount + MP_BARRIER_FAN_IN - 1) / MP_BARRIER_FAN_IN;
+  }
+
+  return NodeCount;
+}
+
+/**
+  Arrive at the completion barrier after the broadcast procedure has finished
+  on an AP.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] ProcessorNumber    The handle number of the AP.
+**/
+VOID
+ArriveAtBarrier (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN UINTN                     ProcessorNumber
+  )
+{
+  MP_BARRIER_NODE              *Node;
+
+  Node = GetBarrierNode (CpuMpData, ProcessorNumber / MP_BARRIER_FAN_IN);
+  //
+  // The last AP, or child node, to arrive at a node arrives at its parent.
+  //
+  while (InterlockedIncrement ((UINT32 *) &Node->Arrived) == Node->Expected &&
+         Node->Parent != MAX_UINT32) {
+    Node = GetBarrierNode (CpuMpData, Node->Parent);
+  }
+}
+
+/**
+  Check whether all APs started by WakeUpAllApsByMailbox() have arrived at
+  the completion barrier.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+
+  @retval TRUE   All APs have finished the broadcast procedure.
+  @retval FALSE  Some APs are still running the broadcast procedure.
+**/
+BOOLEAN
+IsBarrierComplete (
+  IN CPU_MP_DATA               *CpuMpData
+  )
+{
+  MP_BARRIER_NODE              *Root;
+
+  Root = GetBarrierNode (CpuMpData, CpuMpData->BarrierNodeCount - 1);
+  return (BOOLEAN) (Root->Arrived == Root->Expected);
+}
+
 /**
   This function will be called from AP reset code if BSP uses WakeUpAP.
 
@@ -731,11 +851,21 @@ ApWakeupFunction (
   CPU_INFO_IN_HOB            *CpuInfoInHob;
   UINT64                     ApTopOfStack;
   UINTN                      CurrentApicMode;
+  MP_BROADCAST_MAILBOX       *Mailbox;
+  UINT32                     BroadcastGeneration;
+  BOOLEAN                    BroadcastWakeup;
 
   //
   // AP finished assembly code and begin to execute C code
   //
   CpuMpData = ExchangeInfo->CpuMpData;
+  Mailbox   = CpuMpData->BroadcastMailbox;
+
+  //
+  // Broadcasts made before this point are not meant for this AP.
+  //
+  BroadcastGeneration = Mailbox->Generation;
+  BroadcastWakeup     = FALSE;
 
   //
   // AP's local APIC settings will be lost after received INIT IPI
@@ -784,14 +914,15 @@ ApWakeupFunction (
       //
       GetProcessorNumber (CpuMpData, &ProcessorNumber);
       //
-      // Clear AP start-up signal when AP waken up
+      // Clear AP start-up signal when AP waken up. If the signal was not set,
+      // the AP has been woken up through the broadcast mailbox.
       //
       ApStartupSignalBuffer = CpuMpData->CpuData[ProcessorNumber].StartupApSignal;
-      InterlockedCompareExchange32 (
-        (UINT32 *) ApStartupSignalBuffer,
-        WAKEUP_AP_SIGNAL,
-        0
-        );
+      BroadcastWakeup = (BOOLEAN) (InterlockedCompareExchange32 (
+                                     (UINT32 *) ApStartupSignalBuffer,
+                                     WAKEUP_AP_SIGNAL,
+                                     0
+                                     ) != WAKEUP_AP_SIGNAL);
 
       if (CpuMpData->InitFlag == ApInitReconfig) {
         //
@@ -820,8 +951,13 @@ ApWakeupFunction (
       }
 
       if (GetApState (&CpuMpData->CpuData[ProcessorNumber]) == CpuStateReady) {
-        Procedure = (EFI_AP_PROCEDURE)CpuMpData->CpuData[ProcessorNumber].ApFunction;
-        Parameter = (VOID *) CpuMpData->CpuData[ProcessorNumber].ApFunctionArgument;
+        if (BroadcastWakeup) {
+          Procedure = (EFI_AP_PROCEDURE) Mailbox->Procedure;
+          Parameter = (VOID *) Mailbox->ProcedureArgument;
+        } else {
+          Procedure = (EFI_AP_PROCEDURE)CpuMpData->CpuData[ProcessorNumber].ApFunction;
+          Parameter = (VOID *) CpuMpData->CpuData[ProcessorNumber].ApFunctionArgument;
+        }
         if (Procedure != NULL) {
           SetApState (&CpuMpData->CpuData[ProcessorNumber], CpuStateBusy);
           //
@@ -863,13 +999,19 @@ ApWakeupFunction (
           }
         }
         SetApState (&CpuMpData->CpuData[ProcessorNumber], CpuStateFinished);
+        if (BroadcastWakeup) {
+          ArriveAtBarrier (CpuMpData, ProcessorNumber);
+        }
       }
     }
 
     //
-    // AP finished executing C code
+    // AP finished executing C code. The BSP tracks APs woken up through the
+    // broadcast mailbox by the completion barrier instead.
     //
-    InterlockedIncrement ((UINT32 *) &CpuMpData->FinishedCount);
+    if (!BroadcastWakeup) {
+      InterlockedIncrement ((UINT32 *) &CpuMpData->FinishedCount);
+    }
 
     //
     // Place AP is specified loop mode
@@ -936,14 +1078,16 @@ ApWakeupFunction (
       DisableInterrupts ();
       if (CpuMpData->ApLoopMode == ApInMwaitLoop) {
         //
-        // Place AP in MWAIT-loop
+        // Place AP in MWAIT-loop. Each AP monitors its own start-up signal,
+        // so waking one AP does not wake the others. A broadcast also stores
+        // to the start-up signal of every waiting AP.
         //
         AsmMonitor ((UINTN) ApStartupSignalBuffer, 0, 0);
-        if (*ApStartupSignalBuffer != WAKEUP_AP_SIGNAL) {
+        if (*ApStartupSignalBuffer != WAKEUP_AP_SIGNAL &&
+            Mailbox->Generation == BroadcastGeneration) {
           //
-          // Check AP start-up signal again.
-          // If AP start-up signal is not set, place AP into
-          // the specified C-state
+          // Check AP start-up signal and broadcast generation again.
+          // If neither changed, place AP into the specified C-state
           //
           AsmMwait (CpuMpData->ApTargetCState << 4, 0);
         }
@@ -957,10 +1101,12 @@ ApWakeupFunction (
       }
 
       //
-      // If AP start-up signal is written, AP is waken up
-      // otherwise place AP in loop again
+      // If AP start-up signal is written, or a new broadcast is made, AP is
+      // waken up, otherwise place AP in loop again
       //
-      if (*ApStartupSignalBuffer == WAKEUP_AP_SIGNAL) {
+      if (*ApStartupSignalBuffer == WAKEUP_AP_SIGNAL ||
+          Mailbox->Generation != BroadcastGeneration) {
+        BroadcastGeneration = Mailbox->Generation;
         break;
       }
     }
@@ -1506,6 +1652,88 @@ WakeUpAP (
   CpuMpData->WakeUpByInitSipiSipi = (CpuMpData->ApLoopMode == ApInHltLoop);
 }
 
+/**
+  Start the procedure on all APs marked as waiting through the broadcast
+  mailbox.
+
+  The caller must make sure that all these APs are idle, in MWAIT-loop or
+  Run-loop. Instead of one start-up signal per AP, every AP watches the
+  generation of the mailbox, and the BSP does not wait for each AP to wake up.
+  APs in MWAIT-loop also need one store to their monitored start-up signal.
+  The APs report completion through the completion barrier.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] Procedure          The function to be invoked by APs
+  @param[in] ProcedureArgument  The argument to be passed into AP function
+**/
+VOID
+WakeUpAllApsByMailbox (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN EFI_AP_PROCEDURE          Procedure,
+  IN VOID                      *ProcedureArgument      OPTIONAL
+  )
+{
+  MP_BROADCAST_MAILBOX         *Mailbox;
+  MP_BARRIER_NODE              *Node;
+  UINTN                        Index;
+
+  if (CpuMpData->ApLoopMode == ApInMwaitLoop) {
+    //
+    // Get AP target C-state each time when waking up AP,
+    // for it maybe updated by platform again
+    //
+    CpuMpData->ApTargetCState = PcdGet8 (PcdCpuApTargetCstate);
+  }
+
+  for (Index = 0; Index < CpuMpData->BarrierNodeCount; Index++) {
+    Node = GetBarrierNode (CpuMpData, Index);
+    Node->Arrived  = 0;
+    Node->Expected = 0;
+  }
+
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    if (CpuMpData->CpuData[Index].Waiting) {
+      SetApState (&CpuMpData->CpuData[Index], CpuStateReady);
+      GetBarrierNode (CpuMpData, Index / MP_BARRIER_FAN_IN)->Expected++;
+    }
+  }
+
+  //
+  // A node that expects any arrival arrives at its parent once. Parents come
+  // after their children, so one pass sets all the counts.
+  //
+  for (Index = 0; Index < CpuMpData->BarrierNodeCount; Index++) {
+    Node = GetBarrierNode (CpuMpData, Index);
+    if (Node->Expected != 0 && Node->Parent != MAX_UINT32) {
+      GetBarrierNode (CpuMpData, Node->Parent)->Expected++;
+    }
+  }
+
+  Mailbox = CpuMpData->BroadcastMailbox;
+  Mailbox->Procedure         = (UINTN) Procedure;
+  Mailbox->ProcedureArgument = (UINTN) ProcedureArgument;
+  CpuMpData->BroadcastPending = TRUE;
+
+  //
+  // The locked increment orders all the writes above before the new
+  // generation becomes visible to the APs.
+  //
+  InterlockedIncrement ((UINT32 *) &Mailbox->Generation);
+
+  if (CpuMpData->ApLoopMode == ApInMwaitLoop) {
+    //
+    // APs in MWAIT-loop monitor their own start-up signal. Any store to the
+    // monitored line ends MWAIT, so store the cleared signal again; the AP
+    // then sees the new generation. The BSP does not wait for the AP here.
+    //
+    for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+      if (CpuMpData->CpuData[Index].Waiting) {
+        *(UINT32 *) CpuMpData->CpuData[Index].StartupApSignal = 0;
+      }
+    }
+  }
+}
+
 /**
   Calculate timeout value and return the current performance counter value.
 
@@ -1821,10 +2049,28 @@ CheckAllAPs (
   EFI_STATUS      Status;
   CPU_MP_DATA     *CpuMpData;
   CPU_AP_DATA     *CpuData;
+  BOOLEAN         TimedOut;
 
   CpuMpData = GetCpuMpData ();
 
   NextProcessorNumber = 0;
+  TimedOut            = FALSE;
+
+  if (CpuMpData->BroadcastPending && !IsBarrierComplete (CpuMpData)) {
+    //
+    // Only the root of the completion barrier needs to be checked until all
+    // APs woken up through the broadcast mailbox have finished. On time-out,
+    // go through all APs so that finished APs are not reported as failed.
+    //
+    TimedOut = CheckTimeout (
+                 &CpuMpData->CurrentTime,
+                 &CpuMpData->TotalTime,
+                 CpuMpData->ExpectedTime
+                 );
+    if (!TimedOut) {
+      return EFI_NOT_READY;
+    }
+  }
 
   //
   // Go through all APs that are responsible for the StartupAllAPs().
@@ -1869,17 +2115,20 @@ CheckAllAPs (
   // If all APs finish, return EFI_SUCCESS.
   //
   if (CpuMpData->RunningCount == 0) {
+    CpuMpData->BroadcastPending = FALSE;
     return EFI_SUCCESS;
   }
 
   //
   // If timeout expires, report timeout.
   //
-  if (CheckTimeout (
+  if (TimedOut ||
+      CheckTimeout (
        &CpuMpData->CurrentTime,
        &CpuMpData->TotalTime,
        CpuMpData->ExpectedTime)
        ) {
+    CpuMpData->BroadcastPending = FALSE;
     //
     // If FailedCpuList is not NULL, record all failed APs in it.
     //
@@ -1949,6 +2198,9 @@ MpInitLibInitialize (
   UINTN                    ApResetVectorSize;
   UINTN                    BackupBufferAddr;
   UINTN                    ApIdtBase;
+  UINT32                   LineSize;
+  UINT32                   BarrierNodeCount;
+  UINTN                    BroadcastBuffer;
 
   OldCpuMpData = GetCpuMpDataFromGuidedHob ();
   if (OldCpuMpData == NULL) {
@@ -1968,6 +2220,13 @@ MpInitLibInitialize (
   //
   SaveVolatileRegisters (&VolatileRegisters);
 
+  //
+  // The broadcast mailbox and each node of the completion barrier take one
+  // line that is at least as large as the monitor filter.
+  //
+  LineSize         = MAX (MonitorFilterSize, MP_CACHE_LINE_SIZE);
+  BarrierNodeCount = InitializeBarrier (NULL, MaxLogicalProcessorNumber);
+
   BufferSize  = ApStackSize * MaxLogicalProcessorNumber;
   BufferSize += MonitorFilterSize * MaxLogicalProcessorNumber;
   BufferSize += ApResetVectorSize;
@@ -1975,6 +2234,7 @@ MpInitLibInitialize (
   BufferSize += VolatileRegisters.Idtr.Limit + 1;
   BufferSize += sizeof (CPU_MP_DATA);
   BufferSize += (sizeof (CPU_AP_DATA) + sizeof (CPU_INFO_IN_HOB))* MaxLogicalProcessorNumber;
+  BufferSize += LineSize * (1 + 1 + BarrierNodeCount);
   MpBuffer    = AllocatePages (EFI_SIZE_TO_PAGES (BufferSize));
   ASSERT (MpBuffer != NULL);
   ZeroMem (MpBuffer, BufferSize);
@@ -2000,6 +2260,12 @@ MpInitLibInitialize (
   //    +--------------------+ <-- CpuMpData->CpuInfoInHob
   //      CPU_INFO_IN_HOB (N)
   //    +--------------------+
+  //           Padding
+  //    +--------------------+ <-- CpuMpData->BroadcastMailbox (LineSize boundary)
+  //     MP_BROADCAST_MAILBOX
+  //    +--------------------+ <-- CpuMpData->BarrierNodes
+  //      MP_BARRIER_NODE (M)   Each node takes one line, the root is the last one.
+  //    +--------------------+
   //
   MonitorBuffer    = (UINT8 *) (Buffer + ApStackSize * MaxLogicalProcessorNumber);
   BackupBufferAddr = (UINTN) MonitorBuffer + MonitorFilterSize * MaxLogicalProcessorNumber;
@@ -2021,10 +2287,19 @@ MpInitLibInitialize (
   CpuMpData->SevEsAPBuffer  = (UINTN) -1;
   CpuMpData->GhcbBase       = PcdGet64 (PcdGhcbBase);
 
+  BroadcastBuffer = ALIGN_VALUE (
+                      (UINTN) CpuMpData->CpuInfoInHob + sizeof (CPU_INFO_IN_HOB) * MaxLogicalProcessorNumber,
+                      LineSize
+                      );
+  CpuMpData->BroadcastMailbox = (MP_BROADCAST_MAILBOX *) BroadcastBuffer;
+  CpuMpData->BarrierNodes     = (UINT8 *) (BroadcastBuffer + LineSize);
+  CpuMpData->BarrierNodeSize  = LineSize;
+  CpuMpData->BarrierNodeCount = InitializeBarrier (CpuMpData, MaxLogicalProcessorNumber);
+
   //
   // Make sure no memory usage outside of the allocated buffer.
   //
-  ASSERT ((CpuMpData->CpuInfoInHob + sizeof (CPU_INFO_IN_HOB) * MaxLogicalProcessorNumber) ==
+  ASSERT ((UINTN) CpuMpData->BarrierNodes + LineSize * BarrierNodeCount <=
           Buffer + BufferSize);
 
   //
@@ -2087,6 +2362,8 @@ MpInitLibInitialize (
       InitializeSpinLock(&CpuMpData->CpuData[Index].ApLock);
       CpuMpData->CpuData[Index].CpuHealthy = (CpuInfoInHob[Index].Health == 0)? TRUE:FALSE;
       CpuMpData->CpuData[Index].ApFunction = 0;
+      CpuMpData->CpuData[Index].ProcessorSignature = CpuInfoInHob[Index].ProcessorSignature;
+      CpuMpData->CpuData[Index].PlatformId         = CpuInfoInHob[Index].PlatformId;
     }
   }
 
@@ -2101,6 +2378,12 @@ MpInitLibInitialize (
     ShadowMicrocodeUpdatePatch (CpuMpData);
   }
 
+  //
+  // Find the microcode patch of all processors once, so that the APs do not
+  // scan the microcode patch region again
+  //
+  IndexMicrocodePatches (CpuMpData);
+
   //
   // Detect and apply Microcode on BSP
   //
@@ -2132,6 +2415,7 @@ MpInitLibInitialize (
     if (OldCpuMpData != NULL) {
       CpuMpData->InitFlag = ApInitDone;
     }
+    ReportMicrocodeLoadTime (CpuMpData);
     for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
       SetApState (&CpuMpData->CpuData[Index], CpuStateIdle);
     }
@@ -2673,7 +2957,11 @@ StartupAllCPUsWorker (
   CpuMpData->WaitEvent     = WaitEvent;
 
   if (!SingleThread) {
-    WakeUpAP (CpuMpData, TRUE, 0, Procedure, ProcedureArgument, FALSE);
+    if (CpuMpData->InitFlag == ApInitDone && !CpuMpData->WakeUpByInitSipiSipi) {
+      WakeUpAllApsByMailbox (CpuMpData, Procedure, ProcedureArgument);
+    } else {
+      WakeUpAP (CpuMpData, TRUE, 0, Procedure, ProcedureArgument, FALSE);
+    }
   } else {
     for (ProcessorNumber = 0; ProcessorNumber < ProcessorCount; ProcessorNumber++) {
       if (ProcessorNumber == CallerNumber) {
@@ -37,6 +37,17 @@
 
 #define WAKEUP_AP_SIGNAL SIGNATURE_32 ('S', 'T', 'A', 'P')
 
+//
+// Each node of the completion barrier takes its own cache line, at least
+// this large, so that APs arriving at different nodes do not contend.
+//
+#define MP_CACHE_LINE_SIZE      64
+
+//
+// Number of APs, or of child nodes, that arrive at one barrier node.
+//
+#define MP_BARRIER_FAN_IN       8
+
 #define CPU_INIT_MP_LIB_HOB_GUID \
   { \
     0x58eb6a19, 0x3699, 0x4c68, { 0xa8, 0x36, 0xda, 0xcd, 0x8e, 0xdc, 0xad, 0x4a } \
@@ -146,11 +157,34 @@ typedef struct {
   UINT64                         MicrocodeEntryAddr;
 } CPU_AP_DATA;
 
+//
+// Broadcast mailbox. StartupAllAPs() wakes all APs waiting in MWAIT or run
+// loop with one increment of Generation instead of one start-up signal per
+// AP.
+//
+typedef struct {
+  volatile UINT32                Generation;
+  volatile UINTN                 Procedure;
+  volatile UINTN                 ProcedureArgument;
+} MP_BROADCAST_MAILBOX;
+
+//
+// Node of the tree-structured completion barrier. An AP arrives at the leaf
+// node of its processor number; the last arrival at a node arrives at its
+// parent, so the BSP only watches the root.
+//
+typedef struct {
+  volatile UINT32                Arrived;
+  UINT32                         Expected;
+  UINT32                         Parent;
+} MP_BARRIER_NODE;
+
 //
 // Basic CPU information saved in Guided HOB.
 // Because the contents will be shard between PEI and DXE,
 // we need to make sure the each fields offset same in different
-// architecture.
+// architecture. The AP startup code walks this array with the
+// CPU_INFO_IN_HOB_SIZE stride of MpEqu.inc.
 //
 #pragma pack (1)
 typedef struct {
@@ -158,6 +192,14 @@ typedef struct {
   UINT32                         ApicId;
   UINT32                         Health;
   UINT64                         ApTopOfStack;
+  UINT32                         ProcessorSignature;
+  UINT8                          PlatformId;
+  UINT8                          Reserved[3];
+  //
+  // Time stamp counter ticks spent by MicrocodeDetect() on this processor.
+  // 0 if the processor did not load microcode.
+  //
+  UINT64                         MicrocodeLoadTicks;
 } CPU_INFO_IN_HOB;
 #pragma pack ()
 
@@ -275,6 +317,11 @@ struct _CPU_MP_DATA {
   BOOLEAN                        TimerInterruptState;
   UINT64                         MicrocodePatchAddress;
   UINT64                         MicrocodePatchRegionSize;
+  //
+  // TRUE if IndexMicrocodePatches() has set MicrocodeEntryAddr of all
+  // processors.
+  //
+  BOOLEAN                        MicrocodeIndexed;
 
   //
   // Whether need to use Init-Sipi-Sipi to wake up the APs.
@@ -291,6 +338,17 @@ struct _CPU_MP_DATA {
   CPU_MP_DATA                    *NewCpuMpData;
 
   UINT64                         GhcbBase;
+
+  //
+  // Broadcast mailbox and completion barrier used by StartupAllAPs() when
+  // the APs wait in MWAIT or run loop. BarrierNodeSize is the distance
+  // between two nodes, the root is the last node.
+  //
+  MP_BROADCAST_MAILBOX           *BroadcastMailbox;
+  UINT8                          *BarrierNodes;
+  UINT32                         BarrierNodeSize;
+  UINT32                         BarrierNodeCount;
+  BOOLEAN                        BroadcastPending;
 };
 
 #define AP_SAFE_STACK_SIZE  128
@@ -658,6 +716,30 @@ MicrocodeDetect (
   IN UINTN                   ProcessorNumber
   );
 
+/**
+  Find the microcode patch of every processor on the BSP.
+
+  The microcode patch region is scanned once for each distinct pair of
+  processor signature and platform ID, and the result is saved in the
+  MicrocodeEntryAddr field of all processors with that pair.
+
+  @param[in, out]  CpuMpData    The pointer to CPU MP Data structure.
+**/
+VOID
+IndexMicrocodePatches (
+  IN OUT CPU_MP_DATA             *CpuMpData
+  );
+
+/**
+  Report the time spent loading microcode on each processor.
+
+  @param[in]  CpuMpData    The pointer to CPU MP Data structure.
+**/
+VOID
+ReportMicrocodeLoadTime (
+  IN CPU_MP_DATA                 *CpuMpData
+  );
+
 /**
   Shadow the required microcode patches data into memory.
 
@@ -0,0 +1,170 @@
+/** @file
+  DXE instance of the fork-join task library, on top of
+  EFI_MP_SERVICES_PROTOCOL.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include "MpTask.h"
+
+/**
+  Worker function to get the MP services.
+
+  @return The MP services. The pointer is NULL if no MP services are
+          available.
+**/
+MP_SERVICES
+GetMpService (
+  VOID
+  )
+{
+  EFI_STATUS                 Status;
+  MP_SERVICES                MpService;
+
+  //
+  // Get MP Services Protocol
+  //
+  Status = gBS->LocateProtocol (
+                  &gEfiMpServiceProtocolGuid,
+                  NULL,
+                  (VOID **)&MpService.Protocol
+                  );
+  if (EFI_ERROR (Status)) {
+    MpService.Protocol = NULL;
+  }
+
+  return MpService;
+}
+
+/**
+  Worker function to retrieve the number of logical processors in the platform.
+
+  @param[in]  MpService                   The MP services.
+  @param[out] NumberOfCpus                Pointer to the total number of logical
+                                          processors in the system, including the BSP
+                                          and disabled APs.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled logical
+                                          processors that exist in system, including
+                                          the BSP.
+
+  @return Status of MpServices->GetNumberOfProcessors().
+**/
+EFI_STATUS
+GetNumberOfProcessor (
+  IN  MP_SERVICES                      MpService,
+  OUT UINTN                            *NumberOfCpus,
+  OUT UINTN                            *NumberOfEnabledProcessors
+  )
+{
+  return MpService.Protocol->GetNumberOfProcessors (
+                               MpService.Protocol,
+                               NumberOfCpus,
+                               NumberOfEnabledProcessors
+                               );
+}
+
+/**
+  Worker function to return the processor index of the caller.
+
+  This function is called from the BSP and from APs.
+
+  @param[in]  MpService               The MP services.
+
+  @return  The processor index.
+**/
+UINTN
+GetProcessorIndex (
+  IN  MP_SERVICES                      MpService
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      ProcessorIndex;
+
+  Status = MpService.Protocol->WhoAmI (MpService.Protocol, &ProcessorIndex);
+  ASSERT_EFI_ERROR (Status);
+  return ProcessorIndex;
+}
+
+/**
+  Worker function to execute a caller provided function on all enabled
+  processors, including the BSP.
+
+  The APs are started in non-blocking mode so that the BSP can run Procedure
+  at the same time. The MP services signal the completion of the APs from a
+  timer, so the BSP may wait up to PcdCpuApStatusCheckIntervalInMicroSeconds
+  after the last AP returned.
+
+  @param[in]  MpService               The MP services.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      enabled processors of the system.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure.
+
+  @retval EFI_SUCCESS    Procedure ran on all enabled processors.
+  @retval Others         The APs could not be started. Procedure did not run.
+**/
+EFI_STATUS
+StartupAllCPUsWorker (
+  IN  MP_SERVICES                      MpService,
+  IN  EFI_AP_PROCEDURE                 Procedure,
+  IN  VOID                             *ProcedureArgument
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_EVENT                  MpEvent;
+  UINTN                      NumberOfCpus;
+  UINTN                      NumberOfEnabledProcessors;
+
+  Status = GetNumberOfProcessor (MpService, &NumberOfCpus, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (NumberOfEnabledProcessors < 2) {
+    Procedure (ProcedureArgument);
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_WAIT,
+                  TPL_CALLBACK,
+                  EfiEventEmptyFunction,
+                  NULL,
+                  &MpEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Wakeup all APs
+  //
+  Status = MpService.Protocol->StartupAllAPs (
+                                 MpService.Protocol,
+                                 Procedure,
+                                 FALSE,
+                                 MpEvent,
+                                 0,
+                                 ProcedureArgument,
+                                 NULL
+                                 );
+  if (!EFI_ERROR (Status)) {
+    Procedure (ProcedureArgument);
+
+    //
+    // Poll rather than use WaitForEvent () so that callers above
+    // TPL_APPLICATION work too.
+    //
+    while (gBS->CheckEvent (MpEvent) == EFI_NOT_READY) {
+      CpuPause ();
+    }
+  }
+
+  gBS->CloseEvent (MpEvent);
+  return Status;
+}
@@ -0,0 +1,187 @@
+/** @file
+  Host instance of the fork-join task library.
+
+  POSIX threads stand in for the APs so that the scheduler can be tested and
+  benchmarked on the build machine. One thread is created per online host
+  processor; the environment variable MP_TASK_HOST_PROCESSORS overrides the
+  count.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "MpTask.h"
+
+typedef struct {
+  pthread_t                  Thread;
+  UINTN                      ProcessorIndex;
+  EFI_AP_PROCEDURE           Procedure;
+  VOID                       *ProcedureArgument;
+} HOST_AP;
+
+//
+// Only the address is used, to tell MpTaskLib that MP services exist.
+//
+STATIC EDKII_PEI_MP_SERVICES2_PPI  mHostMpServices;
+
+STATIC __thread UINTN              mHostProcessorIndex;
+
+/**
+  Worker function to get the MP services.
+
+  @return The MP services. The pointer is NULL if no MP services are
+          available.
+**/
+MP_SERVICES
+GetMpService (
+  VOID
+  )
+{
+  MP_SERVICES                MpService;
+
+  MpService.Ppi = &mHostMpServices;
+  return MpService;
+}
+
+/**
+  Worker function to retrieve the number of logical processors in the platform.
+
+  @param[in]  MpService                   The MP services.
+  @param[out] NumberOfCpus                Pointer to the total number of logical
+                                          processors in the system, including the BSP
+                                          and disabled APs.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled logical
+                                          processors that exist in system, including
+                                          the BSP.
+
+  @return EFI_SUCCESS.
+**/
+EFI_STATUS
+GetNumberOfProcessor (
+  IN  MP_SERVICES                      MpService,
+  OUT UINTN                            *NumberOfCpus,
+  OUT UINTN                            *NumberOfEnabledProcessors
+  )
+{
+  CONST CHAR8                *Override;
+  long                       Count;
+
+  Override = getenv ("MP_TASK_HOST_PROCESSORS");
+  if (Override != NULL) {
+    Count = strtol (Override, NULL, 0);
+  } else {
+    Count = sysconf (_SC_NPROCESSORS_ONLN);
+  }
+
+  if (Count < 1) {
+    Count = 1;
+  }
+
+  *NumberOfCpus              = (UINTN) Count;
+  *NumberOfEnabledProcessors = (UINTN) Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Worker function to return the processor index of the caller.
+
+  This function is called from the BSP and from APs.
+
+  @param[in]  MpService               The MP services.
+
+  @return  The processor index.
+**/
+UINTN
+GetProcessorIndex (
+  IN  MP_SERVICES                      MpService
+  )
+{
+  return mHostProcessorIndex;
+}
+
+/**
+  Thread entry of a host AP.
+
+  @param[in]  Argument    Pointer to the HOST_AP.
+
+  @return NULL.
+**/
+STATIC
+VOID *
+HostApEntry (
+  IN VOID                    *Argument
+  )
+{
+  HOST_AP                    *Ap;
+
+  Ap = (HOST_AP *) Argument;
+  mHostProcessorIndex = Ap->ProcessorIndex;
+  Ap->Procedure (Ap->ProcedureArgument);
+  return NULL;
+}
+
+/**
+  Worker function to execute a caller provided function on all enabled
+  processors, including the BSP.
+
+  The function returns after Procedure has returned on every processor.
+
+  @param[in]  MpService               The MP services.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      enabled processors of the system.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure.
+
+  @retval EFI_SUCCESS           Procedure ran on the BSP and on every thread
+                                that could be created.
+  @retval EFI_OUT_OF_RESOURCES  There is no memory for the thread table.
+**/
+EFI_STATUS
+StartupAllCPUsWorker (
+  IN  MP_SERVICES                      MpService,
+  IN  EFI_AP_PROCEDURE                 Procedure,
+  IN  VOID                             *ProcedureArgument
+  )
+{
+  HOST_AP                    *Aps;
+  UINTN                      NumberOfCpus;
+  UINTN                      NumberOfEnabledProcessors;
+  UINTN                      Index;
+  UINTN                      Started;
+
+  GetNumberOfProcessor (MpService, &NumberOfCpus, &NumberOfEnabledProcessors);
+
+  //
+  // The calling thread is the BSP, processor 0.
+  //
+  mHostProcessorIndex = 0;
+  Aps = calloc (NumberOfCpus, sizeof (HOST_AP));
+  if (Aps == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Started = 1; Started < NumberOfCpus; Started++) {
+    Aps[Started].ProcessorIndex    = Started;
+    Aps[Started].Procedure         = Procedure;
+    Aps[Started].ProcedureArgument = ProcedureArgument;
+    if (pthread_create (&Aps[Started].Thread, NULL, HostApEntry, &Aps[Started]) != 0) {
+      //
+      // Run with the threads created so far; the missing ones behave like
+      // disabled APs.
+      //
+      break;
+    }
+  }
+
+  Procedure (ProcedureArgument);
+
+  for (Index = 1; Index < Started; Index++) {
+    pthread_join (Aps[Index].Thread, NULL);
+  }
+
+  free (Aps);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/** @file
+  Internal definitions of the fork-join task library.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _MP_TASK_H_
+#define _MP_TASK_H_
+
+#include <PiPei.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MpTaskLib.h>
+#include <Library/SynchronizationLib.h>
+
+#include <Ppi/MpServices2.h>
+
+//
+// Number of tasks each per-processor deque can hold. Must be a power of 2.
+//
+#define MP_TASK_DEQUE_SIZE     64
+
+//
+// Number of chunks per processor MpTaskParallelFor() aims at when the caller
+// does not give a grain size.
+//
+#define MP_TASK_CHUNKS_PER_WORKER  8
+
+typedef union {
+  EDKII_PEI_MP_SERVICES2_PPI    *Ppi;
+  EFI_MP_SERVICES_PROTOCOL      *Protocol;
+} MP_SERVICES;
+
+typedef struct _MP_TASK_SCHEDULER  MP_TASK_SCHEDULER;
+
+typedef struct {
+  MP_TASK_PROCEDURE          Procedure;
+  MP_TASK_RANGE_PROCEDURE    RangeProcedure;
+  VOID                       *Context;
+  UINTN                      Begin;
+  UINTN                      End;
+  UINTN                      Grain;
+  MP_TASK_GROUP              *Group;
+} MP_TASK;
+
+//
+// Per-processor state. The owner pushes and pops tasks at Tail, other
+// processors steal them at Head. Head and Tail only ever grow; the slot of a
+// task is its position modulo MP_TASK_DEQUE_SIZE.
+//
+struct _MP_TASK_WORKER {
+  SPIN_LOCK                  Lock;
+  volatile UINTN             Head;
+  volatile UINTN             Tail;
+  MP_TASK                    Tasks[MP_TASK_DEQUE_SIZE];
+  MP_TASK_SCHEDULER          *Scheduler;
+  UINTN                      Index;
+  UINT32                     Seed;
+  UINTN                      Executed;
+  UINTN                      Stolen;
+};
+
+struct _MP_TASK_SCHEDULER {
+  MP_SERVICES                MpServices;
+  MP_TASK_WORKER             *Workers;
+  UINTN                      WorkerCount;
+  UINTN                      BspIndex;
+  MP_TASK_PROCEDURE          Procedure;
+  VOID                       *Context;
+  volatile BOOLEAN           Done;
+};
+
+/**
+  Worker function to get the MP services.
+
+  @return The MP services. The pointer is NULL if no MP services are
+          available.
+**/
+MP_SERVICES
+GetMpService (
+  VOID
+  );
+
+/**
+  Worker function to retrieve the number of logical processors in the platform.
+
+  @param[in]  MpService                   The MP services.
+  @param[out] NumberOfCpus                Pointer to the total number of logical
+                                          processors in the system, including the BSP
+                                          and disabled APs.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled logical
+                                          processors that exist in system, including
+                                          the BSP.
+
+  @return Status of MpServices->GetNumberOfProcessors().
+**/
+EFI_STATUS
+GetNumberOfProcessor (
+  IN  MP_SERVICES                      MpService,
+  OUT UINTN                            *NumberOfCpus,
+  OUT UINTN                            *NumberOfEnabledProcessors
+  );
+
+/**
+  Worker function to return the processor index of the caller.
+
+  This function is called from the BSP and from APs.
+
+  @param[in]  MpService               The MP services.
+
+  @return  The processor index.
+**/
+UINTN
+GetProcessorIndex (
+  IN  MP_SERVICES                      MpService
+  );
+
+/**
+  Worker function to execute a caller provided function on all enabled
+  processors, including the BSP.
+
+  The function returns after Procedure has returned on every processor.
+
+  @param[in]  MpService               The MP services.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      enabled processors of the system.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure.
+
+  @retval EFI_SUCCESS    Procedure ran on all enabled processors.
+  @retval Others         The APs could not be started. Procedure did not run.
+**/
+EFI_STATUS
+StartupAllCPUsWorker (
+  IN  MP_SERVICES                      MpService,
+  IN  EFI_AP_PROCEDURE                 Procedure,
+  IN  VOID                             *ProcedureArgument
+  );
+
+#endif
@@ -0,0 +1,647 @@
+/** @file
+  Fork-join task library with per-processor work stealing deques.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MpTask.h"
+
+typedef struct {
+  UINTN                      Begin;
+  UINTN                      End;
+  UINTN                      Grain;
+  MP_TASK_RANGE_PROCEDURE    Procedure;
+  VOID                       *Context;
+} MP_TASK_LOOP;
+
+/**
+  Push a task on the deque of Worker.
+
+  @param[in]  Worker     The processor that owns the deque.
+  @param[in]  Task       The task to push.
+
+  @retval TRUE   The task has been queued.
+  @retval FALSE  The deque is full.
+**/
+STATIC
+BOOLEAN
+PushTask (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK                 *Task
+  )
+{
+  BOOLEAN                    Pushed;
+
+  Pushed = FALSE;
+  AcquireSpinLock (&Worker->Lock);
+  if (Worker->Tail - Worker->Head < MP_TASK_DEQUE_SIZE) {
+    CopyMem (&Worker->Tasks[Worker->Tail & (MP_TASK_DEQUE_SIZE - 1)], Task, sizeof (*Task));
+    Worker->Tail++;
+    Pushed = TRUE;
+  }
+  ReleaseSpinLock (&Worker->Lock);
+
+  return Pushed;
+}
+
+/**
+  Take the most recently pushed task from the deque of Worker.
+
+  @param[in]  Worker     The processor that owns the deque.
+  @param[out] Task       Returns the task.
+
+  @retval TRUE   A task has been returned.
+  @retval FALSE  The deque is empty.
+**/
+STATIC
+BOOLEAN
+PopTask (
+  IN  MP_TASK_WORKER         *Worker,
+  OUT MP_TASK                *Task
+  )
+{
+  BOOLEAN                    Popped;
+
+  if (Worker->Tail == Worker->Head) {
+    return FALSE;
+  }
+
+  Popped = FALSE;
+  AcquireSpinLock (&Worker->Lock);
+  if (Worker->Tail != Worker->Head) {
+    Worker->Tail--;
+    CopyMem (Task, &Worker->Tasks[Worker->Tail & (MP_TASK_DEQUE_SIZE - 1)], sizeof (*Task));
+    Popped = TRUE;
+  }
+  ReleaseSpinLock (&Worker->Lock);
+
+  return Popped;
+}
+
+/**
+  Take the oldest task from the deque of Victim.
+
+  The oldest task is the one closest to the root of the task tree, so it
+  usually carries the most work.
+
+  @param[in]  Victim     The processor that owns the deque.
+  @param[out] Task       Returns the task.
+
+  @retval TRUE   A task has been returned.
+  @retval FALSE  The deque is empty.
+**/
+STATIC
+BOOLEAN
+StealTaskFrom (
+  IN  MP_TASK_WORKER         *Victim,
+  OUT MP_TASK                *Task
+  )
+{
+  BOOLEAN                    Stolen;
+
+  //
+  // Look before taking the lock so that idle processors do not bounce the
+  // lock of every other processor around.
+  //
+  if (Victim->Tail == Victim->Head) {
+    return FALSE;
+  }
+
+  Stolen = FALSE;
+  AcquireSpinLock (&Victim->Lock);
+  if (Victim->Tail != Victim->Head) {
+    CopyMem (Task, &Victim->Tasks[Victim->Head & (MP_TASK_DEQUE_SIZE - 1)], sizeof (*Task));
+    Victim->Head++;
+    Stolen = TRUE;
+  }
+  ReleaseSpinLock (&Victim->Lock);
+
+  return Stolen;
+}
+
+/**
+  Steal a task from another processor, starting at a random one.
+
+  @param[in]  Worker     The processor that looks for work.
+  @param[out] Task       Returns the task.
+
+  @retval TRUE   A task has been returned.
+  @retval FALSE  No other processor has queued tasks.
+**/
+STATIC
+BOOLEAN
+StealTask (
+  IN  MP_TASK_WORKER         *Worker,
+  OUT MP_TASK                *Task
+  )
+{
+  MP_TASK_SCHEDULER          *Scheduler;
+  UINTN                      Start;
+  UINTN                      Index;
+  UINTN                      Victim;
+
+  Scheduler = Worker->Scheduler;
+  if (Scheduler->WorkerCount < 2) {
+    return FALSE;
+  }
+
+  //
+  // Xorshift keeps the victims of different processors apart.
+  //
+  Worker->Seed ^= Worker->Seed << 13;
+  Worker->Seed ^= Worker->Seed >> 17;
+  Worker->Seed ^= Worker->Seed << 5;
+  Start = Worker->Seed % Scheduler->WorkerCount;
+
+  for (Index = 0; Index < Scheduler->WorkerCount; Index++) {
+    Victim = (Start + Index) % Scheduler->WorkerCount;
+    if (Victim == Worker->Index) {
+      continue;
+    }
+    if (StealTaskFrom (&Scheduler->Workers[Victim], Task)) {
+      Worker->Stolen++;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Handle the index range [Begin, End) of a parallel loop.
+
+  The range is split in halves until it is not larger than Grain. The upper
+  halves are queued on Worker as tasks of Group.
+
+  @param[in]  Worker     The processor that runs the loop.
+  @param[in]  Procedure  The procedure that handles a chunk.
+  @param[in]  Context    The context passed to Procedure.
+  @param[in]  Begin      The first index of the range.
+  @param[in]  End        One past the last index of the range.
+  @param[in]  Grain      The largest chunk size.
+  @param[in]  Group      The group the queued halves are added to.
+**/
+STATIC
+VOID
+RunRange (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK_RANGE_PROCEDURE Procedure,
+  IN VOID                    *Context,
+  IN UINTN                   Begin,
+  IN UINTN                   End,
+  IN UINTN                   Grain,
+  IN MP_TASK_GROUP           *Group
+  )
+{
+  MP_TASK                    Task;
+  UINTN                      Middle;
+  UINTN                      ChunkEnd;
+
+  while (End - Begin > Grain) {
+    Middle = Begin + (End - Begin) / 2;
+
+    Task.Procedure      = NULL;
+    Task.RangeProcedure = Procedure;
+    Task.Context        = Context;
+    Task.Begin          = Middle;
+    Task.End            = End;
+    Task.Grain          = Grain;
+    Task.Group          = Group;
+
+    InterlockedIncrement (&Group->Pending);
+    if (!PushTask (Worker, &Task)) {
+      //
+      // The deque is full. Handle the rest of the range on this processor.
+      //
+      InterlockedDecrement (&Group->Pending);
+      break;
+    }
+    End = Middle;
+  }
+
+  while (Begin < End) {
+    ChunkEnd = (End - Begin > Grain) ? Begin + Grain : End;
+    Procedure (Worker, Context, Begin, ChunkEnd);
+    Begin = ChunkEnd;
+  }
+}
+
+/**
+  Run a task and remove it from its group.
+
+  @param[in]  Worker     The processor that runs the task.
+  @param[in]  Task       The task.
+**/
+STATIC
+VOID
+ExecuteTask (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK                 *Task
+  )
+{
+  if (Task->RangeProcedure != NULL) {
+    RunRange (
+      Worker,
+      Task->RangeProcedure,
+      Task->Context,
+      Task->Begin,
+      Task->End,
+      Task->Grain,
+      Task->Group
+      );
+  } else {
+    Task->Procedure (Worker, Task->Context);
+  }
+
+  Worker->Executed++;
+  InterlockedDecrement (&Task->Group->Pending);
+}
+
+/**
+  Run one queued task, from the deque of Worker if possible.
+
+  @param[in]  Worker     The processor that looks for work.
+
+  @retval TRUE   A task has been run.
+  @retval FALSE  No task is queued.
+**/
+STATIC
+BOOLEAN
+RunOneTask (
+  IN MP_TASK_WORKER          *Worker
+  )
+{
+  MP_TASK                    Task;
+
+  if (PopTask (Worker, &Task) || StealTask (Worker, &Task)) {
+    ExecuteTask (Worker, &Task);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  Procedure run on every enabled processor by MpTaskRun().
+
+  The BSP runs the root procedure and then tells the APs to stop. The APs run
+  queued tasks until then.
+
+  @param[in, out]  Buffer    Pointer to the MP_TASK_SCHEDULER.
+**/
+STATIC
+VOID
+EFIAPI
+MpTaskWorkerProcedure (
+  IN OUT VOID                *Buffer
+  )
+{
+  MP_TASK_SCHEDULER          *Scheduler;
+  MP_TASK_WORKER             *Worker;
+  UINTN                      Index;
+
+  Scheduler = (MP_TASK_SCHEDULER *) Buffer;
+  if (Scheduler->MpServices.Ppi == NULL) {
+    Index = Scheduler->BspIndex;
+  } else {
+    Index = GetProcessorIndex (Scheduler->MpServices);
+  }
+  ASSERT (Index < Scheduler->WorkerCount);
+  Worker = &Scheduler->Workers[Index];
+
+  if (Index == Scheduler->BspIndex) {
+    Scheduler->Procedure (Worker, Scheduler->Context);
+    Scheduler->Done = TRUE;
+    return;
+  }
+
+  while (!Scheduler->Done) {
+    if (!RunOneTask (Worker)) {
+      CpuPause ();
+    }
+  }
+}
+
+/**
+  Return the number of processors that run tasks, including the BSP.
+
+  This function may only be called from the BSP, outside of MpTaskRun().
+
+  @return The number of enabled processors. 1 if no MP services are available.
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerCount (
+  VOID
+  )
+{
+  MP_SERVICES                MpService;
+  UINTN                      NumberOfCpus;
+  UINTN                      NumberOfEnabledProcessors;
+
+  MpService = GetMpService ();
+  if (MpService.Ppi == NULL) {
+    return 1;
+  }
+
+  if (EFI_ERROR (GetNumberOfProcessor (MpService, &NumberOfCpus, &NumberOfEnabledProcessors))) {
+    return 1;
+  }
+
+  return NumberOfEnabledProcessors;
+}
+
+/**
+  Return the index of the processor that runs a task.
+
+  The index is smaller than the total number of processors reported by the MP
+  services, and can be used to select per-processor scratch data.
+
+  @param[in]  Worker     The processor that runs the task.
+
+  @return The processor number of Worker.
+**/
+UINTN
+EFIAPI
+MpTaskGetWorkerIndex (
+  IN MP_TASK_WORKER          *Worker
+  )
+{
+  return Worker->Index;
+}
+
+/**
+  Run Procedure on the BSP with all enabled APs available to run the tasks it
+  spawns.
+
+  The function returns after Procedure and every task spawned while it ran
+  have completed. This function may only be called from the BSP, and must not
+  be called from a task.
+
+  @param[in]  Procedure  The root procedure.
+  @param[in]  Context    The context passed to Procedure.
+
+  @retval EFI_SUCCESS            Procedure and all spawned tasks completed.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_OUT_OF_RESOURCES   There is not enough memory for the per-processor
+                                 deques.
+  @retval Others                 The APs could not be started. Nothing was run.
+**/
+EFI_STATUS
+EFIAPI
+MpTaskRun (
+  IN MP_TASK_PROCEDURE       Procedure,
+  IN VOID                    *Context  OPTIONAL
+  )
+{
+  EFI_STATUS                 Status;
+  MP_TASK_SCHEDULER          Scheduler;
+  MP_TASK_WORKER             *Bsp;
+  MP_TASK                    Task;
+  UINTN                      NumberOfEnabledProcessors;
+  UINTN                      Index;
+  UINTN                      Executed;
+  UINTN                      Stolen;
+  BOOLEAN                    Found;
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&Scheduler, sizeof (Scheduler));
+  Scheduler.Procedure   = Procedure;
+  Scheduler.Context     = Context;
+  Scheduler.WorkerCount = 1;
+  Scheduler.MpServices  = GetMpService ();
+  if (Scheduler.MpServices.Ppi != NULL) {
+    Status = GetNumberOfProcessor (
+               Scheduler.MpServices,
+               &Scheduler.WorkerCount,
+               &NumberOfEnabledProcessors
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Scheduler.BspIndex = GetProcessorIndex (Scheduler.MpServices);
+  }
+
+  Scheduler.Workers = AllocateZeroPool (Scheduler.WorkerCount * sizeof (MP_TASK_WORKER));
+  if (Scheduler.Workers == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Scheduler.WorkerCount; Index++) {
+    InitializeSpinLock (&Scheduler.Workers[Index].Lock);
+    Scheduler.Workers[Index].Scheduler = &Scheduler;
+    Scheduler.Workers[Index].Index     = Index;
+    Scheduler.Workers[Index].Seed      = (UINT32) (Index * 0x9E3779B9U) | 1;
+  }
+
+  if (Scheduler.MpServices.Ppi == NULL) {
+    MpTaskWorkerProcedure (&Scheduler);
+    Status = EFI_SUCCESS;
+  } else {
+    Status = StartupAllCPUsWorker (Scheduler.MpServices, MpTaskWorkerProcedure, &Scheduler);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    //
+    // All processors are back. Tasks that were spawned but never waited for
+    // may still be queued; run them on the BSP.
+    //
+    Bsp = &Scheduler.Workers[Scheduler.BspIndex];
+    do {
+      Found = FALSE;
+      for (Index = 0; Index < Scheduler.WorkerCount; Index++) {
+        while (StealTaskFrom (&Scheduler.Workers[Index], &Task)) {
+          ExecuteTask (Bsp, &Task);
+          Found = TRUE;
+        }
+      }
+    } while (Found);
+
+    Executed = 0;
+    Stolen   = 0;
+    for (Index = 0; Index < Scheduler.WorkerCount; Index++) {
+      Executed += Scheduler.Workers[Index].Executed;
+      Stolen   += Scheduler.Workers[Index].Stolen;
+    }
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "MpTaskRun: %d processors ran %d tasks, %d of them stolen\n",
+      Scheduler.WorkerCount,
+      Executed,
+      Stolen
+      ));
+  }
+
+  FreePool (Scheduler.Workers);
+  return Status;
+}
+
+/**
+  Initialize a task group.
+
+  @param[out] Group      The task group to initialize.
+**/
+VOID
+EFIAPI
+MpTaskGroupInitialize (
+  OUT MP_TASK_GROUP          *Group
+  )
+{
+  Group->Pending = 0;
+}
+
+/**
+  Create a task that runs Procedure, and add it to Group.
+
+  The task is queued on the deque of Worker. If that deque is full, the task
+  runs before this function returns.
+
+  @param[in]  Worker     The processor that runs the calling task.
+  @param[in]  Group      The group the new task is added to.
+  @param[in]  Procedure  The task procedure.
+  @param[in]  Context    The context passed to Procedure.
+**/
+VOID
+EFIAPI
+MpTaskSpawn (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK_GROUP           *Group,
+  IN MP_TASK_PROCEDURE       Procedure,
+  IN VOID                    *Context  OPTIONAL
+  )
+{
+  MP_TASK                    Task;
+
+  ASSERT (Worker != NULL);
+  ASSERT (Procedure != NULL);
+
+  Task.Procedure      = Procedure;
+  Task.RangeProcedure = NULL;
+  Task.Context        = Context;
+  Task.Begin          = 0;
+  Task.End            = 0;
+  Task.Grain          = 0;
+  Task.Group          = Group;
+
+  InterlockedIncrement (&Group->Pending);
+  if (!PushTask (Worker, &Task)) {
+    ExecuteTask (Worker, &Task);
+  }
+}
+
+/**
+  Wait for all tasks in Group to complete.
+
+  While waiting, the calling processor runs queued tasks, its own first.
+
+  @param[in]  Worker     The processor that runs the calling task.
+  @param[in]  Group      The task group to wait for.
+**/
+VOID
+EFIAPI
+MpTaskWait (
+  IN MP_TASK_WORKER          *Worker,
+  IN MP_TASK_GROUP           *Group
+  )
+{
+  ASSERT (Worker != NULL);
+
+  while (Group->Pending != 0) {
+    if (!RunOneTask (Worker)) {
+      CpuPause ();
+    }
+  }
+}
+
+/**
+  Root procedure of a parallel loop started outside of MpTaskRun().
+
+  @param[in]  Worker     The BSP.
+  @param[in]  Context    Pointer to the MP_TASK_LOOP.
+**/
+STATIC
+VOID
+EFIAPI
+ParallelForRoot (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context
+  )
+{
+  MP_TASK_LOOP               *Loop;
+
+  Loop = (MP_TASK_LOOP *) Context;
+  MpTaskParallelFor (Worker, Loop->Begin, Loop->End, Loop->Grain, Loop->Procedure, Loop->Context);
+}
+
+/**
+  Call Procedure on chunks of the index range [Begin, End) in parallel.
+
+  The range is split in halves until the chunks are not larger than Grain.
+  One half is queued and can be stolen by other processors, and the calling
+  processor keeps splitting the other half. The function returns after all
+  chunks have been handled.
+
+  If Worker is NULL, this function must be called from the BSP, outside of
+  MpTaskRun(), and it brings up the APs for the loop. Otherwise it must be
+  called from a task and uses the processors of that MpTaskRun() call.
+
+  @param[in]  Worker     The processor that runs the calling task, or NULL.
+  @param[in]  Begin      The first index of the range.
+  @param[in]  End        One past the last index of the range.
+  @param[in]  Grain      The largest chunk size. 0 picks a chunk size from the
+                         number of processors.
+  @param[in]  Procedure  The procedure that handles a chunk.
+  @param[in]  Context    The context passed to Procedure.
+
+  @retval EFI_SUCCESS            All chunks have been handled.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL, or End is smaller than Begin.
+  @retval Others                 See MpTaskRun().
+**/
+EFI_STATUS
+EFIAPI
+MpTaskParallelFor (
+  IN MP_TASK_WORKER          *Worker  OPTIONAL,
+  IN UINTN                   Begin,
+  IN UINTN                   End,
+  IN UINTN                   Grain,
+  IN MP_TASK_RANGE_PROCEDURE Procedure,
+  IN VOID                    *Context  OPTIONAL
+  )
+{
+  MP_TASK_LOOP               Loop;
+  MP_TASK_GROUP              Group;
+
+  if ((Procedure == NULL) || (End < Begin)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Begin == End) {
+    return EFI_SUCCESS;
+  }
+
+  if (Worker == NULL) {
+    Loop.Begin     = Begin;
+    Loop.End       = End;
+    Loop.Grain     = Grain;
+    Loop.Procedure = Procedure;
+    Loop.Context   = Context;
+    return MpTaskRun (ParallelForRoot, &Loop);
+  }
+
+  if (Grain == 0) {
+    Grain = (End - Begin) / (Worker->Scheduler->WorkerCount * MP_TASK_CHUNKS_PER_WORKER);
+    if (Grain == 0) {
+      Grain = 1;
+    }
+  }
+
+  MpTaskGroupInitialize (&Group);
+  RunRange (Worker, Procedure, Context, Begin, End, Grain, &Group);
+  MpTaskWait (Worker, &Group);
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/** @file
+  PEI instance of the fork-join task library, on top of
+  EDKII_PEI_MP_SERVICES2_PPI.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+
+#include <Library/PeiServicesLib.h>
+
+#include "MpTask.h"
+
+/**
+  Worker function to get the MP services.
+
+  @return The MP services. The pointer is NULL if no MP services are
+          available.
+**/
+MP_SERVICES
+GetMpService (
+  VOID
+  )
+{
+  EFI_STATUS                 Status;
+  MP_SERVICES                MpService;
+
+  //
+  // Get MP Services2 Ppi
+  //
+  Status = PeiServicesLocatePpi (
+             &gEdkiiPeiMpServices2PpiGuid,
+             0,
+             NULL,
+             (VOID **)&MpService.Ppi
+             );
+  if (EFI_ERROR (Status)) {
+    MpService.Ppi = NULL;
+  }
+
+  return MpService;
+}
+
+/**
+  Worker function to retrieve the number of logical processors in the platform.
+
+  @param[in]  MpService                   The MP services.
+  @param[out] NumberOfCpus                Pointer to the total number of logical
+                                          processors in the system, including the BSP
+                                          and disabled APs.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled logical
+                                          processors that exist in system, including
+                                          the BSP.
+
+  @return Status of MpServices->GetNumberOfProcessors().
+**/
+EFI_STATUS
+GetNumberOfProcessor (
+  IN  MP_SERVICES                      MpService,
+  OUT UINTN                            *NumberOfCpus,
+  OUT UINTN                            *NumberOfEnabledProcessors
+  )
+{
+  return MpService.Ppi->GetNumberOfProcessors (
+                          MpService.Ppi,
+                          NumberOfCpus,
+                          NumberOfEnabledProcessors
+                          );
+}
+
+/**
+  Worker function to return the processor index of the caller.
+
+  This function is called from the BSP and from APs.
+
+  @param[in]  MpService               The MP services.
+
+  @return  The processor index.
+**/
+UINTN
+GetProcessorIndex (
+  IN  MP_SERVICES                      MpService
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      ProcessorIndex;
+
+  //
+  // APs must not use the PEI Services Table, so the PPI is passed in by the
+  // BSP rather than located again.
+  //
+  Status = MpService.Ppi->WhoAmI (MpService.Ppi, &ProcessorIndex);
+  ASSERT_EFI_ERROR (Status);
+  return ProcessorIndex;
+}
+
+/**
+  Worker function to execute a caller provided function on all enabled
+  processors, including the BSP.
+
+  The function returns after Procedure has returned on every processor.
+
+  @param[in]  MpService               The MP services.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      enabled processors of the system.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure.
+
+  @retval EFI_SUCCESS    Procedure ran on all enabled processors.
+  @retval Others         The APs could not be started. Procedure did not run.
+**/
+EFI_STATUS
+StartupAllCPUsWorker (
+  IN  MP_SERVICES                      MpService,
+  IN  EFI_AP_PROCEDURE                 Procedure,
+  IN  VOID                             *ProcedureArgument
+  )
+{
+  return MpService.Ppi->StartupAllCPUs (
+                          MpService.Ppi,
+                          Procedure,
+                          0,
+                          ProcedureArgument
+                          );
+}
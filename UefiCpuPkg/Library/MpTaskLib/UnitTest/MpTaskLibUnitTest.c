@@ -0,0 +1,501 @@
+/** @file
+  Unit tests of the MpTaskLib scheduler, plus a benchmark that hashes and
+  zeroes a large buffer on one processor and with MpTaskParallelFor().
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <time.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MpTaskLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "MpTaskLib Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_LOOP_SIZE         100000
+#define TEST_FIB_N             24
+#define TEST_FIB_CUTOFF        10
+#define TEST_BENCHMARK_SIZE    SIZE_256MB
+#define TEST_BENCHMARK_BLOCK   SIZE_64KB
+
+typedef struct {
+  volatile UINT32            *Hits;
+  volatile UINT32            Calls;
+  UINTN                      Grain;
+  BOOLEAN                    ChunkTooLarge;
+} PARALLEL_FOR_CONTEXT;
+
+typedef struct {
+  UINTN                      N;
+  UINT64                     Result;
+} FIB_CONTEXT;
+
+typedef struct {
+  UINT8                      *Buffer;
+  UINT64                     *Hashes;
+} BENCHMARK_CONTEXT;
+
+/**
+  Return the wall clock time in microseconds.
+
+  @return The wall clock time.
+**/
+STATIC
+UINT64
+GetTimeInMicroseconds (
+  VOID
+  )
+{
+  struct timespec            Now;
+
+  timespec_get (&Now, TIME_UTC);
+  return (UINT64) Now.tv_sec * 1000000 + (UINT64) Now.tv_nsec / 1000;
+}
+
+/**
+  Range procedure that counts how often each index is handled.
+**/
+STATIC
+VOID
+EFIAPI
+CountRange (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context,
+  IN UINTN                   Begin,
+  IN UINTN                   End
+  )
+{
+  PARALLEL_FOR_CONTEXT       *Loop;
+  UINTN                      Index;
+
+  Loop = (PARALLEL_FOR_CONTEXT *) Context;
+  if (End - Begin > Loop->Grain) {
+    Loop->ChunkTooLarge = TRUE;
+  }
+
+  for (Index = Begin; Index < End; Index++) {
+    InterlockedIncrement (&Loop->Hits[Index]);
+  }
+  InterlockedIncrement (&Loop->Calls);
+}
+
+/**
+  Run a parallel loop over [Begin, End) and check that every index in the
+  range is handled exactly once, and no index outside it.
+
+  @retval  UNIT_TEST_PASSED             The loop covered the range.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckParallelFor (
+  IN MP_TASK_WORKER          *Worker,
+  IN UINTN                   Begin,
+  IN UINTN                   End,
+  IN UINTN                   Grain
+  )
+{
+  PARALLEL_FOR_CONTEXT       Loop;
+  UINTN                      Index;
+
+  Loop.Hits          = AllocateZeroPool ((TEST_LOOP_SIZE + 1) * sizeof (UINT32));
+  Loop.Calls         = 0;
+  Loop.Grain         = (Grain == 0) ? MAX_UINTN : Grain;
+  Loop.ChunkTooLarge = FALSE;
+  UT_ASSERT_NOT_NULL (Loop.Hits);
+
+  UT_ASSERT_NOT_EFI_ERROR (MpTaskParallelFor (Worker, Begin, End, Grain, CountRange, &Loop));
+
+  for (Index = 0; Index <= TEST_LOOP_SIZE; Index++) {
+    UT_ASSERT_EQUAL (Loop.Hits[Index], (Index >= Begin && Index < End) ? 1 : 0);
+  }
+  UT_ASSERT_FALSE (Loop.ChunkTooLarge);
+  if (Begin == End) {
+    UT_ASSERT_EQUAL (Loop.Calls, 0);
+  }
+
+  FreePool ((VOID *) Loop.Hits);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that MpTaskParallelFor() handles every index once for a variety of
+  ranges and grain sizes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ParallelForShouldCoverRange (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS           Status;
+
+  Status = CheckParallelFor (NULL, 0, TEST_LOOP_SIZE, 0);
+  if (Status == UNIT_TEST_PASSED) {
+    Status = CheckParallelFor (NULL, 0, TEST_LOOP_SIZE, 1);
+  }
+  if (Status == UNIT_TEST_PASSED) {
+    Status = CheckParallelFor (NULL, 17, 4099, 64);
+  }
+  if (Status == UNIT_TEST_PASSED) {
+    Status = CheckParallelFor (NULL, 5, 6, 1000);
+  }
+  if (Status == UNIT_TEST_PASSED) {
+    Status = CheckParallelFor (NULL, 42, 42, 0);
+  }
+
+  UT_ASSERT_STATUS_EQUAL (MpTaskParallelFor (NULL, 2, 1, 0, CountRange, NULL), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MpTaskParallelFor (NULL, 0, 1, 0, NULL, NULL), EFI_INVALID_PARAMETER);
+
+  return Status;
+}
+
+/**
+  Task that computes a Fibonacci number by spawning a task for one of the two
+  recursive calls.
+**/
+STATIC
+VOID
+EFIAPI
+FibTask (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context
+  )
+{
+  FIB_CONTEXT                *Fib;
+  FIB_CONTEXT                Left;
+  FIB_CONTEXT                Right;
+  MP_TASK_GROUP              Group;
+  UINT64                     Previous;
+  UINT64                     Current;
+  UINT64                     Next;
+  UINTN                      Index;
+
+  Fib = (FIB_CONTEXT *) Context;
+  if (Fib->N < TEST_FIB_CUTOFF) {
+    Previous = 0;
+    Current  = 1;
+    for (Index = 0; Index < Fib->N; Index++) {
+      Next     = Previous + Current;
+      Previous = Current;
+      Current  = Next;
+    }
+    Fib->Result = Previous;
+    return;
+  }
+
+  Left.N  = Fib->N - 1;
+  Right.N = Fib->N - 2;
+  MpTaskGroupInitialize (&Group);
+  MpTaskSpawn (Worker, &Group, FibTask, &Left);
+  FibTask (Worker, &Right);
+  MpTaskWait (Worker, &Group);
+  Fib->Result = Left.Result + Right.Result;
+}
+
+/**
+  Check that nested MpTaskSpawn() and MpTaskWait() compute the same result as
+  a serial computation.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SpawnShouldJoinNestedTasks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FIB_CONTEXT                Fib;
+
+  Fib.N      = TEST_FIB_N;
+  Fib.Result = 0;
+  UT_ASSERT_NOT_EFI_ERROR (MpTaskRun (FibTask, &Fib));
+
+  //
+  // Fib (24)
+  //
+  UT_ASSERT_EQUAL (Fib.Result, 46368);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Task that increments a counter.
+**/
+STATIC
+VOID
+EFIAPI
+IncrementTask (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context
+  )
+{
+  InterlockedIncrement ((volatile UINT32 *) Context);
+}
+
+/**
+  Root procedure that spawns more tasks than a deque holds and returns
+  without waiting for them.
+**/
+STATIC
+VOID
+EFIAPI
+SpawnWithoutWait (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context
+  )
+{
+  STATIC MP_TASK_GROUP       Group;
+  UINTN                      Index;
+
+  MpTaskGroupInitialize (&Group);
+  for (Index = 0; Index < 1000; Index++) {
+    MpTaskSpawn (Worker, &Group, IncrementTask, Context);
+  }
+}
+
+/**
+  Check that MpTaskRun() does not return before tasks that nobody waited for
+  have run.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RunShouldCompleteUnwaitedTasks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  volatile UINT32            Counter;
+
+  Counter = 0;
+  UT_ASSERT_NOT_EFI_ERROR (MpTaskRun (SpawnWithoutWait, (VOID *) &Counter));
+  UT_ASSERT_EQUAL (Counter, 1000);
+
+  UT_ASSERT_STATUS_EQUAL (MpTaskRun (NULL, NULL), EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Range procedure that hashes and then zeroes blocks of the benchmark buffer.
+**/
+STATIC
+VOID
+EFIAPI
+HashAndZeroBlocks (
+  IN MP_TASK_WORKER          *Worker,
+  IN VOID                    *Context,
+  IN UINTN                   Begin,
+  IN UINTN                   End
+  )
+{
+  BENCHMARK_CONTEXT          *Benchmark;
+  UINT64                     *Data;
+  UINT64                     Hash;
+  UINTN                      Block;
+  UINTN                      Index;
+
+  Benchmark = (BENCHMARK_CONTEXT *) Context;
+  for (Block = Begin; Block < End; Block++) {
+    Data = (UINT64 *) (Benchmark->Buffer + Block * TEST_BENCHMARK_BLOCK);
+    Hash = 0xCBF29CE484222325ULL;
+    for (Index = 0; Index < TEST_BENCHMARK_BLOCK / sizeof (UINT64); Index++) {
+      Hash = (Hash ^ Data[Index]) * 0x100000001B3ULL;
+    }
+    Benchmark->Hashes[Block] = Hash;
+    ZeroMem (Data, TEST_BENCHMARK_BLOCK);
+  }
+}
+
+/**
+  Hash and zero a large buffer on one processor and on all processors, check
+  that both give the same hashes, and report the times.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkHashAndZero (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BENCHMARK_CONTEXT          Benchmark;
+  UINT64                     *SerialHashes;
+  UINTN                      BlockCount;
+  UINTN                      Index;
+  UINT64                     Start;
+  UINT64                     Serial;
+  UINT64                     Parallel;
+
+  BlockCount            = TEST_BENCHMARK_SIZE / TEST_BENCHMARK_BLOCK;
+  Benchmark.Buffer      = AllocatePool (TEST_BENCHMARK_SIZE);
+  Benchmark.Hashes      = AllocateZeroPool (BlockCount * sizeof (UINT64));
+  SerialHashes          = AllocateZeroPool (BlockCount * sizeof (UINT64));
+  UT_ASSERT_NOT_NULL (Benchmark.Buffer);
+  UT_ASSERT_NOT_NULL (Benchmark.Hashes);
+  UT_ASSERT_NOT_NULL (SerialHashes);
+
+  for (Index = 0; Index < TEST_BENCHMARK_SIZE / sizeof (UINT64); Index++) {
+    ((UINT64 *) Benchmark.Buffer)[Index] = Index * 0x9E3779B97F4A7C15ULL;
+  }
+  Start = GetTimeInMicroseconds ();
+  HashAndZeroBlocks (NULL, &Benchmark, 0, BlockCount);
+  Serial = GetTimeInMicroseconds () - Start;
+  CopyMem (SerialHashes, Benchmark.Hashes, BlockCount * sizeof (UINT64));
+
+  for (Index = 0; Index < TEST_BENCHMARK_SIZE / sizeof (UINT64); Index++) {
+    ((UINT64 *) Benchmark.Buffer)[Index] = Index * 0x9E3779B97F4A7C15ULL;
+  }
+  Start = GetTimeInMicroseconds ();
+  UT_ASSERT_NOT_EFI_ERROR (MpTaskParallelFor (NULL, 0, BlockCount, 0, HashAndZeroBlocks, &Benchmark));
+  Parallel = GetTimeInMicroseconds () - Start;
+
+  UT_ASSERT_MEM_EQUAL (SerialHashes, Benchmark.Hashes, BlockCount * sizeof (UINT64));
+  UT_ASSERT_TRUE (IsZeroBuffer (Benchmark.Buffer, TEST_BENCHMARK_SIZE));
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Hash and zero %d MB: %d us on 1 processor, %d us on %d processors\n",
+    (UINT32) (TEST_BENCHMARK_SIZE / SIZE_1MB),
+    (UINT32) Serial,
+    (UINT32) Parallel,
+    (UINT32) MpTaskGetWorkerCount ()
+    ));
+
+  FreePool (SerialHashes);
+  FreePool (Benchmark.Hashes);
+  FreePool (Benchmark.Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  MpTaskLib and run the MpTaskLib unit test.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SchedulerTests;
+
+  Framework = NULL;
+
+  DEBUG(( DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION ));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+      goto EXIT;
+  }
+
+  //
+  // Populate the MpTaskLib Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&SchedulerTests, Framework, "MpTaskLib Scheduler Tests", "MpTaskLib.Scheduler", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SchedulerTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite-----------Description--------------Name----------Function--------Pre---Post-------------------Context-----------
+  //
+  AddTestCase (SchedulerTests, "Parallel loops should handle every index once", "ParallelFor", ParallelForShouldCoverRange, NULL, NULL, NULL);
+  AddTestCase (SchedulerTests, "Nested spawned tasks should be joined", "Spawn", SpawnShouldJoinNestedTasks, NULL, NULL, NULL);
+  AddTestCase (SchedulerTests, "Tasks nobody waited for should complete", "Unwaited", RunShouldCompleteUnwaitedTasks, NULL, NULL, NULL);
+  AddTestCase (SchedulerTests, "Benchmark hashing and zeroing a buffer", "Benchmark", BenchmarkHashAndZero, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
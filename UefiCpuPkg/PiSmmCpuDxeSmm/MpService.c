@@ -111,7 +111,28 @@ LockdownSemaphore (
 }
 
 /**
-  Wait all APs to performs an atomic compare exchange operation to release semaphore.
+  Signal the BSP that this AP has reached a synchronization point.
+
+  APs increment the arrival counter of their processor package instead of a
+  single semaphore owned by the BSP, so that the atomic operations of the APs
+  of one package do not contend with those of other packages.
+
+  @param   CpuIndex         The index of the AP.
+
+**/
+VOID
+SignalBsp (
+  IN      UINTN                     CpuIndex
+  )
+{
+  InterlockedIncrement ((UINT32 *)mSmmMpSyncData->CpuData[CpuIndex].Arrival);
+}
+
+/**
+  Wait for NumberOfAPs more APs to signal the BSP with SignalBsp().
+
+  Only the BSP reads the arrival counters, it sums them up and compares the
+  sum with the number of signals it has already consumed in this SMI.
 
   @param   NumberOfAPs      AP number
 
@@ -121,12 +142,41 @@ WaitForAllAPs (
   IN      UINTN                     NumberOfAPs
   )
 {
-  UINTN                             BspIndex;
+  UINT32                            Target;
+  UINT32                            Arrived;
+  UINTN                             Index;
 
-  BspIndex = mSmmMpSyncData->BspIndex;
-  while (NumberOfAPs-- > 0) {
-    WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  Target = mSmmMpSyncData->ArrivalConsumed + (UINT32)NumberOfAPs;
+  while (TRUE) {
+    Arrived = 0;
+    for (Index = 0; Index < mSmmMpSyncData->ArrivalCount; Index++) {
+      Arrived += *(volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.Arrival + mSemaphoreSize * Index);
+    }
+    if (Arrived >= Target) {
+      break;
+    }
+    CpuPause ();
+  }
+  mSmmMpSyncData->ArrivalConsumed = Target;
+}
+
+/**
+  Reset the arrival counters at the end of an SMI.
+
+  All APs that took part in the SMI must have sent their last signal.
+
+**/
+VOID
+ResetArrivalCounters (
+  VOID
+  )
+{
+  UINTN                             Index;
+
+  for (Index = 0; Index < mSmmMpSyncData->ArrivalCount; Index++) {
+    *(volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.Arrival + mSemaphoreSize * Index) = 0;
   }
+  mSmmMpSyncData->ArrivalConsumed = 0;
 }
 
 /**
@@ -461,9 +511,18 @@ BSPHandler (
   UINTN                             ApCount;
   BOOLEAN                           ClearTopLevelSmiResult;
   UINTN                             PresentCount;
+  UINT64                            SmiTimer;
+  UINT64                            RendezvousTimer;
+  UINT64                            RendezvousTicks;
 
   ASSERT (CpuIndex == mSmmMpSyncData->BspIndex);
   ApCount = 0;
+  SmiTimer = 0;
+  RendezvousTimer = 0;
+  RendezvousTicks = 0;
+  if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+    SmiTimer = StartSyncTimer ();
+  }
 
   //
   // Flag BSP's presence
@@ -497,6 +556,7 @@ BSPHandler (
   // If Traditional Sync Mode or need to configure MTRRs: gather all available APs.
   //
   if (SyncMode == SmmCpuSyncModeTradition || SmmCpuFeaturesNeedConfigureMtrrs()) {
+    RendezvousTimer = SmiTimer;
 
     //
     // Wait for APs to arrive
@@ -514,6 +574,10 @@ BSPHandler (
     //
     WaitForAllAPs (ApCount);
 
+    if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+      RendezvousTicks = GetSyncTimerElapsed (RendezvousTimer);
+    }
+
     if (SmmCpuFeaturesNeedConfigureMtrrs()) {
       //
       // Signal all APs it's time for backup MTRRs
@@ -585,6 +649,9 @@ BSPHandler (
   // will run through freely.
   //
   if (SyncMode != SmmCpuSyncModeTradition && !SmmCpuFeaturesNeedConfigureMtrrs()) {
+    if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+      RendezvousTimer = StartSyncTimer ();
+    }
 
     //
     // Lock the counter down and retrieve the number of APs
@@ -605,6 +672,10 @@ BSPHandler (
         break;
       }
     }
+
+    if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+      RendezvousTicks = GetSyncTimerElapsed (RendezvousTimer);
+    }
   }
 
   //
@@ -668,6 +739,11 @@ BSPHandler (
   //
   ResetTokens ();
 
+  //
+  // All APs have sent their last signal of this SMI
+  //
+  ResetArrivalCounters ();
+
   //
   // Reset BspIndex to -1, meaning BSP has not been elected.
   //
@@ -675,6 +751,10 @@ BSPHandler (
     mSmmMpSyncData->BspIndex = (UINT32)-1;
   }
 
+  if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+    SmmProfileRecordLatency (RendezvousTicks, GetSyncTimerElapsed (SmiTimer));
+  }
+
   //
   // Allow APs to check in from this point on
   //
@@ -769,7 +849,7 @@ APHandler (
     //
     // Notify BSP of arrival at this point
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SignalBsp (CpuIndex);
   }
 
   if (SmmCpuFeaturesNeedConfigureMtrrs()) {
@@ -786,7 +866,7 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SignalBsp (CpuIndex);
 
     //
     // Wait for BSP's signal to program MTRRs
@@ -801,7 +881,7 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SignalBsp (CpuIndex);
   }
 
   while (TRUE) {
@@ -848,7 +928,7 @@ APHandler (
     //
     // Notify BSP the readiness of this AP to program MTRRs
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    SignalBsp (CpuIndex);
 
     //
     // Wait for the signal from BSP to program MTRRs
@@ -865,7 +945,7 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to Reset states/semaphore for this processor
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  SignalBsp (CpuIndex);
 
   //
   // Wait for the signal from BSP to Reset states/semaphore for this processor
@@ -880,7 +960,7 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to exit SMM
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  SignalBsp (CpuIndex);
 
 }
 
@@ -1796,6 +1876,8 @@ InitializeSmmCpuSemaphores (
   mSmmCpuSemaphores.SemaphoreCpu.Run     = (UINT32 *)SemaphoreAddr;
   SemaphoreAddr += ProcessorCount * SemaphoreSize;
   mSmmCpuSemaphores.SemaphoreCpu.Present = (BOOLEAN *)SemaphoreAddr;
+  SemaphoreAddr += ProcessorCount * SemaphoreSize;
+  mSmmCpuSemaphores.SemaphoreCpu.Arrival = (UINT32 *)SemaphoreAddr;
 
   mPFLock                       = mSmmCpuSemaphores.SemaphoreGlobal.PFLock;
   mConfigSmmCodeAccessCheckLock = mSmmCpuSemaphores.SemaphoreGlobal.CodeAccessCheckLock;
@@ -1814,6 +1896,8 @@ InitializeMpSyncData (
   )
 {
   UINTN                      CpuIndex;
+  UINTN                      Index;
+  UINTN                      Arrival;
 
   if (mSmmMpSyncData != NULL) {
     //
@@ -1850,7 +1934,35 @@ InitializeMpSyncData (
       *(mSmmMpSyncData->CpuData[CpuIndex].Busy)    = 0;
       *(mSmmMpSyncData->CpuData[CpuIndex].Run)     = 0;
       *(mSmmMpSyncData->CpuData[CpuIndex].Present) = FALSE;
+
+      //
+      // Processors of the same package share an arrival counter. Processors
+      // that are not present yet, like hot-plug ones, use the first counter.
+      //
+      Arrival = 0;
+      if (gSmmCpuPrivate->ProcessorInfo[CpuIndex].ProcessorId != INVALID_APIC_ID) {
+        for (Index = 0; Index < CpuIndex; Index++) {
+          if (gSmmCpuPrivate->ProcessorInfo[Index].ProcessorId != INVALID_APIC_ID &&
+              gSmmCpuPrivate->ProcessorInfo[Index].Location.Package ==
+              gSmmCpuPrivate->ProcessorInfo[CpuIndex].Location.Package) {
+            break;
+          }
+        }
+        if (Index < CpuIndex) {
+          Arrival = ((UINTN)mSmmMpSyncData->CpuData[Index].Arrival -
+                     (UINTN)mSmmCpuSemaphores.SemaphoreCpu.Arrival) / mSemaphoreSize;
+        } else if (mSmmMpSyncData->ArrivalCount != 0) {
+          Arrival = mSmmMpSyncData->ArrivalCount;
+        }
+      }
+      if (Arrival >= mSmmMpSyncData->ArrivalCount) {
+        mSmmMpSyncData->ArrivalCount = (UINT32)Arrival + 1;
+      }
+      mSmmMpSyncData->CpuData[CpuIndex].Arrival =
+        (UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.Arrival + mSemaphoreSize * Arrival);
+      *(mSmmMpSyncData->CpuData[CpuIndex].Arrival) = 0;
     }
+    DEBUG ((DEBUG_INFO, "SMM CPU arrival counters = %d\n", mSmmMpSyncData->ArrivalCount));
   }
 }
 
@@ -407,6 +407,11 @@ typedef struct {
   volatile BOOLEAN                  *Present;
   PROCEDURE_TOKEN                   *Token;
   EFI_STATUS                        *Status;
+  //
+  // Arrival counter of the processor package. APs increment it to signal the
+  // BSP, see WaitForAllAPs().
+  //
+  volatile UINT32                   *Arrival;
 } SMM_CPU_DATA_BLOCK;
 
 typedef enum {
@@ -430,6 +435,15 @@ typedef struct {
   volatile BOOLEAN              *CandidateBsp;
   EFI_AP_PROCEDURE              StartupProcedure;
   VOID                          *StartupProcArgs;
+  //
+  // Number of arrival counters, one per processor package. The counters are
+  // mSemaphoreSize apart starting at mSmmCpuSemaphores.SemaphoreCpu.Arrival.
+  //
+  UINT32                        ArrivalCount;
+  //
+  // Number of AP signals the BSP has consumed in this SMI.
+  //
+  UINT32                        ArrivalConsumed;
 } SMM_DISPATCHER_MP_SYNC_DATA;
 
 #define SMM_PSD_OFFSET              0xfb00
@@ -453,6 +467,7 @@ typedef struct {
   volatile UINT32                   *Run;
   volatile BOOLEAN                  *Present;
   SPIN_LOCK                         *Token;
+  volatile UINT32                   *Arrival;
 } SMM_CPU_SEMAPHORE_CPU;
 
 ///
@@ -535,6 +550,20 @@ StartSyncTimer (
   VOID
   );
 
+/**
+  Get the number of performance counter ticks elapsed since a timer started.
+
+  @param Timer  The start timer from the begin.
+
+  @return The number of ticks elapsed since Timer.
+
+**/
+UINT64
+EFIAPI
+GetSyncTimerElapsed (
+  IN      UINT64                    Timer
+  );
+
 /**
   Check if the SMM AP Sync timer is timeout.
 
@@ -113,6 +113,11 @@ UINTN                     mSplitMemRangeCount      = 0;
 //
 UINT32                    mSmiCommandPort;
 
+//
+// SMI latency histograms.
+//
+SMM_PROFILE_LATENCY_DATA  mSmmProfileLatency;
+
 /**
   Disable branch trace store.
 
@@ -1122,6 +1127,122 @@ SmmProfileRecordSmiNum (
   }
 }
 
+/**
+  Get the histogram bucket of a latency.
+
+  @param  Nanoseconds  The latency in nanoseconds.
+
+  @return The index of the bucket.
+
+**/
+UINTN
+GetLatencyBucket (
+  IN UINT64  Nanoseconds
+  )
+{
+  UINT64  Microseconds;
+  UINTN   Bucket;
+
+  Microseconds = DivU64x32 (Nanoseconds, 1000);
+  if (Microseconds == 0) {
+    return 0;
+  }
+  Bucket = (UINTN)HighBitSet64 (Microseconds) + 1;
+  return MIN (Bucket, SMM_PROFILE_LATENCY_BUCKET_COUNT - 1);
+}
+
+/**
+  Record the latency of an SMI in the SMI latency histograms.
+
+  @param  RendezvousTicks  Performance counter ticks the BSP waited for the
+                           APs to synchronize.
+  @param  SmiTicks         Performance counter ticks the BSP spent in the SMI
+                           handler.
+
+**/
+VOID
+SmmProfileRecordLatency (
+  IN UINT64  RendezvousTicks,
+  IN UINT64  SmiTicks
+  )
+{
+  UINT64  RendezvousTime;
+  UINT64  SmiTime;
+
+  RendezvousTime = GetTimeInNanoSecond (RendezvousTicks);
+  SmiTime        = GetTimeInNanoSecond (SmiTicks);
+
+  mSmmProfileLatency.NumSmis++;
+  mSmmProfileLatency.MaxRendezvousTime = MAX (mSmmProfileLatency.MaxRendezvousTime, RendezvousTime);
+  mSmmProfileLatency.MaxSmiTime        = MAX (mSmmProfileLatency.MaxSmiTime, SmiTime);
+  mSmmProfileLatency.RendezvousHistogram[GetLatencyBucket (RendezvousTime)]++;
+  mSmmProfileLatency.SmiHistogram[GetLatencyBucket (SmiTime)]++;
+}
+
+/**
+  Communication service SMI Handler entry.
+
+  This SMI handler returns or resets the SMI latency histograms.
+
+  @param[in]     DispatchHandle   The unique handle assigned to this handler by SmiHandlerRegister().
+  @param[in]     RegisterContext  Points to an optional handler context which was specified when the
+                                  handler was registered.
+  @param[in,out] CommBuffer       A pointer to a collection of data in memory that will
+                                  be conveyed from a non-SMM environment into an SMM environment.
+  @param[in,out] CommBufferSize   The size of the CommBuffer.
+
+  @retval EFI_SUCCESS             The interrupt was handled and quiesced. No other handlers
+                                  should still be called.
+**/
+EFI_STATUS
+EFIAPI
+SmmProfileLatencyHandler (
+  IN     EFI_HANDLE                   DispatchHandle,
+  IN     CONST VOID                   *RegisterContext,
+  IN OUT VOID                         *CommBuffer,
+  IN OUT UINTN                        *CommBufferSize
+  )
+{
+  SMM_PROFILE_LATENCY_COMMUNICATE     *Communicate;
+  UINT64                              Function;
+
+  //
+  // If input is invalid, stop processing this SMI
+  //
+  if (CommBuffer == NULL || CommBufferSize == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if (*CommBufferSize < sizeof (SMM_PROFILE_LATENCY_COMMUNICATE)) {
+    return EFI_SUCCESS;
+  }
+
+  if (!SmmIsBufferOutsideSmmValid ((UINTN)CommBuffer, *CommBufferSize)) {
+    DEBUG ((DEBUG_ERROR, "SmmProfileLatencyHandler: SMM communication buffer in SMRAM or overflow!\n"));
+    return EFI_SUCCESS;
+  }
+
+  Communicate = (SMM_PROFILE_LATENCY_COMMUNICATE *)CommBuffer;
+  Function    = Communicate->Function;
+  switch (Function) {
+  case SMM_PROFILE_LATENCY_FUNCTION_GET:
+    CopyMem (&Communicate->Data, &mSmmProfileLatency, sizeof (mSmmProfileLatency));
+    Communicate->ReturnStatus = EFI_SUCCESS;
+    break;
+
+  case SMM_PROFILE_LATENCY_FUNCTION_RESET:
+    ZeroMem (&mSmmProfileLatency, sizeof (mSmmProfileLatency));
+    Communicate->ReturnStatus = EFI_SUCCESS;
+    break;
+
+  default:
+    Communicate->ReturnStatus = EFI_UNSUPPORTED;
+    break;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize processor environment for SMM profile.
 
@@ -1162,6 +1283,9 @@ InitSmmProfile (
   UINT32  Cr3
   )
 {
+  EFI_STATUS  Status;
+  EFI_HANDLE  DispatchHandle;
+
   //
   // Save Cr3
   //
@@ -1190,6 +1314,19 @@ InitSmmProfile (
   // Tell #PF handler to prepare a #DB subsequently.
   //
   mSetupDebugTrap = TRUE;
+
+  if (FeaturePcdGet (PcdCpuSmmProfileEnable)) {
+    //
+    // Let the SMI latency histograms be retrieved via SMM communication.
+    //
+    DispatchHandle = NULL;
+    Status = gSmst->SmiHandlerRegister (
+                      SmmProfileLatencyHandler,
+                      &gEdkiiSmmProfileLatencyGuid,
+                      &DispatchHandle
+                      );
+    ASSERT_EFI_ERROR (Status);
+  }
 }
 
 /**
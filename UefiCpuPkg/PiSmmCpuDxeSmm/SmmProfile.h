@@ -46,6 +46,21 @@ SmmProfileRecordSmiNum (
   VOID
   );
 
+/**
+  Record the latency of an SMI in the SMI latency histograms.
+
+  @param  RendezvousTicks  Performance counter ticks the BSP waited for the
+                           APs to synchronize.
+  @param  SmiTicks         Performance counter ticks the BSP spent in the SMI
+                           handler.
+
+**/
+VOID
+SmmProfileRecordLatency (
+  IN UINT64  RendezvousTicks,
+  IN UINT64  SmiTicks
+  );
+
 /**
   The Page fault handler to save SMM profile data.
 
@@ -10,11 +10,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _SMM_PROFILE_INTERNAL_H_
 #define _SMM_PROFILE_INTERNAL_H_
 
+#include <Guid/SmmProfileLatency.h>
 #include <Protocol/SmmReadyToLock.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/DxeServicesTableLib.h>
 #include <Library/CpuLib.h>
 #include <Library/UefiCpuLib.h>
+#include <Library/SmmMemLib.h>
 #include <IndustryStandard/Acpi.h>
 
 #include "SmmProfileArch.h"